@@ -0,0 +1,49 @@
+#include "../src/pgsql/pgsql_async.h"
+#include "bench.h"
+
+#include <iostream>
+#include <vector>
+
+namespace petstoreBench {
+	// Each query waits on the server, which is where multiplexing pays off
+	static const char* kSleepQuery = "SELECT pg_sleep(0.005);";
+
+	void benchAsyncEngine(const BenchContext& context) {
+		PGconn* conn = PQconnectdb(context.conninfo.c_str());
+		if (PQstatus(conn) != CONNECTION_OK) {
+			std::cerr << "Skipping: cannot connect: " << PQerrorMessage(conn) << std::endl;
+			PQfinish(conn);
+			return;
+		}
+
+		std::size_t queries = context.iterations;
+		auto start = Clock::now();
+		for (std::size_t i = 0; i < queries; ++i) {
+			PQclear(PQexec(conn, kSleepQuery));
+		}
+		report("blocking PQexec, 1 connection", queries, secondsSince(start));
+		PQfinish(conn);
+
+		for (std::size_t connections : {4, 16, 64}) {
+			pgsqlAsync::EngineOptions options;
+			options.maxConnectionsPerTarget = connections;
+			pgsqlAsync::AsyncEngine engine(options);
+			if (!engine.start()) {
+				return;
+			}
+
+			start = Clock::now();
+			std::vector<std::future<pgsqlAsync::QueryResult>> results;
+			results.reserve(queries);
+			for (std::size_t i = 0; i < queries; ++i) {
+				results.push_back(engine.submit(context.conninfo, kSleepQuery));
+			}
+			std::size_t failed = 0;
+			for (auto& result : results) {
+				failed += result.get().ok() ? 0 : 1;
+			}
+			report("async engine, " + std::to_string(connections) + " connections", queries - failed,
+			       secondsSince(start));
+		}
+	}
+} // namespace petstoreBench
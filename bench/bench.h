@@ -0,0 +1,59 @@
+#ifndef BENCH_H
+#define BENCH_H
+
+#include <chrono>
+#include <cstddef>
+#include <string>
+
+namespace petstoreBench {
+
+	using Clock = std::chrono::steady_clock;
+
+	// Settings shared by every benchmark, filled from the command line and environment
+	struct BenchContext {
+		std::string conninfo; // Connection string of a database the benchmark may write to
+		std::size_t iterations; // Operations per measured run
+	};
+
+	// Seconds elapsed since start
+	double secondsSince(Clock::time_point start);
+
+	// Prints one result line: name, operation count, elapsed time and operations per second
+	void report(const std::string& name, std::size_t operations, double seconds);
+
+	// Connect-per-call versus pooled connections
+	void benchConnectionPool(const BenchContext& context);
+
+	// Blocking PQexec versus the epoll-driven async engine
+	void benchAsyncEngine(const BenchContext& context);
+
+	// Concatenated SQL versus registry-managed prepared statements
+	void benchPreparedStatements(const BenchContext& context);
+
+	// Text versus binary result decoding over a million Order_Items rows
+	void benchBinaryResults(const BenchContext& context);
+
+	// Round-trip latency over TCP loopback versus a Unix-domain socket profile
+	void benchConnectionProfiles(const BenchContext& context);
+
+	// Buffered PQexec versus single-row / chunked streaming: time to first row and peak RSS
+	void benchStreaming(const BenchContext& context);
+
+	// Store query latency before and after the secondary index pack is built
+	void benchIndexPack(const BenchContext& context);
+
+	// COPY import of a generated product catalog versus one prepared INSERT per row
+	void benchCopyImport(const BenchContext& context);
+
+	// Binary COPY of in-memory order history versus text COPY and multi-row INSERT
+	void benchOrderCopy(const BenchContext& context);
+
+	// Staged catalog sync of a changed feed versus one prepared upsert per feed row
+	void benchCatalogSync(const BenchContext& context);
+
+	// Consistent store dump and restore with one worker versus four
+	void benchStoreArchive(const BenchContext& context);
+
+} // namespace petstoreBench
+
+#endif // BENCH_H
@@ -0,0 +1,60 @@
+#include "../src/pgsql/pgsql_binary.h"
+#include "../src/pgsql/pgsql_schema.h"
+#include "bench.h"
+
+#include <iostream>
+
+namespace petstoreBench {
+	// Produces Order_Items-shaped rows server-side so the benchmark needs no seeded table
+	static const char* kSyntheticOrderItemsSQL =
+	    "SELECT i::int4 AS order_item_id, (i / 4 + 1)::int4 AS order_id, (i % 5000 + 1)::int4 AS product_id, "
+	    "(i % 9 + 1)::int4 AS quantity, ((i % 100000) / 100.0)::numeric(10, 2) AS price, false AS is_deleted "
+	    "FROM generate_series(1, $1::int4) AS i";
+
+	void benchBinaryResults(const BenchContext& context) {
+		pgsqlHandles::PgConn conn = pgsqlHandles::PgConn::connect(context.conninfo);
+		if (!conn.ok()) {
+			std::cerr << "Skipping: cannot connect: " << conn.errorMessage() << std::endl;
+			return;
+		}
+
+		const std::size_t rows = 1000000;
+		std::vector<std::string> params = {std::to_string(rows)};
+		std::vector<const char*> values = {params[0].c_str()};
+
+		// Text: the server formats every value, the client parses it back
+		auto start = Clock::now();
+		pgsqlHandles::PgResult text(
+		    PQexecParams(conn.get(), kSyntheticOrderItemsSQL, 1, nullptr, values.data(), nullptr, nullptr, 0));
+		double fetchSeconds = secondsSince(start);
+		std::int64_t checksum = 0;
+		pgsqlSchema::OrderItems::Row item{};
+		auto decodeStart = Clock::now();
+		for (pgsqlHandles::RowView row : text) {
+			if (pgsqlSchema::parseText<pgsqlSchema::OrderItems>(row, item)) {
+				checksum += item.priceCents + item.quantity;
+			}
+		}
+		report("text fetch", rows, fetchSeconds);
+		report("text decode", rows, secondsSince(decodeStart));
+		text.reset();
+
+		// Binary: values arrive in wire format and are decoded with shifts
+		start = Clock::now();
+		pgsqlHandles::PgResult binary = pgsqlBinary::execBinary(conn.get(), kSyntheticOrderItemsSQL, params);
+		fetchSeconds = secondsSince(start);
+		std::int64_t binaryChecksum = 0;
+		decodeStart = Clock::now();
+		for (pgsqlHandles::RowView row : binary) {
+			if (pgsqlSchema::decodeBinary<pgsqlSchema::OrderItems>(row, item)) {
+				binaryChecksum += item.priceCents + item.quantity;
+			}
+		}
+		report("binary fetch", rows, fetchSeconds);
+		report("binary decode", rows, secondsSince(decodeStart));
+
+		if (checksum != binaryChecksum) {
+			std::cerr << "Checksum mismatch: text " << checksum << " vs binary " << binaryChecksum << std::endl;
+		}
+	}
+} // namespace petstoreBench
@@ -0,0 +1,259 @@
+#include "../src/pgsql/pgsql_binary.h"
+#include "../src/pgsql/pgsql_copy.h"
+#include "../src/pgsql/pgsql_handles.h"
+#include "../src/pgsql/pgsql_prepared.h"
+#include "bench.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <vector>
+
+namespace petstoreBench {
+	static const pgsqlPrepared::PreparedStatement kInsertProduct{
+	    "bench_copy_insert_product",
+	    "INSERT INTO Products (name, price, stock, category, is_deleted) VALUES ($1, $2, $3, $4, $5)",
+	    {pgsqlPrepared::kTextOid,
+	     pgsqlPrepared::kNumericOid,
+	     pgsqlPrepared::kInt4Oid,
+	     pgsqlPrepared::kTextOid,
+	     pgsqlPrepared::kBoolOid}};
+
+	// Catalog CSV with iterations * 200 products; every 1000th row has a bad price to exercise rejection
+	static std::string writeCatalog(std::size_t products) {
+		std::string path = "/tmp/petstore_copy_bench_products.csv";
+		std::ofstream out(path);
+		out << "name,price,stock,category,is_deleted\n";
+		for (std::size_t i = 1; i <= products; ++i) {
+			out << "\"Product " << i << ", size " << i % 7 << "\",";
+			if (i % 1000 == 0) {
+				out << "n/a";
+			}
+			else {
+				out << i % 500 << '.' << i % 100;
+			}
+			out << ',' << i % 300 << ",category " << i % 40 << ',' << (i % 50 == 0 ? "t" : "f") << '\n';
+		}
+		return path;
+	}
+
+	void benchCopyImport(const BenchContext& context) {
+		pgsqlHandles::PgConn conn = pgsqlHandles::PgConn::connect(context.conninfo);
+		if (!conn.ok()) {
+			std::cerr << "Connection failed: " << conn.errorMessage() << std::endl;
+			return;
+		}
+
+		std::string setup = "DROP SCHEMA IF EXISTS petstore_copy_bench CASCADE; CREATE SCHEMA petstore_copy_bench; "
+		                    "SET search_path = petstore_copy_bench; "
+		                    + pgsqlSchema::createTableSQL<pgsqlSchema::Products>();
+		if (!pgsqlHandles::PgResult::exec(conn.get(), setup.c_str()).ok()) {
+			std::cerr << "Setup failed: " << conn.errorMessage() << std::endl;
+			return;
+		}
+
+		std::size_t products = context.iterations * 200;
+		std::string path = writeCatalog(products);
+
+		auto start = Clock::now();
+		pgsqlCopy::ImportStats stats = pgsqlCopy::importTable<pgsqlSchema::Products>(conn.get(), path);
+		report("COPY import", stats.rows, secondsSince(start));
+		stats.errors.resize(std::min<std::size_t>(stats.errors.size(), 3));
+		stats.print(std::cout);
+
+		// Baseline: one prepared INSERT per row, on a slice of the catalog
+		std::size_t inserts = std::min<std::size_t>(products, context.iterations * 10);
+		pgsqlHandles::PgResult::exec(conn.get(), "TRUNCATE Products;");
+		pgsqlHandles::PgResult::exec(conn.get(), "BEGIN;");
+		start = Clock::now();
+		for (std::size_t i = 1; i <= inserts; ++i) {
+			pgsqlPrepared::PreparedStatementRegistry::instance().execute(conn.get(),
+			                                                             kInsertProduct,
+			                                                             "Product " + std::to_string(i),
+			                                                             std::to_string(i % 500) + ".50",
+			                                                             static_cast<int>(i % 300),
+			                                                             "category " + std::to_string(i % 40),
+			                                                             "f");
+		}
+		pgsqlHandles::PgResult::exec(conn.get(), "COMMIT;");
+		report("prepared INSERT per row", inserts, secondsSince(start));
+
+		pgsqlHandles::PgResult::exec(conn.get(), "DROP SCHEMA petstore_copy_bench CASCADE;");
+		std::remove(path.c_str());
+	}
+
+	// Historical orders with four items each; every tenth order has no employee
+	static void makeOrderHistory(std::size_t count,
+	                             std::vector<pgsqlSchema::Orders::Row>& orders,
+	                             std::vector<pgsqlSchema::OrderItems::Row>& items) {
+		for (std::size_t i = 1; i <= count; ++i) {
+			auto id = static_cast<std::int32_t>(i);
+			std::optional<std::int32_t> employee;
+			if (i % 10 != 0) {
+				employee = static_cast<std::int32_t>(i % 50 + 1);
+			}
+			orders.push_back({id,
+			                  static_cast<std::int32_t>(7300 + i % 1500),
+			                  employee,
+			                  static_cast<std::int32_t>(i % 20000 + 1),
+			                  static_cast<std::int64_t>(i % 50000),
+			                  i % 7 == 0 ? "pending" : "completed",
+			                  i % 20 == 0});
+			for (std::int32_t line = 0; line < 4; ++line) {
+				items.push_back({static_cast<std::int32_t>(i * 4 + static_cast<std::size_t>(line) - 3),
+				                 id,
+				                 static_cast<std::int32_t>((i + static_cast<std::size_t>(line)) % 5000 + 1),
+				                 line + 1,
+				                 static_cast<std::int64_t>(i % 10000),
+				                 false});
+			}
+		}
+	}
+
+	static std::string moneyText(std::int64_t cents) {
+		char text[32];
+		std::snprintf(text,
+		              sizeof(text),
+		              "%s%lld.%02lld",
+		              cents < 0 ? "-" : "",
+		              static_cast<long long>(std::llabs(cents) / 100),
+		              static_cast<long long>(std::llabs(cents) % 100));
+		return text;
+	}
+
+	static std::string dateText(std::int32_t pgDays) {
+		pgsqlBinary::Date date = pgsqlBinary::civilFromDays(pgDays + pgsqlBinary::kPostgresEpochDays);
+		char text[16];
+		std::snprintf(text, sizeof(text), "%04d-%02u-%02u", date.year, date.month, date.day);
+		return text;
+	}
+
+	// Column values as SQL literals / COPY text, in descriptor order
+	static std::vector<std::string> orderValues(const pgsqlSchema::Orders::Row& order) {
+		return {std::to_string(order.orderId),
+		        dateText(order.orderDate),
+		        order.employeeId ? std::to_string(*order.employeeId) : "",
+		        order.customerId ? std::to_string(*order.customerId) : "",
+		        moneyText(order.totalCents),
+		        order.status,
+		        order.isDeleted ? "t" : "f"};
+	}
+
+	static std::vector<std::string> itemValues(const pgsqlSchema::OrderItems::Row& item) {
+		return {std::to_string(item.orderItemId),
+		        std::to_string(item.orderId),
+		        std::to_string(item.productId),
+		        std::to_string(item.quantity),
+		        moneyText(item.priceCents),
+		        item.isDeleted ? "t" : "f"};
+	}
+
+	// Text COPY of rows already held in memory; empty values are sent as NULL
+	template<typename Table, typename Rows, typename Values>
+	static bool copyText(PGconn* conn, const Rows& rows, Values values) {
+		std::string sql = "COPY " + std::string(Table::name) + " (" + pgsqlSchema::columnList<Table>() + ") FROM STDIN";
+		if (pgsqlHandles::PgResult::exec(conn, sql.c_str()).status() != PGRES_COPY_IN) {
+			return false;
+		}
+		std::string buffer;
+		for (const auto& row : rows) {
+			bool first = true;
+			for (const std::string& value : values(row)) {
+				buffer += first ? "" : "\t";
+				buffer += value.empty() ? "\\N" : value;
+				first = false;
+			}
+			buffer += '\n';
+			if (buffer.size() >= 256 * 1024) {
+				PQputCopyData(conn, buffer.data(), static_cast<int>(buffer.size()));
+				buffer.clear();
+			}
+		}
+		PQputCopyData(conn, buffer.data(), static_cast<int>(buffer.size()));
+		PQputCopyEnd(conn, nullptr);
+		bool ok = true;
+		for (PGresult* res = PQgetResult(conn); res; res = PQgetResult(conn)) {
+			ok = ok && PQresultStatus(res) == PGRES_COMMAND_OK;
+			PQclear(res);
+		}
+		return ok;
+	}
+
+	// INSERT ... VALUES (...), (...) with 500 literal rows per statement
+	template<typename Table, typename Rows, typename Values>
+	static bool insertMultiRow(PGconn* conn, const Rows& rows, Values values) {
+		const std::string prefix =
+		    "INSERT INTO " + std::string(Table::name) + " (" + pgsqlSchema::columnList<Table>() + ") VALUES ";
+		std::string sql;
+		std::size_t batched = 0;
+		for (std::size_t i = 0; i < rows.size(); ++i) {
+			sql += batched == 0 ? prefix : ", ";
+			sql += '(';
+			bool first = true;
+			for (const std::string& value : values(rows[i])) {
+				sql += first ? "" : ", ";
+				sql += value.empty() ? "NULL" : "'" + value + "'";
+				first = false;
+			}
+			sql += ')';
+			if (++batched == 500 || i + 1 == rows.size()) {
+				if (!pgsqlHandles::PgResult::exec(conn, sql.c_str()).ok()) {
+					return false;
+				}
+				sql.clear();
+				batched = 0;
+			}
+		}
+		return true;
+	}
+
+	void benchOrderCopy(const BenchContext& context) {
+		pgsqlHandles::PgConn conn = pgsqlHandles::PgConn::connect(context.conninfo);
+		if (!conn.ok()) {
+			std::cerr << "Connection failed: " << conn.errorMessage() << std::endl;
+			return;
+		}
+
+		pgsqlSchema::DdlOptions orderOptions;
+		orderOptions.omitReferencesTo = {"Employees", "Customers"};
+		pgsqlSchema::DdlOptions itemOptions;
+		itemOptions.omitReferencesTo = {"Products"};
+		std::string setup = "DROP SCHEMA IF EXISTS petstore_order_copy_bench CASCADE; "
+		                    "CREATE SCHEMA petstore_order_copy_bench; SET search_path = petstore_order_copy_bench; "
+		                    + pgsqlSchema::createTableSQL<pgsqlSchema::Orders>(orderOptions)
+		                    + pgsqlSchema::createTableSQL<pgsqlSchema::OrderItems>(itemOptions);
+		if (!pgsqlHandles::PgResult::exec(conn.get(), setup.c_str()).ok()) {
+			std::cerr << "Setup failed: " << conn.errorMessage() << std::endl;
+			return;
+		}
+
+		std::vector<pgsqlSchema::Orders::Row> orders;
+		std::vector<pgsqlSchema::OrderItems::Row> items;
+		makeOrderHistory(context.iterations * 100, orders, items);
+		std::size_t rows = orders.size() + items.size();
+		auto reset = [&]() { pgsqlHandles::PgResult::exec(conn.get(), "TRUNCATE Orders, Order_Items;"); };
+
+		auto start = Clock::now();
+		std::vector<pgsqlCopy::ImportStats> stats = pgsqlCopy::importOrderHistory(conn.get(), orders, items);
+		report("binary COPY (orders + items)", rows, secondsSince(start));
+		for (const pgsqlCopy::ImportStats& table : stats) {
+			table.print(std::cout);
+		}
+
+		reset();
+		start = Clock::now();
+		bool ok = copyText<pgsqlSchema::Orders>(conn.get(), orders, orderValues)
+		          && copyText<pgsqlSchema::OrderItems>(conn.get(), items, itemValues);
+		report(ok ? "text COPY (orders + items)" : "text COPY (FAILED)", rows, secondsSince(start));
+
+		reset();
+		start = Clock::now();
+		ok = insertMultiRow<pgsqlSchema::Orders>(conn.get(), orders, orderValues)
+		     && insertMultiRow<pgsqlSchema::OrderItems>(conn.get(), items, itemValues);
+		report(ok ? "multi-row INSERT x500 (orders + items)" : "multi-row INSERT (FAILED)", rows, secondsSince(start));
+
+		pgsqlHandles::PgResult::exec(conn.get(), "DROP SCHEMA petstore_order_copy_bench CASCADE;");
+	}
+} // namespace petstoreBench
@@ -0,0 +1,91 @@
+#include "../src/pgsql/pgsql_datagen.h"
+#include "../src/pgsql/pgsql_dump.h"
+#include "../src/pgsql/pgsql_handles.h"
+#include "../src/pgsql/pgsql_indexes.h"
+#include "../src/pgsql/pgsql_schema.h"
+#include "bench.h"
+
+#include <filesystem>
+#include <iostream>
+#include <string>
+
+namespace petstoreBench {
+	// Fresh schema with every store table and the index pack; the returned conninfo resolves to it
+	static bool createStoreSchema(PGconn* conn,
+	                              const BenchContext& context,
+	                              const std::string& schema,
+	                              std::string& conninfo) {
+		std::string setup = "DROP SCHEMA IF EXISTS " + schema + " CASCADE; CREATE SCHEMA " + schema
+		                    + "; SET search_path = " + schema + ";";
+		pgsqlSchema::forEachTable<pgsqlSchema::PetstoreTables>(
+		    [&](auto table) { setup += pgsqlSchema::createTableSQL<decltype(table)>(); });
+		for (const pgsqlIndexes::IndexDefinition& index : pgsqlIndexes::petstoreIndexPack()) {
+			setup += pgsqlIndexes::createIndexSQL(index, false);
+		}
+		if (!pgsqlHandles::PgResult::exec(conn, setup.c_str()).ok()) {
+			std::cerr << "Setup failed: " << PQerrorMessage(conn) << std::endl;
+			return false;
+		}
+		conninfo = context.conninfo + " options='-c search_path=" + schema + "'";
+		return true;
+	}
+
+	static std::size_t archivedRows(const pgsqlDump::ArchiveReport& report) {
+		std::size_t rows = 0;
+		for (const pgsqlDump::TableStats& table : report.tables) {
+			rows += table.rows;
+		}
+		return rows;
+	}
+
+	void benchStoreArchive(const BenchContext& context) {
+		pgsqlHandles::PgConn conn = pgsqlHandles::PgConn::connect(context.conninfo);
+		if (!conn.ok()) {
+			std::cerr << "Connection failed: " << conn.errorMessage() << std::endl;
+			return;
+		}
+		std::string source, target;
+		if (!createStoreSchema(conn.get(), context, "petstore_dump_bench", source)
+		    || !createStoreSchema(conn.get(), context, "petstore_restore_bench", target))
+		{
+			return;
+		}
+
+		pgsqlDatagen::DatagenConfig config;
+		config.orders = context.iterations * 200;
+		config.customers = context.iterations * 20;
+		config.products = context.iterations * 5;
+		pgsqlDatagen::DatagenReport generated = pgsqlDatagen::loadDatabase(config, source);
+		if (!generated.ok) {
+			generated.print(std::cerr);
+			return;
+		}
+
+		// One worker is what a plain COPY-per-table dump amounts to
+		std::string truncate = "TRUNCATE " + pgsqlSchema::tableList<pgsqlSchema::PetstoreTables>() + ";";
+		for (std::size_t threads : {1, 4}) {
+			std::string directory = "/tmp/petstore_dump_bench_" + std::to_string(threads);
+			std::filesystem::remove_all(directory);
+
+			pgsqlDump::DumpOptions dumpOptions;
+			dumpOptions.threads = threads;
+			dumpOptions.chunkKeys = static_cast<std::int64_t>(config.orders / 8 + 1);
+			auto start = Clock::now();
+			pgsqlDump::ArchiveReport dumped = pgsqlDump::dumpDatabase(source, directory, dumpOptions);
+			report("dump, " + std::to_string(threads) + " workers", archivedRows(dumped), secondsSince(start));
+
+			pgsqlDump::RestoreOptions restoreOptions;
+			restoreOptions.threads = threads;
+			pgsqlHandles::PgResult::exec(conn.get(), ("SET search_path = petstore_restore_bench; " + truncate).c_str());
+			start = Clock::now();
+			pgsqlDump::ArchiveReport restored = pgsqlDump::restoreDatabase(target, directory, restoreOptions);
+			report("restore, " + std::to_string(threads) + " workers", archivedRows(restored), secondsSince(start));
+			if (!dumped.ok || !restored.ok) {
+				(dumped.ok ? restored : dumped).print(std::cerr);
+			}
+			std::filesystem::remove_all(directory);
+		}
+
+		pgsqlHandles::PgResult::exec(conn.get(), "DROP SCHEMA petstore_dump_bench, petstore_restore_bench CASCADE;");
+	}
+} // namespace petstoreBench
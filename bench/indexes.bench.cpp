@@ -0,0 +1,146 @@
+#include "../src/pgsql/pgsql_handles.h"
+#include "../src/pgsql/pgsql_indexes.h"
+#include "bench.h"
+
+#include <algorithm>
+#include <iostream>
+#include <random>
+#include <vector>
+
+namespace petstoreBench {
+	// Store tables without foreign keys, filled with generate_series in a throwaway schema.
+	// Volumes scale with the iteration count: iterations * 200 orders, four items per order.
+	static const char* kSetupSQL = R"(
+	    DROP SCHEMA IF EXISTS petstore_index_bench CASCADE;
+	    CREATE SCHEMA petstore_index_bench;
+	    SET search_path = petstore_index_bench;
+	    CREATE TABLE Orders (order_id SERIAL PRIMARY KEY, order_date DATE NOT NULL, employee_id INTEGER,
+	        customer_id INTEGER, total NUMERIC(10, 2) NOT NULL, status TEXT NOT NULL, is_deleted BOOLEAN DEFAULT FALSE);
+	    CREATE TABLE Order_Items (order_item_id SERIAL PRIMARY KEY, order_id INTEGER NOT NULL,
+	        product_id INTEGER NOT NULL, quantity INTEGER NOT NULL, price NUMERIC(10, 2) NOT NULL,
+	        is_deleted BOOLEAN DEFAULT FALSE);
+	    CREATE TABLE Inventory_Actions (action_id SERIAL PRIMARY KEY, product_id INTEGER NOT NULL,
+	        action_type TEXT NOT NULL, quantity INTEGER NOT NULL, action_date DATE NOT NULL,
+	        is_deleted BOOLEAN DEFAULT FALSE);
+	    CREATE TABLE Suppliers (supplier_id SERIAL PRIMARY KEY, name TEXT NOT NULL, contact_info TEXT,
+	        product_id INTEGER, is_deleted BOOLEAN DEFAULT FALSE);
+	)";
+
+	static const char* kFillSQL = R"(
+	    INSERT INTO Orders (order_date, employee_id, customer_id, total, status, is_deleted)
+	        SELECT DATE '2020-01-01' + i % 1500, i % 50 + 1, i % 20000 + 1, (i % 50000) / 100.0, 'completed', i % 20 = 0
+	        FROM generate_series(1, $1::int4) AS i;
+	    INSERT INTO Order_Items (order_id, product_id, quantity, price, is_deleted)
+	        SELECT i / 4 + 1, i % 5000 + 1, i % 9 + 1, (i % 10000) / 100.0, i % 20 = 0
+	        FROM generate_series(0, $1::int4 * 4 - 1) AS i;
+	    INSERT INTO Inventory_Actions (product_id, action_type, quantity, action_date, is_deleted)
+	        SELECT i % 5000 + 1, CASE WHEN i % 2 = 0 THEN 'inbound' ELSE 'outbound' END, i % 30 + 1,
+	            DATE '2020-01-01' + i % 1500, i % 20 = 0
+	        FROM generate_series(1, $1::int4) AS i;
+	    INSERT INTO Suppliers (name, product_id, is_deleted)
+	        SELECT 'supplier ' || i, i % 5000 + 1, i % 20 = 0 FROM generate_series(1, 20000) AS i;
+	)";
+
+	struct IndexedQuery {
+		const char* label;
+		const char* sql;
+		int keyRange; // Keys are drawn uniformly from [1, keyRange]; 0 means the order count
+		bool dated; // Second parameter is a lower bound on the date column
+	};
+
+	static const IndexedQuery kQueries[] = {
+	    {"orders by customer and date",
+	     "SELECT order_id, total FROM Orders WHERE customer_id = $1 AND order_date >= $2 AND NOT is_deleted",
+	     20000,
+	     true},
+	    {"items of an order", "SELECT product_id, quantity FROM Order_Items WHERE order_id = $1", 0, false},
+	    {"inventory of a product since date",
+	     "SELECT sum(quantity) FROM Inventory_Actions WHERE product_id = $1 AND action_date >= $2 AND NOT is_deleted",
+	     5000,
+	     true},
+	    {"active suppliers of a product",
+	     "SELECT supplier_id, name FROM Suppliers WHERE product_id = $1 AND NOT is_deleted",
+	     5000,
+	     false},
+	};
+
+	// Runs every query `queries` times with seeded random keys and prints the median latency
+	static void measureQueries(PGconn* conn, const std::string& phase, int orders, std::size_t queries) {
+		for (const IndexedQuery& query : kQueries) {
+			std::mt19937 random(42);
+			std::uniform_int_distribution<int> keys(1, query.keyRange ? query.keyRange : orders);
+			std::vector<double> micros;
+			micros.reserve(queries);
+
+			auto start = Clock::now();
+			for (std::size_t i = 0; i < queries; ++i) {
+				std::string key = std::to_string(keys(random));
+				const char* values[] = {key.c_str(), "2023-06-01"};
+				auto queryStart = Clock::now();
+				pgsqlHandles::PgResult res(
+				    PQexecParams(conn, query.sql, query.dated ? 2 : 1, nullptr, values, nullptr, nullptr, 0));
+				micros.push_back(secondsSince(queryStart) * 1e6);
+				if (!res.ok()) {
+					std::cerr << query.label << " failed: " << res.errorMessage() << std::endl;
+					return;
+				}
+			}
+			report(phase + ": " + query.label, queries, secondsSince(start));
+			std::sort(micros.begin(), micros.end());
+			std::cout << "  p50 " << micros[micros.size() / 2] << " us" << std::endl;
+		}
+	}
+
+	void benchIndexPack(const BenchContext& context) {
+		pgsqlHandles::PgConn conn = pgsqlHandles::PgConn::connect(context.conninfo);
+		if (!conn.ok()) {
+			std::cerr << "Skipping: cannot connect: " << conn.errorMessage() << std::endl;
+			return;
+		}
+
+		pgsqlHandles::PgResult setup = pgsqlHandles::PgResult::exec(conn.get(), kSetupSQL);
+		if (!setup.ok()) {
+			std::cerr << "Setup failed: " << setup.errorMessage() << std::endl;
+			return;
+		}
+
+		// Multi-statement text cannot take parameters, so each fill statement is sent separately
+		const int orders = static_cast<int>(context.iterations * 200);
+		std::string ordersParam = std::to_string(orders);
+		const char* values[] = {ordersParam.c_str()};
+		std::string fill = kFillSQL;
+		auto fillStart = Clock::now();
+		for (std::size_t begin = 0, end; (end = fill.find(';', begin)) != std::string::npos; begin = end + 1) {
+			std::string statement = fill.substr(begin, end - begin);
+			bool usesParam = statement.find("$1") != std::string::npos;
+			pgsqlHandles::PgResult res(PQexecParams(
+			    conn.get(), statement.c_str(), usesParam ? 1 : 0, nullptr, values, nullptr, nullptr, 0));
+			if (!res.ok()) {
+				std::cerr << "Fill failed: " << res.errorMessage() << std::endl;
+				return;
+			}
+		}
+		pgsqlHandles::PgResult analyze = pgsqlHandles::PgResult::exec(conn.get(), "ANALYZE;");
+		report("fill (orders)", static_cast<std::size_t>(orders), secondsSince(fillStart));
+
+		const std::size_t queries = 200;
+		measureQueries(conn.get(), "before", orders, queries);
+
+		auto buildStart = Clock::now();
+		for (const pgsqlIndexes::IndexDefinition& index : pgsqlIndexes::petstoreIndexPack()) {
+			pgsqlHandles::PgResult res =
+			    pgsqlHandles::PgResult::exec(conn.get(), pgsqlIndexes::createIndexSQL(index).c_str());
+			if (!res.ok()) {
+				std::cerr << "Index build failed: " << res.errorMessage() << std::endl;
+				return;
+			}
+		}
+		report("build index pack concurrently", pgsqlIndexes::petstoreIndexPack().size(), secondsSince(buildStart));
+		analyze = pgsqlHandles::PgResult::exec(conn.get(), "ANALYZE;");
+
+		measureQueries(conn.get(), "after", orders, queries);
+
+		pgsqlHandles::PgResult cleanup =
+		    pgsqlHandles::PgResult::exec(conn.get(), "DROP SCHEMA petstore_index_bench CASCADE;");
+	}
+} // namespace petstoreBench
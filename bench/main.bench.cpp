@@ -0,0 +1,64 @@
+#include "bench.h"
+
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <vector>
+
+namespace petstoreBench {
+	double secondsSince(Clock::time_point start) {
+		return std::chrono::duration<double>(Clock::now() - start).count();
+	}
+
+	void report(const std::string& name, std::size_t operations, double seconds) {
+		std::cout << std::left << std::setw(44) << name << std::right << std::setw(10) << operations << " ops "
+		          << std::fixed << std::setprecision(3) << std::setw(10) << seconds << " s " << std::setw(14)
+		          << (seconds > 0 ? static_cast<double>(operations) / seconds : 0.0) << " ops/s" << std::endl;
+	}
+} // namespace petstoreBench
+
+struct BenchEntry {
+	const char* name;
+	void (*run)(const petstoreBench::BenchContext&);
+};
+
+// Usage: main_bench [benchmark|all] [iterations]
+// The target database is taken from PETSTORE_BENCH_CONNINFO.
+auto main(int argc, char* argv[]) -> int {
+	std::vector<BenchEntry> benches = {
+	    {"pool", petstoreBench::benchConnectionPool},
+	    {"async", petstoreBench::benchAsyncEngine},
+	    {"prepared", petstoreBench::benchPreparedStatements},
+	    {"binary", petstoreBench::benchBinaryResults},
+	    {"profiles", petstoreBench::benchConnectionProfiles},
+	    {"stream", petstoreBench::benchStreaming},
+	    {"indexes", petstoreBench::benchIndexPack},
+	    {"copy", petstoreBench::benchCopyImport},
+	    {"ordercopy", petstoreBench::benchOrderCopy},
+	    {"catalogsync", petstoreBench::benchCatalogSync},
+	    {"archive", petstoreBench::benchStoreArchive},
+	};
+
+	std::string selected = argc > 1 ? argv[1] : "all";
+	petstoreBench::BenchContext context;
+	context.iterations = argc > 2 ? std::stoul(argv[2]) : 1000;
+
+	const char* conninfo = std::getenv("PETSTORE_BENCH_CONNINFO");
+	context.conninfo = conninfo ? conninfo : "dbname=postgres user=postgres host=localhost port=5432";
+
+	bool found = false;
+	for (const BenchEntry& bench : benches) {
+		if (selected == "all" || selected == bench.name) {
+			std::cout << "\n=== " << bench.name << " ===" << std::endl;
+			bench.run(context);
+			found = true;
+		}
+	}
+
+	if (!found) {
+		std::cerr << "Unknown benchmark: " << selected << std::endl;
+		return 1;
+	}
+	return 0;
+}
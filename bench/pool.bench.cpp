@@ -0,0 +1,83 @@
+#include "../src/pgsql/pgsql_connection_pool.h"
+#include "bench.h"
+
+#include <iostream>
+#include <thread>
+#include <vector>
+
+namespace petstoreBench {
+	namespace {
+		// One trivial round trip, the same work for both variants
+		bool runProbe(PGconn* conn) {
+			PGresult* res = PQexec(conn, "SELECT 1;");
+			bool ok = PQresultStatus(res) == PGRES_TUPLES_OK;
+			PQclear(res);
+			return ok;
+		}
+
+		void connectPerCall(const BenchContext& context, std::size_t operations) {
+			for (std::size_t i = 0; i < operations; ++i) {
+				PGconn* conn = PQconnectdb(context.conninfo.c_str());
+				if (PQstatus(conn) == CONNECTION_OK) {
+					runProbe(conn);
+				}
+				PQfinish(conn);
+			}
+		}
+
+		void pooled(pgsqlPool::PgConnectionPool& pool, const BenchContext& context, std::size_t operations) {
+			for (std::size_t i = 0; i < operations; ++i) {
+				pgsqlPool::PooledConnection conn = pool.acquire(context.conninfo);
+				if (conn) {
+					runProbe(conn.get());
+				}
+			}
+		}
+	} // namespace
+
+	void benchConnectionPool(const BenchContext& context) {
+		PGconn* probe = PQconnectdb(context.conninfo.c_str());
+		if (PQstatus(probe) != CONNECTION_OK) {
+			std::cerr << "Skipping: cannot connect: " << PQerrorMessage(probe) << std::endl;
+			PQfinish(probe);
+			return;
+		}
+		PQfinish(probe);
+
+		auto start = Clock::now();
+		connectPerCall(context, context.iterations);
+		report("connect-per-call, 1 thread", context.iterations, secondsSince(start));
+
+		pgsqlPool::PgConnectionPool pool;
+		start = Clock::now();
+		pooled(pool, context, context.iterations);
+		report("pooled, 1 thread", context.iterations, secondsSince(start));
+
+		const std::size_t threads = 8;
+		std::size_t perThread = context.iterations / threads;
+
+		start = Clock::now();
+		std::vector<std::thread> workers;
+		for (std::size_t t = 0; t < threads; ++t) {
+			workers.emplace_back([&] { connectPerCall(context, perThread); });
+		}
+		for (auto& worker : workers) {
+			worker.join();
+		}
+		report("connect-per-call, 8 threads", perThread * threads, secondsSince(start));
+
+		start = Clock::now();
+		workers.clear();
+		for (std::size_t t = 0; t < threads; ++t) {
+			workers.emplace_back([&] { pooled(pool, context, perThread); });
+		}
+		for (auto& worker : workers) {
+			worker.join();
+		}
+		report("pooled, 8 threads", perThread * threads, secondsSince(start));
+
+		pgsqlPool::PoolStats stats = pool.stats(context.conninfo);
+		std::cout << "pool: created=" << stats.created << " reused=" << stats.reused << " open=" << stats.open
+		          << std::endl;
+	}
+} // namespace petstoreBench
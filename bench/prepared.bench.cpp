@@ -0,0 +1,42 @@
+#include "../src/pgsql/pgsql_prepared.h"
+#include "bench.h"
+
+#include <iostream>
+
+namespace petstoreBench {
+	static const pgsqlPrepared::PreparedStatement kRoleLookup{
+	    "bench_role_lookup",
+	    "SELECT rolname FROM pg_roles WHERE rolname = $1 AND rolsuper = true;",
+	    {pgsqlPrepared::kTextOid}};
+
+	void benchPreparedStatements(const BenchContext& context) {
+		PGconn* conn = PQconnectdb(context.conninfo.c_str());
+		if (PQstatus(conn) != CONNECTION_OK) {
+			std::cerr << "Skipping: cannot connect: " << PQerrorMessage(conn) << std::endl;
+			PQfinish(conn);
+			return;
+		}
+
+		std::string role = PQuser(conn);
+		auto start = Clock::now();
+		for (std::size_t i = 0; i < context.iterations; ++i) {
+			std::string query = "SELECT rolname FROM pg_roles WHERE rolname = '" + role + "' AND rolsuper = true;";
+			PQclear(PQexec(conn, query.c_str()));
+		}
+		report("concatenated SQL via PQexec", context.iterations, secondsSince(start));
+
+		auto& registry = pgsqlPrepared::PreparedStatementRegistry::instance();
+		start = Clock::now();
+		for (std::size_t i = 0; i < context.iterations; ++i) {
+			pgsqlHandles::PgResult res = registry.execute(conn, kRoleLookup, role);
+		}
+		report("prepared via registry", context.iterations, secondsSince(start));
+
+		pgsqlPrepared::PreparedStats stats = registry.stats();
+		std::cout << "registry: hits=" << stats.hits << " misses=" << stats.misses
+		          << " reuse=" << stats.reuseRate() * 100.0 << "%" << std::endl;
+
+		registry.forget(conn);
+		PQfinish(conn);
+	}
+} // namespace petstoreBench
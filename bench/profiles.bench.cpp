@@ -0,0 +1,57 @@
+#include "../src/pgsql/pgsql_handles.h"
+#include "../src/pgsql/pgsql_profiles.h"
+#include "bench.h"
+
+#include <algorithm>
+#include <cstdlib>
+#include <iostream>
+#include <vector>
+
+namespace petstoreBench {
+	namespace {
+		// Per-query latency of SELECT 1 on one connection, reported as p50/p99 in microseconds
+		void measureLatency(const std::string& label, const std::string& conninfo, std::size_t queries) {
+			pgsqlHandles::PgConn conn = pgsqlHandles::PgConn::connect(conninfo);
+			if (!conn.ok()) {
+				std::cerr << "Skipping " << label << ": " << conn.errorMessage() << std::endl;
+				return;
+			}
+
+			std::vector<double> micros;
+			micros.reserve(queries);
+			auto start = Clock::now();
+			for (std::size_t i = 0; i < queries; ++i) {
+				auto queryStart = Clock::now();
+				pgsqlHandles::PgResult res = pgsqlHandles::PgResult::exec(conn.get(), "SELECT 1;");
+				micros.push_back(secondsSince(queryStart) * 1e6);
+			}
+			report(label, queries, secondsSince(start));
+
+			std::sort(micros.begin(), micros.end());
+			std::cout << "  p50 " << micros[micros.size() / 2] << " us, p99 " << micros[micros.size() * 99 / 100]
+			          << " us" << std::endl;
+		}
+	} // namespace
+
+	void benchConnectionProfiles(const BenchContext& context) {
+		std::string error;
+		auto options = pgsqlProfiles::ProfileRegistry::parse(context.conninfo, error);
+		if (!options) {
+			std::cerr << "Skipping: " << error << std::endl;
+			return;
+		}
+		std::string dbName = options->count("dbname") ? options->at("dbname") : "postgres";
+		std::string user = options->count("user") ? options->at("user") : "postgres";
+		std::string password = options->count("password") ? options->at("password") : "";
+
+		const char* socketDir = std::getenv("PETSTORE_BENCH_SOCKET_DIR");
+		auto& registry = pgsqlProfiles::ProfileRegistry::instance();
+		registry.define("bench-tcp", pgsqlProfiles::ConnectionProfile::tcp("127.0.0.1"));
+		registry.define("bench-socket",
+		                pgsqlProfiles::ConnectionProfile::unixSocket(socketDir ? socketDir : "/var/run/postgresql"));
+
+		measureLatency("TCP loopback", registry.conninfoFor("bench-tcp", dbName, user, password), context.iterations);
+		measureLatency(
+		    "Unix socket", registry.conninfoFor("bench-socket", dbName, user, password), context.iterations);
+	}
+} // namespace petstoreBench
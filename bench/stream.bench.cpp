@@ -0,0 +1,81 @@
+#include "../src/pgsql/pgsql_handles.h"
+#include "../src/pgsql/pgsql_stream.h"
+#include "bench.h"
+
+#include <iostream>
+#include <sys/resource.h>
+
+namespace petstoreBench {
+	// Orders-report-shaped rows with a text payload, generated server-side
+	static const char* kSyntheticReportSQL =
+	    "SELECT i AS order_id, (DATE '2020-01-01' + i % 1500) AS order_date, md5(i::text) AS note "
+	    "FROM generate_series(1, $1::int4) AS i";
+
+	// ru_maxrss is a high-water mark, so each mode is reported as growth over the previous peak.
+	// Streaming modes run first; the buffered run goes last because it raises the mark for good.
+	static long peakRssKb() {
+		rusage usage{};
+		getrusage(RUSAGE_SELF, &usage);
+		return usage.ru_maxrss;
+	}
+
+	static void reportStream(const std::string& name, const pgsqlStream::StreamResult& result, long rssBefore) {
+		if (!result.ok) {
+			std::cerr << name << " failed: " << result.error << std::endl;
+			return;
+		}
+		report(name, result.rows, result.totalSeconds);
+		std::cout << "  first row " << result.firstRowSeconds * 1e3 << " ms, peak RSS +" << peakRssKb() - rssBefore
+		          << " KiB" << std::endl;
+	}
+
+	void benchStreaming(const BenchContext& context) {
+		pgsqlHandles::PgConn conn = pgsqlHandles::PgConn::connect(context.conninfo);
+		if (!conn.ok()) {
+			std::cerr << "Skipping: cannot connect: " << conn.errorMessage() << std::endl;
+			return;
+		}
+
+		const std::size_t rows = context.iterations * 1000;
+		std::vector<std::string> params = {std::to_string(rows)};
+		std::size_t bytes = 0;
+		auto consume = [&bytes](const pgsqlHandles::RowView& row) {
+			bytes += row[2].size();
+			return true;
+		};
+
+		long rssBefore = peakRssKb();
+		reportStream("single-row mode",
+		             pgsqlStream::streamQuery(conn.get(), kSyntheticReportSQL, params, consume),
+		             rssBefore);
+
+#ifdef LIBPQ_HAS_CHUNK_MODE
+		rssBefore = peakRssKb();
+		pgsqlStream::StreamOptions chunked;
+		chunked.chunkRows = 1000;
+		reportStream("chunked-rows mode (1000)",
+		             pgsqlStream::streamQuery(conn.get(), kSyntheticReportSQL, params, consume, chunked),
+		             rssBefore);
+#else
+		std::cout << "chunked-rows mode needs libpq 17; skipped" << std::endl;
+#endif
+
+		// Buffered: nothing is visible until the last row has been received
+		rssBefore = peakRssKb();
+		std::vector<const char*> values = {params[0].c_str()};
+		auto start = Clock::now();
+		pgsqlHandles::PgResult buffered(
+		    PQexecParams(conn.get(), kSyntheticReportSQL, 1, nullptr, values.data(), nullptr, nullptr, 0));
+		double firstRowSeconds = secondsSince(start);
+		if (!buffered.ok()) {
+			std::cerr << "buffered PQexec failed: " << buffered.errorMessage() << std::endl;
+			return;
+		}
+		for (pgsqlHandles::RowView row : buffered) {
+			consume(row);
+		}
+		report("buffered PQexec", rows, secondsSince(start));
+		std::cout << "  first row " << firstRowSeconds * 1e3 << " ms, peak RSS +" << peakRssKb() - rssBefore
+		          << " KiB" << std::endl;
+	}
+} // namespace petstoreBench
@@ -0,0 +1,107 @@
+#include "../src/pgsql/pgsql_copy.h"
+#include "../src/pgsql/pgsql_datagen.h"
+#include "../src/pgsql/pgsql_handles.h"
+#include "../src/pgsql/pgsql_prepared.h"
+#include "../src/pgsql/pgsql_sync.h"
+#include "bench.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <fstream>
+#include <iostream>
+#include <vector>
+
+namespace petstoreBench {
+	static const pgsqlPrepared::PreparedStatement kUpsertProduct{
+	    "bench_sync_upsert_product",
+	    "INSERT INTO Products (product_id, name, price, stock, category, is_deleted) VALUES ($1, $2, $3, $4, $5, $6) "
+	    "ON CONFLICT (product_id) DO UPDATE SET name = EXCLUDED.name, price = EXCLUDED.price, stock = EXCLUDED.stock, "
+	    "category = EXCLUDED.category, is_deleted = EXCLUDED.is_deleted",
+	    {pgsqlPrepared::kInt4Oid,
+	     pgsqlPrepared::kTextOid,
+	     pgsqlPrepared::kNumericOid,
+	     pgsqlPrepared::kInt4Oid,
+	     pgsqlPrepared::kTextOid,
+	     pgsqlPrepared::kBoolOid}};
+
+	// Tomorrow's feed for a catalog of `products`: every 50th product repriced, every 100th dropped and
+	// products / 100 new ones appended
+	static std::vector<pgsqlSchema::Products::Row> makeFeed(const pgsqlDatagen::DatagenConfig& config,
+	                                                       std::size_t products) {
+		std::vector<pgsqlSchema::Products::Row> feed;
+		for (std::size_t id = 1; id <= products + products / 100; ++id) {
+			if (id <= products && id % 100 == 0) {
+				continue;
+			}
+			pgsqlSchema::Products::Row row = pgsqlDatagen::makeProduct(config, static_cast<std::int32_t>(id));
+			if (id % 50 == 0) {
+				row.priceCents += 100;
+			}
+			feed.push_back(std::move(row));
+		}
+		return feed;
+	}
+
+	void benchCatalogSync(const BenchContext& context) {
+		pgsqlHandles::PgConn conn = pgsqlHandles::PgConn::connect(context.conninfo);
+		if (!conn.ok()) {
+			std::cerr << "Connection failed: " << conn.errorMessage() << std::endl;
+			return;
+		}
+
+		std::string setup = "DROP SCHEMA IF EXISTS petstore_sync_bench CASCADE; CREATE SCHEMA petstore_sync_bench; "
+		                    "SET search_path = petstore_sync_bench; "
+		                    + pgsqlSchema::createTableSQL<pgsqlSchema::Products>();
+		if (!pgsqlHandles::PgResult::exec(conn.get(), setup.c_str()).ok()) {
+			std::cerr << "Setup failed: " << conn.errorMessage() << std::endl;
+			return;
+		}
+
+		// Today's catalog, loaded with binary COPY
+		pgsqlDatagen::DatagenConfig config;
+		std::size_t products = context.iterations * 500;
+		std::vector<pgsqlSchema::Products::Row> catalog;
+		for (std::size_t id = 1; id <= products; ++id) {
+			catalog.push_back(pgsqlDatagen::makeProduct(config, static_cast<std::int32_t>(id)));
+		}
+		if (!pgsqlCopy::copyBinary<pgsqlSchema::Products>(conn.get(), catalog).ok) {
+			std::cerr << "Loading the catalog failed: " << conn.errorMessage() << std::endl;
+			return;
+		}
+		pgsqlHandles::PgResult::exec(conn.get(), "ANALYZE Products;");
+
+		std::vector<pgsqlSchema::Products::Row> feed = makeFeed(config, products);
+		std::string path = "/tmp/petstore_sync_bench_products.csv";
+		{
+			std::string csv;
+			pgsqlDatagen::appendCsvHeader<pgsqlSchema::Products>(csv);
+			for (const pgsqlSchema::Products::Row& row : feed) {
+				pgsqlDatagen::appendCsv<pgsqlSchema::Products>(row, csv);
+			}
+			std::ofstream(path, std::ios::binary) << csv;
+		}
+
+		auto start = Clock::now();
+		pgsqlSync::SyncStats stats =
+		    pgsqlSync::syncFeed(conn.get(), pgsqlSync::syncTable<pgsqlSchema::Products>(), path);
+		report("staged sync (COPY + set-based diff)", stats.staged, secondsSince(start));
+		stats.print(std::cout);
+
+		// Baseline: one prepared upsert per feed row, on a slice of the feed; it cannot see removed products
+		std::size_t upserts = std::min<std::size_t>(feed.size(), context.iterations * 10);
+		pgsqlHandles::PgResult::exec(conn.get(), "BEGIN;");
+		start = Clock::now();
+		for (std::size_t i = 0; i < upserts; ++i) {
+			const pgsqlSchema::Products::Row& row = feed[i];
+			std::string price;
+			pgsqlDatagen::appendCsvMoney(price, row.priceCents);
+			pgsqlPrepared::PreparedStatementRegistry::instance().execute(
+			    conn.get(), kUpsertProduct, row.productId, row.name, price, row.stock, row.category.value_or(""), "f");
+		}
+		pgsqlHandles::PgResult::exec(conn.get(), "COMMIT;");
+		report("prepared upsert per row", upserts, secondsSince(start));
+
+		pgsqlHandles::PgResult::exec(conn.get(), "DROP SCHEMA petstore_sync_bench CASCADE;");
+		std::remove(path.c_str());
+	}
+} // namespace petstoreBench
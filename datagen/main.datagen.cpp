@@ -0,0 +1,105 @@
+#include "../src/pgsql/pgsql_datagen.h"
+
+#include <algorithm>
+#include <cstdlib>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+#include <thread>
+
+static void printUsage() {
+	std::cout << "Usage: petstore_datagen (--conninfo CONNINFO | --out DIRECTORY) [options]\n"
+	          << "  --conninfo CONNINFO  Load an initialized, empty store with binary COPY\n"
+	          << "  --out DIRECTORY      Write one CSV file per table instead\n"
+	          << "  --customers N        (default 10000)\n"
+	          << "  --products N         (default 5000)\n"
+	          << "  --employees N        (default 50)\n"
+	          << "  --suppliers N        (default 500)\n"
+	          << "  --orders N           (default 100000)\n"
+	          << "  --max-items N        Items per order are uniform in 1..N (default 8)\n"
+	          << "  --zipf S             Product popularity exponent, 0 for uniform (default 1.1)\n"
+	          << "  --seed N             Same seed and counts, same data (default 42)\n"
+	          << "  --threads N          (default: hardware threads)\n"
+	          << "  --chunk N            Rows per unit of work (default 16384)\n"
+	          << "Partitioned stores get the Orders partitions for the generated dates created automatically."
+	          << std::endl;
+}
+
+// Usage: petstore_datagen (--conninfo CONNINFO | --out DIRECTORY) [options], see printUsage
+auto main(int argc, char* argv[]) -> int {
+	pgsqlDatagen::DatagenConfig config;
+	config.threads = std::max(1u, std::thread::hardware_concurrency());
+	std::string conninfo;
+	std::string directory;
+
+	try {
+		for (int i = 1; i < argc; ++i) {
+			std::string option = argv[i];
+			if (option == "--help" || option == "-h") {
+				printUsage();
+				return 0;
+			}
+			if (i + 1 >= argc) {
+				throw std::invalid_argument(option + " needs a value");
+			}
+			std::string value = argv[++i];
+			if (option == "--conninfo") {
+				conninfo = value;
+			}
+			else if (option == "--out") {
+				directory = value;
+			}
+			else if (option == "--customers") {
+				config.customers = std::stoull(value);
+			}
+			else if (option == "--products") {
+				config.products = std::stoull(value);
+			}
+			else if (option == "--employees") {
+				config.employees = std::stoull(value);
+			}
+			else if (option == "--suppliers") {
+				config.suppliers = std::stoull(value);
+			}
+			else if (option == "--orders") {
+				config.orders = std::stoull(value);
+			}
+			else if (option == "--max-items") {
+				config.maxItemsPerOrder = std::stoi(value);
+			}
+			else if (option == "--zipf") {
+				config.zipfExponent = std::stod(value);
+			}
+			else if (option == "--seed") {
+				config.seed = std::stoull(value);
+			}
+			else if (option == "--threads") {
+				config.threads = std::stoull(value);
+			}
+			else if (option == "--chunk") {
+				config.chunkRows = std::stoull(value);
+			}
+			else {
+				throw std::invalid_argument("unknown option " + option);
+			}
+		}
+	} catch (const std::exception& e) {
+		std::cerr << "Invalid arguments: " << e.what() << std::endl;
+		printUsage();
+		return 1;
+	}
+
+	if (conninfo.empty() == directory.empty()) {
+		std::cerr << "Give exactly one of --conninfo and --out" << std::endl;
+		printUsage();
+		return 1;
+	}
+
+	std::cout << "Generating " << config.orders << " orders for " << config.customers << " customers and "
+	          << config.products << " products on " << config.threads << " threads (seed " << config.seed << ")"
+	          << std::endl;
+	pgsqlDatagen::DatagenReport report = conninfo.empty() ? pgsqlDatagen::writeFiles(config, directory)
+	                                                      : pgsqlDatagen::loadDatabase(config, conninfo);
+	report.print(std::cout);
+	return report.ok ? 0 : 1;
+}
@@ -1,52 +1,160 @@
 #include "database_drop.h"
+#include "pgsql_handles.h"
+#include "pgsql_partitions.h"
+#include "pgsql_prepared.h"
+#include "pgsql_profiles.h"
+#include "pgsql_purge.h"
+#include "pgsql_schema.h"
+#include "pgsql_stream.h"
 #include <libpq-fe.h>
 #include <iostream>
 
 namespace pgsqlDropDatabase {
-	// Constructor: Initializes the connection string with database, user, and password
-	DatabaseDropManager::DatabaseDropManager(const std::string& dbName,
-	                                         const std::string& userName,
-	                                         const std::string& password) {
-		conninfo_ = "dbname=" + dbName + " user=" + userName + " host=localhost port=5432";
-		if (!password.empty()) {
-			conninfo_ += " password=" + password;
+	const pgsqlPrepared::PreparedStatement terminateConnectionsStatement{
+	    "drop_terminate_connections",
+	    "SELECT pg_terminate_backend(pid) FROM pg_stat_activity WHERE datname = $1 AND pid <> pg_backend_pid();",
+	    {pgsqlPrepared::kTextOid}};
+
+	const pgsqlPrepared::PreparedStatement listDatabasesStatement{
+	    "drop_list_databases",
+	    "SELECT datname FROM pg_database WHERE NOT datistemplate AND datname <> 'postgres' ORDER BY datname;",
+	    {}};
+
+	// DROP DATABASE ... WITH (FORCE) terminates the sessions itself, atomically with the drop
+	constexpr int kForceDropServerVersion = 130000;
+
+	// Names come from pg_database verbatim, so they are quoted: "Store-A" must not fold to store-a
+	static std::string quoteIdentifier(PGconn* conn, const std::string& name) {
+		char* quoted = PQescapeIdentifier(conn, name.c_str(), name.size());
+		if (!quoted) {
+			return "";
 		}
-		conn_ = nullptr;
+		std::string identifier(quoted);
+		PQfreemem(quoted);
+		return identifier;
 	}
 
-	// Destructor: Close the connection
-	DatabaseDropManager::~DatabaseDropManager() {
-		if (conn_) {
-			PQfinish(conn_);
+	// Drop without printing anything on success, so parallel workers do not interleave their output
+	static bool executeDropDatabase(const std::string& dbName, PGconn* superuser_conn) {
+		std::string identifier = quoteIdentifier(superuser_conn, dbName);
+		if (identifier.empty()) {
+			std::cerr << "Cannot quote database name " << dbName << ": " << PQerrorMessage(superuser_conn)
+			          << std::endl;
+			return false;
 		}
-	}
 
-	// Connect to the database
-	bool DatabaseDropManager::connect() {
-		conn_ = PQconnectdb(conninfo_.c_str());
-		if (PQstatus(conn_) != CONNECTION_OK) {
-			std::cerr << "Connection to database failed: " << PQerrorMessage(conn_) << std::endl;
-			PQfinish(conn_);
-			conn_ = nullptr;
+		if (PQserverVersion(superuser_conn) >= kForceDropServerVersion) {
+			std::string dropDatabaseSQL = "DROP DATABASE IF EXISTS " + identifier + " WITH (FORCE);";
+			pgsqlHandles::PgResult res = pgsqlHandles::PgResult::exec(superuser_conn, dropDatabaseSQL.c_str());
+			if (res.status() != PGRES_COMMAND_OK) {
+				std::cerr << "Failed to drop database " << dbName << ": " << res.errorMessage() << std::endl;
+				return false;
+			}
+			return true;
+		}
+
+		// Older servers: terminate the sessions first. A client that reconnects in between makes the
+		// drop fail, which the caller may retry.
+		pgsqlHandles::PgResult res = pgsqlPrepared::PreparedStatementRegistry::instance().execute(
+		    superuser_conn, terminateConnectionsStatement, dbName);
+		if (res.status() != PGRES_TUPLES_OK) {
+			std::cerr << "Failed to terminate connections: " << PQerrorMessage(superuser_conn) << std::endl;
+			return false;
+		}
+
+		std::string dropDatabaseSQL = "DROP DATABASE IF EXISTS " + identifier + ";";
+		res = pgsqlHandles::PgResult::exec(superuser_conn, dropDatabaseSQL.c_str());
+		if (res.status() != PGRES_COMMAND_OK) {
+			std::cerr << "Failed to drop database " << dbName << ": " << PQerrorMessage(superuser_conn) << std::endl;
 			return false;
 		}
 		return true;
 	}
 
+	// Constructor: Initializes the connection string with database, user, and password
+	DatabaseDropManager::DatabaseDropManager(const std::string& dbName,
+	                                         const std::string& userName,
+	                                         const std::string& password) {
+		conninfo_ = pgsqlProfiles::ProfileRegistry::instance().conninfo(dbName, userName, password);
+	}
+
+	// Borrow a connection to the database from the shared pool
+	bool DatabaseDropManager::connect() {
+		conn_ = pgsqlPool::PgConnectionPool::instance().acquire(conninfo_);
+		return static_cast<bool>(conn_);
+	}
+
+	// Close the borrowed connection instead of returning it, the database is about to go away
+	void DatabaseDropManager::disconnect() {
+		conn_.discard();
+	}
+
 	// Drop a specific table by name
 	bool DatabaseDropManager::dropSpecificTable(const std::string& tableName) {
 		std::string dropTableSQL = "DROP TABLE IF EXISTS " + tableName + ";";
 		return executeDrop(dropTableSQL.c_str(), tableName);
 	}
 
-	// Drop all tables
+	// Drop all tables in a single statement: one round trip, and a statement is atomic, so a failure
+	// leaves the schema untouched instead of half dropped. The purge archives and schema_migrations go
+	// too, otherwise the migration fingerprint would make the next initializeTables skip recreating the tables.
+	// So do the monthly partitions maintenance detached: no longer partitions, the CASCADE misses them.
 	bool DatabaseDropManager::dropAllTables() {
-		if (!dropProductsTable() || !dropEmployeesTable() || !dropOrdersTable() || !dropOrderItemsTable()
-		    || !dropCustomersTable() || !dropSuppliersTable() || !dropInventoryActionsTable())
-		{
+		std::string extra;
+		for (const pgsqlPurge::PurgeTable& table : pgsqlPurge::purgeTables()) {
+			extra += ", " + pgsqlPurge::archiveTableName(table.name);
+		}
+		pgsqlHandles::PgResult plain = pgsqlHandles::PgResult::exec(
+		    conn_.get(),
+		    "SELECT relname FROM pg_class WHERE relnamespace = to_regnamespace(current_schema()) AND relkind = 'r' "
+		    "AND NOT relispartition;");
+		if (!plain.ok()) {
+			std::cerr << "Failed to list tables: " << plain.errorMessage() << std::endl;
+			return false;
+		}
+		std::vector<std::string> tables;
+		for (pgsqlHandles::RowView row : plain) {
+			tables.emplace_back(row[0]);
+		}
+		for (const std::string& detached : pgsqlPartitions::partitionNames(tables)) {
+			extra += ", " + detached;
+		}
+		std::string dropSQL = "DROP TABLE IF EXISTS " + pgsqlSchema::tableList<pgsqlSchema::PetstoreTables>()
+		                      + extra + ", schema_migrations CASCADE;";
+		pgsqlHandles::PgResult res = pgsqlHandles::PgResult::exec(conn_.get(), dropSQL.c_str());
+		if (!res.ok()) {
+			std::cerr << "Failed to drop tables: " << res.errorMessage() << std::endl;
+			return false;
+		}
+		return true;
+	}
+
+	// TRUNCATE takes the same ACCESS EXCLUSIVE locks as DROP but keeps tables, indexes and the migration
+	// history, so the database needs no initializeTables afterwards. The purge archives go too, since the
+	// restarted ids would otherwise collide with the archived ones; stores without the soft-delete step
+	// have none, and TRUNCATE has no IF EXISTS.
+	bool DatabaseDropManager::resetAllTables() {
+		std::string archives;
+		for (const pgsqlPurge::PurgeTable& table : pgsqlPurge::purgeTables()) {
+			archives += (archives.empty() ? "'" : ", '") + pgsqlPurge::archiveTableName(table.name) + "'";
+		}
+		std::string existingSQL = "SELECT string_agg(name, ', ') FROM unnest(ARRAY[" + archives
+		                          + "]) AS name WHERE to_regclass(name) IS NOT NULL;";
+		pgsqlHandles::PgResult existing = pgsqlHandles::PgResult::exec(conn_.get(), existingSQL.c_str());
+		if (!existing.ok() || existing.rows() != 1) {
+			std::cerr << "Failed to reset tables: " << existing.errorMessage() << std::endl;
+			return false;
+		}
+		std::string truncateSQL = "TRUNCATE TABLE " + pgsqlSchema::tableList<pgsqlSchema::PetstoreTables>();
+		if (!PQgetisnull(existing.get(), 0, 0)) {
+			truncateSQL += std::string(", ") + PQgetvalue(existing.get(), 0, 0);
+		}
+		truncateSQL += " RESTART IDENTITY CASCADE;";
+		pgsqlHandles::PgResult res = pgsqlHandles::PgResult::exec(conn_.get(), truncateSQL.c_str());
+		if (!res.ok()) {
+			std::cerr << "Failed to reset tables: " << res.errorMessage() << std::endl;
 			return false;
 		}
-		std::cout << "All tables dropped successfully." << std::endl;
 		return true;
 	}
 
@@ -98,92 +206,99 @@ namespace pgsqlDropDatabase {
 	// }
 
 	bool DatabaseDropManager::dropDatabase(const std::string& dbName, PGconn* superuser_conn) {
-		std::string terminateConnectionsSQL = "SELECT pg_terminate_backend(pg_stat_activity.pid) "
-		                                      "FROM pg_stat_activity "
-		                                      "WHERE pg_stat_activity.datname = '"
-		                                      + dbName
-		                                      + "' "
-		                                        "AND pid <> pg_backend_pid();";
-		PGresult* res = PQexec(superuser_conn, terminateConnectionsSQL.c_str());
-		if (PQresultStatus(res) != PGRES_COMMAND_OK) {
-			std::cerr << "Failed to terminate connections: " << PQerrorMessage(superuser_conn) << std::endl;
-			PQclear(res);
+		if (!executeDropDatabase(dbName, superuser_conn)) {
 			return false;
 		}
-		PQclear(res);
-
-		std::string dropDatabaseSQL = "DROP DATABASE IF EXISTS " + dbName + ";";
-		res = PQexec(superuser_conn, dropDatabaseSQL.c_str());
+		std::cout << "Database '" << dbName << "' dropped successfully." << std::endl;
+		return true;
+	}
 
-		if (PQresultStatus(res) != PGRES_COMMAND_OK) {
-			std::cerr << "Failed to drop database: " << PQerrorMessage(superuser_conn) << std::endl;
-			PQclear(res);
-			return false;
+	pgsqlProvisioning::ProvisionReport DatabaseDropManager::dropDatabases(
+	    const std::vector<std::string>& dbNames,
+	    const std::string& superUserConnInfo,
+	    const pgsqlProvisioning::ProvisionOptions& options) {
+		std::vector<pgsqlProvisioning::TenantSpec> targets;
+		targets.reserve(dbNames.size());
+		for (const std::string& dbName : dbNames) {
+			targets.push_back({dbName, "", ""});
 		}
 
-		PQclear(res);
-		std::cout << "Database '" << dbName << "' dropped successfully." << std::endl;
-		return true;
+		pgsqlProvisioning::ProvisionOptions pooled = options;
+		pooled.pooledConnInfo = superUserConnInfo;
+
+		// DROP DATABASE IF EXISTS is idempotent, so a retried database is simply dropped again or skipped
+		return pgsqlProvisioning::provisionTenants(
+		    targets,
+		    [&superUserConnInfo](const pgsqlProvisioning::TenantSpec& target) {
+			    pgsqlPool::PooledConnection conn = pgsqlPool::PgConnectionPool::instance().acquire(superUserConnInfo);
+			    if (!conn) {
+				    return false;
+			    }
+			    return executeDropDatabase(target.dbName, conn.get());
+		    },
+		    pooled);
+	}
+
+	std::vector<std::string> DatabaseDropManager::matchDatabases(PGconn* superuser_conn, const std::string& pattern) {
+		std::vector<std::string> dbNames;
+		pgsqlHandles::PgResult res =
+		    pgsqlPrepared::PreparedStatementRegistry::instance().execute(superuser_conn, listDatabasesStatement);
+		if (!res.ok()) {
+			std::cerr << "Failed to retrieve databases: " << res.errorMessage() << std::endl;
+			return dbNames;
+		}
+		for (pgsqlHandles::RowView row : res) {
+			if (pgsqlProvisioning::likeMatches(row[0], pattern)) {
+				dbNames.emplace_back(row[0]);
+			}
+		}
+		return dbNames;
 	}
 
 	// Private method to execute the drop table SQL commands
 	bool DatabaseDropManager::executeDrop(const char* dropSQL, const std::string& tableName) {
-		PGresult* res = PQexec(conn_, dropSQL);
-		if (PQresultStatus(res) != PGRES_COMMAND_OK) {
-			std::cerr << "Failed to drop " << tableName << " table: " << PQerrorMessage(conn_) << std::endl;
-			PQclear(res);
+		pgsqlHandles::PgResult res = pgsqlHandles::PgResult::exec(conn_.get(), dropSQL);
+		if (res.status() != PGRES_COMMAND_OK) {
+			std::cerr << "Failed to drop " << tableName << " table: " << PQerrorMessage(conn_.get()) << std::endl;
 			return false;
 		}
-		PQclear(res);
 		std::cout << tableName << " table dropped successfully." << std::endl;
 		return true;
 	}
 
 	PGconn* DatabaseDropManager::getConnection() const {
-		return conn_;
-	}
-
-	// Drop individual tables
-	bool DatabaseDropManager::dropProductsTable() {
-		return executeDrop("DROP TABLE IF EXISTS Products CASCADE;", "Products");
-	}
-
-	bool DatabaseDropManager::dropEmployeesTable() {
-		return executeDrop("DROP TABLE IF EXISTS Employees CASCADE;", "Employees");
-	}
-
-	bool DatabaseDropManager::dropOrdersTable() {
-		return executeDrop("DROP TABLE IF EXISTS Orders CASCADE;", "Orders");
-	}
-
-	bool DatabaseDropManager::dropOrderItemsTable() {
-		return executeDrop("DROP TABLE IF EXISTS Order_Items CASCADE;", "Order Items");
-	}
-
-	bool DatabaseDropManager::dropCustomersTable() {
-		return executeDrop("DROP TABLE IF EXISTS Customers CASCADE;", "Customers");
-	}
-
-	bool DatabaseDropManager::dropSuppliersTable() {
-		return executeDrop("DROP TABLE IF EXISTS Suppliers CASCADE;", "Suppliers");
-	}
-
-	bool DatabaseDropManager::dropInventoryActionsTable() {
-		return executeDrop("DROP TABLE IF EXISTS Inventory_Actions CASCADE;", "Inventory Actions");
+		return conn_.get();
 	}
 
 	void pgsqlDropMenuShow() {
 		std::cout << "\n==== PostgreSQL Database Drop Debug Menu ====" << std::endl;
 		std::cout << "1. Drop specific table" << std::endl;
 		std::cout << "2. Drop all tables" << std::endl;
-		std::cout << "3. Drop database" << std::endl;
-		std::cout << "4. Exit" << std::endl;
+		std::cout << "3. Reset all tables (keep schema)" << std::endl;
+		std::cout << "4. Drop database" << std::endl;
+		std::cout << "5. Drop databases matching a pattern" << std::endl;
+		std::cout << "6. Exit" << std::endl;
 		std::cout << "=============================================" << std::endl;
 		std::cout << "Enter your choice: ";
 	}
 
+	// Ask for superuser credentials and build the conninfo for the 'postgres' maintenance database
+	static std::string readSuperUserConnInfo() {
+		std::string superUserName, superUserPassword;
+		std::cout << "Enter superuser name (default is 'postgres'): ";
+		std::getline(std::cin, superUserName);
+		if (superUserName.empty()) {
+			superUserName = "postgres"; // default to postgres
+		}
+
+		std::cout << "Enter superuser password (leave blank for no password): ";
+		std::getline(std::cin, superUserPassword);
+
+		return pgsqlProfiles::ProfileRegistry::instance().conninfo("postgres", superUserName, superUserPassword);
+	}
+
 	void pgsqlDropManagementMenu() {
-		std::string dbName, userName, password, superUserName, superUserPassword, tableName;
+		std::string dbName, userName, password, tableName;
 		int choice;
 
 		std::cout << "Enter database name(Name of database operated on) : ";
@@ -210,29 +325,30 @@ namespace pgsqlDropDatabase {
 			switch (choice) {
 			case 1: { // Drop a specific table
 				// List all tables before asking for input
-				PGresult* res = PQexec(dbDropManager.getConnection(),
-				                       "SELECT tablename FROM pg_tables WHERE schemaname = 'public';");
-
-				if (PQresultStatus(res) != PGRES_TUPLES_OK) {
-					std::cerr << "Failed to retrieve tables: " << PQerrorMessage(dbDropManager.getConnection())
-					          << std::endl;
-					PQclear(res);
+				bool printedHeader = false;
+				pgsqlStream::StreamResult tables = pgsqlStream::streamQuery(
+				    dbDropManager.getConnection(),
+				    "SELECT tablename FROM pg_tables WHERE schemaname = 'public';",
+				    [&printedHeader](const pgsqlHandles::RowView& row) {
+					    if (!printedHeader) {
+						    std::cout << "\nAvailable tables:" << std::endl;
+						    printedHeader = true;
+					    }
+					    std::cout << "- " << row[0] << '\n';
+					    return true;
+				    });
+				std::cout.flush();
+
+				if (!tables.ok) {
+					std::cerr << "Failed to retrieve tables: " << tables.error << std::endl;
 					break;
 				}
 
-				int rows = PQntuples(res);
-				if (rows == 0) {
+				if (tables.rows == 0) {
 					std::cout << "No tables found in the current database." << std::endl;
-					PQclear(res);
 					break;
 				}
 
-				std::cout << "\nAvailable tables:" << std::endl;
-				for (int i = 0; i < rows; i++) {
-					std::cout << "- " << PQgetvalue(res, i, 0) << std::endl;
-				}
-				PQclear(res);
-
 				// Drop a specific table
 				std::cout << "\nEnter the table name to drop: ";
 				std::getline(std::cin, tableName);
@@ -256,45 +372,87 @@ namespace pgsqlDropDatabase {
 				break;
 			}
 			case 3: {
-				// Drop the database
-				std::cout << "Enter superuser name (default is 'postgres'): ";
-				std::getline(std::cin, superUserName);
-				if (superUserName.empty()) {
-					superUserName = "postgres"; // default to postgres
+				// Empty all tables but keep the schema
+				if (dbDropManager.resetAllTables()) {
+					std::cout << "All tables reset successfully." << std::endl;
 				}
-
-				std::cout << "Enter superuser password (leave blank for no password): ";
-				std::getline(std::cin, superUserPassword);
+				else {
+					std::cerr << "Failed to reset tables." << std::endl;
+				}
+				break;
+			}
+			case 4: {
+				// Drop the database
+				std::string conninfo = readSuperUserConnInfo();
 
 				std::cout << "Reconnecting to the 'postgres' database to drop the target database..." << std::endl;
 
-				// use postgres reconnect
-				std::string conninfo = "dbname=postgres user=" + superUserName + " host=localhost port=5432";
-				if (!superUserPassword.empty()) {
-					conninfo += " password=" + superUserPassword;
-				}
-
-				PGconn* superuser_conn = PQconnectdb(conninfo.c_str());
-				if (PQstatus(superuser_conn) != CONNECTION_OK) {
-					std::cerr << "Failed to connect to 'postgres' database: " << PQerrorMessage(superuser_conn)
-					          << std::endl;
-					PQfinish(superuser_conn);
+				pgsqlPool::PooledConnection superuser_conn = pgsqlPool::PgConnectionPool::instance().acquire(conninfo);
+				if (!superuser_conn) {
+					std::cerr << "Failed to connect to 'postgres' database." << std::endl;
 					return;
 				}
 
+				// Our own pooled connection to the target database would block the drop
+				dbDropManager.disconnect();
+
 				// Terminate all connections to 'store_db' and drop it
-				if (dbDropManager.dropDatabase(dbName, superuser_conn)) {
+				if (pgsqlDropDatabase::DatabaseDropManager::dropDatabase(dbName, superuser_conn.get())) {
 					std::cout << "Database '" << dbName << "' dropped successfully." << std::endl;
 				}
 				else {
 					std::cerr << "Failed to drop database '" << dbName << "'." << std::endl;
 				}
 
-				PQfinish(superuser_conn);
-
 				return; // exit after dropping the database
 			}
-			case 4: {
+			case 5: {
+				// Drop many databases at once, e.g. every load-test store
+				std::string pattern, answer;
+				pgsqlProvisioning::ProvisionOptions options;
+				std::string conninfo = readSuperUserConnInfo();
+
+				std::cout << "Enter database name pattern (SQL LIKE, e.g. store_%): ";
+				std::getline(std::cin, pattern);
+
+				std::cout << "Enter concurrency limit: ";
+				std::cin >> options.concurrency;
+				std::cin.ignore();
+
+				std::vector<std::string> targets;
+				{
+					pgsqlPool::PooledConnection superuser_conn =
+					    pgsqlPool::PgConnectionPool::instance().acquire(conninfo);
+					if (!superuser_conn) {
+						std::cerr << "Failed to connect to 'postgres' database." << std::endl;
+						break;
+					}
+					targets = pgsqlDropDatabase::DatabaseDropManager::matchDatabases(superuser_conn.get(), pattern);
+				}
+
+				if (targets.empty()) {
+					std::cout << "No databases match '" << pattern << "'." << std::endl;
+					break;
+				}
+				std::cout << "About to drop " << targets.size() << " databases:" << std::endl;
+				for (const std::string& target : targets) {
+					std::cout << "- " << target << std::endl;
+				}
+				std::cout << "Continue? (y/n): ";
+				std::getline(std::cin, answer);
+				if (answer != "y" && answer != "Y") {
+					break;
+				}
+
+				// The menu's own connection would be force-closed if its database is among the targets
+				dbDropManager.disconnect();
+
+				pgsqlProvisioning::ProvisionReport report =
+				    pgsqlDropDatabase::DatabaseDropManager::dropDatabases(targets, conninfo, options);
+				report.print(std::cout, "Dropped");
+				return;
+			}
+			case 6: {
 				// Exit
 				std::cout << "Exiting..." << std::endl;
 				return;
@@ -1,8 +1,12 @@
 #ifndef DATABASE_DROP_H
 #define DATABASE_DROP_H
 
+#include "pgsql_connection_pool.h"
+#include "pgsql_provisioning.h"
 #include <libpq-fe.h>
 #include <iostream>
+#include <string>
+#include <vector>
 
 namespace pgsqlDropDatabase {
 	class DatabaseDropManager {
@@ -10,36 +14,41 @@ namespace pgsqlDropDatabase {
 		// Constructor: Initializes the connection string with database, user, and password
 		DatabaseDropManager(const std::string& dbName, const std::string& userName, const std::string& Password);
 
-		// Destructor: Close the connection
-		~DatabaseDropManager();
-
-		// Connect to the database
+		// Borrow a connection to the database from the shared pool
 		bool connect();
 
-		// Drop all tables
+		// Close the borrowed connection
+		void disconnect();
+
+		// Drop all tables and the migration history in one statement, so it either fully happens or not at all
 		bool dropAllTables();
 
+		// Empty every table and restart its id sequence, keeping the schema; the fast way to reset a test database
+		bool resetAllTables();
+
 		// Drop a specific table
 		bool dropSpecificTable(const std::string& tableName);
 
-		// Drop a specific database
+		// Drop a specific database, forcing its sessions off the server
 		static bool dropDatabase(const std::string& dbName, PGconn* superuser_conn);
 
+		// Drop every database in dbNames in parallel; each worker borrows one superuser connection per
+		// database, and the superuser sub-pool is sized to options.concurrency
+		static pgsqlProvisioning::ProvisionReport dropDatabases(
+		    const std::vector<std::string>& dbNames,
+		    const std::string& superUserConnInfo,
+		    const pgsqlProvisioning::ProvisionOptions& options = {});
+
+		// Databases whose name matches a LIKE pattern such as "store_%" (see pgsqlProvisioning::likeMatches);
+		// never postgres or a template
+		static std::vector<std::string> matchDatabases(PGconn* superuser_conn, const std::string& pattern);
+
 		[[nodiscard]] PGconn* getConnection() const;
 
 	 private:
-		PGconn* conn_;
+		pgsqlPool::PooledConnection conn_;
 		std::string conninfo_;
 
-		// Drop individual tables
-		bool dropProductsTable();
-		bool dropEmployeesTable();
-		bool dropOrdersTable();
-		bool dropOrderItemsTable();
-		bool dropCustomersTable();
-		bool dropSuppliersTable();
-		bool dropInventoryActionsTable();
-
 		// Execute the drop statement for a table
 		bool executeDrop(const char* dropSQL, const std::string& tableName);
 	};
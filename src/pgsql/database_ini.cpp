@@ -1,259 +1,726 @@
 #include "database_ini.h"
 
+#include <atomic>
+#include <chrono>
+#include <iomanip>
+#include <optional>
+#include <thread>
+
 namespace pgsqlInitialization {
-	const char* createCustomersTableSQL = R"(
-	    CREATE TABLE IF NOT EXISTS Customers (
-	        customer_id SERIAL PRIMARY KEY,  -- Auto-incrementing unique identifier for each customer
-	        name TEXT NOT NULL,  -- Name of the customer
-	        phone_number TEXT NOT NULL,  -- Customer's phone number
-	        email TEXT NOT NULL,  -- Customer's email address
-	        address TEXT NOT NULL,  -- Customer's address
-	        is_deleted BOOLEAN DEFAULT FALSE  -- Soft delete flag, marks whether the customer is logically deleted
-	    );
-	)";
-
-	const char* createProductsTableSQL = R"(
-	    CREATE TABLE IF NOT EXISTS Products (
-	        product_id SERIAL PRIMARY KEY,  -- Auto-incrementing unique identifier for each product
-	        name TEXT NOT NULL,  -- Name of the product
-	        price NUMERIC(10, 2) NOT NULL,  -- Price of the product with two decimal precision
-	        stock INTEGER NOT NULL,  -- Current stock quantity of the product
-	        category TEXT,  -- Product category or classification
-	        is_deleted BOOLEAN DEFAULT FALSE  -- Soft delete flag, marks whether the product is logically deleted
-	    );
-	)";
-
-	const char* createEmployeesTableSQL = R"(
-	    CREATE TABLE IF NOT EXISTS Employees (
-	        employee_id SERIAL PRIMARY KEY,  -- Auto-incrementing unique identifier for each employee
-	        name TEXT NOT NULL,  -- Name of the employee
-	        position TEXT NOT NULL,  -- Job position of the employee
-	        hire_date DATE NOT NULL,  -- Date when the employee was hired
-	        contact_info TEXT,  -- Contact details of the employee
-	        is_deleted BOOLEAN DEFAULT FALSE  -- Soft delete flag, marks whether the employee is logically deleted
-	    );
-	)";
-
-	const char* createOrdersTableSQL = R"(
-	    CREATE TABLE IF NOT EXISTS Orders (
-	        order_id SERIAL PRIMARY KEY,  -- Auto-incrementing unique identifier for each order
-	        order_date DATE NOT NULL,  -- Date when the order was placed
-	        employee_id INTEGER,  -- Reference to the employee who handled the order (foreign key to Employees table)
-	        customer_id INTEGER,  -- Reference to the customer who placed the order (foreign key to Customers table)
-	        total NUMERIC(10, 2) NOT NULL,  -- Total amount of the order, with two decimal precision
-	        status TEXT NOT NULL,  -- Status of the order (e.g., pending, completed)
-	        is_deleted BOOLEAN DEFAULT FALSE,  -- Soft delete flag, marks whether the order is logically deleted
-	        FOREIGN KEY (employee_id) REFERENCES Employees(employee_id),  -- Foreign key to Employees table
-	        FOREIGN KEY (customer_id) REFERENCES Customers(customer_id)  -- Foreign key to Customers table
-	    );
-	)";
-
-	const char* createOrderItemsTableSQL = R"(
-	    CREATE TABLE IF NOT EXISTS Order_Items (
-	        order_item_id SERIAL PRIMARY KEY,  -- Auto-incrementing unique identifier for each order item
-	        order_id INTEGER NOT NULL,  -- Reference to the order (foreign key to Orders table)
-	        product_id INTEGER NOT NULL,  -- Reference to the product in the order (foreign key to Products table)
-	        quantity INTEGER NOT NULL,  -- Quantity of the product ordered
-	        price NUMERIC(10, 2) NOT NULL,  -- Price of the product at the time of order, with two decimal precision
-	        is_deleted BOOLEAN DEFAULT FALSE,  -- Soft delete flag, marks whether the order item is logically deleted
-	        FOREIGN KEY (order_id) REFERENCES Orders(order_id),  -- Foreign key to Orders table
-	        FOREIGN KEY (product_id) REFERENCES Products(product_id)  -- Foreign key to Products table
-	    );
-	)";
-
-	const char* createSuppliersTableSQL = R"(
-	    CREATE TABLE IF NOT EXISTS Suppliers (
-	        supplier_id SERIAL PRIMARY KEY,  -- Auto-incrementing unique identifier for each supplier
-	        name TEXT NOT NULL,  -- Name of the supplier
-	        contact_info TEXT,  -- Supplier's contact details
-	        product_id INTEGER,  -- Reference to the product supplied by this supplier (foreign key to Products table)
-	        is_deleted BOOLEAN DEFAULT FALSE,  -- Soft delete flag, marks whether the supplier is logically deleted
-	        FOREIGN KEY (product_id) REFERENCES Products(product_id)  -- Foreign key to Products table
-	    );
-	)";
-
-	const char* createInventoryActionsTableSQL = R"(
-	    CREATE TABLE IF NOT EXISTS Inventory_Actions (
-	        action_id SERIAL PRIMARY KEY,  -- Auto-incrementing unique identifier for each inventory action
-	        product_id INTEGER NOT NULL,  -- Reference to the product for the inventory action (foreign key to Products table)
-	        action_type TEXT NOT NULL,  -- Type of inventory action (e.g., inbound, outbound)
-	        quantity INTEGER NOT NULL,  -- Quantity of the inventory action
-	        action_date DATE NOT NULL,  -- Date when the inventory action took place
-	        is_deleted BOOLEAN DEFAULT FALSE,  -- Soft delete flag, marks whether the inventory action is logically deleted
-	        FOREIGN KEY (product_id) REFERENCES Products(product_id)  -- Foreign key to Products table
-	    );
-	)";
+	// Schema history of a store database. Append new steps at the end; never edit an applied one.
+	// Version 1 differs per layout, so a database is only ever migrated with the layout it was created with.
+	const std::vector<pgsqlMigrations::Migration>& petstoreMigrations(TableLayout layout) {
+		static const auto build = [](TableLayout layout) {
+			bool partitioned = layout == TableLayout::MonthlyPartitioned;
 
-	// Constructor that sets up connection information for the superuser
-	DatabaseInitializer::DatabaseInitializer(const std::string& superUserName, const std::string& superUserPassword) {
-		superUserConnInfo_ = "dbname=postgres user=" + superUserName + " host=localhost port=5432";
-		if (!superUserPassword.empty()) {
-			superUserConnInfo_ += " password=" + superUserPassword;
-		}
-		conn_ = nullptr; // Initialize the connection pointer to null
+			// The partition key must be part of every unique constraint, so partitioned tables get
+			// composite primary keys and nothing can reference them by their id alone
+			std::vector<std::string> partitionedTables;
+			if (partitioned) {
+				for (const pgsqlPartitions::PartitionedTable& table : pgsqlPartitions::petstorePartitionedTables()) {
+					partitionedTables.emplace_back(table.table);
+				}
+			}
+
+			// Version 1: every table from its descriptor, in foreign-key order
+			std::string createTables;
+			pgsqlSchema::forEachTable<pgsqlSchema::PetstoreTables>([&](auto table) {
+				using Table = decltype(table);
+				pgsqlSchema::DdlOptions options;
+				options.omitReferencesTo = partitionedTables;
+				for (const pgsqlPartitions::PartitionedTable& partitionedTable :
+				     pgsqlPartitions::petstorePartitionedTables())
+				{
+					if (partitioned && std::string(partitionedTable.table) == Table::name) {
+						options.partitionColumn = partitionedTable.column;
+					}
+				}
+				createTables += pgsqlSchema::createTableSQL<Table>(options) + "\n";
+			});
+			std::vector<pgsqlMigrations::Migration> steps = {
+			    {1, partitioned ? "create_core_tables_partitioned" : "create_core_tables", createTables},
+			};
+
+			// Versions 2-5: secondary index pack, built concurrently so live stores keep taking writes
+			auto indexes = pgsqlIndexes::indexMigrations(2, pgsqlIndexes::petstoreIndexPack(), partitionedTables);
+			steps.insert(steps.end(), indexes.begin(), indexes.end());
+
+			// Version 6: deleted_at stamping and the archive tables of the soft-delete purge
+			steps.push_back(
+			    {static_cast<int>(steps.size()) + 1, "soft_delete_archive", pgsqlPurge::softDeleteArchiveSQL()});
+			return steps;
+		};
+		static const std::vector<pgsqlMigrations::Migration> plain = build(TableLayout::Plain);
+		static const std::vector<pgsqlMigrations::Migration> monthly = build(TableLayout::MonthlyPartitioned);
+		return layout == TableLayout::MonthlyPartitioned ? monthly : plain;
 	}
 
-	// Destructor to close the PostgreSQL connection
-	DatabaseInitializer::~DatabaseInitializer() {
-		if (conn_) {
-			PQfinish(conn_);
-		}
+	// Layout of an existing store: partitioned when Orders is a partitioned table
+	static TableLayout detectLayout(PGconn* conn) {
+		pgsqlHandles::PgResult res = pgsqlHandles::PgResult::exec(
+		    conn, "SELECT 1 FROM pg_class WHERE oid = to_regclass('orders') AND relkind = 'p';");
+		return res.ok() && res.rows() > 0 ? TableLayout::MonthlyPartitioned : TableLayout::Plain;
 	}
 
-	// Method to establish a connection using the superuser credentials
+	const pgsqlPrepared::PreparedStatement databaseExistsStatement{
+	    "init_database_exists", "SELECT 1 FROM pg_database WHERE datname = $1;", {pgsqlPrepared::kTextOid}};
+
+	// No row when the database is missing; otherwise whether it carries the comment $2
+	const pgsqlPrepared::PreparedStatement databaseCommentStatement{
+	    "init_database_comment",
+	    "SELECT shobj_description(oid, 'pg_database') IS NOT DISTINCT FROM $2 FROM pg_database WHERE datname = $1;",
+	    {pgsqlPrepared::kTextOid, pgsqlPrepared::kTextOid}};
+
+	// Which halves of a tenant (role, database) already exist
+	const pgsqlPrepared::PreparedStatement tenantStateStatement{
+	    "init_tenant_state",
+	    "SELECT EXISTS (SELECT 1 FROM pg_roles WHERE rolname = $1), "
+	    "EXISTS (SELECT 1 FROM pg_database WHERE datname = $2);",
+	    {pgsqlPrepared::kTextOid, pgsqlPrepared::kTextOid}};
+
+	// Constructor that sets up connection information for the superuser
+	DatabaseInitializer::DatabaseInitializer(const std::string& superUserName, const std::string& superUserPassword)
+	: superUserName_(superUserName)
+	, superUserPassword_(superUserPassword) {
+		superUserConnInfo_ =
+		    pgsqlProfiles::ProfileRegistry::instance().conninfo("postgres", superUserName, superUserPassword);
+	}
+
+	// Method to check if a database exists, looked up in pg_database over the pooled superuser
+	// connection so that no connection is left pinned to the tenant database
 	bool DatabaseInitializer::checkDatabaseExists(const std::string& dbName) {
-		std::string conninfo = "dbname=" + dbName + " user=postgres host=localhost port=5432";
-		conn_ = PQconnectdb(conninfo.c_str());
+		pgsqlPool::PooledConnection conn = pgsqlPool::PgConnectionPool::instance().acquire(superUserConnInfo_);
+		if (!conn) {
+			return false;
+		}
 
-		if (PQstatus(conn_) != CONNECTION_OK) {
-			std::cerr << "Database does not exist: " << PQerrorMessage(conn_) << std::endl;
-			PQfinish(conn_);
+		pgsqlHandles::PgResult res =
+		    pgsqlPrepared::PreparedStatementRegistry::instance().execute(conn.get(), databaseExistsStatement, dbName);
+		if (res.status() != PGRES_TUPLES_OK) {
+			std::cerr << "Failed to look up database: " << PQerrorMessage(conn.get()) << std::endl;
 			return false;
 		}
 
-		PQfinish(conn_);
-		return true;
+		bool exists = res.rows() > 0;
+		if (!exists) {
+			std::cerr << "Database does not exist: " << dbName << std::endl;
+		}
+		return exists;
 	}
 
 	bool DatabaseInitializer::createUserAndDatabase(const std::string& dbName,
 	                                                const std::string& userName,
 	                                                const std::string& password) {
-		conn_ = PQconnectdb(superUserConnInfo_.c_str());
-		if (PQstatus(conn_) != CONNECTION_OK) {
-			std::cerr << "Connection to database failed: " << PQerrorMessage(conn_) << std::endl;
-			PQfinish(conn_);
+		return createUserAndDatabaseFrom(dbName, userName, password, "", true);
+	}
+
+	// The tenant role, a superuser of its own store
+	static std::vector<std::string> createRoleSQL(const std::string& userName, const std::string& password) {
+		return {"CREATE USER " + userName + " WITH ENCRYPTED PASSWORD '" + password + "';",
+		        "ALTER USER " + userName + " WITH SUPERUSER;"};
+	}
+
+	static std::string grantDatabaseSQL(const std::string& dbName, const std::string& userName) {
+		return "GRANT ALL PRIVILEGES ON DATABASE " + dbName + " TO " + userName + ";";
+	}
+
+	bool DatabaseInitializer::createUserAndDatabaseFrom(const std::string& dbName,
+	                                                    const std::string& userName,
+	                                                    const std::string& password,
+	                                                    const std::string& templateName,
+	                                                    bool createRole) {
+		pgsqlPool::PooledConnection conn = pgsqlPool::PgConnectionPool::instance().acquire(superUserConnInfo_);
+		if (!conn) {
+			return false;
+		}
+
+		std::string createDatabaseSQL = templateName.empty()
+		                                    ? "CREATE DATABASE " + dbName + ";"
+		                                    : "CREATE DATABASE " + dbName + " TEMPLATE " + templateName + ";";
+
+		// The role is created in the first segment, CREATE DATABASE refuses to run inside a transaction
+		// block so it gets a segment of its own, and the grant depends on the database existing. Each
+		// segment needs the one before it, so a failed one ends the batch: creating a database for a
+		// role that could not be created would leave a store nobody can log in to.
+		pgsqlPipeline::PipelineExecutor pipeline(conn.get(), true);
+		std::vector<const char*> failedStep;
+		if (createRole) {
+			for (const std::string& sql : createRoleSQL(userName, password)) {
+				pipeline.add(sql);
+			}
+			pipeline.sync();
+			failedStep = {"Failed to create user: ", "Failed to grant superuser privileges: "};
+		}
+		pipeline.add(createDatabaseSQL);
+		pipeline.sync();
+		pipeline.add(grantDatabaseSQL(dbName, userName));
+		failedStep.push_back("Failed to create database: ");
+		failedStep.push_back("Failed to grant privileges: ");
+
+		if (!pipeline.execute()) {
+			for (const pgsqlPipeline::StatementError& error : pipeline.errors()) {
+				if (!error.aborted) {
+					std::cerr << (error.index < failedStep.size() ? failedStep[error.index] : "") << error.message
+					          << std::endl;
+				}
+			}
+			return false;
+		}
+
+		return true;
+	}
+
+	// Method to initialize tables in the database
+	bool DatabaseInitializer::initializeTables(const std::string& dbName,
+	                                           const std::string& userName,
+	                                           const std::string& password,
+	                                           TableLayout layout,
+	                                           bool ephemeral) {
+		// Partitioned parents cannot be UNLOGGED, and logged partitions could not reference unlogged tables
+		if (ephemeral && layout == TableLayout::MonthlyPartitioned) {
+			std::cerr << "Ephemeral tables are only supported with the plain layout." << std::endl;
 			return false;
 		}
 
-		// SQL statements to create the user and database
-		std::string createUserSQL = "CREATE USER " + userName + " WITH ENCRYPTED PASSWORD '" + password + "';";
-		std::string createDatabaseSQL = "CREATE DATABASE " + dbName + ";";
-		std::string grantPrivilegesSQL = "GRANT ALL PRIVILEGES ON DATABASE " + dbName + " TO " + userName + ";";
-		std::string alterUserToSuperUserSQL = "ALTER USER " + userName + " WITH SUPERUSER;"; // grant to super user
+		std::string conninfo = pgsqlProfiles::ProfileRegistry::instance().conninfo(dbName, userName, password);
 
-		// Execute user creation
-		PGresult* res = PQexec(conn_, createUserSQL.c_str());
-		if (PQresultStatus(res) != PGRES_COMMAND_OK) {
-			std::cerr << "Failed to create user: " << PQerrorMessage(conn_) << std::endl;
-			PQclear(res);
-			PQfinish(conn_);
+		pgsqlPool::PooledConnection conn = pgsqlPool::PgConnectionPool::instance().acquire(conninfo);
+		if (!conn) {
 			return false;
 		}
-		PQclear(res);
 
-		// Execute database creation
-		res = PQexec(conn_, createDatabaseSQL.c_str());
-		if (PQresultStatus(res) != PGRES_COMMAND_OK) {
-			std::cerr << "Failed to create database: " << PQerrorMessage(conn_) << std::endl;
-			PQclear(res);
-			PQfinish(conn_);
+		// Grant all privileges on the public schema to the user, then apply the migrations this
+		// database has not seen yet; an up-to-date database costs one catalog lookup
+		pgsqlHandles::PgResult grant = pgsqlHandles::PgResult::exec(
+		    conn.get(), ("GRANT ALL PRIVILEGES ON SCHEMA public TO " + userName + ";").c_str());
+		bool ok = grant.ok();
+		if (!ok) {
+			std::cerr << "Failed to grant schema privileges: " << grant.errorMessage() << std::endl;
+		}
+		else {
+			pgsqlMigrations::MigrationResult result =
+			    pgsqlMigrations::migrate(conn.get(), petstoreMigrations(layout));
+			ok = result.ok;
+			if (!ok) {
+				std::cerr << "Failed to migrate " << dbName << ": " << result.error << std::endl;
+			}
+		}
+
+		// Converted after the migrations rather than created UNLOGGED, so an ephemeral store shares the
+		// migration history (and checksums) of a regular one. Only an empty store is converted, where the
+		// rewrite is free; a store that already holds data keeps its logged tables, since a crash would
+		// truncate them once unlogged. Re-initializing an ephemeral store finds nothing left to convert.
+		if (ok && ephemeral) {
+			pgsqlHandles::PgResult state = pgsqlHandles::PgResult::exec(
+			    conn.get(), pgsqlSchema::persistenceCheckSQL<pgsqlSchema::PetstoreTables>().c_str());
+			ok = state.ok() && state.rows() == 1;
+			if (!ok) {
+				std::cerr << "Failed to inspect the tables of " << dbName << ": " << state.errorMessage() << std::endl;
+			}
+			else if (state[0].get<bool>(0) && state[0].get<bool>(1)) {
+				std::cerr << dbName << " already holds data; its tables stay logged. Use a new database for an "
+				          << "ephemeral store." << std::endl;
+				ok = false;
+			}
+			else if (state[0].get<bool>(0)) {
+				pgsqlHandles::PgResult unlogged = pgsqlHandles::PgResult::exec(
+				    conn.get(), pgsqlSchema::setLoggedSQL<pgsqlSchema::PetstoreTables>(false).c_str());
+				ok = unlogged.ok();
+				if (!ok) {
+					std::cerr << "Failed to make tables unlogged in " << dbName << ": " << unlogged.errorMessage()
+					          << std::endl;
+				}
+			}
+		}
+
+		// A partitioned parent accepts no rows until the partitions for the current months exist
+		if (ok && layout == TableLayout::MonthlyPartitioned) {
+			pgsqlPartitions::MaintenanceResult partitions = pgsqlPartitions::runMaintenance(conn.get());
+			ok = partitions.ok;
+			if (!ok) {
+				std::cerr << "Failed to create partitions in " << dbName << ": " << partitions.error << std::endl;
+			}
+		}
+
+		// Each tenant database is initialized once; keeping its connection idle in the pool would
+		// pin one server backend per store when many stores are provisioned
+		conn.discard();
+		return ok;
+	}
+
+	bool DatabaseInitializer::buildTemplateDatabase(bool rebuild) {
+		pgsqlPool::PooledConnection conn = pgsqlPool::PgConnectionPool::instance().acquire(superUserConnInfo_);
+		if (!conn) {
 			return false;
 		}
-		PQclear(res);
 
-		// Grant privileges
-		res = PQexec(conn_, grantPrivilegesSQL.c_str());
-		if (PQresultStatus(res) != PGRES_COMMAND_OK) {
-			std::cerr << "Failed to grant privileges: " << PQerrorMessage(conn_) << std::endl;
-			PQclear(res);
-			PQfinish(conn_);
+		pgsqlHandles::PgResult existing =
+		    pgsqlPrepared::PreparedStatementRegistry::instance().execute(conn.get(),
+		                                                                 databaseCommentStatement,
+		                                                                 std::string(kTemplateDatabaseName),
+		                                                                 std::string(kTemplateCompleteComment));
+		if (existing.status() != PGRES_TUPLES_OK) {
+			std::cerr << "Failed to look up template database: " << PQerrorMessage(conn.get()) << std::endl;
 			return false;
 		}
-		PQclear(res);
+		std::string name = kTemplateDatabaseName;
+		if (existing.rows() > 0) {
+			bool complete = existing[0].get<bool>(0);
+			if (complete && !rebuild) {
+				std::cout << "Template database " << name << " already exists." << std::endl;
+				return true;
+			}
+			if (!complete) {
+				std::cout << "Template database " << name << " is incomplete, rebuilding it." << std::endl;
+			}
+
+			// A template cannot be dropped until it is demoted to an ordinary database
+			pgsqlPipeline::PipelineExecutor drop(conn.get());
+			drop.add("ALTER DATABASE " + name + " WITH IS_TEMPLATE false;");
+			drop.sync();
+			drop.add("DROP DATABASE " + name + ";");
+			if (!drop.execute()) {
+				std::cerr << "Failed to drop old template: " << drop.firstError()->message << std::endl;
+				return false;
+			}
+		}
 
-		// Alter user to superuser
-		res = PQexec(conn_, alterUserToSuperUserSQL.c_str());
-		if (PQresultStatus(res) != PGRES_COMMAND_OK) {
-			std::cerr << "Failed to grant superuser privileges: " << PQerrorMessage(conn_) << std::endl;
-			PQclear(res);
-			PQfinish(conn_);
+		pgsqlHandles::PgResult created =
+		    pgsqlHandles::PgResult::exec(conn.get(), ("CREATE DATABASE " + name + ";").c_str());
+		if (!created.ok()) {
+			std::cerr << "Failed to create template database: " << created.errorMessage() << std::endl;
 			return false;
 		}
-		PQclear(res);
 
-		PQfinish(conn_);
+		// Create the tables in the template as the superuser. The connection is discarded rather than
+		// pooled: CREATE DATABASE ... TEMPLATE fails while any session is connected to the template.
+		{
+			pgsqlPool::PooledConnection templateConn = pgsqlPool::PgConnectionPool::instance().acquire(
+			    pgsqlProfiles::ProfileRegistry::instance().conninfo(name, superUserName_, superUserPassword_));
+			if (!templateConn) {
+				return false;
+			}
+
+			// Clones inherit schema_migrations and its fingerprint, so they start on the fast path
+			pgsqlMigrations::MigrationResult result =
+			    pgsqlMigrations::migrate(templateConn.get(), petstoreMigrations());
+			bool ok = result.ok;
+			if (!ok) {
+				std::cerr << "Failed to migrate template database: " << result.error << std::endl;
+			}
+			templateConn.discard();
+			if (!ok) {
+				return false;
+			}
+		}
+
+		// Mark it as a template and keep sessions out so cloning never waits on a stray connection
+		pgsqlHandles::PgResult marked = pgsqlHandles::PgResult::exec(
+		    conn.get(), ("ALTER DATABASE " + name + " WITH IS_TEMPLATE true ALLOW_CONNECTIONS false;").c_str());
+		if (!marked.ok()) {
+			std::cerr << "Failed to mark template database: " << marked.errorMessage() << std::endl;
+			return false;
+		}
+
+		// Last, so a build that stopped anywhere above leaves a template the next build replaces
+		std::string completeSQL =
+		    "COMMENT ON DATABASE " + name + " IS '" + std::string(kTemplateCompleteComment) + "';";
+		pgsqlHandles::PgResult completed = pgsqlHandles::PgResult::exec(conn.get(), completeSQL.c_str());
+		if (!completed.ok()) {
+			std::cerr << "Failed to mark template database complete: " << completed.errorMessage() << std::endl;
+			return false;
+		}
+
+		std::cout << "Template database " << name << " built successfully." << std::endl;
 		return true;
 	}
 
-	// Method to initialize tables in the database
-	bool DatabaseInitializer::initializeTables(const std::string& dbName,
-	                                           const std::string& userName,
-	                                           const std::string& password) {
-		std::string conninfo = "dbname=" + dbName + " user=" + userName + " host=localhost port=5432";
-		if (!password.empty()) {
-			conninfo += " password=" + password;
+	bool DatabaseInitializer::createDatabaseFromTemplate(const std::string& dbName,
+	                                                     const std::string& userName,
+	                                                     const std::string& password) {
+		return createUserAndDatabaseFrom(dbName, userName, password, kTemplateDatabaseName, true)
+		       && grantTemplateObjects(dbName, userName);
+	}
+
+	// Creates the role when createRole is set and grants it the database again, for a store whose
+	// database outlived an earlier, failed attempt
+	bool DatabaseInitializer::grantTenantRole(const std::string& dbName,
+	                                          const std::string& userName,
+	                                          const std::string& password,
+	                                          bool createRole) {
+		pgsqlPool::PooledConnection conn = pgsqlPool::PgConnectionPool::instance().acquire(superUserConnInfo_);
+		if (!conn) {
+			return false;
 		}
 
-		conn_ = PQconnectdb(conninfo.c_str());
-		if (PQstatus(conn_) != CONNECTION_OK) {
-			std::cerr << "Connection to database failed: " << PQerrorMessage(conn_) << std::endl;
-			PQfinish(conn_);
+		pgsqlPipeline::PipelineExecutor pipeline(conn.get(), true);
+		if (createRole) {
+			for (const std::string& sql : createRoleSQL(userName, password)) {
+				pipeline.add(sql);
+			}
+			pipeline.sync();
+		}
+		pipeline.add(grantDatabaseSQL(dbName, userName));
+		if (!pipeline.execute()) {
+			std::cerr << "Failed to set up the role of " << dbName << ": " << pipeline.firstError()->message
+			          << std::endl;
 			return false;
 		}
+		return true;
+	}
 
-		// Grant all privileges on the public schema to the user
-		std::string grantPublicSchemaPrivilegesSQL = "GRANT ALL PRIVILEGES ON SCHEMA public TO " + userName + ";";
-		PGresult* res = PQexec(conn_, grantPublicSchemaPrivilegesSQL.c_str());
-		if (PQresultStatus(res) != PGRES_COMMAND_OK) {
-			std::cerr << "Failed to grant schema privileges: " << PQerrorMessage(conn_) << std::endl;
-			PQclear(res);
-			PQfinish(conn_);
+	// The cloned tables belong to the template's owner, so the tenant role gets explicit grants.
+	// This runs once per new store; the connection is not kept in the pool afterwards.
+	bool DatabaseInitializer::grantTemplateObjects(const std::string& dbName, const std::string& userName) {
+		pgsqlPool::PooledConnection conn = pgsqlPool::PgConnectionPool::instance().acquire(
+		    pgsqlProfiles::ProfileRegistry::instance().conninfo(dbName, superUserName_, superUserPassword_));
+		if (!conn) {
 			return false;
 		}
-		PQclear(res);
-
-		const char* createTableSQL[] = {createCustomersTableSQL,
-		                                createProductsTableSQL,
-		                                createEmployeesTableSQL,
-		                                createOrdersTableSQL,
-		                                createOrderItemsTableSQL,
-		                                createSuppliersTableSQL,
-		                                createInventoryActionsTableSQL};
-
-		for (const char* sql : createTableSQL) {
-			PGresult* res = PQexec(conn_, sql);
-			if (PQresultStatus(res) != PGRES_COMMAND_OK) {
-				std::cerr << "Failed to create table: " << PQerrorMessage(conn_) << std::endl;
-				PQclear(res);
-				PQfinish(conn_);
-				return false;
+
+		pgsqlPipeline::PipelineExecutor pipeline(conn.get());
+		pipeline.add("GRANT ALL PRIVILEGES ON SCHEMA public TO " + userName + ";");
+		pipeline.add("GRANT ALL PRIVILEGES ON ALL TABLES IN SCHEMA public TO " + userName + ";");
+		pipeline.add("GRANT ALL PRIVILEGES ON ALL SEQUENCES IN SCHEMA public TO " + userName + ";");
+		bool ok = pipeline.execute();
+		if (!ok) {
+			std::cerr << "Failed to grant tenant privileges: " << pipeline.firstError()->message << std::endl;
+		}
+		conn.discard();
+		return ok;
+	}
+
+	bool DatabaseInitializer::lookupTenant(const std::string& dbName,
+	                                       const std::string& userName,
+	                                       bool& roleExists,
+	                                       bool& databaseExists) {
+		pgsqlPool::PooledConnection conn = pgsqlPool::PgConnectionPool::instance().acquire(superUserConnInfo_);
+		if (!conn) {
+			return false;
+		}
+
+		pgsqlHandles::PgResult res = pgsqlPrepared::PreparedStatementRegistry::instance().execute(
+		    conn.get(), tenantStateStatement, userName, dbName);
+		if (res.status() != PGRES_TUPLES_OK || res.rows() != 1) {
+			std::cerr << "Failed to look up tenant " << dbName << ": " << PQerrorMessage(conn.get()) << std::endl;
+			return false;
+		}
+		roleExists = res[0].get<bool>(0);
+		databaseExists = res[0].get<bool>(1);
+		return true;
+	}
+
+	bool DatabaseInitializer::provisionStore(const std::string& dbName,
+	                                         const std::string& userName,
+	                                         const std::string& password,
+	                                         bool fromTemplate) {
+		bool roleExists = false;
+		bool databaseExists = false;
+		if (!lookupTenant(dbName, userName, roleExists, databaseExists)) {
+			return false;
+		}
+
+		std::string templateName = fromTemplate ? kTemplateDatabaseName : "";
+		bool ready = databaseExists ? grantTenantRole(dbName, userName, password, !roleExists)
+		                            : createUserAndDatabaseFrom(dbName, userName, password, templateName, !roleExists);
+		if (!ready) {
+			return false;
+		}
+
+		// The remaining steps are idempotent (GRANTs, and migrations that skip what is applied), so they
+		// run for an existing database as well and repair one an earlier attempt left half set up. A
+		// clone is migrated too, in case the template predates the latest migrations.
+		if (fromTemplate) {
+			return migrateDatabase(dbName) && grantTemplateObjects(dbName, userName);
+		}
+		return initializeTables(dbName, userName, password);
+	}
+
+	bool DatabaseInitializer::migrateDatabase(const std::string& dbName) {
+		pgsqlPool::PooledConnection conn = pgsqlPool::PgConnectionPool::instance().acquire(
+		    pgsqlProfiles::ProfileRegistry::instance().conninfo(dbName, superUserName_, superUserPassword_));
+		if (!conn) {
+			return false;
+		}
+
+		// Partitioned stores also get their partitions rolled forward
+		TableLayout layout = detectLayout(conn.get());
+		pgsqlMigrations::MigrationResult result = pgsqlMigrations::migrate(conn.get(), petstoreMigrations(layout));
+		pgsqlPartitions::MaintenanceResult partitions;
+		if (result.ok && layout == TableLayout::MonthlyPartitioned) {
+			partitions = pgsqlPartitions::runMaintenance(conn.get());
+		}
+		conn.discard(); // Fleet upgrades touch every store once; do not pin a backend per store
+		if (!result.ok) {
+			std::cerr << "Failed to migrate " << dbName << ": " << result.error << std::endl;
+			return false;
+		}
+		if (layout == TableLayout::MonthlyPartitioned && !partitions.ok) {
+			std::cerr << "Failed to maintain partitions in " << dbName << ": " << partitions.error << std::endl;
+			return false;
+		}
+		return true;
+	}
+
+	bool DatabaseInitializer::promoteDatabase(const std::string& dbName) {
+		pgsqlPool::PooledConnection conn = pgsqlPool::PgConnectionPool::instance().acquire(
+		    pgsqlProfiles::ProfileRegistry::instance().conninfo(dbName, superUserName_, superUserPassword_));
+		if (!conn) {
+			return false;
+		}
+
+		// SET LOGGED on a table that already is logged is a no-op, so a partly promoted store can be promoted again
+		pgsqlHandles::PgResult res = pgsqlHandles::PgResult::exec(
+		    conn.get(), pgsqlSchema::setLoggedSQL<pgsqlSchema::PetstoreTables>(true).c_str());
+		conn.discard();
+		if (!res.ok()) {
+			std::cerr << "Failed to promote " << dbName << ": " << res.errorMessage() << std::endl;
+			return false;
+		}
+		return true;
+	}
+
+	pgsqlCopy::ImportStats DatabaseInitializer::importCsv(const std::string& dbName,
+	                                                      const std::string& tableName,
+	                                                      const std::string& path,
+	                                                      const pgsqlCopy::ImportOptions& options) {
+		pgsqlPool::PooledConnection conn = pgsqlPool::PgConnectionPool::instance().acquire(
+		    pgsqlProfiles::ProfileRegistry::instance().conninfo(dbName, superUserName_, superUserPassword_));
+		if (!conn) {
+			pgsqlCopy::ImportStats stats;
+			stats.table = tableName;
+			stats.error = "cannot connect to " + dbName;
+			return stats;
+		}
+
+		pgsqlCopy::ImportStats stats = pgsqlCopy::importStoreTable(conn.get(), tableName, path, options);
+		conn.discard(); // Onboarding loads a store once; do not keep a backend pinned to it
+		return stats;
+	}
+
+	std::vector<pgsqlSync::SyncStats> DatabaseInitializer::syncCatalog(const std::string& dbName,
+	                                                                  const std::string& productsPath,
+	                                                                  const std::string& suppliersPath,
+	                                                                  const pgsqlSync::SyncOptions& options) {
+		pgsqlPool::PooledConnection conn = pgsqlPool::PgConnectionPool::instance().acquire(
+		    pgsqlProfiles::ProfileRegistry::instance().conninfo(dbName, superUserName_, superUserPassword_));
+		if (!conn) {
+			pgsqlSync::SyncStats stats;
+			stats.table = dbName;
+			stats.error = "cannot connect to " + dbName;
+			return {stats};
+		}
+
+		std::vector<pgsqlSync::SyncStats> stats =
+		    pgsqlSync::syncCatalog(conn.get(), productsPath, suppliersPath, options);
+		conn.discard(); // A daily job; do not keep a backend pinned to the store
+		return stats;
+	}
+
+	// "<lsn> <table> <kind> <key column>=<key>"; a Delete only carries the key
+	template<typename Table>
+	static void printChange(const pgsqlCdc::ChangeEvent& event, const pgsqlCdc::Change<Table>& change) {
+		const auto& key = std::get<0>(Table::columns);
+		std::cout << pgsqlCdc::formatLsn(event.lsn) << " " << Table::name << " "
+		          << pgsqlCdc::changeKindName(change.kind);
+		if (change.kind != pgsqlCdc::ChangeKind::Truncate) {
+			std::cout << " " << key.name << "=" << change.row.*key.member;
+		}
+		std::cout << std::endl;
+	}
+
+	bool DatabaseInitializer::watchChanges(const std::string& dbName, bool dropSlot) {
+		pgsqlCdc::CdcConsumer consumer(
+		    pgsqlProfiles::ProfileRegistry::instance().conninfo(dbName, superUserName_, superUserPassword_));
+		std::string error;
+		if (!consumer.setup(error)) {
+			std::cerr << "Cannot capture changes of " << dbName << ": " << error << std::endl;
+			return false;
+		}
+		consumer.subscribe([](const pgsqlCdc::ChangeEvent& event) {
+			std::visit([&](const auto& change) { printChange(event, change); }, event.change);
+		});
+
+		std::atomic<bool> stop{false};
+		bool ok = true;
+		std::thread streamer([&] { ok = consumer.run(stop, error); });
+		std::cout << "Watching " << dbName << "; press Enter to stop." << std::endl;
+		std::string line;
+		std::getline(std::cin, line);
+		stop = true;
+		streamer.join();
+
+		if (!ok) {
+			std::cerr << "Change stream of " << dbName << " failed: " << error << std::endl;
+		}
+		std::cout << "Acknowledged up to " << pgsqlCdc::formatLsn(consumer.acknowledged()) << std::endl;
+		if (dropSlot && !consumer.dropSlot(error)) {
+			std::cerr << "Cannot drop the replication slot: " << error << std::endl;
+			return false;
+		}
+		return ok;
+	}
+
+	pgsqlDump::ArchiveReport DatabaseInitializer::dumpStore(const std::string& dbName,
+	                                                        const std::string& directory,
+	                                                        const pgsqlDump::DumpOptions& options) {
+		return pgsqlDump::dumpDatabase(
+		    pgsqlProfiles::ProfileRegistry::instance().conninfo(dbName, superUserName_, superUserPassword_),
+		    directory,
+		    options);
+	}
+
+	pgsqlDump::ArchiveReport DatabaseInitializer::restoreStore(const std::string& dbName,
+	                                                           const std::string& directory,
+	                                                           const pgsqlDump::RestoreOptions& options) {
+		return pgsqlDump::restoreDatabase(
+		    pgsqlProfiles::ProfileRegistry::instance().conninfo(dbName, superUserName_, superUserPassword_),
+		    directory,
+		    options);
+	}
+
+	pgsqlPurge::PurgeReport DatabaseInitializer::purgeSoftDeleted(const std::string& dbName,
+	                                                              const pgsqlPurge::PurgeOptions& options) {
+		pgsqlPurge::PurgeJob job(
+		    pgsqlProfiles::ProfileRegistry::instance().conninfo(dbName, superUserName_, superUserPassword_), options);
+		job.start();
+		while (job.progress().running) {
+			std::this_thread::sleep_for(std::chrono::seconds(1));
+			pgsqlPurge::PurgeProgress progress = job.progress();
+			if (!progress.table.empty()) {
+				std::cout << progress.table << ": " << progress.moved << " rows archived, " << std::fixed
+				          << std::setprecision(0) << progress.rowsPerSecond() << " rows/s, batches of "
+				          << progress.batchRows << std::endl;
 			}
-			PQclear(res);
+		}
+		return job.wait();
+	}
+
+	pgsqlSnapshot::ExportStats DatabaseInitializer::exportSnapshot(const std::string& dbName,
+	                                                               const std::string& tableName,
+	                                                               const std::string& path) {
+		pgsqlPool::PooledConnection conn = pgsqlPool::PgConnectionPool::instance().acquire(
+		    pgsqlProfiles::ProfileRegistry::instance().conninfo(dbName, superUserName_, superUserPassword_));
+		if (!conn) {
+			pgsqlSnapshot::ExportStats stats;
+			stats.table = tableName;
+			stats.error = "cannot connect to " + dbName;
+			return stats;
+		}
+
+		pgsqlSnapshot::ExportStats stats = pgsqlSnapshot::exportStoreTable(conn.get(), tableName, path);
+		conn.discard();
+		return stats;
+	}
+
+	bool DatabaseInitializer::maintainPartitions(const std::string& dbName,
+	                                             const pgsqlPartitions::MaintenancePolicy& policy) {
+		pgsqlPool::PooledConnection conn = pgsqlPool::PgConnectionPool::instance().acquire(
+		    pgsqlProfiles::ProfileRegistry::instance().conninfo(dbName, superUserName_, superUserPassword_));
+		if (!conn) {
+			return false;
 		}
 
-		PQfinish(conn_);
-		std::cout << "Tables initialized successfully." << std::endl;
+		pgsqlPartitions::MaintenanceResult result = pgsqlPartitions::runMaintenance(conn.get(), policy);
+		if (!result.ok) {
+			std::cerr << "Failed to maintain partitions in " << dbName << ": " << result.error << std::endl;
+			return false;
+		}
+		std::cout << "Created " << result.created << " partitions, detached " << result.detached << "." << std::endl;
 		return true;
 	}
 
+	std::vector<std::string> DatabaseInitializer::listStoreDatabases() {
+		std::vector<std::string> stores;
+		pgsqlPool::PooledConnection conn = pgsqlPool::PgConnectionPool::instance().acquire(superUserConnInfo_);
+		if (!conn) {
+			return stores;
+		}
+
+		pgsqlHandles::PgResult res = pgsqlHandles::PgResult::exec(
+		    conn.get(),
+		    "SELECT datname FROM pg_database WHERE NOT datistemplate AND datallowconn AND datname <> 'postgres';");
+		if (!res.ok()) {
+			std::cerr << "Failed to retrieve databases: " << res.errorMessage() << std::endl;
+			return stores;
+		}
+		for (pgsqlHandles::RowView row : res) {
+			stores.emplace_back(row[0]);
+		}
+		return stores;
+	}
+
+	// One short query per store. The async engine keeps a whole wave of them in flight from a single
+	// event-loop thread; each wave gets its own engine, so its connections are closed before the next
+	// one opens and a large fleet never holds more than kWave connections.
+	void DatabaseInitializer::listSchemaVersions() {
+		constexpr std::size_t kWave = 64;
+		int latest = petstoreMigrations().back().version;
+		std::vector<std::string> stores = listStoreDatabases();
+		for (std::size_t first = 0; first < stores.size(); first += kWave) {
+			pgsqlAsync::EngineOptions options;
+			options.maxConnectionsPerTarget = 1;
+			pgsqlAsync::AsyncEngine engine(options);
+			if (!engine.start()) {
+				return;
+			}
+
+			std::size_t last = std::min(stores.size(), first + kWave);
+			std::vector<std::future<pgsqlAsync::QueryResult>> versions;
+			for (std::size_t i = first; i < last; ++i) {
+				versions.push_back(engine.submit(
+				    pgsqlProfiles::ProfileRegistry::instance().conninfo(stores[i], superUserName_, superUserPassword_),
+				    "SELECT max(version) FROM schema_migrations;"));
+			}
+			for (std::size_t i = first; i < last; ++i) {
+				pgsqlAsync::QueryResult version = versions[i - first].get();
+				std::cout << "  " << std::left << std::setw(32) << stores[i] << std::right;
+				if (!version.ok()) {
+					std::cout << "error: " << version.error;
+					if (version.error.back() != '\n') {
+						std::cout << "\n";
+					}
+					continue;
+				}
+				std::optional<int> applied;
+				if (version.result.rows() == 1) {
+					applied = version.result[0].getOptional<int>(0);
+				}
+				if (!applied) {
+					std::cout << "no migrations applied\n";
+					continue;
+				}
+				std::cout << "v" << *applied;
+				if (*applied < latest) {
+					std::cout << " (" << latest - *applied << " behind v" << latest << ")";
+				}
+				std::cout << "\n";
+			}
+		}
+		std::cout << std::flush;
+	}
+
 	void DatabaseInitializer::listDatabases() {
-		conn_ = PQconnectdb(superUserConnInfo_.c_str());
-		if (PQstatus(conn_) != CONNECTION_OK) {
-			std::cerr << "Connection to database failed: " << PQerrorMessage(conn_) << std::endl;
-			PQfinish(conn_);
+		pgsqlPool::PooledConnection conn = pgsqlPool::PgConnectionPool::instance().acquire(superUserConnInfo_);
+		if (!conn) {
 			return;
 		}
 
 		// Query to get the list of databases
 		const char* query = "SELECT datname FROM pg_database WHERE datistemplate = false;";
-		PGresult* res = PQexec(conn_, query);
 
-		if (PQresultStatus(res) != PGRES_TUPLES_OK) {
-			std::cerr << "Failed to retrieve databases: " << PQerrorMessage(conn_) << std::endl;
-			PQclear(res);
-			PQfinish(conn_);
-			return;
-		}
-
-		// Print the list of databases
-		int rows = PQntuples(res);
+		// Print the list of databases as rows arrive
 		std::cout << "\nCurrent databases:\n";
-		for (int i = 0; i < rows; i++) {
-			std::cout << "- " << PQgetvalue(res, i, 0) << std::endl;
-		}
+		pgsqlStream::StreamResult result =
+		    pgsqlStream::streamQuery(conn.get(), query, [](const pgsqlHandles::RowView& row) {
+			    std::cout << "- " << row[0] << '\n';
+			    return true;
+		    });
+		std::cout.flush();
 
-		PQclear(res);
-		PQfinish(conn_);
+		if (!result.ok) {
+			std::cerr << "Failed to retrieve databases: " << result.error << std::endl;
+		}
 	}
 
 	void pgsqlInitializationMenuShow() {
@@ -262,7 +729,22 @@ namespace pgsqlInitialization {
 		std::cout << "2. Create User and Database" << std::endl;
 		std::cout << "3. Initialize Tables" << std::endl;
 		std::cout << "4. List Databases" << std::endl;
-		std::cout << "5. Exit" << std::endl;
+		std::cout << "5. Build Store Template Database" << std::endl;
+		std::cout << "6. Create Store From Template" << std::endl;
+		std::cout << "7. Provision Stores From Manifest" << std::endl;
+		std::cout << "8. Migrate All Store Databases" << std::endl;
+		std::cout << "9. Run Partition Maintenance" << std::endl;
+		std::cout << "10. Promote Ephemeral Store To Logged Tables" << std::endl;
+		std::cout << "11. Import CSV Into Store Table" << std::endl;
+		std::cout << "12. Export Table Snapshot" << std::endl;
+		std::cout << "13. Inspect Snapshot File" << std::endl;
+		std::cout << "14. Sync Supplier Catalog Feed" << std::endl;
+		std::cout << "15. Watch Order And Stock Changes" << std::endl;
+		std::cout << "16. Dump Store Archive" << std::endl;
+		std::cout << "17. Restore Store Archive" << std::endl;
+		std::cout << "18. Archive Old Soft-Deleted Rows" << std::endl;
+		std::cout << "19. Show Schema Version Of Every Store" << std::endl;
+		std::cout << "20. Exit" << std::endl;
 		std::cout << "========================================" << std::endl;
 		std::cout << "Enter your choice: ";
 	}
@@ -341,7 +823,21 @@ namespace pgsqlInitialization {
 				std::cout << "Enter password for user (leave blank if none): ";
 				std::cin >> password;
 
-				if (dbInitializer.initializeTables(dbName, userName, password)) {
+				std::string answer;
+				std::cout << "Partition Orders and Inventory_Actions by month? (y/n): ";
+				std::cin >> answer;
+				pgsqlInitialization::TableLayout layout = answer == "y" || answer == "Y"
+				                                              ? pgsqlInitialization::TableLayout::MonthlyPartitioned
+				                                              : pgsqlInitialization::TableLayout::Plain;
+
+				bool ephemeral = false;
+				if (layout == pgsqlInitialization::TableLayout::Plain) {
+					std::cout << "Ephemeral store with UNLOGGED tables (no WAL, lost on crash)? (y/n): ";
+					std::cin >> answer;
+					ephemeral = answer == "y" || answer == "Y";
+				}
+
+				if (dbInitializer.initializeTables(dbName, userName, password, layout, ephemeral)) {
 					std::cout << "Tables initialized successfully." << std::endl;
 				}
 				else {
@@ -353,7 +849,236 @@ namespace pgsqlInitialization {
 				dbInitializer.listDatabases();
 				break;
 			}
-			case 5: { // exit
+			case 5: { // Build the template database
+				std::string answer;
+				std::cout << "Rebuild if it already exists? (y/n): ";
+				std::cin >> answer;
+
+				if (!dbInitializer.buildTemplateDatabase(answer == "y" || answer == "Y")) {
+					std::cout << "Failed to build template database." << std::endl;
+				}
+				break;
+			}
+			case 6: { // create user and database from the template
+				std::cout << "Enter new database name: ";
+				std::cin >> dbName;
+
+				std::cout << "Enter new user name: ";
+				std::cin >> userName;
+
+				std::cout << "Enter password for new user: ";
+				std::cin >> password;
+
+				if (dbInitializer.createDatabaseFromTemplate(dbName, userName, password)) {
+					std::cout << "Store database created from template successfully." << std::endl;
+				}
+				else {
+					std::cout << "Failed to create store database from template." << std::endl;
+				}
+				break;
+			}
+			case 7: { // Provision many stores in parallel
+				std::string manifestPath, answer;
+				pgsqlProvisioning::ProvisionOptions options;
+
+				std::cout << "Enter manifest path (one 'dbName,userName,password' per line): ";
+				std::cin >> manifestPath;
+
+				std::cout << "Enter concurrency limit: ";
+				std::cin >> options.concurrency;
+
+				std::cout << "Clone from " << kTemplateDatabaseName << "? (y/n): ";
+				std::cin >> answer;
+				bool fromTemplate = answer == "y" || answer == "Y";
+
+				options.pooledConnInfo = dbInitializer.superUserConnInfo();
+
+				std::vector<pgsqlProvisioning::TenantSpec> tenants;
+				if (!pgsqlProvisioning::loadManifest(manifestPath, tenants)) {
+					break;
+				}
+				if (fromTemplate && !dbInitializer.buildTemplateDatabase()) {
+					std::cout << "Failed to build template database." << std::endl;
+					break;
+				}
+
+				pgsqlProvisioning::ProvisionReport report = pgsqlProvisioning::provisionTenants(
+				    tenants,
+				    [&dbInitializer, fromTemplate](const pgsqlProvisioning::TenantSpec& tenant) {
+					    return dbInitializer.provisionStore(
+					        tenant.dbName, tenant.userName, tenant.password, fromTemplate);
+				    },
+				    options);
+				report.print(std::cout);
+				break;
+			}
+			case 8: { // Upgrade every store database to the latest schema in parallel
+				pgsqlProvisioning::ProvisionOptions options;
+				std::cout << "Enter concurrency limit: ";
+				std::cin >> options.concurrency;
+
+				std::vector<pgsqlProvisioning::TenantSpec> stores;
+				for (std::string& store : dbInitializer.listStoreDatabases()) {
+					stores.push_back({std::move(store), "", ""});
+				}
+
+				pgsqlProvisioning::ProvisionReport report = pgsqlProvisioning::provisionTenants(
+				    stores,
+				    [&dbInitializer](const pgsqlProvisioning::TenantSpec& store) {
+					    return dbInitializer.migrateDatabase(store.dbName);
+				    },
+				    options);
+				report.print(std::cout, "Migrated");
+				break;
+			}
+			case 9: { // Pre-create future partitions and detach expired ones
+				pgsqlPartitions::MaintenancePolicy policy;
+				std::cout << "Enter database name: ";
+				std::cin >> dbName;
+
+				std::cout << "Months to create ahead (default " << policy.monthsAhead << "): ";
+				std::cin >> policy.monthsAhead;
+
+				std::cout << "Months to keep attached (default " << policy.retainMonths << "): ";
+				std::cin >> policy.retainMonths;
+
+				if (!dbInitializer.maintainPartitions(dbName, policy)) {
+					std::cout << "Partition maintenance failed." << std::endl;
+				}
+				break;
+			}
+			case 10: { // Make an ephemeral store durable
+				std::cout << "Enter database name: ";
+				std::cin >> dbName;
+
+				if (dbInitializer.promoteDatabase(dbName)) {
+					std::cout << "Tables of " << dbName << " are logged now." << std::endl;
+				}
+				else {
+					std::cout << "Failed to promote " << dbName << "." << std::endl;
+				}
+				break;
+			}
+			case 11: { // Bulk-load a catalog or customer list
+				std::string tableName, path;
+				std::cout << "Enter database name: ";
+				std::cin >> dbName;
+
+				std::cout << "Enter table (Products, Customers, Employees or Suppliers): ";
+				std::cin >> tableName;
+
+				std::cout << "Enter CSV path (first line names the columns): ";
+				std::cin >> path;
+
+				dbInitializer.importCsv(dbName, tableName, path).print(std::cout);
+				break;
+			}
+			case 12: { // Dump a table into a columnar snapshot
+				std::string tableName, path;
+				std::cout << "Enter database name: ";
+				std::cin >> dbName;
+
+				std::cout << "Enter table name: ";
+				std::cin >> tableName;
+
+				std::cout << "Enter snapshot path: ";
+				std::cin >> path;
+
+				dbInitializer.exportSnapshot(dbName, tableName, path).print(std::cout);
+				break;
+			}
+			case 13: { // Summarize a snapshot without a database
+				std::string path, error;
+				std::cout << "Enter snapshot path: ";
+				std::cin >> path;
+
+				pgsqlSnapshot::SnapshotReader reader;
+				if (!reader.open(path, error)) {
+					std::cout << "Cannot read snapshot: " << error << std::endl;
+					break;
+				}
+				reader.summarize(std::cout);
+				break;
+			}
+			case 14: { // Daily supplier catalog
+				std::string productsPath, suppliersPath;
+				std::cout << "Enter database name: ";
+				std::cin >> dbName;
+
+				std::cout << "Enter Products feed path ('-' to skip): ";
+				std::cin >> productsPath;
+
+				std::cout << "Enter Suppliers feed path ('-' to skip): ";
+				std::cin >> suppliersPath;
+
+				for (const pgsqlSync::SyncStats& stats : dbInitializer.syncCatalog(
+				         dbName, productsPath == "-" ? "" : productsPath, suppliersPath == "-" ? "" : suppliersPath))
+				{
+					stats.print(std::cout);
+				}
+				break;
+			}
+			case 15: { // Feed order and stock changes to the console
+				std::string answer;
+				std::cout << "Enter database name: ";
+				std::cin >> dbName;
+
+				std::cout << "Drop the replication slot when done? (y/n): ";
+				std::cin >> answer;
+				std::cin.ignore(std::numeric_limits<std::streamsize>::max(), '\n');
+
+				dbInitializer.watchChanges(dbName, answer == "y" || answer == "Y");
+				break;
+			}
+			case 16: { // Backup or clone source
+				std::string directory;
+				pgsqlDump::DumpOptions options;
+				std::cout << "Enter database name: ";
+				std::cin >> dbName;
+
+				std::cout << "Enter archive directory: ";
+				std::cin >> directory;
+
+				std::cout << "Enter worker connections: ";
+				std::cin >> options.threads;
+
+				dbInitializer.dumpStore(dbName, directory, options).print(std::cout);
+				break;
+			}
+			case 17: { // Into a freshly initialized store
+				std::string directory;
+				pgsqlDump::RestoreOptions options;
+				std::cout << "Enter database name: ";
+				std::cin >> dbName;
+
+				std::cout << "Enter archive directory: ";
+				std::cin >> directory;
+
+				std::cout << "Enter worker connections: ";
+				std::cin >> options.threads;
+
+				dbInitializer.restoreStore(dbName, directory, options).print(std::cout);
+				break;
+			}
+			case 18: { // Throttled, safe to run against a live store
+				pgsqlPurge::PurgeOptions options;
+				std::cout << "Enter database name: ";
+				std::cin >> dbName;
+
+				std::cout << "Enter retention in days: ";
+				std::cin >> options.retentionDays;
+
+				std::cout << "Enter max rows per second (0 for unlimited): ";
+				std::cin >> options.maxRowsPerSecond;
+
+				dbInitializer.purgeSoftDeleted(dbName, options).print(std::cout);
+				break;
+			}
+			case 19: { // Spot stores a rollout missed
+				dbInitializer.listSchemaVersions();
+				break;
+			}
+			case 20: { // exit
 				std::cout << "Exiting program..." << std::endl;
 				return;
 			}
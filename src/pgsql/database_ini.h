@@ -2,22 +2,48 @@
 #define DATABASE_INI_H
 
 #include "libpq-fe.h"
+#include "pgsql_async.h"
+#include "pgsql_cdc.h"
+#include "pgsql_connection_pool.h"
+#include "pgsql_copy.h"
+#include "pgsql_dump.h"
+#include "pgsql_handles.h"
+#include "pgsql_indexes.h"
+#include "pgsql_migrations.h"
+#include "pgsql_partitions.h"
+#include "pgsql_pipeline.h"
+#include "pgsql_prepared.h"
+#include "pgsql_profiles.h"
+#include "pgsql_schema.h"
+#include "pgsql_snapshot.h"
+#include "pgsql_sync.h"
+#include "pgsql_provisioning.h"
+#include "pgsql_purge.h"
+#include "pgsql_stream.h"
 #include <iostream>
 #include <numeric>
 #include <string>
+#include <vector>
 
 namespace pgsqlInitialization {
 
+	// Plain tables, or Orders and Inventory_Actions range-partitioned by month
+	enum class TableLayout { Plain, MonthlyPartitioned };
+
 	class DatabaseInitializer {
 	 public:
 		// Constructor that takes superuser credentials for database management
 		DatabaseInitializer(const std::string& superUserName = "postgres", const std::string& superUserPassword = "");
 
-		// Destructor to close any open connections
-		~DatabaseInitializer();
-
-		// Method to initialize tables in the database
-		bool initializeTables(const std::string& dbName, const std::string& userName, const std::string& password);
+		// Method to initialize tables in the database: applies the pending petstoreMigrations(layout)
+		// and, for the partitioned layout, creates the partitions around the current month.
+		// ephemeral makes every table UNLOGGED: no WAL is written, and the data is lost on a crash.
+		// Only the plain layout can be ephemeral.
+		bool initializeTables(const std::string& dbName,
+		                      const std::string& userName,
+		                      const std::string& password,
+		                      TableLayout layout = TableLayout::Plain,
+		                      bool ephemeral = false);
 
 		// Method to create a new user and database
 		bool createUserAndDatabase(const std::string& dbName, const std::string& userName, const std::string& password);
@@ -27,11 +53,121 @@ namespace pgsqlInitialization {
 
 		void listDatabases();
 
+		// Build kTemplateDatabaseName with every table created once. A complete template (one carrying
+		// kTemplateCompleteComment) is kept unless rebuild is set; one left behind by a failed build is
+		// dropped and recreated.
+		bool buildTemplateDatabase(bool rebuild = false);
+
+		// Create a user and a store database cloned from the template, then grant the user the
+		// schema, tables and sequences the template's owner created
+		bool createDatabaseFromTemplate(const std::string& dbName,
+		                                const std::string& userName,
+		                                const std::string& password);
+
+		// Create whatever part of a store is still missing and rerun the idempotent setup (role, grants,
+		// migrations) on the rest, so a failed attempt can simply be retried. fromTemplate clones
+		// kTemplateDatabaseName instead of running the table DDL.
+		bool provisionStore(const std::string& dbName,
+		                    const std::string& userName,
+		                    const std::string& password,
+		                    bool fromTemplate);
+
+		// Apply pending migrations to one store database as the superuser, in the layout it was created with
+		bool migrateDatabase(const std::string& dbName);
+
+		// Turn the UNLOGGED tables of an ephemeral store back into logged ones, e.g. when a load-test
+		// dataset is kept. Each table is rewritten into the WAL, so this takes as long as copying it.
+		bool promoteDatabase(const std::string& dbName);
+
+		// Bulk-load a CSV file into Products, Customers, Employees or Suppliers of a store with COPY
+		pgsqlCopy::ImportStats importCsv(const std::string& dbName,
+		                                 const std::string& tableName,
+		                                 const std::string& path,
+		                                 const pgsqlCopy::ImportOptions& options = {});
+
+		// Apply full supplier catalog feeds (Products, then Suppliers) to a store in one transaction:
+		// new rows are inserted, changed rows updated and rows missing from a feed soft-deleted
+		std::vector<pgsqlSync::SyncStats> syncCatalog(const std::string& dbName,
+		                                              const std::string& productsPath,
+		                                              const std::string& suppliersPath,
+		                                              const pgsqlSync::SyncOptions& options = {});
+
+		// Print committed Orders, Order_Items and Inventory_Actions changes of a store until a line is read
+		// from standard input; needs wal_level = logical. dropSlot retires the replication slot afterwards.
+		bool watchChanges(const std::string& dbName, bool dropSlot);
+
+		// Stream one of the seven store tables into a columnar snapshot file for offline analysis
+		pgsqlSnapshot::ExportStats exportSnapshot(const std::string& dbName,
+		                                          const std::string& tableName,
+		                                          const std::string& path);
+
+		// Consistent parallel dump of all seven tables of a store into an archive directory, for backups
+		// and cloning; the store keeps taking writes meanwhile
+		pgsqlDump::ArchiveReport dumpStore(const std::string& dbName,
+		                                   const std::string& directory,
+		                                   const pgsqlDump::DumpOptions& options = {});
+
+		// Parallel load of an archive into an initialized, empty store
+		pgsqlDump::ArchiveReport restoreStore(const std::string& dbName,
+		                                      const std::string& directory,
+		                                      const pgsqlDump::RestoreOptions& options = {});
+
+		// Move rows soft-deleted longer than the retention into the archive tables in small, throttled
+		// batches, printing progress every second until the store has none left
+		pgsqlPurge::PurgeReport purgeSoftDeleted(const std::string& dbName,
+		                                         const pgsqlPurge::PurgeOptions& options = {});
+
+		// Pre-create upcoming monthly partitions and detach expired ones; a no-op on the plain layout
+		bool maintainPartitions(const std::string& dbName, const pgsqlPartitions::MaintenancePolicy& policy = {});
+
+		// Every non-template database that accepts connections, except the maintenance database "postgres"
+		std::vector<std::string> listStoreDatabases();
+
+		// Print the latest applied migration of every store database, and how far behind it is
+		void listSchemaVersions();
+
+		// The superuser's conninfo for the maintenance database, which provisioning workers share
+		[[nodiscard]] const std::string& superUserConnInfo() const {
+			return superUserConnInfo_;
+		}
+
+		// Whether the role and the database of a tenant exist; false only if the lookup failed
+		bool lookupTenant(const std::string& dbName,
+		                  const std::string& userName,
+		                  bool& roleExists,
+		                  bool& databaseExists);
+
 	 private:
-		PGconn* conn_; // PostgreSQL connection object
+		// Shared by createUserAndDatabase and createDatabaseFromTemplate; an empty templateName
+		// creates the database from the server default. createRole is false when resuming a tenant
+		// whose role was created by an earlier attempt.
+		bool createUserAndDatabaseFrom(const std::string& dbName,
+		                               const std::string& userName,
+		                               const std::string& password,
+		                               const std::string& templateName,
+		                               bool createRole);
+
+		bool grantTemplateObjects(const std::string& dbName, const std::string& userName);
+
+		bool grantTenantRole(const std::string& dbName,
+		                     const std::string& userName,
+		                     const std::string& password,
+		                     bool createRole);
+
+		std::string superUserName_;
+		std::string superUserPassword_;
 		std::string superUserConnInfo_; // Connection string for superuser
 	};
 
+	// Ordered schema steps of a store database
+	const std::vector<pgsqlMigrations::Migration>& petstoreMigrations(TableLayout layout = TableLayout::Plain);
+
+	// Fully initialized database new stores are cloned from with CREATE DATABASE ... TEMPLATE
+	inline constexpr const char* kTemplateDatabaseName = "petstore_template";
+
+	// COMMENT ON DATABASE of the template, set as the last step of a successful build
+	inline constexpr const char* kTemplateCompleteComment = "petstore template: complete";
+
 	void pgsqlInitializationManagementMenu();
 
 } // namespace pgsqlInitialization
@@ -0,0 +1,417 @@
+#include "pgsql_async.h"
+
+#include <cerrno>
+#include <iostream>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <unistd.h>
+
+namespace pgsqlAsync {
+	AsyncEngine::AsyncEngine(EngineOptions options)
+	: options_(options) {
+		if (options_.maxConnectionsPerTarget == 0) {
+			options_.maxConnectionsPerTarget = 1;
+		}
+		if (options_.maxEventsPerWait <= 0) {
+			options_.maxEventsPerWait = 64;
+		}
+	}
+
+	AsyncEngine::~AsyncEngine() {
+		stop();
+	}
+
+	bool AsyncEngine::start() {
+		if (running_) {
+			return true;
+		}
+
+		epollFd_ = epoll_create1(EPOLL_CLOEXEC);
+		wakeFd_ = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+		if (epollFd_ < 0 || wakeFd_ < 0) {
+			std::cerr << "Failed to create the async engine event loop." << std::endl;
+			stop();
+			return false;
+		}
+
+		epoll_event ev{};
+		ev.events = EPOLLIN;
+		ev.data.ptr = nullptr; // nullptr marks the wake-up eventfd
+		epoll_ctl(epollFd_, EPOLL_CTL_ADD, wakeFd_, &ev);
+
+		running_ = true;
+		loop_ = std::thread(&AsyncEngine::run, this);
+		return true;
+	}
+
+	void AsyncEngine::stop() {
+		// Flipped under the inbox lock: a submit either got its query in before this, and it is failed
+		// below, or sees the engine stopped and never touches wakeFd_, which is closed further down
+		bool wasRunning = false;
+		{
+			std::lock_guard<std::mutex> lock(inboxMutex_);
+			wasRunning = running_.exchange(false);
+			if (wasRunning) {
+				std::uint64_t one = 1;
+				[[maybe_unused]] ssize_t written = write(wakeFd_, &one, sizeof(one));
+			}
+		}
+		if (wasRunning) {
+			loop_.join();
+		}
+
+		// The loop thread is gone, so its state can be torn down from here
+		drainInbox();
+		for (auto& entry : connections_) {
+			AsyncConnection& connection = *entry.second;
+			if (connection.state == ConnectionState::Busy) {
+				complete(connection.current, {pgsqlHandles::PgResult(), "Async engine stopped."});
+			}
+			PQfinish(connection.conn);
+		}
+		connections_.clear();
+		closed_.clear();
+		for (auto& entry : targets_) {
+			failQueue(*entry.second, "Async engine stopped.");
+		}
+		targets_.clear();
+
+		if (wakeFd_ >= 0) {
+			close(wakeFd_);
+			wakeFd_ = -1;
+		}
+		if (epollFd_ >= 0) {
+			close(epollFd_);
+			epollFd_ = -1;
+		}
+	}
+
+	void AsyncEngine::submit(const std::string& conninfo,
+	                         std::string sql,
+	                         std::vector<std::string> params,
+	                         QueryCallback callback) {
+		{
+			std::lock_guard<std::mutex> lock(inboxMutex_);
+			if (running_) {
+				inbox_.push_back({conninfo, {std::move(sql), std::move(params), std::move(callback)}});
+				std::uint64_t one = 1;
+				[[maybe_unused]] ssize_t written = write(wakeFd_, &one, sizeof(one));
+				return;
+			}
+		}
+
+		// Outside the lock: the callback may submit again
+		if (callback) {
+			callback({pgsqlHandles::PgResult(), "Async engine is not running."});
+		}
+	}
+
+	std::future<QueryResult> AsyncEngine::submit(const std::string& conninfo,
+	                                             std::string sql,
+	                                             std::vector<std::string> params) {
+		auto promise = std::make_shared<std::promise<QueryResult>>();
+		std::future<QueryResult> future = promise->get_future();
+		submit(conninfo, std::move(sql), std::move(params), [promise](QueryResult result) {
+			promise->set_value(std::move(result));
+		});
+		return future;
+	}
+
+	void AsyncEngine::run() {
+		std::vector<epoll_event> events(static_cast<std::size_t>(options_.maxEventsPerWait));
+
+		while (running_) {
+			int ready = epoll_wait(epollFd_, events.data(), options_.maxEventsPerWait, -1);
+			if (ready < 0) {
+				if (errno == EINTR) {
+					continue;
+				}
+				std::cerr << "Async engine epoll_wait failed." << std::endl;
+				break;
+			}
+
+			for (int i = 0; i < ready; ++i) {
+				if (events[i].data.ptr == nullptr) {
+					std::uint64_t count;
+					[[maybe_unused]] ssize_t got = read(wakeFd_, &count, sizeof(count));
+					drainInbox();
+					continue;
+				}
+
+				auto* connection = static_cast<AsyncConnection*>(events[i].data.ptr);
+				if (!connection->closed) {
+					handleEvent(*connection, events[i].events);
+				}
+			}
+
+			// Connections closed during this batch may still have appeared later in `events`
+			for (AsyncConnection* connection : closed_) {
+				connections_.erase(connection);
+			}
+			closed_.clear();
+		}
+	}
+
+	void AsyncEngine::drainInbox() {
+		std::vector<std::pair<std::string, PendingQuery>> incoming;
+		{
+			std::lock_guard<std::mutex> lock(inboxMutex_);
+			incoming.swap(inbox_);
+		}
+
+		for (auto& item : incoming) {
+			auto& slot = targets_[item.first];
+			if (!slot) {
+				slot = std::make_unique<Target>();
+				slot->conninfo = item.first;
+			}
+			slot->queue.push_back(std::move(item.second));
+			if (running_) {
+				dispatch(*slot);
+			}
+		}
+	}
+
+	// Hand queued queries to idle connections, opening new ones while the target is below its limit
+	void AsyncEngine::dispatch(Target& target) {
+		while (!target.queue.empty() && !target.idle.empty()) {
+			AsyncConnection* connection = target.idle.back();
+			target.idle.pop_back();
+			connection->current = std::move(target.queue.front());
+			target.queue.pop_front();
+			sendQuery(*connection);
+		}
+
+		while (target.queue.size() > target.connecting && target.open < options_.maxConnectionsPerTarget) {
+			if (!openConnection(target)) {
+				break;
+			}
+		}
+	}
+
+	bool AsyncEngine::openConnection(Target& target) {
+		PGconn* conn = PQconnectStart(target.conninfo.c_str());
+		if (!conn || PQstatus(conn) == CONNECTION_BAD || PQsocket(conn) < 0) {
+			std::string error = conn ? PQerrorMessage(conn) : "out of memory";
+			PQfinish(conn);
+			if (target.open == 0) {
+				failQueue(target, "Connection to database failed: " + error);
+			}
+			return false;
+		}
+
+		auto owned = std::make_unique<AsyncConnection>();
+		AsyncConnection* connection = owned.get();
+		connection->conn = conn;
+		connection->target = &target;
+		connections_.emplace(connection, std::move(owned));
+		++target.open;
+		++target.connecting;
+
+		// libpq requires waiting for writability before the first PQconnectPoll call
+		watch(*connection, EPOLLOUT);
+		return true;
+	}
+
+	void AsyncEngine::handleEvent(AsyncConnection& connection, std::uint32_t events) {
+		switch (connection.state) {
+		case ConnectionState::Connecting: {
+			continueConnect(connection);
+			break;
+		}
+		case ConnectionState::Busy: {
+			if ((events & EPOLLOUT) && !flush(connection)) {
+				return;
+			}
+			if (events & (EPOLLIN | EPOLLERR | EPOLLHUP)) {
+				readResults(connection);
+			}
+			break;
+		}
+		case ConnectionState::Idle: {
+			// Nothing is expected on an idle connection; input here is a notice or a closed session
+			if (!PQconsumeInput(connection.conn) || PQstatus(connection.conn) != CONNECTION_OK) {
+				closeConnection(connection, PQerrorMessage(connection.conn));
+			}
+			break;
+		}
+		}
+	}
+
+	void AsyncEngine::continueConnect(AsyncConnection& connection) {
+		PostgresPollingStatusType status = PQconnectPoll(connection.conn);
+		switch (status) {
+		case PGRES_POLLING_READING: watch(connection, EPOLLIN); break;
+		case PGRES_POLLING_WRITING: watch(connection, EPOLLOUT); break;
+		case PGRES_POLLING_OK: {
+			PQsetnonblocking(connection.conn, 1);
+			connection.state = ConnectionState::Idle;
+			watch(connection, EPOLLIN);
+			--connection.target->connecting;
+			connection.target->idle.push_back(&connection);
+			dispatch(*connection.target);
+			break;
+		}
+		default: {
+			std::string error = PQerrorMessage(connection.conn);
+			closeConnection(connection, "Connection to database failed: " + error);
+			break;
+		}
+		}
+	}
+
+	void AsyncEngine::sendQuery(AsyncConnection& connection) {
+		PendingQuery& query = connection.current;
+		connection.state = ConnectionState::Busy;
+		connection.result.reset();
+		connection.error.clear();
+
+		int sent;
+		if (query.params.empty()) {
+			sent = PQsendQuery(connection.conn, query.sql.c_str());
+		}
+		else {
+			std::vector<const char*> values;
+			values.reserve(query.params.size());
+			for (const std::string& param : query.params) {
+				values.push_back(param.c_str());
+			}
+			sent = PQsendQueryParams(connection.conn,
+			                         query.sql.c_str(),
+			                         static_cast<int>(values.size()),
+			                         nullptr,
+			                         values.data(),
+			                         nullptr,
+			                         nullptr,
+			                         0);
+		}
+
+		if (!sent) {
+			closeConnection(connection, "Failed to send query: " + std::string(PQerrorMessage(connection.conn)));
+			return;
+		}
+		flush(connection);
+	}
+
+	// Returns false if the connection was closed
+	bool AsyncEngine::flush(AsyncConnection& connection) {
+		int pending = PQflush(connection.conn);
+		if (pending < 0) {
+			closeConnection(connection, "Failed to send query: " + std::string(PQerrorMessage(connection.conn)));
+			return false;
+		}
+		watch(connection, pending == 1 ? (EPOLLIN | EPOLLOUT) : EPOLLIN);
+		return true;
+	}
+
+	void AsyncEngine::readResults(AsyncConnection& connection) {
+		if (!PQconsumeInput(connection.conn)) {
+			closeConnection(connection, "Failed to read result: " + std::string(PQerrorMessage(connection.conn)));
+			return;
+		}
+
+		while (!PQisBusy(connection.conn)) {
+			PGresult* res = PQgetResult(connection.conn);
+			if (!res) {
+				finishQuery(connection);
+				return;
+			}
+
+			ExecStatusType status = PQresultStatus(res);
+			bool failed = status == PGRES_BAD_RESPONSE || status == PGRES_FATAL_ERROR;
+			// Keep the first error, otherwise the last result of a multi-statement query
+			if (connection.error.empty()) {
+				connection.result.reset(res);
+				if (failed) {
+					connection.error = PQresultErrorMessage(res);
+				}
+			}
+			else {
+				PQclear(res);
+			}
+		}
+	}
+
+	void AsyncEngine::finishQuery(AsyncConnection& connection) {
+		QueryResult result{std::move(connection.result), std::move(connection.error)};
+		connection.error.clear();
+		connection.state = ConnectionState::Idle;
+		watch(connection, EPOLLIN);
+
+		PendingQuery query = std::move(connection.current);
+		complete(query, std::move(result));
+
+		Target& target = *connection.target;
+		target.idle.push_back(&connection);
+		dispatch(target);
+	}
+
+	void AsyncEngine::closeConnection(AsyncConnection& connection, const std::string& error) {
+		Target& target = *connection.target;
+		if (connection.state == ConnectionState::Busy) {
+			complete(connection.current, {std::move(connection.result), error});
+		}
+		else if (connection.state == ConnectionState::Connecting) {
+			--target.connecting;
+		}
+		else {
+			std::erase(target.idle, &connection);
+		}
+
+		epoll_ctl(epollFd_, EPOLL_CTL_DEL, connection.fd, nullptr);
+		PQfinish(connection.conn);
+		connection.conn = nullptr;
+		connection.closed = true;
+		closed_.push_back(&connection);
+		--target.open;
+
+		// Without a live connection the queue would wait forever on a target that cannot be reached
+		if (target.open == 0 && !target.queue.empty()) {
+			failQueue(target, error);
+		}
+		else {
+			dispatch(target);
+		}
+	}
+
+	void AsyncEngine::watch(AsyncConnection& connection, std::uint32_t events) {
+		int fd = PQsocket(connection.conn);
+		epoll_event ev{};
+		ev.events = events;
+		ev.data.ptr = &connection;
+
+		// PQconnectPoll may switch sockets when it falls through to another host or address
+		if (fd != connection.fd) {
+			if (connection.fd >= 0) {
+				epoll_ctl(epollFd_, EPOLL_CTL_DEL, connection.fd, nullptr);
+			}
+			connection.fd = fd;
+			epoll_ctl(epollFd_, EPOLL_CTL_ADD, fd, &ev);
+		}
+		else if (events != connection.watched && epoll_ctl(epollFd_, EPOLL_CTL_MOD, fd, &ev) < 0 && errno == ENOENT) {
+			// libpq closed and reopened the socket under the same descriptor number
+			epoll_ctl(epollFd_, EPOLL_CTL_ADD, fd, &ev);
+		}
+		connection.watched = events;
+	}
+
+	void AsyncEngine::failQueue(Target& target, const std::string& error) {
+		while (!target.queue.empty()) {
+			PendingQuery query = std::move(target.queue.front());
+			target.queue.pop_front();
+			complete(query, {pgsqlHandles::PgResult(), error});
+		}
+	}
+
+	void AsyncEngine::complete(PendingQuery& query, QueryResult result) {
+		if (!query.callback) {
+			return;
+		}
+		try {
+			query.callback(std::move(result));
+		} catch (const std::exception& e) {
+			std::cerr << "Async query callback threw: " << e.what() << std::endl;
+		}
+		query.callback = nullptr;
+	}
+} // namespace pgsqlAsync
@@ -0,0 +1,129 @@
+#ifndef PGSQL_ASYNC_H
+#define PGSQL_ASYNC_H
+
+#include "libpq-fe.h"
+#include "pgsql_handles.h"
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+namespace pgsqlAsync {
+
+	// Outcome of one asynchronous query
+	struct QueryResult {
+		pgsqlHandles::PgResult result; // Last result returned by the server, null if the query never ran
+		std::string error; // Empty on success
+
+		[[nodiscard]] bool ok() const {
+			return error.empty();
+		}
+	};
+
+	// Invoked on the event-loop thread; must not block
+	using QueryCallback = std::function<void(QueryResult)>;
+
+	struct EngineOptions {
+		std::size_t maxConnectionsPerTarget = 16; // Connections opened per conninfo
+		int maxEventsPerWait = 256; // epoll_wait batch size
+	};
+
+	// Non-blocking libpq engine: one epoll loop thread multiplexes every connection, queries are
+	// queued per conninfo and handed to the first idle connection of that target
+	class AsyncEngine {
+	 public:
+		explicit AsyncEngine(EngineOptions options = {});
+		~AsyncEngine();
+
+		AsyncEngine(const AsyncEngine&) = delete;
+		AsyncEngine& operator=(const AsyncEngine&) = delete;
+
+		// Start the event-loop thread
+		bool start();
+
+		// Stop the loop and fail every query that has not completed yet
+		void stop();
+
+		// Queue a query; text parameters are bound as $1..$n. Thread-safe, also against stop(): a query
+		// submitted once stop() has begun completes at once with "Async engine is not running."
+		void submit(const std::string& conninfo,
+		            std::string sql,
+		            std::vector<std::string> params,
+		            QueryCallback callback);
+
+		std::future<QueryResult> submit(const std::string& conninfo,
+		                                std::string sql,
+		                                std::vector<std::string> params = {});
+
+	 private:
+		struct PendingQuery {
+			std::string sql;
+			std::vector<std::string> params;
+			QueryCallback callback;
+		};
+
+		struct Target;
+
+		enum class ConnectionState { Connecting, Idle, Busy };
+
+		struct AsyncConnection {
+			PGconn* conn = nullptr;
+			int fd = -1;
+			std::uint32_t watched = 0; // epoll events currently registered
+			ConnectionState state = ConnectionState::Connecting;
+			Target* target = nullptr;
+			PendingQuery current;
+			pgsqlHandles::PgResult result;
+			std::string error;
+			bool closed = false;
+		};
+
+		struct Target {
+			std::string conninfo;
+			std::deque<PendingQuery> queue;
+			std::vector<AsyncConnection*> idle;
+			std::size_t open = 0;
+			std::size_t connecting = 0;
+		};
+
+		void run();
+		void drainInbox();
+		void dispatch(Target& target);
+		bool openConnection(Target& target);
+		void handleEvent(AsyncConnection& connection, std::uint32_t events);
+		void continueConnect(AsyncConnection& connection);
+		void sendQuery(AsyncConnection& connection);
+		bool flush(AsyncConnection& connection);
+		void readResults(AsyncConnection& connection);
+		void finishQuery(AsyncConnection& connection);
+		void closeConnection(AsyncConnection& connection, const std::string& error);
+		void watch(AsyncConnection& connection, std::uint32_t events);
+		void failQueue(Target& target, const std::string& error);
+		static void complete(PendingQuery& query, QueryResult result);
+
+		EngineOptions options_;
+		int epollFd_ = -1;
+		int wakeFd_ = -1;
+		std::thread loop_;
+		std::atomic<bool> running_{false};
+
+		std::mutex inboxMutex_;
+		std::vector<std::pair<std::string, PendingQuery>> inbox_;
+
+		// Owned by the loop thread
+		std::unordered_map<std::string, std::unique_ptr<Target>> targets_;
+		std::unordered_map<AsyncConnection*, std::unique_ptr<AsyncConnection>> connections_;
+		std::vector<AsyncConnection*> closed_; // Freed after the current epoll batch
+	};
+
+} // namespace pgsqlAsync
+
+#endif // PGSQL_ASYNC_H
@@ -0,0 +1,325 @@
+#include "pgsql_binary.h"
+
+#include <algorithm>
+#include <charconv>
+#include <cstring>
+#include <limits>
+
+namespace pgsqlBinary {
+	// NUMERIC sign words from the server's wire format
+	constexpr std::uint16_t kNumericPositive = 0x0000;
+	constexpr std::uint16_t kNumericNegative = 0x4000;
+
+	static std::uint16_t readUint16(const char* data) {
+		auto bytes = reinterpret_cast<const unsigned char*>(data);
+		return static_cast<std::uint16_t>((bytes[0] << 8) | bytes[1]);
+	}
+
+	static std::uint32_t readUint32(const char* data) {
+		auto bytes = reinterpret_cast<const unsigned char*>(data);
+		return (static_cast<std::uint32_t>(bytes[0]) << 24) | (static_cast<std::uint32_t>(bytes[1]) << 16)
+		       | (static_cast<std::uint32_t>(bytes[2]) << 8) | static_cast<std::uint32_t>(bytes[3]);
+	}
+
+	static const std::int64_t kPowersOfTen[] = {1LL,
+	                                            10LL,
+	                                            100LL,
+	                                            1000LL,
+	                                            10000LL,
+	                                            100000LL,
+	                                            1000000LL,
+	                                            10000000LL,
+	                                            100000000LL,
+	                                            1000000000LL,
+	                                            10000000000LL,
+	                                            100000000000LL,
+	                                            1000000000000LL,
+	                                            10000000000000LL,
+	                                            100000000000000LL,
+	                                            1000000000000000LL,
+	                                            10000000000000000LL,
+	                                            100000000000000000LL,
+	                                            1000000000000000000LL};
+
+	// Howard Hinnant's days_from_civil / civil_from_days, relative to 1970-01-01
+	std::int32_t daysFromCivil(int year, unsigned month, unsigned day) {
+		year -= month <= 2 ? 1 : 0;
+		const int era = (year >= 0 ? year : year - 399) / 400;
+		const unsigned yearOfEra = static_cast<unsigned>(year - era * 400);
+		const unsigned dayOfYear = (153 * (month > 2 ? month - 3 : month + 9) + 2) / 5 + day - 1;
+		const unsigned dayOfEra = yearOfEra * 365 + yearOfEra / 4 - yearOfEra / 100 + dayOfYear;
+		return era * 146097 + static_cast<int>(dayOfEra) - 719468;
+	}
+
+	Date civilFromDays(std::int32_t daysSinceUnixEpoch) {
+		const int z = daysSinceUnixEpoch + 719468;
+		const int era = (z >= 0 ? z : z - 146096) / 146097;
+		const unsigned dayOfEra = static_cast<unsigned>(z - era * 146097);
+		const unsigned yearOfEra = (dayOfEra - dayOfEra / 1460 + dayOfEra / 36524 - dayOfEra / 146096) / 365;
+		const unsigned dayOfYear = dayOfEra - (365 * yearOfEra + yearOfEra / 4 - yearOfEra / 100);
+		const unsigned mp = (5 * dayOfYear + 2) / 153;
+		const unsigned day = dayOfYear - (153 * mp + 2) / 5 + 1;
+		const unsigned month = mp < 10 ? mp + 3 : mp - 9;
+		const int year = static_cast<int>(yearOfEra) + era * 400 + (month <= 2 ? 1 : 0);
+		return {year, month, day};
+	}
+
+	bool decodeInt4(std::string_view bytes, std::int32_t& out) {
+		if (bytes.size() != 4) {
+			return false;
+		}
+		out = static_cast<std::int32_t>(readUint32(bytes.data()));
+		return true;
+	}
+
+	bool decodeInt8(std::string_view bytes, std::int64_t& out) {
+		if (bytes.size() != 8) {
+			return false;
+		}
+		std::uint64_t high = readUint32(bytes.data());
+		std::uint64_t low = readUint32(bytes.data() + 4);
+		out = static_cast<std::int64_t>((high << 32) | low);
+		return true;
+	}
+
+	bool decodeBool(std::string_view bytes, bool& out) {
+		if (bytes.size() != 1) {
+			return false;
+		}
+		out = bytes[0] != 0;
+		return true;
+	}
+
+	bool decodeDate(std::string_view bytes, std::int32_t& pgDays) {
+		return decodeInt4(bytes, pgDays);
+	}
+
+	bool decodeTimestamp(std::string_view bytes, std::int64_t& pgMicros) {
+		return decodeInt8(bytes, pgMicros);
+	}
+
+	// Wire layout: ndigits, weight, sign, dscale (all int16) followed by ndigits base-10000 digits,
+	// where digit i is worth 10000^(weight - i)
+	bool decodeNumeric(std::string_view bytes, int scale, std::int64_t& out) {
+		if (bytes.size() < 8 || scale < 0 || scale > 18) {
+			return false;
+		}
+		const int ndigits = static_cast<std::int16_t>(readUint16(bytes.data()));
+		const int weight = static_cast<std::int16_t>(readUint16(bytes.data() + 2));
+		const std::uint16_t sign = readUint16(bytes.data() + 4);
+		if (ndigits < 0 || bytes.size() != 8 + static_cast<std::size_t>(ndigits) * 2
+		    || (sign != kNumericPositive && sign != kNumericNegative))
+		{
+			return false;
+		}
+
+		std::int64_t value = 0;
+		for (int i = 0; i < ndigits; ++i) {
+			const std::int64_t digit = readUint16(bytes.data() + 8 + i * 2);
+			const int exponent = 4 * (weight - i) + scale; // Power of ten this digit is worth after scaling
+			std::int64_t contribution;
+			if (exponent >= 0) {
+				if (exponent > 18 || digit > std::numeric_limits<std::int64_t>::max() / kPowersOfTen[exponent]) {
+					return false;
+				}
+				contribution = digit * kPowersOfTen[exponent];
+			}
+			else if (exponent > -4) {
+				contribution = digit / kPowersOfTen[-exponent];
+			}
+			else {
+				break; // Digits are ordered by decreasing weight, the rest are all below the scale
+			}
+
+			if (value > std::numeric_limits<std::int64_t>::max() - contribution) {
+				return false;
+			}
+			value += contribution;
+		}
+
+		out = sign == kNumericNegative ? -value : value;
+		return true;
+	}
+
+	void encodeInt2(std::string& out, std::int16_t value) {
+		auto bits = static_cast<std::uint16_t>(value);
+		out += static_cast<char>(bits >> 8);
+		out += static_cast<char>(bits & 0xFF);
+	}
+
+	void encodeInt4(std::string& out, std::int32_t value) {
+		auto bits = static_cast<std::uint32_t>(value);
+		out += static_cast<char>(bits >> 24);
+		out += static_cast<char>((bits >> 16) & 0xFF);
+		out += static_cast<char>((bits >> 8) & 0xFF);
+		out += static_cast<char>(bits & 0xFF);
+	}
+
+	void encodeInt8(std::string& out, std::int64_t value) {
+		auto bits = static_cast<std::uint64_t>(value);
+		encodeInt4(out, static_cast<std::int32_t>(static_cast<std::uint32_t>(bits >> 32)));
+		encodeInt4(out, static_cast<std::int32_t>(static_cast<std::uint32_t>(bits & 0xFFFFFFFF)));
+	}
+
+	void encodeBool(std::string& out, bool value) {
+		out += value ? '\1' : '\0';
+	}
+
+	void encodeDate(std::string& out, std::int32_t pgDays) {
+		encodeInt4(out, pgDays);
+	}
+
+	void encodeTimestamp(std::string& out, std::int64_t pgMicros) {
+		encodeInt8(out, pgMicros);
+	}
+
+	// Splits the value into base-10000 digits aligned on the decimal point, then drops leading and
+	// trailing zero digits as the server does; dscale keeps the displayed scale
+	void encodeNumeric(std::string& out, std::int64_t value, int scale) {
+		const bool negative = value < 0;
+		// Magnitude in unsigned arithmetic, so INT64_MIN does not overflow
+		const std::uint64_t magnitude =
+		    negative ? 0 - static_cast<std::uint64_t>(value) : static_cast<std::uint64_t>(value);
+		const auto unit = static_cast<std::uint64_t>(kPowersOfTen[scale]);
+		std::uint64_t whole = magnitude / unit;
+		std::uint64_t fraction = magnitude % unit;
+
+		// Digits are collected least significant first. The lowest fraction digit is padded on the right
+		// to a full four decimal places: 0.5 at scale 2 becomes the digit 5000.
+		const int fractionGroups = (scale + 3) / 4;
+		const int lowestPlaces = scale - (fractionGroups - 1) * 4;
+		std::uint16_t reversed[12]; // 5 for the whole part of an int64, 5 for an 18-place fraction
+		int count = 0;
+		for (int i = 0; i < fractionGroups; ++i) {
+			const int places = i == 0 ? lowestPlaces : 4;
+			const auto group = static_cast<std::uint64_t>(kPowersOfTen[places]);
+			reversed[count++] = static_cast<std::uint16_t>(fraction % group * kPowersOfTen[4 - places]);
+			fraction /= group;
+		}
+		int wholeCount = 0;
+		while (whole > 0) {
+			reversed[count++] = static_cast<std::uint16_t>(whole % 10000);
+			whole /= 10000;
+			++wholeCount;
+		}
+
+		std::uint16_t digits[12];
+		for (int i = 0; i < count; ++i) {
+			digits[i] = reversed[count - 1 - i];
+		}
+
+		int first = 0;
+		int weight = wholeCount - 1;
+		while (first < count && digits[first] == 0) {
+			++first;
+			--weight;
+		}
+		while (count > first && digits[count - 1] == 0) {
+			--count;
+		}
+		if (first == count) {
+			weight = 0; // Zero has no digits
+		}
+
+		encodeInt2(out, static_cast<std::int16_t>(count - first));
+		encodeInt2(out, static_cast<std::int16_t>(weight));
+		encodeInt2(out, static_cast<std::int16_t>(negative && first < count ? kNumericNegative : kNumericPositive));
+		encodeInt2(out, static_cast<std::int16_t>(scale));
+		for (int i = first; i < count; ++i) {
+			encodeInt2(out, static_cast<std::int16_t>(digits[i]));
+		}
+	}
+
+	static bool allDigits(std::string_view text) {
+		for (char c : text) {
+			if (c < '0' || c > '9') {
+				return false;
+			}
+		}
+		return true;
+	}
+
+	bool parseNumericText(std::string_view text, int scale, std::int64_t& out, int precision) {
+		if (text.empty() || scale < 0 || scale > 18 || precision < 0 || precision > 18) {
+			return false;
+		}
+		bool negative = text.front() == '-';
+		if (negative || text.front() == '+') {
+			text.remove_prefix(1);
+		}
+
+		std::size_t dot = text.find('.');
+		std::string_view whole = text.substr(0, dot);
+		std::string_view fraction = dot == std::string_view::npos ? std::string_view() : text.substr(dot + 1);
+		if ((whole.empty() && fraction.empty()) || !allDigits(whole) || !allDigits(fraction)) {
+			return false; // Also "", ".", "-" and a second sign or dot
+		}
+		while (whole.size() > 1 && whole.front() == '0') {
+			whole.remove_prefix(1);
+		}
+		if (whole.size() > 18) {
+			return false;
+		}
+
+		std::int64_t wholeValue = 0;
+		if (!whole.empty()) {
+			std::from_chars(whole.data(), whole.data() + whole.size(), wholeValue);
+		}
+
+		std::string_view kept = fraction.substr(0, std::min(fraction.size(), static_cast<std::size_t>(scale)));
+		bool roundUp = fraction.size() > kept.size() && fraction[kept.size()] >= '5';
+		std::int64_t fractionValue = 0;
+		if (!kept.empty()) {
+			std::from_chars(kept.data(), kept.data() + kept.size(), fractionValue);
+		}
+		fractionValue = fractionValue * kPowersOfTen[scale - static_cast<int>(kept.size())] + (roundUp ? 1 : 0);
+
+		if (wholeValue > (std::numeric_limits<std::int64_t>::max() - fractionValue) / kPowersOfTen[scale]) {
+			return false;
+		}
+		std::int64_t value = wholeValue * kPowersOfTen[scale] + fractionValue;
+		if (precision > 0 && value >= kPowersOfTen[precision]) {
+			return false;
+		}
+		out = negative ? -value : value;
+		return true;
+	}
+
+	static unsigned daysInMonth(int year, unsigned month) {
+		if (month == 2) {
+			bool leap = year % 4 == 0 && (year % 100 != 0 || year % 400 == 0);
+			return leap ? 29 : 28;
+		}
+		return month == 4 || month == 6 || month == 9 || month == 11 ? 30 : 31;
+	}
+
+	bool parseDateText(std::string_view text, std::int32_t& pgDays) {
+		// ISO DateStyle: YYYY-MM-DD
+		if (text.size() != 10 || text[4] != '-' || text[7] != '-' || !allDigits(text.substr(0, 4))
+		    || !allDigits(text.substr(5, 2)) || !allDigits(text.substr(8, 2)))
+		{
+			return false;
+		}
+		int year = 0;
+		unsigned month = 0, day = 0;
+		const char* data = text.data();
+		std::from_chars(data, data + 4, year);
+		std::from_chars(data + 5, data + 7, month);
+		std::from_chars(data + 8, data + 10, day);
+		if (year < 1 || month < 1 || month > 12 || day < 1 || day > daysInMonth(year, month)) {
+			return false;
+		}
+		pgDays = daysFromCivil(year, month, day) - kPostgresEpochDays;
+		return true;
+	}
+
+	pgsqlHandles::PgResult execBinary(PGconn* conn, const char* sql, const std::vector<std::string>& params) {
+		std::vector<const char*> values;
+		values.reserve(params.size());
+		for (const std::string& param : params) {
+			values.push_back(param.c_str());
+		}
+		return pgsqlHandles::PgResult(
+		    PQexecParams(conn, sql, static_cast<int>(values.size()), nullptr, values.data(), nullptr, nullptr, 1));
+	}
+} // namespace pgsqlBinary
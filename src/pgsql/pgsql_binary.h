@@ -0,0 +1,62 @@
+#ifndef PGSQL_BINARY_H
+#define PGSQL_BINARY_H
+
+#include "libpq-fe.h"
+#include "pgsql_handles.h"
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace pgsqlBinary {
+
+	// Calendar date; PostgreSQL stores DATE as days since 2000-01-01
+	struct Date {
+		int year;
+		unsigned month;
+		unsigned day;
+	};
+
+	// Days between 1970-01-01 and the PostgreSQL epoch 2000-01-01
+	constexpr std::int32_t kPostgresEpochDays = 10957;
+
+	std::int32_t daysFromCivil(int year, unsigned month, unsigned day);
+	Date civilFromDays(std::int32_t daysSinceUnixEpoch);
+
+	// Decoders for resultFormat=1 values; each returns false when the byte length does not match
+	bool decodeInt4(std::string_view bytes, std::int32_t& out);
+	bool decodeInt8(std::string_view bytes, std::int64_t& out);
+	bool decodeBool(std::string_view bytes, bool& out);
+	bool decodeDate(std::string_view bytes, std::int32_t& pgDays); // Days since 2000-01-01
+	bool decodeTimestamp(std::string_view bytes, std::int64_t& pgMicros); // Microseconds since 2000-01-01
+
+	// Decodes a binary NUMERIC into an integer scaled by 10^scale (cents for scale 2).
+	// Digits beyond `scale` are truncated; NaN, infinities and overflow return false.
+	bool decodeNumeric(std::string_view bytes, int scale, std::int64_t& out);
+
+	// Encoders for binary parameters and binary COPY; each appends the value's wire bytes to out
+	void encodeInt2(std::string& out, std::int16_t value);
+	void encodeInt4(std::string& out, std::int32_t value);
+	void encodeInt8(std::string& out, std::int64_t value);
+	void encodeBool(std::string& out, bool value);
+	void encodeDate(std::string& out, std::int32_t pgDays); // Days since 2000-01-01
+	void encodeTimestamp(std::string& out, std::int64_t pgMicros); // Microseconds since 2000-01-01
+
+	// Encodes an integer scaled by 10^scale (cents for scale 2) as a NUMERIC with dscale = scale.
+	// Exact inverse of decodeNumeric; scale must be in 0..18.
+	void encodeNumeric(std::string& out, std::int64_t value, int scale);
+
+	// Text-format counterparts, used by the benchmark baseline, by text results and to validate CSV input.
+	// Digits beyond `scale` are rounded half away from zero, as the server does. A non-zero precision
+	// rejects values that do not fit NUMERIC(precision, scale) after rounding.
+	bool parseNumericText(std::string_view text, int scale, std::int64_t& out, int precision = 0);
+
+	// ISO YYYY-MM-DD; the month and the day must exist in that year
+	bool parseDateText(std::string_view text, std::int32_t& pgDays);
+
+	// Run a query with resultFormat=1 so every column arrives in binary
+	pgsqlHandles::PgResult execBinary(PGconn* conn, const char* sql, const std::vector<std::string>& params = {});
+
+} // namespace pgsqlBinary
+
+#endif // PGSQL_BINARY_H
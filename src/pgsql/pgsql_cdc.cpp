@@ -0,0 +1,525 @@
+#include "pgsql_cdc.h"
+#include "pgsql_binary.h"
+#include "pgsql_handles.h"
+
+#include <algorithm>
+#include <cctype>
+#include <charconv>
+#include <cstdio>
+#include <exception>
+#include <fstream>
+#include <poll.h>
+
+namespace pgsqlCdc {
+	using Clock = std::chrono::steady_clock;
+
+	// Microseconds between the Unix epoch and the PostgreSQL epoch 2000-01-01
+	constexpr std::int64_t kPostgresEpochMicros = 946684800LL * 1000000;
+
+	std::string formatLsn(Lsn lsn) {
+		char text[32];
+		std::snprintf(text,
+		              sizeof(text),
+		              "%X/%X",
+		              static_cast<unsigned>(lsn >> 32),
+		              static_cast<unsigned>(lsn & 0xFFFFFFFF));
+		return text;
+	}
+
+	bool parseLsn(std::string_view text, Lsn& lsn) {
+		std::size_t slash = text.find('/');
+		if (slash == std::string_view::npos || slash == 0 || slash + 1 == text.size()) {
+			return false;
+		}
+		std::uint32_t high = 0;
+		std::uint32_t low = 0;
+		const char* end = text.data() + text.size();
+		auto [highEnd, highError] = std::from_chars(text.data(), text.data() + slash, high, 16);
+		auto [lowEnd, lowError] = std::from_chars(text.data() + slash + 1, end, low, 16);
+		if (highError != std::errc() || highEnd != text.data() + slash || lowError != std::errc() || lowEnd != end) {
+			return false;
+		}
+		lsn = (static_cast<Lsn>(high) << 32) | low;
+		return true;
+	}
+
+	const char* changeKindName(ChangeKind kind) {
+		switch (kind) {
+		case ChangeKind::Insert: return "INSERT";
+		case ChangeKind::Update: return "UPDATE";
+		case ChangeKind::Delete: return "DELETE";
+		case ChangeKind::Truncate: return "TRUNCATE";
+		}
+		return "";
+	}
+
+	static bool sameName(std::string_view a, std::string_view b) {
+		return a.size() == b.size() && std::equal(a.begin(), a.end(), b.begin(), [](unsigned char x, unsigned char y) {
+			       return std::tolower(x) == std::tolower(y);
+		       });
+	}
+
+	// Big-endian fields of a pgoutput message; any read past the end clears ok()
+	class MessageReader {
+	 public:
+		explicit MessageReader(std::string_view data)
+		: data_(data) {}
+
+		template<typename T>
+		T integer() {
+			if (data_.size() - pos_ < sizeof(T)) {
+				ok_ = false;
+				pos_ = data_.size();
+				return 0;
+			}
+			std::uint64_t value = 0;
+			for (std::size_t i = 0; i < sizeof(T); ++i) {
+				value = (value << 8) | static_cast<unsigned char>(data_[pos_++]);
+			}
+			return static_cast<T>(value);
+		}
+
+		// NUL-terminated string
+		std::string_view string() {
+			std::size_t end = data_.find('\0', pos_);
+			if (end == std::string_view::npos) {
+				ok_ = false;
+				pos_ = data_.size();
+				return {};
+			}
+			std::string_view value = data_.substr(pos_, end - pos_);
+			pos_ = end + 1;
+			return value;
+		}
+
+		std::string_view bytes(std::size_t length) {
+			if (data_.size() - pos_ < length) {
+				ok_ = false;
+				pos_ = data_.size();
+				return {};
+			}
+			std::string_view value = data_.substr(pos_, length);
+			pos_ += length;
+			return value;
+		}
+
+		[[nodiscard]] bool ok() const {
+			return ok_;
+		}
+
+	 private:
+		std::string_view data_;
+		std::size_t pos_ = 0;
+		bool ok_ = true;
+	};
+
+	// TupleData: column count, then per column 'n' (NULL), 'u' (unchanged TOAST, treated as NULL) or
+	// 't' with a length-prefixed text value
+	static bool readTuple(MessageReader& reader, std::vector<std::optional<std::string_view>>& values) {
+		values.clear();
+		auto count = reader.integer<std::uint16_t>();
+		for (std::uint16_t i = 0; i < count && reader.ok(); ++i) {
+			auto kind = reader.integer<char>();
+			if (kind == 't') {
+				values.emplace_back(reader.bytes(reader.integer<std::uint32_t>()));
+			}
+			else if (kind == 'n' || kind == 'u') {
+				values.emplace_back(std::nullopt);
+			}
+			else {
+				return false; // 'b' only comes with the binary option, which is never requested
+			}
+		}
+		return reader.ok();
+	}
+
+	template<typename Table, std::size_t I>
+	static bool decodeColumn(const std::vector<std::string>& columns,
+	                         const std::vector<std::optional<std::string_view>>& values,
+	                         typename Table::Row& row,
+	                         std::string& error) {
+		using Column = std::tuple_element_t<I, std::remove_const_t<decltype(Table::columns)>>;
+		const char* name = std::get<I>(Table::columns).name;
+		auto found = std::find_if(
+		    columns.begin(), columns.end(), [&](const std::string& column) { return sameName(column, name); });
+		auto index = static_cast<std::size_t>(found - columns.begin());
+		if (index >= values.size()) {
+			return true; // Column not replicated: left value-initialized
+		}
+		if (!parseTextValue<Column::type>(values[index], row.*Column::member)) {
+			error = std::string(Table::name) + "." + name + ": cannot parse '" + std::string(values[index].value_or(""))
+			        + "'";
+			return false;
+		}
+		return true;
+	}
+
+	template<typename Table, std::size_t... I>
+	static bool decodeColumns(const std::vector<std::string>& columns,
+	                          const std::vector<std::optional<std::string_view>>& values,
+	                          typename Table::Row& row,
+	                          std::string& error,
+	                          std::index_sequence<I...>) {
+		return (decodeColumn<Table, I>(columns, values, row, error) && ...);
+	}
+
+	template<typename Table>
+	static bool decodeRow(const std::vector<std::string>& columns,
+	                      const std::vector<std::optional<std::string_view>>& values,
+	                      typename Table::Row& row,
+	                      std::string& error) {
+		return decodeColumns<Table>(
+		    columns, values, row, error, std::make_index_sequence<pgsqlSchema::columnCount<Table>()>{});
+	}
+
+	bool PgOutputDecoder::decode(std::string_view message,
+	                             Lsn walStart,
+	                             std::vector<ChangeEvent>& events,
+	                             std::string& error) {
+		MessageReader reader(message);
+		auto tag = reader.integer<char>();
+
+		switch (tag) {
+		case 'B': // Begin: final LSN, commit time, xid
+			finalLsn_ = reader.integer<std::uint64_t>();
+			commitTime_ = reader.integer<std::int64_t>();
+			xid_ = reader.integer<std::uint32_t>();
+			inTransaction_ = true;
+			break;
+		case 'C': { // Commit: flags, commit LSN, end LSN, commit time
+			reader.integer<std::uint8_t>();
+			reader.integer<std::uint64_t>();
+			Lsn end = reader.integer<std::uint64_t>();
+			reader.integer<std::int64_t>();
+			inTransaction_ = false;
+			committed_ = end;
+			break;
+		}
+		case 'R': { // Relation: OID, namespace, name, replica identity, columns
+			auto oid = reader.integer<std::uint32_t>();
+			reader.string();
+			Relation relation{std::string(reader.string()), {}};
+			reader.integer<std::uint8_t>();
+			auto count = reader.integer<std::uint16_t>();
+			for (std::uint16_t i = 0; i < count && reader.ok(); ++i) {
+				reader.integer<std::uint8_t>(); // Part of the key
+				relation.columns.emplace_back(reader.string());
+				reader.integer<std::uint32_t>(); // Type OID
+				reader.integer<std::int32_t>(); // Type modifier
+			}
+			relations_[oid] = std::move(relation);
+			break;
+		}
+		case 'I':
+		case 'U':
+		case 'D': {
+			auto oid = reader.integer<std::uint32_t>();
+			auto relation = relations_.find(oid);
+			if (relation == relations_.end()) {
+				error = "change for relation " + std::to_string(oid) + " before its Relation message";
+				return false;
+			}
+
+			// Insert: 'N' new. Update: optional 'K' key / 'O' old, then 'N' new. Delete: 'K' or 'O'.
+			std::vector<std::optional<std::string_view>> oldValues;
+			std::vector<std::optional<std::string_view>> newValues;
+			auto part = reader.integer<char>();
+			bool hasOld = part == 'K' || part == 'O';
+			if (hasOld && !readTuple(reader, oldValues)) {
+				error = "malformed old tuple";
+				return false;
+			}
+			if (tag != 'D') {
+				if (hasOld) {
+					part = reader.integer<char>();
+				}
+				if (part != 'N' || !readTuple(reader, newValues)) {
+					error = "malformed new tuple";
+					return false;
+				}
+			}
+
+			ChangeKind kind = tag == 'I' ? ChangeKind::Insert : tag == 'U' ? ChangeKind::Update : ChangeKind::Delete;
+			bool ok = true;
+			pgsqlSchema::forEachTable<CdcTables>([&](auto table) {
+				using Table = decltype(table);
+				if (!ok || !sameName(Table::name, relation->second.name)) {
+					return;
+				}
+				Change<Table> change;
+				change.kind = kind;
+				const std::vector<std::string>& columns = relation->second.columns;
+				ok = decodeRow<Table>(columns, kind == ChangeKind::Delete ? oldValues : newValues, change.row, error);
+				if (ok && kind == ChangeKind::Update && hasOld) {
+					change.old.emplace();
+					ok = decodeRow<Table>(columns, oldValues, *change.old, error);
+				}
+				if (ok) {
+					events.push_back({walStart, finalLsn_, xid_, commitTime_, std::move(change)});
+				}
+			});
+			if (!ok) {
+				return false;
+			}
+			break;
+		}
+		case 'T': { // Truncate: relation count, options, OIDs
+			auto count = reader.integer<std::uint32_t>();
+			reader.integer<std::uint8_t>();
+			for (std::uint32_t i = 0; i < count && reader.ok(); ++i) {
+				auto relation = relations_.find(reader.integer<std::uint32_t>());
+				if (relation == relations_.end()) {
+					continue;
+				}
+				pgsqlSchema::forEachTable<CdcTables>([&](auto table) {
+					using Table = decltype(table);
+					if (sameName(Table::name, relation->second.name)) {
+						Change<Table> change;
+						change.kind = ChangeKind::Truncate;
+						events.push_back({walStart, finalLsn_, xid_, commitTime_, std::move(change)});
+					}
+				});
+			}
+			break;
+		}
+		case 'O': // Origin
+		case 'Y': // Type
+		case 'M': // Logical decoding message
+			return true;
+		default: error = std::string("unknown pgoutput message '") + tag + "'"; return false;
+		}
+
+		if (!reader.ok()) {
+			error = std::string("truncated pgoutput message '") + tag + "'";
+			return false;
+		}
+		return true;
+	}
+
+	CdcConsumer::CdcConsumer(std::string conninfo, CdcOptions options)
+	: conninfo_(std::move(conninfo))
+	, options_(std::move(options)) {}
+
+	// Slot and publication names go into commands unquoted, so keep them to what slots accept anyway
+	static bool validName(const std::string& name) {
+		return !name.empty() && name.size() < 64 && std::all_of(name.begin(), name.end(), [](unsigned char c) {
+			return std::islower(c) || std::isdigit(c) || c == '_';
+		});
+	}
+
+	static pgsqlHandles::PgResult execParam(PGconn* conn, const char* sql, const std::string& param) {
+		const char* values[] = {param.c_str()};
+		return pgsqlHandles::PgResult(PQexecParams(conn, sql, 1, nullptr, values, nullptr, nullptr, 0));
+	}
+
+	bool CdcConsumer::setup(std::string& error) {
+		if (!validName(options_.slot) || !validName(options_.publication)) {
+			error = "slot and publication names may only use a-z, 0-9 and _";
+			return false;
+		}
+		pgsqlHandles::PgConn conn = pgsqlHandles::PgConn::connect(conninfo_);
+		if (!conn.ok()) {
+			error = conn.errorMessage();
+			return false;
+		}
+
+		pgsqlHandles::PgResult publication =
+		    execParam(conn.get(), "SELECT 1 FROM pg_publication WHERE pubname = $1;", options_.publication);
+		if (!publication.ok()) {
+			error = publication.errorMessage();
+			return false;
+		}
+		if (publication.rows() == 0) {
+			// Changes to monthly partitions are published as changes to Orders / Inventory_Actions (PostgreSQL 13+)
+			bool viaRoot = PQserverVersion(conn.get()) >= 130000;
+			std::string sql = "CREATE PUBLICATION " + options_.publication + " FOR TABLE "
+			                  + pgsqlSchema::tableList<CdcTables>()
+			                  + (viaRoot ? " WITH (publish_via_partition_root = true);" : ";");
+			pgsqlHandles::PgResult created = pgsqlHandles::PgResult::exec(conn.get(), sql.c_str());
+			if (!created.ok()) {
+				error = created.errorMessage();
+				return false;
+			}
+		}
+
+		pgsqlHandles::PgResult slot = execParam(
+		    conn.get(),
+		    "SELECT pg_create_logical_replication_slot($1, 'pgoutput') WHERE NOT EXISTS "
+		    "(SELECT 1 FROM pg_replication_slots WHERE slot_name = $1);",
+		    options_.slot);
+		if (!slot.ok()) {
+			error = slot.errorMessage(); // e.g. wal_level is not logical
+			return false;
+		}
+		return true;
+	}
+
+	bool CdcConsumer::dropSlot(std::string& error) {
+		pgsqlHandles::PgConn conn = pgsqlHandles::PgConn::connect(conninfo_);
+		if (!conn.ok()) {
+			error = conn.errorMessage();
+			return false;
+		}
+		pgsqlHandles::PgResult res = execParam(
+		    conn.get(),
+		    "SELECT pg_drop_replication_slot(slot_name) FROM pg_replication_slots WHERE slot_name = $1;",
+		    options_.slot);
+		if (!res.ok()) {
+			error = res.errorMessage();
+			return false;
+		}
+		if (!options_.checkpointPath.empty()) {
+			std::remove(options_.checkpointPath.c_str()); // Its position belonged to the dropped slot
+		}
+		return true;
+	}
+
+	void CdcConsumer::saveCheckpoint() const {
+		if (options_.checkpointPath.empty()) {
+			return;
+		}
+		// Written aside and renamed, so a crash leaves either the old or the new position
+		std::string temporary = options_.checkpointPath + ".tmp";
+		{
+			std::ofstream file(temporary, std::ios::trunc);
+			file << formatLsn(acknowledged_) << "\n";
+			if (!file) {
+				return;
+			}
+		}
+		std::rename(temporary.c_str(), options_.checkpointPath.c_str());
+	}
+
+	// Standby status update: written, flushed and applied position, client clock, no reply requested
+	bool CdcConsumer::sendStatus(PGconn* conn, std::string& error) {
+		std::string status(1, 'r');
+		auto appendInt64 = [&](std::uint64_t value) {
+			for (int shift = 56; shift >= 0; shift -= 8) {
+				status += static_cast<char>((value >> shift) & 0xFF);
+			}
+		};
+		Lsn position = acknowledged_;
+		appendInt64(position);
+		appendInt64(position);
+		appendInt64(position);
+		auto now = std::chrono::duration_cast<std::chrono::microseconds>(
+		               std::chrono::system_clock::now().time_since_epoch())
+		               .count();
+		appendInt64(static_cast<std::uint64_t>(now - kPostgresEpochMicros));
+		status += '\0';
+
+		if (PQputCopyData(conn, status.data(), static_cast<int>(status.size())) != 1 || PQflush(conn) != 0) {
+			error = PQerrorMessage(conn);
+			return false;
+		}
+		return true;
+	}
+
+	bool CdcConsumer::run(const std::atomic<bool>& stop, std::string& error) {
+		if (!validName(options_.slot) || !validName(options_.publication)) {
+			error = "slot and publication names may only use a-z, 0-9 and _";
+			return false;
+		}
+		if (!options_.checkpointPath.empty()) {
+			std::ifstream file(options_.checkpointPath);
+			std::string text;
+			Lsn saved = 0;
+			if (file >> text && parseLsn(text, saved) && saved > acknowledged_) {
+				acknowledged_ = saved;
+			}
+		}
+
+		// expand_dbname lets conninfo be a key/value string or a URI
+		const char* keywords[] = {"dbname", "replication", nullptr};
+		const char* values[] = {conninfo_.c_str(), "database", nullptr};
+		pgsqlHandles::PgConn conn(PQconnectdbParams(keywords, values, 1));
+		if (!conn.ok()) {
+			error = conn.errorMessage();
+			return false;
+		}
+
+		// From 0/0 the server resumes at the slot's confirmed position; a later checkpoint skips ahead
+		std::string start = "START_REPLICATION SLOT " + options_.slot + " LOGICAL " + formatLsn(acknowledged_)
+		                    + " (proto_version '1', publication_names '" + options_.publication + "')";
+		pgsqlHandles::PgResult started = pgsqlHandles::PgResult::exec(conn.get(), start.c_str());
+		if (started.status() != PGRES_COPY_BOTH) {
+			error = started.errorMessage();
+			return false;
+		}
+
+		PgOutputDecoder decoder;
+		std::vector<ChangeEvent> events;
+		auto lastStatus = Clock::now();
+		bool statusDue = false;
+		bool ok = true;
+
+		while (ok && !stop) {
+			char* buffer = nullptr;
+			int length = PQgetCopyData(conn.get(), &buffer, 1);
+			if (length == 0) {
+				// Nothing buffered: wait briefly for the socket so stop and status deadlines are noticed
+				pollfd socket{PQsocket(conn.get()), POLLIN, 0};
+				poll(&socket, 1, 100);
+				if (PQconsumeInput(conn.get()) == 0) {
+					error = PQerrorMessage(conn.get());
+					ok = false;
+				}
+			}
+			else if (length > 0) {
+				std::string_view message(buffer, static_cast<std::size_t>(length));
+				if (message[0] == 'w' && message.size() >= 25) { // XLogData: start, end, send time, payload
+					MessageReader header(message.substr(1, 8));
+					Lsn walStart = header.integer<std::uint64_t>();
+					ok = decoder.decode(message.substr(25), walStart, events, error);
+					try {
+						for (std::size_t i = 0; ok && i < events.size(); ++i) {
+							const ChangeEvent& event = events[i];
+							if (event.commitLsn < acknowledged_) {
+								continue; // Replayed from a transaction acknowledged before a restart
+							}
+							for (const auto& subscriber : subscribers_) {
+								subscriber(event);
+							}
+						}
+					} catch (const std::exception& e) {
+						error = std::string("subscriber failed: ") + e.what();
+						ok = false;
+					}
+					events.clear();
+					std::optional<Lsn> committed = decoder.takeCommit();
+					if (ok && committed && *committed > acknowledged_) {
+						acknowledged_ = *committed;
+						saveCheckpoint();
+					}
+				}
+				else if (message[0] == 'k' && message.size() >= 18) { // Keepalive: end, send time, reply
+					MessageReader header(message.substr(1, 8));
+					Lsn walEnd = header.integer<std::uint64_t>();
+					// Outside a transaction nothing before walEnd is pending; without this an idle store
+					// would keep its WAL pinned by the slot
+					if (!decoder.inTransaction() && walEnd > acknowledged_) {
+						acknowledged_ = walEnd;
+						saveCheckpoint();
+					}
+					statusDue = statusDue || message[17] != 0;
+				}
+				PQfreemem(buffer);
+			}
+			else {
+				error = length == -1 ? "server ended the replication stream" : PQerrorMessage(conn.get());
+				ok = false;
+			}
+
+			if (ok && (statusDue || Clock::now() - lastStatus >= options_.statusInterval)) {
+				ok = sendStatus(conn.get(), error);
+				lastStatus = Clock::now();
+				statusDue = false;
+			}
+		}
+
+		// Report the final position; a subscriber failure keeps its transaction unacknowledged
+		std::string ignored;
+		sendStatus(conn.get(), ignored);
+		return ok;
+	}
+} // namespace pgsqlCdc
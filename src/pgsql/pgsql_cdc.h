@@ -0,0 +1,186 @@
+#ifndef PGSQL_CDC_H
+#define PGSQL_CDC_H
+
+#include "libpq-fe.h"
+#include "pgsql_schema.h"
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <tuple>
+#include <unordered_map>
+#include <utility>
+#include <variant>
+#include <vector>
+
+namespace pgsqlCdc {
+
+	// WAL position; "X/Y" in text, the high and low 32 bits in hex
+	using Lsn = std::uint64_t;
+
+	std::string formatLsn(Lsn lsn);
+	bool parseLsn(std::string_view text, Lsn& lsn);
+
+	// Tables whose changes are captured
+	using CdcTables = std::tuple<pgsqlSchema::Orders, pgsqlSchema::OrderItems, pgsqlSchema::InventoryActions>;
+
+	enum class ChangeKind { Insert, Update, Delete, Truncate };
+
+	const char* changeKindName(ChangeKind kind);
+
+	// One row change of Table. row is the new row for Insert / Update; for Delete it holds the old
+	// primary key with every other column value-initialized (REPLICA IDENTITY DEFAULT), and for
+	// Truncate it is empty. old is set for an Update that changed the key.
+	template<typename Table>
+	struct Change {
+		ChangeKind kind = ChangeKind::Insert;
+		typename Table::Row row{};
+		std::optional<typename Table::Row> old;
+	};
+
+	using AnyChange = std::variant<Change<pgsqlSchema::Orders>,
+	                               Change<pgsqlSchema::OrderItems>,
+	                               Change<pgsqlSchema::InventoryActions>>;
+
+	struct ChangeEvent {
+		Lsn lsn = 0; // Start of the WAL record carrying the change
+		Lsn commitLsn = 0; // Commit record of its transaction
+		std::uint32_t xid = 0;
+		std::int64_t commitTime = 0; // Microseconds since 2000-01-01 UTC
+		AnyChange change;
+	};
+
+	// Decodes pgoutput (protocol version 1) messages into change events. Relation messages are cached
+	// by OID, so a decoder must see a stream from its start; columns are matched to the descriptors by
+	// name, so column order and unknown extra columns do not matter.
+	class PgOutputDecoder {
+	 public:
+		// Decodes one message, the payload of an XLogData. Changes to CdcTables are appended to events;
+		// changes to other tables, Origin, Type and Message records are skipped.
+		bool decode(std::string_view message, Lsn walStart, std::vector<ChangeEvent>& events, std::string& error);
+
+		// End LSN of a transaction whose Commit was just decoded, once; acknowledge it after its events
+		// have been handled
+		std::optional<Lsn> takeCommit() {
+			return std::exchange(committed_, std::nullopt);
+		}
+
+		// Between Begin and Commit
+		[[nodiscard]] bool inTransaction() const {
+			return inTransaction_;
+		}
+
+	 private:
+		struct Relation {
+			std::string name;
+			std::vector<std::string> columns;
+		};
+
+		std::unordered_map<std::uint32_t, Relation> relations_;
+		bool inTransaction_ = false;
+		Lsn finalLsn_ = 0;
+		std::int64_t commitTime_ = 0;
+		std::uint32_t xid_ = 0;
+		std::optional<Lsn> committed_;
+	};
+
+	struct CdcOptions {
+		std::string slot = "petstore_cdc";
+		std::string publication = "petstore_cdc";
+		std::chrono::milliseconds statusInterval{10000}; // Standby status updates at least this often
+		std::string checkpointPath; // Optional file keeping the last acknowledged LSN across restarts
+	};
+
+	// Streams Orders, Order_Items and Inventory_Actions changes from a logical replication slot
+	// (wal_level = logical) to in-process subscribers. Delivery is at least once: a transaction is
+	// acknowledged after every subscriber returned for all of its events, and a restart resumes after
+	// the last acknowledged transaction. The role needs REPLICATION and must own the tables.
+	class CdcConsumer {
+	 public:
+		explicit CdcConsumer(std::string conninfo, CdcOptions options = {});
+
+		// Every event; call before run()
+		void subscribe(std::function<void(const ChangeEvent&)> handler) {
+			subscribers_.push_back(std::move(handler));
+		}
+
+		// Events of one table only
+		template<typename Table>
+		void subscribe(std::function<void(const ChangeEvent&, const Change<Table>&)> handler) {
+			subscribers_.push_back([handler = std::move(handler)](const ChangeEvent& event) {
+				if (const auto* change = std::get_if<Change<Table>>(&event.change)) {
+					handler(event, *change);
+				}
+			});
+		}
+
+		// Creates the publication and the slot unless they exist. The slot keeps WAL from being
+		// recycled until it is consumed, so drop it when the consumer is retired.
+		bool setup(std::string& error);
+		bool dropSlot(std::string& error);
+
+		// Streams until stop is set or the connection fails. A throwing subscriber ends the run without
+		// acknowledging its transaction, so it is delivered again on the next run.
+		bool run(const std::atomic<bool>& stop, std::string& error);
+
+		[[nodiscard]] Lsn acknowledged() const {
+			return acknowledged_;
+		}
+
+	 private:
+		bool sendStatus(PGconn* conn, std::string& error);
+		void saveCheckpoint() const;
+
+		std::string conninfo_;
+		CdcOptions options_;
+		std::vector<std::function<void(const ChangeEvent&)>> subscribers_;
+		std::atomic<Lsn> acknowledged_{0};
+	};
+
+	// Decodes a text-format column value into a Row field; NULL leaves the field value-initialized
+	template<pgsqlSchema::SqlType Type, typename Field>
+	bool parseTextValue(std::optional<std::string_view> text, Field& field) {
+		if constexpr (pgsqlSchema::IsOptional<Field>::value) {
+			if (!text) {
+				field.reset();
+				return true;
+			}
+			typename Field::value_type value{};
+			if (!parseTextValue<Type>(text, value)) {
+				return false;
+			}
+			field = std::move(value);
+			return true;
+		}
+		else {
+			field = Field{};
+			if (!text) {
+				return true;
+			}
+			if constexpr (Type == pgsqlSchema::SqlType::Boolean || Type == pgsqlSchema::SqlType::Serial
+			              || Type == pgsqlSchema::SqlType::Integer)
+			{
+				std::optional<Field> value = pgsqlHandles::RowView::parse<Field>(*text);
+				field = value.value_or(Field{});
+				return value.has_value();
+			}
+			else if constexpr (Type == pgsqlSchema::SqlType::Text) {
+				field.assign(*text);
+				return true;
+			}
+			else if constexpr (Type == pgsqlSchema::SqlType::Money) {
+				return pgsqlBinary::parseNumericText(*text, 2, field);
+			}
+			else {
+				static_assert(Type == pgsqlSchema::SqlType::Date && std::is_same_v<Field, std::int32_t>);
+				return pgsqlBinary::parseDateText(*text, field);
+			}
+		}
+	}
+
+} // namespace pgsqlCdc
+
+#endif // PGSQL_CDC_H
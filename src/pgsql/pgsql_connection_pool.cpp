@@ -0,0 +1,310 @@
+#include "pgsql_connection_pool.h"
+#include "pgsql_prepared.h"
+
+#include <algorithm>
+#include <iostream>
+#include <poll.h>
+#include <utility>
+#include <vector>
+
+namespace pgsqlPool {
+	thread_local std::size_t acquireTimeouts = 0;
+
+	// Every connection the pool closes goes through here so per-session caches are dropped with it
+	static void closeConnection(PGconn* conn) {
+		pgsqlPrepared::PreparedStatementRegistry::instance().forget(conn);
+		PQfinish(conn);
+	}
+
+	PooledConnection::PooledConnection(PgConnectionPool* pool, ConnectionSubPool* subPool, PGconn* conn)
+	: pool_(pool)
+	, subPool_(subPool)
+	, conn_(conn) {}
+
+	PooledConnection::~PooledConnection() {
+		release();
+	}
+
+	PooledConnection::PooledConnection(PooledConnection&& other) noexcept
+	: pool_(std::exchange(other.pool_, nullptr))
+	, subPool_(std::exchange(other.subPool_, nullptr))
+	, conn_(std::exchange(other.conn_, nullptr)) {}
+
+	PooledConnection& PooledConnection::operator=(PooledConnection&& other) noexcept {
+		if (this != &other) {
+			release();
+			pool_ = std::exchange(other.pool_, nullptr);
+			subPool_ = std::exchange(other.subPool_, nullptr);
+			conn_ = std::exchange(other.conn_, nullptr);
+		}
+		return *this;
+	}
+
+	void PooledConnection::release() {
+		if (conn_) {
+			pool_->release(*subPool_, conn_, true);
+			conn_ = nullptr;
+		}
+	}
+
+	void PooledConnection::discard() {
+		if (conn_) {
+			pool_->release(*subPool_, conn_, false);
+			conn_ = nullptr;
+		}
+	}
+
+	std::vector<PGconn*> takeExpired(ConnectionSubPool& sub,
+	                                 std::size_t minSize,
+	                                 std::chrono::steady_clock::time_point cutoff) {
+		std::vector<PGconn*> expired;
+		// The front of the deque holds the least recently used connections
+		while (!sub.idle.empty() && sub.open > minSize && sub.idle.front().lastUsed < cutoff) {
+			expired.push_back(sub.idle.front().conn);
+			sub.idle.pop_front();
+			--sub.open;
+		}
+		return expired;
+	}
+
+	PgConnectionPool::PgConnectionPool(PoolOptions options)
+	: options_(options)
+	, lastSweep_(std::chrono::steady_clock::now().time_since_epoch().count()) {
+		if (options_.maxSize == 0) {
+			options_.maxSize = 1;
+		}
+		if (options_.minSize > options_.maxSize) {
+			options_.minSize = options_.maxSize;
+		}
+	}
+
+	// Every handle must have been released before the pool is destroyed
+	PgConnectionPool::~PgConnectionPool() {
+		clear();
+	}
+
+	PgConnectionPool& PgConnectionPool::instance() {
+		static PgConnectionPool pool;
+		return pool;
+	}
+
+	PooledConnection PgConnectionPool::acquire(const std::string& conninfo) {
+		// Only the caller that moves lastSweep_ forward sweeps, so concurrent acquires never pile up on it
+		std::chrono::steady_clock::rep now = std::chrono::steady_clock::now().time_since_epoch().count();
+		std::chrono::steady_clock::rep last = lastSweep_.load();
+		bool due = std::chrono::steady_clock::duration(now - last) >= options_.idleTimeout;
+		if (due && lastSweep_.compare_exchange_strong(last, now)) {
+			evictIdle();
+		}
+
+		bool created = false;
+		ConnectionSubPool& sub = subPool(conninfo, created);
+		if (created) {
+			warmUp(sub);
+		}
+
+		auto deadline = std::chrono::steady_clock::now() + options_.acquireTimeout;
+		std::unique_lock<std::mutex> lock(sub.mutex);
+
+		while (true) {
+			// Reuse the most recently returned connection first, it is the least likely to be stale
+			while (!sub.idle.empty()) {
+				IdleConnection candidate = sub.idle.back();
+				sub.idle.pop_back();
+				lock.unlock();
+
+				if (isHealthy(candidate)) {
+					++sub.reused;
+					return {this, &sub, candidate.conn};
+				}
+
+				closeConnection(candidate.conn);
+				++sub.failedHealthChecks;
+				lock.lock();
+				--sub.open;
+			}
+
+			if (sub.open < sub.maxSize) {
+				++sub.open; // Reserve the slot before connecting outside the lock
+				lock.unlock();
+
+				PGconn* conn = openConnection(conninfo);
+				if (!conn) {
+					lock.lock();
+					--sub.open;
+					sub.available.notify_one();
+					return {};
+				}
+				++sub.created;
+				return {this, &sub, conn};
+			}
+
+			if (sub.available.wait_until(lock, deadline) == std::cv_status::timeout && sub.idle.empty()
+			    && sub.open >= sub.maxSize)
+			{
+				std::cerr << "Timed out waiting for a pooled connection (" << sub.maxSize << " connections in use)."
+				          << std::endl;
+				++acquireTimeouts;
+				return {};
+			}
+		}
+	}
+
+	void PgConnectionPool::reserve(const std::string& conninfo, std::size_t connections) {
+		bool created = false;
+		ConnectionSubPool& sub = subPool(conninfo, created);
+		{
+			std::lock_guard<std::mutex> lock(sub.mutex);
+			sub.maxSize = std::max(sub.maxSize, connections);
+		}
+		sub.available.notify_all();
+		if (created) {
+			warmUp(sub);
+		}
+	}
+
+	std::size_t PgConnectionPool::timeoutsOnThisThread() {
+		return acquireTimeouts;
+	}
+
+	void PgConnectionPool::evictIdle() {
+		std::vector<ConnectionSubPool*> subPools;
+		{
+			std::lock_guard<std::mutex> lock(poolsMutex_);
+			for (auto& entry : pools_) {
+				subPools.push_back(entry.second.get());
+			}
+		}
+
+		auto cutoff = std::chrono::steady_clock::now() - options_.idleTimeout;
+		for (ConnectionSubPool* sub : subPools) {
+			std::vector<PGconn*> expired;
+			{
+				std::lock_guard<std::mutex> lock(sub->mutex);
+				expired = takeExpired(*sub, options_.minSize, cutoff);
+			}
+			for (PGconn* conn : expired) {
+				closeConnection(conn);
+			}
+			sub->evicted += expired.size();
+		}
+	}
+
+	void PgConnectionPool::clear() {
+		std::lock_guard<std::mutex> poolsLock(poolsMutex_);
+		for (auto& entry : pools_) {
+			ConnectionSubPool& sub = *entry.second;
+			std::lock_guard<std::mutex> lock(sub.mutex);
+			for (const IdleConnection& idle : sub.idle) {
+				closeConnection(idle.conn);
+			}
+			sub.open -= sub.idle.size();
+			sub.idle.clear();
+		}
+	}
+
+	PoolStats PgConnectionPool::stats(const std::string& conninfo) const {
+		PoolStats result;
+		std::lock_guard<std::mutex> poolsLock(poolsMutex_);
+		auto it = pools_.find(conninfo);
+		if (it == pools_.end()) {
+			return result;
+		}
+
+		ConnectionSubPool& sub = *it->second;
+		std::lock_guard<std::mutex> lock(sub.mutex);
+		result.created = sub.created;
+		result.reused = sub.reused;
+		result.evicted = sub.evicted;
+		result.failedHealthChecks = sub.failedHealthChecks;
+		result.idle = sub.idle.size();
+		result.open = sub.open;
+		result.maxSize = sub.maxSize;
+		return result;
+	}
+
+	ConnectionSubPool& PgConnectionPool::subPool(const std::string& conninfo, bool& created) {
+		std::lock_guard<std::mutex> lock(poolsMutex_);
+		auto& slot = pools_[conninfo];
+		created = !slot;
+		if (created) {
+			slot = std::make_unique<ConnectionSubPool>();
+			slot->conninfo = conninfo;
+			slot->maxSize = options_.maxSize;
+		}
+		return *slot;
+	}
+
+	// Open minSize connections up front so the first callers do not pay the handshake
+	void PgConnectionPool::warmUp(ConnectionSubPool& sub) {
+		while (true) {
+			{
+				std::lock_guard<std::mutex> lock(sub.mutex);
+				if (sub.open >= options_.minSize) {
+					return;
+				}
+				++sub.open;
+			}
+
+			PGconn* conn = openConnection(sub.conninfo);
+			std::lock_guard<std::mutex> lock(sub.mutex);
+			if (!conn) {
+				--sub.open;
+				return;
+			}
+			++sub.created;
+			sub.idle.push_back({conn, std::chrono::steady_clock::now()});
+		}
+	}
+
+	void PgConnectionPool::release(ConnectionSubPool& sub, PGconn* conn, bool reusable) {
+		// Only connections that are alive and outside any transaction may be handed out again
+		reusable = reusable && PQstatus(conn) == CONNECTION_OK && PQtransactionStatus(conn) == PQTRANS_IDLE;
+		if (!reusable) {
+			closeConnection(conn);
+		}
+
+		{
+			std::lock_guard<std::mutex> lock(sub.mutex);
+			if (reusable) {
+				sub.idle.push_back({conn, std::chrono::steady_clock::now()});
+			}
+			else {
+				--sub.open;
+			}
+		}
+		sub.available.notify_one();
+	}
+
+	bool PgConnectionPool::isHealthy(const IdleConnection& idle) const {
+		if (PQstatus(idle.conn) != CONNECTION_OK) {
+			return false;
+		}
+
+		// An idle connection should never have pending input; data here usually means the
+		// server terminated the session (pg_terminate_backend, restart) or closed the socket
+		pollfd pfd{PQsocket(idle.conn), POLLIN, 0};
+		if (pfd.fd < 0 || poll(&pfd, 1, 0) != 0) {
+			return false;
+		}
+
+		// Long-idle connections may sit behind a half-open TCP session, verify with an empty query
+		if (std::chrono::steady_clock::now() - idle.lastUsed >= options_.pingAfterIdle) {
+			PGresult* res = PQexec(idle.conn, "");
+			bool alive = PQresultStatus(res) == PGRES_EMPTY_QUERY;
+			PQclear(res);
+			return alive;
+		}
+		return true;
+	}
+
+	PGconn* PgConnectionPool::openConnection(const std::string& conninfo) {
+		PGconn* conn = PQconnectdb(conninfo.c_str());
+		if (PQstatus(conn) != CONNECTION_OK) {
+			std::cerr << "Connection to database failed: " << PQerrorMessage(conn) << std::endl;
+			PQfinish(conn);
+			return nullptr;
+		}
+		return conn;
+	}
+} // namespace pgsqlPool
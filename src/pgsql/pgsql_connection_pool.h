@@ -0,0 +1,154 @@
+#ifndef PGSQL_CONNECTION_POOL_H
+#define PGSQL_CONNECTION_POOL_H
+
+#include "libpq-fe.h"
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace pgsqlPool {
+
+	// Sizing and health-check settings shared by every sub-pool
+	struct PoolOptions {
+		std::size_t minSize = 0; // Connections kept open per conninfo even when idle
+		std::size_t maxSize = 8; // Upper bound of open connections per conninfo, unless raised by reserve()
+		std::chrono::seconds idleTimeout{60}; // Idle connections older than this are evicted
+		std::chrono::milliseconds acquireTimeout{5000}; // How long acquire() waits when a sub-pool is exhausted
+		std::chrono::seconds pingAfterIdle{30}; // Idle time after which checkout verifies the connection with a ping
+	};
+
+	// Counters reported per conninfo
+	struct PoolStats {
+		std::size_t created = 0;
+		std::size_t reused = 0;
+		std::size_t evicted = 0;
+		std::size_t failedHealthChecks = 0;
+		std::size_t idle = 0;
+		std::size_t open = 0;
+		std::size_t maxSize = 0; // Open connections allowed at once
+	};
+
+	class PgConnectionPool;
+	struct ConnectionSubPool;
+
+	// Move-only handle to a borrowed connection, returned to its pool on destruction
+	class PooledConnection {
+	 public:
+		PooledConnection() = default;
+		PooledConnection(PgConnectionPool* pool, ConnectionSubPool* subPool, PGconn* conn);
+		~PooledConnection();
+
+		PooledConnection(const PooledConnection&) = delete;
+		PooledConnection& operator=(const PooledConnection&) = delete;
+		PooledConnection(PooledConnection&& other) noexcept;
+		PooledConnection& operator=(PooledConnection&& other) noexcept;
+
+		[[nodiscard]] PGconn* get() const {
+			return conn_;
+		}
+
+		explicit operator bool() const {
+			return conn_ != nullptr;
+		}
+
+		// Give the connection back to the pool before the handle goes out of scope
+		void release();
+
+		// Close the connection instead of returning it (e.g. after a protocol error)
+		void discard();
+
+	 private:
+		PgConnectionPool* pool_ = nullptr;
+		ConnectionSubPool* subPool_ = nullptr;
+		PGconn* conn_ = nullptr;
+	};
+
+	// Idle connection waiting in a sub-pool
+	struct IdleConnection {
+		PGconn* conn;
+		std::chrono::steady_clock::time_point lastUsed;
+	};
+
+	// Connections that share one conninfo string
+	struct ConnectionSubPool {
+		std::string conninfo;
+		std::mutex mutex;
+		std::condition_variable available;
+		std::deque<IdleConnection> idle; // Most recently used at the back
+		std::size_t open = 0; // Idle + checked out
+		std::size_t maxSize = 0; // PoolOptions::maxSize, or more after PgConnectionPool::reserve
+
+		std::atomic<std::size_t> created{0};
+		std::atomic<std::size_t> reused{0};
+		std::atomic<std::size_t> evicted{0};
+		std::atomic<std::size_t> failedHealthChecks{0};
+	};
+
+	// Takes the idle connections last used before cutoff out of sub, least recently used first, as long
+	// as more than minSize stay open; the caller holds sub.mutex and closes them
+	std::vector<PGconn*> takeExpired(ConnectionSubPool& sub,
+	                                 std::size_t minSize,
+	                                 std::chrono::steady_clock::time_point cutoff);
+
+	// Thread-safe pool of libpq connections keyed by conninfo
+	class PgConnectionPool {
+	 public:
+		explicit PgConnectionPool(PoolOptions options = {});
+		~PgConnectionPool();
+
+		PgConnectionPool(const PgConnectionPool&) = delete;
+		PgConnectionPool& operator=(const PgConnectionPool&) = delete;
+
+		// Process-wide pool used by the managers in src/pgsql/
+		static PgConnectionPool& instance();
+
+		// Borrow a healthy connection; returns an empty handle if none could be opened in time. At most
+		// once per idleTimeout, acquiring also runs evictIdle, so an idle connection is closed within
+		// two idleTimeouts of its last use as long as the pool is in use.
+		PooledConnection acquire(const std::string& conninfo);
+
+		// Let the sub-pool of conninfo open at least connections at once, for callers running that many
+		// workers which each hold one of its connections at a time. Never lowers the limit.
+		void reserve(const std::string& conninfo, std::size_t connections);
+
+		// acquire() calls on the current thread that gave up after acquireTimeout: back-pressure, which
+		// callers retrying failed work should wait out rather than count as a failure
+		static std::size_t timeoutsOnThisThread();
+
+		// Close idle connections past idleTimeout, keeping minSize per sub-pool
+		void evictIdle();
+
+		// Close every idle connection. Checked-out connections stay open and rejoin the pool when released.
+		void clear();
+
+		[[nodiscard]] PoolStats stats(const std::string& conninfo) const;
+
+		[[nodiscard]] const PoolOptions& options() const {
+			return options_;
+		}
+
+	 private:
+		friend class PooledConnection;
+
+		ConnectionSubPool& subPool(const std::string& conninfo, bool& created);
+		void warmUp(ConnectionSubPool& subPool);
+		void release(ConnectionSubPool& subPool, PGconn* conn, bool reusable);
+		bool isHealthy(const IdleConnection& idle) const;
+		static PGconn* openConnection(const std::string& conninfo);
+
+		PoolOptions options_;
+		std::atomic<std::chrono::steady_clock::rep> lastSweep_; // Time of the last evictIdle run from acquire
+		mutable std::mutex poolsMutex_;
+		std::unordered_map<std::string, std::unique_ptr<ConnectionSubPool>> pools_;
+	};
+
+} // namespace pgsqlPool
+
+#endif // PGSQL_CONNECTION_POOL_H
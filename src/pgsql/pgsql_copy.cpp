@@ -0,0 +1,620 @@
+#include "pgsql_copy.h"
+#include "pgsql_binary.h"
+#include "pgsql_handles.h"
+#include "pgsql_partitions.h"
+
+#include <algorithm>
+#include <cctype>
+#include <cerrno>
+#include <charconv>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <fcntl.h>
+#include <iomanip>
+#include <iostream>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <utility>
+
+namespace pgsqlCopy {
+	using Clock = std::chrono::steady_clock;
+
+	MappedFile::~MappedFile() {
+		if (data_ && size_ > 0) {
+			munmap(const_cast<char*>(data_), size_);
+		}
+	}
+
+	MappedFile::MappedFile(MappedFile&& other) noexcept
+	: data_(std::exchange(other.data_, nullptr))
+	, size_(std::exchange(other.size_, 0)) {}
+
+	MappedFile& MappedFile::operator=(MappedFile&& other) noexcept {
+		if (this != &other) {
+			MappedFile discarded(std::move(*this));
+			data_ = std::exchange(other.data_, nullptr);
+			size_ = std::exchange(other.size_, 0);
+		}
+		return *this;
+	}
+
+	bool MappedFile::open(const std::string& path, std::string& error) {
+		*this = MappedFile();
+
+		int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+		if (fd < 0) {
+			error = path + ": " + std::strerror(errno);
+			return false;
+		}
+
+		struct stat info {};
+		if (fstat(fd, &info) != 0) {
+			error = path + ": " + std::strerror(errno);
+			::close(fd);
+			return false;
+		}
+
+		// mmap rejects a zero length; an empty file is simply an empty view
+		if (info.st_size > 0) {
+			std::size_t size = static_cast<std::size_t>(info.st_size);
+			void* mapped = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+			if (mapped == MAP_FAILED) {
+				error = path + ": " + std::strerror(errno);
+				::close(fd);
+				return false;
+			}
+			madvise(mapped, size, MADV_SEQUENTIAL); // Read once front to back; lets the kernel read ahead
+			data_ = static_cast<const char*>(mapped);
+			size_ = size;
+		}
+		::close(fd); // The mapping keeps the file alive
+		return true;
+	}
+
+	CsvReader::CsvReader(std::string_view data, char delimiter)
+	: data_(data)
+	, delimiter_(delimiter) {}
+
+	bool CsvReader::next(std::vector<CsvField>& fields) {
+		while (pos_ < data_.size()) {
+			recordLine_ = currentLine_;
+			malformed_ = false;
+			std::size_t count = 0;
+			bool endOfRecord = false;
+
+			while (!endOfRecord) {
+				if (count == fields.size()) {
+					fields.emplace_back();
+				}
+				CsvField& field = fields[count++];
+				field.value.clear();
+				field.quoted = false;
+
+				if (pos_ < data_.size() && data_[pos_] == '"') {
+					field.quoted = true;
+					++pos_;
+					bool closed = false;
+					while (pos_ < data_.size()) {
+						std::size_t quote = data_.find('"', pos_);
+						std::size_t length = quote == std::string_view::npos ? quote : quote - pos_;
+						std::string_view chunk = data_.substr(pos_, length);
+						currentLine_ += static_cast<std::size_t>(std::count(chunk.begin(), chunk.end(), '\n'));
+						field.value.append(chunk);
+						if (quote == std::string_view::npos) {
+							pos_ = data_.size();
+							break;
+						}
+						if (quote + 1 < data_.size() && data_[quote + 1] == '"') {
+							field.value += '"'; // Doubled quote inside a quoted field
+							pos_ = quote + 2;
+							continue;
+						}
+						pos_ = quote + 1;
+						closed = true;
+						break;
+					}
+					malformed_ = malformed_ || !closed;
+				}
+
+				// Unquoted text, or whatever follows the closing quote up to the next separator
+				std::size_t start = pos_;
+				while (pos_ < data_.size() && data_[pos_] != delimiter_ && data_[pos_] != '\n') {
+					++pos_;
+				}
+				std::size_t end = pos_;
+				if (end > start && data_[end - 1] == '\r' && (end == data_.size() || data_[end] == '\n')) {
+					--end;
+				}
+				field.value.append(data_.substr(start, end - start));
+
+				if (pos_ < data_.size() && data_[pos_] == delimiter_) {
+					++pos_;
+				}
+				else {
+					if (pos_ < data_.size()) {
+						++pos_; // The newline
+						++currentLine_;
+					}
+					endOfRecord = true;
+				}
+			}
+
+			fields.resize(count);
+			bool blank = count == 1 && !fields[0].quoted && fields[0].value.empty();
+			if (!blank) {
+				return true;
+			}
+		}
+		return false;
+	}
+
+	// Value as it appears in an error message, shortened so one huge field cannot flood the report
+	static std::string quoteValue(const std::string& value) {
+		constexpr std::size_t kMaxShown = 40;
+		return "'" + (value.size() > kMaxShown ? value.substr(0, kMaxShown) + "..." : value) + "'";
+	}
+
+	// COPY text format: backslash escapes for the characters that separate columns and rows
+	static void appendCopyText(std::string& out, const std::string& value) {
+		for (char c : value) {
+			switch (c) {
+			case '\\': out += "\\\\"; break;
+			case '\t': out += "\\t"; break;
+			case '\n': out += "\\n"; break;
+			case '\r': out += "\\r"; break;
+			default: out += c; break;
+			}
+		}
+	}
+
+	static bool parseBool(const std::string& value, bool& out) {
+		std::string lower(value);
+		std::transform(lower.begin(), lower.end(), lower.begin(), [](unsigned char c) { return std::tolower(c); });
+		if (lower == "t" || lower == "true" || lower == "1" || lower == "y" || lower == "yes") {
+			out = true;
+			return true;
+		}
+		if (lower == "f" || lower == "false" || lower == "0" || lower == "n" || lower == "no") {
+			out = false;
+			return true;
+		}
+		return false;
+	}
+
+	static bool encodeField(const CsvField& field, const CopyColumn& column, std::string& out, std::string& error) {
+		if (!field.quoted && field.value.empty()) {
+			if (column.notNull) {
+				error = std::string(column.name) + ": value is required";
+				return false;
+			}
+			out += "\\N";
+			return true;
+		}
+
+		const std::string& value = field.value;
+		switch (column.type) {
+		case pgsqlSchema::SqlType::Serial:
+		case pgsqlSchema::SqlType::Integer: {
+			std::int32_t parsed = 0;
+			auto [end, ec] = std::from_chars(value.data(), value.data() + value.size(), parsed);
+			if (ec != std::errc() || end != value.data() + value.size()) {
+				error = std::string(column.name) + ": not an integer " + quoteValue(value);
+				return false;
+			}
+			out += value;
+			return true;
+		}
+		case pgsqlSchema::SqlType::Money: {
+			std::int64_t cents = 0;
+			if (!pgsqlBinary::parseNumericText(value, pgsqlSchema::kMoneyScale, cents, pgsqlSchema::kMoneyPrecision)) {
+				error = std::string(column.name) + ": not a " + pgsqlSchema::sqlTypeName(column.type) + " amount "
+				        + quoteValue(value);
+				return false;
+			}
+			out += value;
+			return true;
+		}
+		case pgsqlSchema::SqlType::Date: {
+			std::int32_t days = 0;
+			if (!pgsqlBinary::parseDateText(value, days)) {
+				error = std::string(column.name) + ": not a valid YYYY-MM-DD date " + quoteValue(value);
+				return false;
+			}
+			out += value;
+			return true;
+		}
+		case pgsqlSchema::SqlType::Boolean: {
+			bool parsed = false;
+			if (!parseBool(value, parsed)) {
+				error = std::string(column.name) + ": not a boolean " + quoteValue(value);
+				return false;
+			}
+			out += parsed ? 't' : 'f';
+			return true;
+		}
+		case pgsqlSchema::SqlType::Text:
+		case pgsqlSchema::SqlType::Timestamp: // Left to the server, which accepts many timestamp spellings
+			appendCopyText(out, value);
+			return true;
+		}
+		return false;
+	}
+
+	bool encodeCopyRow(const std::vector<CsvField>& fields,
+	                   const std::vector<CopyColumn>& columns,
+	                   std::string& out,
+	                   std::string& error) {
+		if (fields.size() != columns.size()) {
+			error = "expected " + std::to_string(columns.size()) + " fields, found " + std::to_string(fields.size());
+			return false;
+		}
+
+		std::size_t mark = out.size();
+		for (std::size_t i = 0; i < fields.size(); ++i) {
+			if (i > 0) {
+				out += '\t';
+			}
+			if (!encodeField(fields[i], columns[i], out, error)) {
+				out.resize(mark);
+				return false;
+			}
+		}
+		out += '\n';
+		return true;
+	}
+
+	double ImportStats::rowsPerSecond() const {
+		return seconds > 0 ? static_cast<double>(rows) / seconds : 0.0;
+	}
+
+	void ImportStats::print(std::ostream& out) const {
+		if (!ok) {
+			out << table << ": import failed: " << error << std::endl;
+		}
+		else {
+			out << table << ": " << rows << " rows in " << std::fixed << std::setprecision(3) << seconds << " s ("
+			    << std::setprecision(0) << rowsPerSecond() << " rows/s, " << std::setprecision(1)
+			    << (seconds > 0 ? static_cast<double>(bytes) / seconds / 1e6 : 0.0) << " MB/s)";
+			if (rejected > 0) {
+				out << ", " << rejected << " rejected";
+			}
+			out << std::endl;
+		}
+		for (const RowError& rowError : errors) {
+			out << "  line " << rowError.line << ": " << rowError.message << std::endl;
+		}
+		if (rejected > errors.size()) {
+			out << "  ... and " << rejected - errors.size() << " more rejected rows" << std::endl;
+		}
+	}
+
+	static bool sameName(std::string_view a, std::string_view b) {
+		return a.size() == b.size() && std::equal(a.begin(), a.end(), b.begin(), [](unsigned char x, unsigned char y) {
+			       return std::tolower(x) == std::tolower(y);
+		       });
+	}
+
+	bool mapHeader(const std::vector<CsvField>& header,
+	               const std::vector<CopyColumn>& columns,
+	               std::vector<CopyColumn>& targets,
+	               std::string& error) {
+		for (const CsvField& name : header) {
+			auto column = std::find_if(
+			    columns.begin(), columns.end(), [&](const CopyColumn& c) { return sameName(c.name, name.value); });
+			if (column == columns.end()) {
+				error = "unknown column " + quoteValue(name.value) + " in header";
+				return false;
+			}
+			for (const CopyColumn& target : targets) {
+				if (target.name == column->name) {
+					error = "column " + quoteValue(name.value) + " appears twice in header";
+					return false;
+				}
+			}
+			targets.push_back(*column);
+		}
+
+		// Left-out columns get their default; SERIAL ids draw from the sequence
+		for (const CopyColumn& column : columns) {
+			bool present = std::any_of(
+			    targets.begin(), targets.end(), [&](const CopyColumn& target) { return target.name == column.name; });
+			if (!present && column.notNull && column.type != pgsqlSchema::SqlType::Serial) {
+				error = std::string("required column '") + column.name + "' missing from header";
+				return false;
+			}
+		}
+		return true;
+	}
+
+	// Ends the COPY (aborting it with abortMessage when set) and collects the server's verdict
+	static bool finishCopy(PGconn* conn, const char* abortMessage, ImportStats& stats) {
+		if (PQputCopyEnd(conn, abortMessage) != 1) {
+			stats.error = PQerrorMessage(conn);
+			return false;
+		}
+
+		bool ok = false;
+		for (PGresult* raw = PQgetResult(conn); raw; raw = PQgetResult(conn)) {
+			pgsqlHandles::PgResult res(raw);
+			if (res.status() == PGRES_COMMAND_OK) {
+				stats.rows = std::strtoull(PQcmdTuples(raw), nullptr, 10);
+				ok = true;
+			}
+			else if (stats.error.empty()) {
+				stats.error = res.errorMessage();
+			}
+		}
+		return ok && !abortMessage;
+	}
+
+	ImportStats importCsv(PGconn* conn,
+	                      const std::string& table,
+	                      const std::vector<CopyColumn>& columns,
+	                      std::string_view csv,
+	                      const ImportOptions& options) {
+		ImportStats stats;
+		stats.table = table;
+		stats.bytes = csv.size();
+		auto start = Clock::now();
+		auto finish = [&](bool ok) {
+			stats.ok = ok;
+			stats.seconds = std::chrono::duration<double>(Clock::now() - start).count();
+			return stats;
+		};
+
+		CsvReader reader(csv, options.delimiter);
+		std::vector<CsvField> fields;
+		std::vector<CopyColumn> targets;
+		if (!reader.next(fields)) {
+			stats.error = "no header row";
+			return finish(false);
+		}
+		if (!mapHeader(fields, columns, targets, stats.error)) {
+			return finish(false);
+		}
+
+		std::string sql = "COPY " + table + " (";
+		for (std::size_t i = 0; i < targets.size(); ++i) {
+			sql += (i ? ", " : "") + std::string(targets[i].name);
+			stats.columns.emplace_back(targets[i].name);
+		}
+		sql += ") FROM STDIN";
+
+		pgsqlHandles::PgResult copy = pgsqlHandles::PgResult::exec(conn, sql.c_str());
+		if (copy.status() != PGRES_COPY_IN) {
+			stats.error = copy.errorMessage();
+			return finish(false);
+		}
+
+		// One buffer for the whole import: rows are encoded into it and it is flushed, never reallocated,
+		// once it holds bufferSize bytes
+		std::string buffer;
+		buffer.reserve(options.bufferSize + 4096);
+		auto flush = [&]() {
+			if (buffer.empty()) {
+				return true;
+			}
+			if (PQputCopyData(conn, buffer.data(), static_cast<int>(buffer.size())) != 1) {
+				stats.error = PQerrorMessage(conn);
+				return false;
+			}
+			buffer.clear();
+			return true;
+		};
+
+		std::string rowError;
+		while (reader.next(fields)) {
+			bool encoded = false;
+			if (reader.malformed()) {
+				rowError = "unterminated quoted field";
+			}
+			else {
+				encoded = encodeCopyRow(fields, targets, buffer, rowError);
+			}
+
+			if (!encoded) {
+				++stats.rejected;
+				if (stats.errors.size() < options.maxReportedErrors) {
+					stats.errors.push_back({reader.line(), rowError});
+				}
+				if (stats.rejected > options.maxRejectedRows) {
+					finishCopy(conn, "too many rejected rows", stats);
+					stats.rows = 0;
+					RowError first = stats.errors.empty() ? RowError{reader.line(), rowError} : stats.errors.front();
+					stats.error = "more than " + std::to_string(options.maxRejectedRows) + " rejected rows; line "
+					              + std::to_string(first.line) + ": " + first.message;
+					return finish(false);
+				}
+				continue;
+			}
+
+			if (buffer.size() >= options.bufferSize && !flush()) {
+				finishCopy(conn, "client failed to send data", stats);
+				return finish(false);
+			}
+		}
+
+		if (!flush()) {
+			finishCopy(conn, "client failed to send data", stats);
+			return finish(false);
+		}
+		if (!finishCopy(conn, nullptr, stats)) {
+			return finish(false);
+		}
+
+		// Ids the file supplied bypass the sequence; without this the next plain INSERT draws a taken id
+		auto serial = std::find_if(targets.begin(), targets.end(), [](const CopyColumn& column) {
+			return column.type == pgsqlSchema::SqlType::Serial;
+		});
+		return finish(serial == targets.end() || !options.advanceSequence
+		              || advanceSequence(conn, table, serial->name, stats.error));
+	}
+
+	ImportStats importCsvFile(PGconn* conn,
+	                          const std::string& table,
+	                          const std::vector<CopyColumn>& columns,
+	                          const std::string& path,
+	                          const ImportOptions& options) {
+		MappedFile file;
+		std::string error;
+		if (!file.open(path, error)) {
+			ImportStats stats;
+			stats.table = table;
+			stats.error = error;
+			return stats;
+		}
+		return importCsv(conn, table, columns, file.data(), options);
+	}
+
+	// "PGCOPY\n\377\r\n\0", then an int32 flags field and an int32 header extension length
+	static const char kBinaryCopyHeader[] = {
+	    'P', 'G', 'C', 'O', 'P', 'Y', '\n', '\377', '\r', '\n', '\0', 0, 0, 0, 0, 0, 0, 0, 0};
+
+	BinaryCopyWriter::BinaryCopyWriter(PGconn* conn, std::size_t bufferSize)
+	: conn_(conn)
+	, bufferSize_(bufferSize) {
+		buffer_.reserve(bufferSize + 4096);
+	}
+
+	BinaryCopyWriter::~BinaryCopyWriter() {
+		if (active_) {
+			ImportStats ignored;
+			finishCopy(conn_, "import abandoned", ignored);
+		}
+	}
+
+	bool BinaryCopyWriter::begin(const std::string& table, const std::string& columns, std::string& error) {
+		std::string sql = "COPY " + table + " (" + columns + ") FROM STDIN (FORMAT binary)";
+		pgsqlHandles::PgResult copy = pgsqlHandles::PgResult::exec(conn_, sql.c_str());
+		if (copy.status() != PGRES_COPY_IN) {
+			error = copy.errorMessage();
+			return false;
+		}
+		active_ = true;
+		buffer_.assign(kBinaryCopyHeader, sizeof(kBinaryCopyHeader));
+		return true;
+	}
+
+	bool BinaryCopyWriter::flush(std::string& error) {
+		if (buffer_.empty()) {
+			return true;
+		}
+		if (PQputCopyData(conn_, buffer_.data(), static_cast<int>(buffer_.size())) != 1) {
+			error = PQerrorMessage(conn_);
+			return false;
+		}
+		bytesSent_ += buffer_.size();
+		buffer_.clear();
+		return true;
+	}
+
+	bool BinaryCopyWriter::rowWritten(std::string& error) {
+		return buffer_.size() < bufferSize_ || flush(error);
+	}
+
+	bool BinaryCopyWriter::finish(std::size_t& rows, std::string& error) {
+		pgsqlBinary::encodeInt2(buffer_, -1); // File trailer
+		if (!flush(error)) {
+			return false; // The destructor aborts the COPY
+		}
+
+		active_ = false;
+		ImportStats result;
+		bool ok = finishCopy(conn_, nullptr, result);
+		rows = result.rows;
+		if (!ok) {
+			error = result.error;
+		}
+		return ok;
+	}
+
+	std::string advanceSequenceSQL(const std::string& table, const char* column) {
+		return "SELECT setval(pg_get_serial_sequence('" + table + "', '" + column + "'), max(" + column + ")) FROM "
+		       + table + " HAVING max(" + column + ") IS NOT NULL;";
+	}
+
+	bool advanceSequence(PGconn* conn, const std::string& table, const char* column, std::string& error) {
+		if (!column) {
+			return true;
+		}
+		pgsqlHandles::PgResult res = pgsqlHandles::PgResult::exec(conn, advanceSequenceSQL(table, column).c_str());
+		if (!res.ok()) {
+			error = res.errorMessage();
+			return false;
+		}
+		return true;
+	}
+
+	std::vector<ImportStats> importOrderHistory(PGconn* conn,
+	                                            const std::vector<pgsqlSchema::Orders::Row>& orders,
+	                                            const std::vector<pgsqlSchema::OrderItems::Row>& items,
+	                                            const ImportOptions& options) {
+		std::vector<ImportStats> stats(2);
+		stats[0].table = pgsqlSchema::Orders::name;
+		stats[1].table = pgsqlSchema::OrderItems::name;
+
+		// On the monthly layout a history older than the maintenance window has no partitions yet
+		auto [first, last] = std::minmax_element(
+		    orders.begin(), orders.end(), [](const auto& a, const auto& b) { return a.orderDate < b.orderDate; });
+		const pgsqlPartitions::PartitionedTable* partitioned =
+		    pgsqlPartitions::partitionedTable(pgsqlSchema::Orders::name);
+		if (partitioned && first != orders.end()
+		    && !pgsqlPartitions::ensureMonths(conn, *partitioned, first->orderDate, last->orderDate, stats[0].error))
+		{
+			return stats;
+		}
+
+		pgsqlHandles::PgResult begin = pgsqlHandles::PgResult::exec(conn, "BEGIN;");
+		if (!begin.ok()) {
+			stats[0].error = begin.errorMessage();
+			return stats;
+		}
+
+		stats[0] = copyBinary<pgsqlSchema::Orders>(conn, orders, options);
+		if (stats[0].ok) {
+			stats[1] = copyBinary<pgsqlSchema::OrderItems>(conn, items, options);
+		}
+
+		bool ok = stats[0].ok && stats[1].ok;
+		pgsqlHandles::PgResult end = pgsqlHandles::PgResult::exec(conn, ok ? "COMMIT;" : "ROLLBACK;");
+		if (ok && !end.ok()) {
+			stats[1].error = end.errorMessage();
+			ok = false;
+		}
+		if (!ok) {
+			for (ImportStats& table : stats) {
+				table.ok = false;
+				table.rows = 0; // Rolled back
+				if (table.error.empty()) {
+					table.error = "rolled back";
+				}
+			}
+		}
+		return stats;
+	}
+
+	ImportStats importStoreTable(PGconn* conn,
+	                             const std::string& tableName,
+	                             const std::string& path,
+	                             const ImportOptions& options) {
+		if (sameName(tableName, pgsqlSchema::Products::name)) {
+			return importTable<pgsqlSchema::Products>(conn, path, options);
+		}
+		if (sameName(tableName, pgsqlSchema::Customers::name)) {
+			return importTable<pgsqlSchema::Customers>(conn, path, options);
+		}
+		if (sameName(tableName, pgsqlSchema::Employees::name)) {
+			return importTable<pgsqlSchema::Employees>(conn, path, options);
+		}
+		if (sameName(tableName, pgsqlSchema::Suppliers::name)) {
+			return importTable<pgsqlSchema::Suppliers>(conn, path, options);
+		}
+
+		ImportStats stats;
+		stats.table = tableName;
+		stats.error = "not a bulk-loadable table (Products, Customers, Employees or Suppliers)";
+		return stats;
+	}
+} // namespace pgsqlCopy
@@ -0,0 +1,248 @@
+#ifndef PGSQL_COPY_H
+#define PGSQL_COPY_H
+
+#include "libpq-fe.h"
+#include "pgsql_schema.h"
+#include <chrono>
+#include <cstddef>
+#include <iosfwd>
+#include <limits>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace pgsqlCopy {
+
+	// Read-only memory mapping of a whole file; the importer parses straight out of the page cache
+	class MappedFile {
+	 public:
+		MappedFile() = default;
+		~MappedFile();
+
+		MappedFile(const MappedFile&) = delete;
+		MappedFile& operator=(const MappedFile&) = delete;
+		MappedFile(MappedFile&& other) noexcept;
+		MappedFile& operator=(MappedFile&& other) noexcept;
+
+		// False with the OS error in error if the file cannot be opened or mapped
+		bool open(const std::string& path, std::string& error);
+
+		[[nodiscard]] std::string_view data() const {
+			return {data_, size_};
+		}
+
+	 private:
+		const char* data_ = nullptr;
+		std::size_t size_ = 0;
+	};
+
+	struct CsvField {
+		std::string value;
+		bool quoted = false; // "" is an empty string, an empty unquoted field is NULL
+	};
+
+	// RFC 4180 records: quoted fields may contain the delimiter, doubled quotes and line breaks.
+	// Both \n and \r\n end a record.
+	class CsvReader {
+	 public:
+		explicit CsvReader(std::string_view data, char delimiter = ',');
+
+		// Next record into fields, reusing their storage. False at the end of the input.
+		bool next(std::vector<CsvField>& fields);
+
+		// Line the last record started on, 1-based
+		[[nodiscard]] std::size_t line() const {
+			return recordLine_;
+		}
+
+		// The last record ended inside a quoted field
+		[[nodiscard]] bool malformed() const {
+			return malformed_;
+		}
+
+	 private:
+		std::string_view data_;
+		std::size_t pos_ = 0;
+		std::size_t currentLine_ = 1;
+		std::size_t recordLine_ = 0;
+		char delimiter_;
+		bool malformed_ = false;
+	};
+
+	// One target column of a COPY, in CSV column order
+	struct CopyColumn {
+		const char* name;
+		pgsqlSchema::SqlType type;
+		bool notNull;
+	};
+
+	// Every column of a table descriptor
+	template<typename Table>
+	std::vector<CopyColumn> copyColumns() {
+		std::vector<CopyColumn> columns;
+		std::apply(
+		    [&](const auto&... column) {
+			    auto append = [&](const auto& c) {
+				    std::string_view constraints = c.constraints;
+				    bool notNull = constraints == "NOT NULL" || constraints == "PRIMARY KEY";
+				    columns.push_back({c.name, c.type, notNull});
+			    };
+			    (append(column), ...);
+		    },
+		    Table::columns);
+		return columns;
+	}
+
+	// Validates one CSV record against columns and appends it to out as a COPY text-format line.
+	// On failure out is left as it was and error says which column was rejected.
+	bool encodeCopyRow(const std::vector<CsvField>& fields,
+	                   const std::vector<CopyColumn>& columns,
+	                   std::string& out,
+	                   std::string& error);
+
+	struct ImportOptions {
+		std::size_t bufferSize = 256 * 1024; // Encoded rows are sent with PQputCopyData once this much is buffered
+		char delimiter = ',';
+		std::size_t maxReportedErrors = 100; // Rejected rows beyond this are counted but not kept
+		std::size_t maxRejectedRows = std::numeric_limits<std::size_t>::max(); // More aborts the whole COPY
+		bool advanceSequence = true; // Explicit ids move the id sequence; off when the caller does it once at the end
+	};
+
+	struct RowError {
+		std::size_t line;
+		std::string message;
+	};
+
+	struct ImportStats {
+		std::string table;
+		bool ok = false; // The COPY committed; rejected rows do not make an import fail
+		std::size_t rows = 0; // Rows the server stored
+		std::size_t rejected = 0; // Rows skipped because they failed validation
+		std::size_t bytes = 0; // CSV bytes read, or binary COPY bytes sent
+		std::vector<std::string> columns; // CSV imports: the target columns the header named, in header order
+		double seconds = 0;
+		std::vector<RowError> errors; // The first maxReportedErrors rejected rows
+		std::string error; // Why the import failed as a whole
+
+		[[nodiscard]] double rowsPerSecond() const;
+		void print(std::ostream& out) const;
+	};
+
+	// Maps a CSV header onto columns (case-insensitively) into targets, in header order. SERIAL columns
+	// may be left out; every other NOT NULL column must be named.
+	bool mapHeader(const std::vector<CsvField>& header,
+	               const std::vector<CopyColumn>& columns,
+	               std::vector<CopyColumn>& targets,
+	               std::string& error);
+
+	// Streams csv into table with COPY ... FROM STDIN. The first record is a header naming the target
+	// columns (see mapHeader). Rows that fail validation are skipped and reported, so one bad line does
+	// not abort the load. A header that supplies the SERIAL ids advances the id sequence afterwards.
+	ImportStats importCsv(PGconn* conn,
+	                      const std::string& table,
+	                      const std::vector<CopyColumn>& columns,
+	                      std::string_view csv,
+	                      const ImportOptions& options = {});
+
+	// importCsv over a memory-mapped file
+	ImportStats importCsvFile(PGconn* conn,
+	                          const std::string& table,
+	                          const std::vector<CopyColumn>& columns,
+	                          const std::string& path,
+	                          const ImportOptions& options = {});
+
+	template<typename Table>
+	ImportStats importTable(PGconn* conn, const std::string& path, const ImportOptions& options = {}) {
+		return importCsvFile(conn, Table::name, copyColumns<Table>(), path, options);
+	}
+
+	// Bulk-loadable store tables by name (case-insensitive): Products, Customers, Employees, Suppliers.
+	// Fails without touching the database for any other name.
+	ImportStats importStoreTable(PGconn* conn,
+	                             const std::string& tableName,
+	                             const std::string& path,
+	                             const ImportOptions& options = {});
+
+	// Sends tuples of a COPY ... FROM STDIN (FORMAT binary). Writes the PGCOPY header and trailer and
+	// sends the buffer with PQputCopyData whenever it holds bufferSize bytes. A writer destroyed
+	// before finish() aborts its COPY, so nothing of a failed import is stored.
+	class BinaryCopyWriter {
+	 public:
+		BinaryCopyWriter(PGconn* conn, std::size_t bufferSize);
+		~BinaryCopyWriter();
+
+		BinaryCopyWriter(const BinaryCopyWriter&) = delete;
+		BinaryCopyWriter& operator=(const BinaryCopyWriter&) = delete;
+
+		// Starts COPY table (columns); false with the server message in error
+		bool begin(const std::string& table, const std::string& columns, std::string& error);
+
+		// The next tuple is appended here, e.g. by pgsqlSchema::encodeCopyBinary
+		std::string& buffer() {
+			return buffer_;
+		}
+
+		// Call after appending each tuple; sends the buffer once it is full
+		bool rowWritten(std::string& error);
+
+		// Sends the trailer and ends the COPY; rows is what the server stored
+		bool finish(std::size_t& rows, std::string& error);
+
+		[[nodiscard]] std::size_t bytesSent() const {
+			return bytesSent_;
+		}
+
+	 private:
+		bool flush(std::string& error);
+
+		PGconn* conn_;
+		std::size_t bufferSize_;
+		std::string buffer_;
+		std::size_t bytesSent_ = 0;
+		bool active_ = false;
+	};
+
+	// Moves the id sequence of a SERIAL column past the largest id in the table, after rows were
+	// loaded with explicit ids. A null column is a no-op.
+	bool advanceSequence(PGconn* conn, const std::string& table, const char* column, std::string& error);
+	std::string advanceSequenceSQL(const std::string& table, const char* column);
+
+	// Loads rows into Table with binary COPY, every column including the SERIAL id, then advances the
+	// id sequence (see ImportOptions::advanceSequence). Values travel in the server's internal
+	// representation, so neither side parses numbers or dates.
+	template<typename Table>
+	ImportStats copyBinary(PGconn* conn,
+	                       const std::vector<typename Table::Row>& rows,
+	                       const ImportOptions& options = {}) {
+		ImportStats stats;
+		stats.table = Table::name;
+		auto start = std::chrono::steady_clock::now();
+
+		BinaryCopyWriter writer(conn, options.bufferSize);
+		bool ok = writer.begin(Table::name, pgsqlSchema::columnList<Table>(), stats.error);
+		for (auto row = rows.begin(); ok && row != rows.end(); ++row) {
+			pgsqlSchema::encodeCopyBinary<Table>(*row, writer.buffer());
+			ok = writer.rowWritten(stats.error);
+		}
+		ok = ok && writer.finish(stats.rows, stats.error);
+		if (ok && options.advanceSequence) {
+			ok = advanceSequence(conn, Table::name, pgsqlSchema::serialColumn<Table>(), stats.error);
+		}
+
+		stats.ok = ok;
+		stats.bytes = writer.bytesSent();
+		stats.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+		return stats;
+	}
+
+	// Historical orders and their items in one transaction, Orders first so the items' foreign key
+	// holds. Both tables are loaded or neither; the stats are for Orders and Order_Items. Missing
+	// monthly partitions for the orders' dates are created first (see pgsqlPartitions::ensureMonths).
+	std::vector<ImportStats> importOrderHistory(PGconn* conn,
+	                                            const std::vector<pgsqlSchema::Orders::Row>& orders,
+	                                            const std::vector<pgsqlSchema::OrderItems::Row>& items,
+	                                            const ImportOptions& options = {});
+
+} // namespace pgsqlCopy
+
+#endif // PGSQL_COPY_H
@@ -0,0 +1,609 @@
+#include "pgsql_datagen.h"
+#include "pgsql_copy.h"
+#include "pgsql_handles.h"
+#include "pgsql_partitions.h"
+#include "pgsql_workers.h"
+
+#include <algorithm>
+#include <cctype>
+#include <chrono>
+#include <cmath>
+#include <condition_variable>
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <limits>
+#include <mutex>
+
+namespace pgsqlDatagen {
+	using Clock = std::chrono::steady_clock;
+
+	// Independent random streams, one per kind of row, so adding a column to one table does not shift
+	// the values of another
+	enum class Stream : std::uint64_t { Customers = 1, Products, Employees, Suppliers, Orders, ItemCounts, Ranks };
+
+	static const char* const kFirstNames[] = {
+	    "Olivia", "Liam", "Emma", "Noah", "Ava", "Elijah", "Sophia", "James", "Mia", "Lucas", "Amelia", "Mateo",
+	    "Harper", "Ethan", "Aria", "Leo", "Chloe", "Kai", "Nora", "Hiroshi", "Mei", "Ravi", "Zoe", "Omar"};
+	static const char* const kLastNames[] = {
+	    "Smith", "Garcia", "Chen", "Johnson", "Schmidt", "Patel", "Brown", "Nguyen", "Kim", "Lopez", "Wilson",
+	    "Tanaka", "Silva", "Martin", "Rossi", "Kowalski", "Okafor", "Dubois", "Walker", "Ivanova", "Haddad", "O'Brien",
+	    "Jensen", "Santos"};
+	static const char* const kStreets[] = {
+	    "Maple", "Oak", "Cedar", "Pine", "Elm", "Willow", "Birch", "Aspen", "Spruce", "Hickory", "Magnolia", "Juniper",
+	    "Chestnut", "Laurel", "Poplar", "Sycamore"};
+	static const char* const kPositions[] = {
+	    "Cashier", "Groomer", "Sales Associate", "Store Manager", "Veterinary Technician", "Stock Clerk"};
+	static const char* const kCategories[] = {
+	    "Dog Food", "Cat Food", "Toys", "Aquarium", "Bird Supplies", "Grooming", "Beds", "Collars, Leashes", "Treats",
+	    "Health", "Small Animals", "Reptile Supplies"};
+	static const char* const kAdjectives[] = {
+	    "Deluxe", "Organic", "Classic", "Premium", "Eco", "Compact", "Jumbo", "Soft"};
+	static const char* const kAnimals[] = {"Dog", "Cat", "Parrot", "Hamster", "Rabbit", "Goldfish", "Turtle", "Ferret"};
+	static const char* const kItems[] = {
+	    "Chew Toy", "Kibble", "Bed", "Collar", "Brush", "Shampoo", "Feeder", "Carrier", "Scratcher", "Treats"};
+
+	template<std::size_t N>
+	static const char* pick(Random& random, const char* const (&words)[N]) {
+		return words[random.uniform(N)];
+	}
+
+	static std::uint64_t mix(std::uint64_t x) {
+		x += 0x9E3779B97F4A7C15ULL;
+		x = (x ^ (x >> 30)) * 0xBF58476D1CE4E5B9ULL;
+		x = (x ^ (x >> 27)) * 0x94D049BB133111EBULL;
+		return x ^ (x >> 31);
+	}
+
+	// Generator for one row of one stream; depends on nothing but the seed and the id
+	static Random rowRandom(const DatagenConfig& config, Stream stream, std::uint64_t id) {
+		return Random(mix(config.seed ^ mix((static_cast<std::uint64_t>(stream) << 40) ^ id)));
+	}
+
+	static std::string lowercase(std::string text) {
+		std::transform(text.begin(), text.end(), text.begin(), [](unsigned char c) {
+			return c < 0x80 ? static_cast<char>(std::tolower(c)) : static_cast<char>(c);
+		});
+		return text;
+	}
+
+	static double secondsSince(Clock::time_point start) {
+		return std::chrono::duration<double>(Clock::now() - start).count();
+	}
+
+	std::uint64_t Random::next() {
+		state_ += 0x9E3779B97F4A7C15ULL;
+		std::uint64_t z = state_;
+		z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+		z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+		return z ^ (z >> 31);
+	}
+
+	std::uint64_t Random::uniform(std::uint64_t bound) {
+		return bound == 0 ? 0 : next() % bound;
+	}
+
+	double Random::unit() {
+		return static_cast<double>(next() >> 11) * 0x1.0p-53;
+	}
+
+	ZipfSampler::ZipfSampler(std::size_t count, double exponent, std::uint64_t seed)
+	: cumulative_(count)
+	, idsByRank_(count) {
+		double sum = 0;
+		for (std::size_t rank = 0; rank < count; ++rank) {
+			sum += 1.0 / std::pow(static_cast<double>(rank + 1), exponent);
+			cumulative_[rank] = sum;
+		}
+		for (double& value : cumulative_) {
+			value /= sum;
+		}
+
+		// Fisher-Yates over the ids, so rank r maps to a seeded, arbitrary product
+		Random random(mix(seed ^ mix(static_cast<std::uint64_t>(Stream::Ranks) << 40)));
+		for (std::size_t i = 0; i < count; ++i) {
+			idsByRank_[i] = static_cast<std::int32_t>(i + 1);
+		}
+		for (std::size_t i = count; i > 1; --i) {
+			std::swap(idsByRank_[i - 1], idsByRank_[random.uniform(i)]);
+		}
+	}
+
+	std::int32_t ZipfSampler::sample(Random& random) const {
+		if (cumulative_.empty()) {
+			return 0;
+		}
+		auto rank = static_cast<std::size_t>(
+		    std::upper_bound(cumulative_.begin(), cumulative_.end(), random.unit()) - cumulative_.begin());
+		return idsByRank_[std::min(rank, idsByRank_.size() - 1)];
+	}
+
+	pgsqlSchema::Customers::Row makeCustomer(const DatagenConfig& config, std::int32_t id) {
+		Random random = rowRandom(config, Stream::Customers, static_cast<std::uint64_t>(id));
+		std::string first = pick(random, kFirstNames);
+		std::string last = pick(random, kLastNames);
+
+		char phone[16];
+		std::snprintf(phone,
+		              sizeof(phone),
+		              "555-%03u-%04u",
+		              static_cast<unsigned>(random.uniform(1000)),
+		              static_cast<unsigned>(random.uniform(10000)));
+
+		pgsqlSchema::Customers::Row row;
+		row.customerId = id;
+		row.name = first + " " + last;
+		row.phoneNumber = phone;
+		row.email = lowercase(first) + "." + lowercase(last) + std::to_string(id) + "@example.com";
+		row.address = std::to_string(1 + random.uniform(9999)) + " " + pick(random, kStreets) + " St, Springfield";
+		row.isDeleted = false;
+		return row;
+	}
+
+	pgsqlSchema::Products::Row makeProduct(const DatagenConfig& config, std::int32_t id) {
+		Random random = rowRandom(config, Stream::Products, static_cast<std::uint64_t>(id));
+
+		pgsqlSchema::Products::Row row;
+		row.productId = id;
+		row.name = std::string(pick(random, kAdjectives)) + " " + pick(random, kAnimals) + " " + pick(random, kItems);
+		// Log-uniform between 1.99 and 198.99, always ending in .99
+		double units = std::exp(std::log(2.0) + random.unit() * (std::log(200.0) - std::log(2.0)));
+		row.priceCents = static_cast<std::int64_t>(units) * 100 - 1;
+		row.stock = static_cast<std::int32_t>(random.uniform(500));
+		if (random.uniform(10) != 0) {
+			row.category = pick(random, kCategories);
+		}
+		row.isDeleted = false;
+		return row;
+	}
+
+	pgsqlSchema::Employees::Row makeEmployee(const DatagenConfig& config, std::int32_t id) {
+		Random random = rowRandom(config, Stream::Employees, static_cast<std::uint64_t>(id));
+		std::string first = pick(random, kFirstNames);
+		std::string last = pick(random, kLastNames);
+
+		pgsqlSchema::Employees::Row row;
+		row.employeeId = id;
+		row.name = first + " " + last;
+		row.position = pick(random, kPositions);
+		row.hireDate = config.firstOrderDate - static_cast<std::int32_t>(random.uniform(3650));
+		if (random.uniform(10) != 0) {
+			row.contactInfo = lowercase(first) + "." + lowercase(last) + "@petstore.example.com";
+		}
+		row.isDeleted = false;
+		return row;
+	}
+
+	pgsqlSchema::Suppliers::Row makeSupplier(const DatagenConfig& config, std::int32_t id) {
+		Random random = rowRandom(config, Stream::Suppliers, static_cast<std::uint64_t>(id));
+		std::string last = pick(random, kLastNames);
+
+		pgsqlSchema::Suppliers::Row row;
+		row.supplierId = id;
+		row.name = last + " Pet Supply " + std::to_string(id);
+		row.contactInfo = "sales@" + lowercase(last) + std::to_string(id) + ".example.com";
+		if (config.products > 0) {
+			row.productId = static_cast<std::int32_t>(1 + random.uniform(config.products));
+		}
+		row.isDeleted = false;
+		return row;
+	}
+
+	OrderGenerator::OrderGenerator(const DatagenConfig& config)
+	: config_(config)
+	, products_(config.products, config.zipfExponent, config.seed) {
+		std::size_t chunkRows = std::max<std::size_t>(config_.chunkRows, 1);
+		std::size_t chunks = (config_.orders + chunkRows - 1) / chunkRows;
+		itemBase_.resize(chunks);
+		for (std::size_t chunk = 0; chunk < chunks; ++chunk) {
+			itemBase_[chunk] = totalItems_;
+			std::size_t last = std::min(config_.orders, (chunk + 1) * chunkRows);
+			for (std::size_t order = chunk * chunkRows; order < last; ++order) {
+				totalItems_ += static_cast<std::uint64_t>(itemCount(static_cast<std::int32_t>(order + 1)));
+			}
+		}
+
+		prices_.resize(config_.products);
+		for (std::size_t product = 0; product < config_.products; ++product) {
+			prices_[product] = makeProduct(config_, static_cast<std::int32_t>(product + 1)).priceCents;
+		}
+	}
+
+	int OrderGenerator::itemCount(std::int32_t orderId) const {
+		Random random = rowRandom(config_, Stream::ItemCounts, static_cast<std::uint64_t>(orderId));
+		return 1 + static_cast<int>(random.uniform(static_cast<std::uint64_t>(std::max(config_.maxItemsPerOrder, 1))));
+	}
+
+	void OrderGenerator::generate(std::size_t chunk, OrderChunk& out) const {
+		out.orders.clear();
+		out.items.clear();
+		std::size_t chunkRows = std::max<std::size_t>(config_.chunkRows, 1);
+		std::size_t first = chunk * chunkRows;
+		std::size_t last = std::min(config_.orders, first + chunkRows);
+		auto itemId = static_cast<std::int32_t>(itemBase_[chunk]);
+		std::uint64_t itemEnd = chunk + 1 < itemBase_.size() ? itemBase_[chunk + 1] : totalItems_;
+		out.orders.reserve(last - first);
+		out.items.reserve(static_cast<std::size_t>(itemEnd - itemBase_[chunk]));
+
+		for (std::size_t index = first; index < last; ++index) {
+			auto orderId = static_cast<std::int32_t>(index + 1);
+			Random random = rowRandom(config_, Stream::Orders, static_cast<std::uint64_t>(orderId));
+
+			pgsqlSchema::Orders::Row order;
+			order.orderId = orderId;
+			order.orderDate = config_.firstOrderDate
+			                  + static_cast<std::int32_t>(random.uniform(static_cast<std::uint64_t>(
+			                      std::max(config_.orderDays, 1))));
+			// One in five orders is placed online without a cashier, one in twenty as a guest
+			if (config_.employees > 0 && random.uniform(5) != 0) {
+				order.employeeId = static_cast<std::int32_t>(1 + random.uniform(config_.employees));
+			}
+			if (config_.customers > 0 && random.uniform(20) != 0) {
+				order.customerId = static_cast<std::int32_t>(1 + random.uniform(config_.customers));
+			}
+			std::uint64_t status = random.uniform(100);
+			order.status = status < 80 ? "completed" : status < 90 ? "shipped" : status < 97 ? "pending" : "cancelled";
+			order.totalCents = 0;
+			order.isDeleted = false;
+
+			for (int line = itemCount(orderId); line > 0; --line) {
+				pgsqlSchema::OrderItems::Row item;
+				item.orderItemId = ++itemId;
+				item.orderId = orderId;
+				item.productId = products_.sample(random);
+				item.quantity = 1 + static_cast<std::int32_t>(random.uniform(10) == 0 ? random.uniform(5) : 0);
+				item.priceCents = prices_[static_cast<std::size_t>(item.productId - 1)];
+				item.isDeleted = false;
+				order.totalCents += item.priceCents * item.quantity;
+				out.items.push_back(std::move(item));
+			}
+			out.orders.push_back(std::move(order));
+		}
+	}
+
+	bool validate(const DatagenConfig& config, std::string& error) {
+		constexpr auto maxId = static_cast<std::size_t>(std::numeric_limits<std::int32_t>::max());
+		if (config.customers > maxId || config.products > maxId || config.employees > maxId
+		    || config.suppliers > maxId || config.orders > maxId) {
+			error = "row counts must fit the INTEGER ids";
+		}
+		else if (config.orders > 0 && config.products == 0) {
+			error = "orders need at least one product";
+		}
+		else if (config.maxItemsPerOrder < 1 || config.threads < 1 || config.chunkRows < 1 || config.orderDays < 1) {
+			error = "items per order, threads, chunk rows and order days must be positive";
+		}
+		else if (!(config.zipfExponent >= 0)) {
+			error = "the Zipf exponent must not be negative";
+		}
+		else {
+			return true;
+		}
+		return false;
+	}
+
+	void appendCsvText(std::string& out, const std::string& value) {
+		if (!value.empty() && value.find_first_of(",\"\r\n") == std::string::npos) {
+			out += value;
+			return;
+		}
+		out += '"';
+		for (char c : value) {
+			out += c;
+			if (c == '"') {
+				out += '"';
+			}
+		}
+		out += '"';
+	}
+
+	void appendCsvDate(std::string& out, std::int32_t pgDays) {
+		pgsqlBinary::Date date = pgsqlBinary::civilFromDays(pgDays + pgsqlBinary::kPostgresEpochDays);
+		char text[16];
+		std::snprintf(text, sizeof(text), "%04d-%02u-%02u", date.year, date.month, date.day);
+		out += text;
+	}
+
+	void appendCsvMoney(std::string& out, std::int64_t cents) {
+		if (cents < 0) {
+			out += '-';
+		}
+		std::uint64_t magnitude = cents < 0 ? 0 - static_cast<std::uint64_t>(cents) : static_cast<std::uint64_t>(cents);
+		out += std::to_string(magnitude / 100);
+		out += '.';
+		out += static_cast<char>('0' + magnitude % 100 / 10);
+		out += static_cast<char>('0' + magnitude % 10);
+	}
+
+	void DatagenReport::print(std::ostream& out) const {
+		std::uint64_t total = 0;
+		for (const TableCount& table : tables) {
+			total += table.rows;
+		}
+		out << "\n" << (ok ? "Generated " : "Generation failed after ") << total << " rows in " << std::fixed
+		    << std::setprecision(2) << seconds << " s (" << (seconds > 0 ? static_cast<double>(total) / seconds : 0.0)
+		    << " rows/s)" << std::endl;
+		for (const TableCount& table : tables) {
+			out << "  " << std::left << std::setw(20) << table.table << std::right << std::setw(14) << table.rows
+			    << std::endl;
+		}
+		if (!ok) {
+			out << "Error: " << error << std::endl;
+		}
+	}
+
+	static std::size_t chunkCount(std::size_t rows, const DatagenConfig& config) {
+		return (rows + config.chunkRows - 1) / config.chunkRows;
+	}
+
+	// Rows of one chunk of a dimension table, ids chunk * chunkRows + 1 onwards
+	template<typename Table>
+	static void makeRows(const DatagenConfig& config,
+	                     typename Table::Row (*make)(const DatagenConfig&, std::int32_t),
+	                     std::size_t count,
+	                     std::size_t chunk,
+	                     std::vector<typename Table::Row>& rows) {
+		rows.clear();
+		std::size_t last = std::min(count, (chunk + 1) * config.chunkRows);
+		for (std::size_t index = chunk * config.chunkRows; index < last; ++index) {
+			rows.push_back(make(config, static_cast<std::int32_t>(index + 1)));
+		}
+	}
+
+	template<typename Table>
+	static bool loadDimension(const DatagenConfig& config,
+	                          typename Table::Row (*make)(const DatagenConfig&, std::int32_t),
+	                          std::size_t count,
+	                          std::vector<pgsqlHandles::PgConn>& conns,
+	                          DatagenReport& report) {
+		pgsqlCopy::ImportOptions options;
+		options.advanceSequence = false; // Once at the end, not racing between workers
+		bool ok = pgsqlWorkers::runIndexed(
+		    chunkCount(count, config),
+		    conns.size(),
+		    [&](std::size_t chunk, std::size_t worker, std::string& error) {
+			    std::vector<typename Table::Row> rows;
+			    makeRows<Table>(config, make, count, chunk, rows);
+			    pgsqlCopy::ImportStats stats = pgsqlCopy::copyBinary<Table>(conns[worker].get(), rows, options);
+			    error = std::string(Table::name) + ": " + stats.error;
+			    return stats.ok;
+		    },
+		    report.error);
+		report.tables.push_back({Table::name, ok ? count : 0});
+		return ok;
+	}
+
+	DatagenReport loadDatabase(const DatagenConfig& config, const std::string& conninfo) {
+		DatagenReport report;
+		auto start = Clock::now();
+		if (!validate(config, report.error)) {
+			return report;
+		}
+		OrderGenerator orders(config);
+		if (orders.totalItems() > static_cast<std::uint64_t>(std::numeric_limits<std::int32_t>::max())) {
+			report.error = "order items would overflow the INTEGER ids";
+			return report;
+		}
+
+		// One connection per worker; async commit is safe here since a crashed load is rerun from scratch
+		std::vector<pgsqlHandles::PgConn> conns;
+		for (std::size_t i = 0; i < config.threads; ++i) {
+			pgsqlHandles::PgConn conn = pgsqlHandles::PgConn::connect(conninfo);
+			if (!conn.ok()) {
+				report.error = conn.errorMessage();
+				return report;
+			}
+			pgsqlHandles::PgResult res = pgsqlHandles::PgResult::exec(conn.get(), "SET synchronous_commit = off;");
+			if (!res.ok()) {
+				report.error = res.errorMessage();
+				return report;
+			}
+			conns.push_back(std::move(conn));
+		}
+
+		// Explicit ids would collide with existing rows, so only an empty store is loaded
+		bool empty = true;
+		pgsqlSchema::forEachTable<pgsqlSchema::PetstoreTables>([&](auto table) {
+			using Table = decltype(table);
+			std::string sql = std::string("SELECT 1 FROM ") + Table::name + " LIMIT 1;";
+			pgsqlHandles::PgResult res = pgsqlHandles::PgResult::exec(conns[0].get(), sql.c_str());
+			if (empty && (!res.ok() || res.rows() > 0)) {
+				report.error = res.ok() ? std::string(Table::name) + " is not empty" : res.errorMessage();
+				empty = false;
+			}
+		});
+		if (!empty) {
+			return report;
+		}
+
+		// Every month of the history gets its partition up front; created chunk by chunk, the workers
+		// would queue behind each other for the lock on Orders
+		const pgsqlPartitions::PartitionedTable* partitioned =
+		    pgsqlPartitions::partitionedTable(pgsqlSchema::Orders::name);
+		std::int32_t lastOrderDate = config.firstOrderDate + config.orderDays - 1;
+		if (partitioned
+		    && !pgsqlPartitions::ensureMonths(
+		        conns[0].get(), *partitioned, config.firstOrderDate, lastOrderDate, report.error))
+		{
+			return report;
+		}
+
+		// Parents first: suppliers reference products, orders customers and employees
+		bool ok = loadDimension<pgsqlSchema::Customers>(config, makeCustomer, config.customers, conns, report)
+		          && loadDimension<pgsqlSchema::Products>(config, makeProduct, config.products, conns, report)
+		          && loadDimension<pgsqlSchema::Employees>(config, makeEmployee, config.employees, conns, report)
+		          && loadDimension<pgsqlSchema::Suppliers>(config, makeSupplier, config.suppliers, conns, report);
+
+		if (ok) {
+			// Each chunk's orders and items commit together, so a failure never leaves orphaned items
+			pgsqlCopy::ImportOptions options;
+			options.advanceSequence = false;
+			ok = pgsqlWorkers::runIndexed(
+			    orders.chunks(),
+			    conns.size(),
+			    [&](std::size_t chunk, std::size_t worker, std::string& error) {
+				    OrderChunk rows;
+				    orders.generate(chunk, rows);
+				    std::vector<pgsqlCopy::ImportStats> stats =
+				        pgsqlCopy::importOrderHistory(conns[worker].get(), rows.orders, rows.items, options);
+				    error = stats[0].ok ? stats[1].error : stats[0].error;
+				    return stats[0].ok && stats[1].ok;
+			    },
+			    report.error);
+			report.tables.push_back({pgsqlSchema::Orders::name, ok ? config.orders : 0});
+			report.tables.push_back({pgsqlSchema::OrderItems::name, ok ? orders.totalItems() : 0});
+		}
+
+		if (ok) {
+			pgsqlSchema::forEachTable<pgsqlSchema::PetstoreTables>([&](auto table) {
+				using Table = decltype(table);
+				ok = ok
+				     && pgsqlCopy::advanceSequence(
+				         conns[0].get(), Table::name, pgsqlSchema::serialColumn<Table>(), report.error);
+			});
+		}
+
+		report.ok = ok;
+		report.seconds = secondsSince(start);
+		return report;
+	}
+
+	// Appends chunks to a file strictly in chunk order, whichever worker finishes first. Workers claim
+	// chunks in increasing order, so the one a writer waits for is always being worked on.
+	class OrderedFile {
+	 public:
+		bool open(const std::string& path, const std::string& header, std::string& error) {
+			file_.open(path, std::ios::binary | std::ios::trunc);
+			file_ << header;
+			if (!file_) {
+				error = "cannot write " + path;
+				return false;
+			}
+			path_ = path;
+			return true;
+		}
+
+		// Every claimed chunk must be written, even after a failure, or later writers would wait forever
+		bool write(std::size_t chunk, const std::string& data, std::string& error) {
+			std::unique_lock<std::mutex> lock(mutex_);
+			turn_.wait(lock, [&] { return next_ == chunk; });
+			bool ok = !failed_ && file_.write(data.data(), static_cast<std::streamsize>(data.size()));
+			failed_ = !ok;
+			++next_;
+			turn_.notify_all();
+			if (!ok) {
+				error = "cannot write " + path_;
+			}
+			return ok;
+		}
+
+		bool close(std::string& error) {
+			file_.close();
+			if (failed_ || !file_) {
+				error = "cannot write " + path_;
+				return false;
+			}
+			return true;
+		}
+
+	 private:
+		std::ofstream file_;
+		std::string path_;
+		std::mutex mutex_;
+		std::condition_variable turn_;
+		std::size_t next_ = 0;
+		bool failed_ = false;
+	};
+
+	template<typename Table>
+	static std::string csvPath(const std::string& directory) {
+		return (std::filesystem::path(directory) / (std::string(Table::name) + ".csv")).string();
+	}
+
+	template<typename Table>
+	static bool openCsv(OrderedFile& file, const std::string& directory, std::string& error) {
+		std::string header;
+		appendCsvHeader<Table>(header);
+		return file.open(csvPath<Table>(directory), header, error);
+	}
+
+	template<typename Table>
+	static bool writeDimension(const DatagenConfig& config,
+	                           typename Table::Row (*make)(const DatagenConfig&, std::int32_t),
+	                           std::size_t count,
+	                           const std::string& directory,
+	                           DatagenReport& report) {
+		OrderedFile file;
+		bool ok = openCsv<Table>(file, directory, report.error)
+		          && pgsqlWorkers::runIndexed(
+		              chunkCount(count, config),
+		              config.threads,
+		              [&](std::size_t chunk, std::size_t, std::string& error) {
+			              std::vector<typename Table::Row> rows;
+			              makeRows<Table>(config, make, count, chunk, rows);
+			              std::string csv;
+			              for (const typename Table::Row& row : rows) {
+				              appendCsv<Table>(row, csv);
+			              }
+			              return file.write(chunk, csv, error);
+		              },
+		              report.error)
+		          && file.close(report.error);
+		report.tables.push_back({Table::name, ok ? count : 0});
+		return ok;
+	}
+
+	DatagenReport writeFiles(const DatagenConfig& config, const std::string& directory) {
+		DatagenReport report;
+		auto start = Clock::now();
+		if (!validate(config, report.error)) {
+			return report;
+		}
+		std::error_code created;
+		std::filesystem::create_directories(directory, created);
+		if (created) {
+			report.error = "cannot create " + directory + ": " + created.message();
+			return report;
+		}
+
+		bool ok = writeDimension<pgsqlSchema::Customers>(config, makeCustomer, config.customers, directory, report)
+		          && writeDimension<pgsqlSchema::Products>(config, makeProduct, config.products, directory, report)
+		          && writeDimension<pgsqlSchema::Employees>(config, makeEmployee, config.employees, directory, report)
+		          && writeDimension<pgsqlSchema::Suppliers>(config, makeSupplier, config.suppliers, directory, report);
+
+		if (ok) {
+			OrderGenerator orders(config);
+			OrderedFile orderFile;
+			OrderedFile itemFile;
+			ok = openCsv<pgsqlSchema::Orders>(orderFile, directory, report.error)
+			     && openCsv<pgsqlSchema::OrderItems>(itemFile, directory, report.error)
+			     && pgsqlWorkers::runIndexed(
+			         orders.chunks(),
+			         config.threads,
+			         [&](std::size_t chunk, std::size_t, std::string& error) {
+				         OrderChunk rows;
+				         orders.generate(chunk, rows);
+				         std::string orderCsv;
+				         std::string itemCsv;
+				         for (const pgsqlSchema::Orders::Row& row : rows.orders) {
+					         appendCsv<pgsqlSchema::Orders>(row, orderCsv);
+				         }
+				         for (const pgsqlSchema::OrderItems::Row& row : rows.items) {
+					         appendCsv<pgsqlSchema::OrderItems>(row, itemCsv);
+				         }
+				         bool written = orderFile.write(chunk, orderCsv, error);
+				         return itemFile.write(chunk, itemCsv, error) && written;
+			         },
+			         report.error)
+			     && orderFile.close(report.error) && itemFile.close(report.error);
+			report.tables.push_back({pgsqlSchema::Orders::name, ok ? config.orders : 0});
+			report.tables.push_back({pgsqlSchema::OrderItems::name, ok ? orders.totalItems() : 0});
+		}
+
+		report.ok = ok;
+		report.seconds = secondsSince(start);
+		return report;
+	}
+} // namespace pgsqlDatagen
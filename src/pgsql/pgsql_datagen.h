@@ -0,0 +1,190 @@
+#ifndef PGSQL_DATAGEN_H
+#define PGSQL_DATAGEN_H
+
+#include "pgsql_schema.h"
+#include <cstddef>
+#include <cstdint>
+#include <iosfwd>
+#include <string>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace pgsqlDatagen {
+
+	// Shape of a synthetic store. Every row is a pure function of (seed, table, id), so the same
+	// config produces the same data whatever the thread count.
+	struct DatagenConfig {
+		std::size_t customers = 10000;
+		std::size_t products = 5000;
+		std::size_t employees = 50;
+		std::size_t suppliers = 500;
+		std::size_t orders = 100000;
+		int maxItemsPerOrder = 8; // Items per order are uniform in 1..maxItemsPerOrder
+		double zipfExponent = 1.1; // Product popularity; 0 is uniform
+		std::uint64_t seed = 42;
+		std::size_t threads = 4;
+		std::size_t chunkRows = 16384; // Rows (orders, for Orders / Order_Items) per unit of work
+		std::int32_t firstOrderDate = 8036; // Days since 2000-01-01; 8036 is 2022-01-01
+		std::int32_t orderDays = 730;
+	};
+
+	// Small, fast generator seeded per row (splitmix64)
+	class Random {
+	 public:
+		explicit Random(std::uint64_t seed)
+		: state_(seed) {}
+
+		std::uint64_t next();
+
+		// Uniform in [0, bound)
+		std::uint64_t uniform(std::uint64_t bound);
+
+		// Uniform in [0, 1)
+		double unit();
+
+	 private:
+		std::uint64_t state_;
+	};
+
+	// Samples product ids with Zipf-distributed popularity. Ranks are shuffled with the seed, so the
+	// best sellers are spread over the id range rather than being products 1, 2, 3...
+	class ZipfSampler {
+	 public:
+		ZipfSampler(std::size_t count, double exponent, std::uint64_t seed);
+
+		// 1-based id
+		std::int32_t sample(Random& random) const;
+
+	 private:
+		std::vector<double> cumulative_;
+		std::vector<std::int32_t> idsByRank_;
+	};
+
+	// False with the reason in error for counts that do not fit the schema or cannot be generated
+	bool validate(const DatagenConfig& config, std::string& error);
+
+	// Dimension rows by id, 1-based. Foreign keys of suppliers point at existing products.
+	pgsqlSchema::Customers::Row makeCustomer(const DatagenConfig& config, std::int32_t id);
+	pgsqlSchema::Products::Row makeProduct(const DatagenConfig& config, std::int32_t id);
+	pgsqlSchema::Employees::Row makeEmployee(const DatagenConfig& config, std::int32_t id);
+	pgsqlSchema::Suppliers::Row makeSupplier(const DatagenConfig& config, std::int32_t id);
+
+	struct OrderChunk {
+		std::vector<pgsqlSchema::Orders::Row> orders;
+		std::vector<pgsqlSchema::OrderItems::Row> items;
+	};
+
+	// Orders in chunks of config.chunkRows. Item ids are dense: the constructor sums the item count
+	// of every chunk so any chunk can be generated on its own, in any order, on any thread.
+	class OrderGenerator {
+	 public:
+		explicit OrderGenerator(const DatagenConfig& config);
+
+		[[nodiscard]] std::size_t chunks() const {
+			return itemBase_.size();
+		}
+
+		[[nodiscard]] std::uint64_t totalItems() const {
+			return totalItems_;
+		}
+
+		// Orders, their items and totals; item prices are the product's list price
+		void generate(std::size_t chunk, OrderChunk& out) const;
+
+	 private:
+		[[nodiscard]] int itemCount(std::int32_t orderId) const;
+
+		DatagenConfig config_;
+		ZipfSampler products_;
+		std::vector<std::uint64_t> itemBase_; // Id of the first item of each chunk, minus one
+		std::vector<std::int64_t> prices_; // List price of every product, by id - 1
+		std::uint64_t totalItems_ = 0;
+	};
+
+	struct TableCount {
+		std::string table;
+		std::uint64_t rows = 0;
+	};
+
+	struct DatagenReport {
+		bool ok = false;
+		std::vector<TableCount> tables;
+		double seconds = 0;
+		std::string error;
+
+		void print(std::ostream& out) const;
+	};
+
+	// Loads the store with binary COPY over config.threads connections. The tables must exist and be
+	// empty (an initialized store); Orders go in before their items, chunk by chunk.
+	DatagenReport loadDatabase(const DatagenConfig& config, const std::string& conninfo);
+
+	// Writes one CSV file per table into directory (Customers.csv, ...), with a header row and the
+	// ids included so the foreign keys line up. Chunks are appended in order, so files are identical
+	// between runs.
+	DatagenReport writeFiles(const DatagenConfig& config, const std::string& directory);
+
+	// Header line naming every column of Table, as pgsqlCopy::importCsv expects it
+	template<typename Table>
+	void appendCsvHeader(std::string& out) {
+		std::apply(
+		    [&](const auto&... column) {
+			    bool first = true;
+			    ((out += first ? "" : ",", out += column.name, first = false), ...);
+		    },
+		    Table::columns);
+		out += '\n';
+	}
+
+	// Text is quoted when it is empty (an unquoted empty field is NULL) or holds a comma, quote or line break
+	void appendCsvText(std::string& out, const std::string& value);
+
+	// Dates as YYYY-MM-DD, money as units.cents
+	void appendCsvDate(std::string& out, std::int32_t pgDays);
+	void appendCsvMoney(std::string& out, std::int64_t cents);
+
+	template<pgsqlSchema::SqlType Type, typename Field>
+	void appendCsvField(const Field& field, std::string& out) {
+		if constexpr (pgsqlSchema::IsOptional<Field>::value) {
+			if (field) {
+				appendCsvField<Type>(*field, out);
+			}
+		}
+		else if constexpr (Type == pgsqlSchema::SqlType::Boolean) {
+			out += field ? 't' : 'f';
+		}
+		else if constexpr (Type == pgsqlSchema::SqlType::Serial || Type == pgsqlSchema::SqlType::Integer) {
+			out += std::to_string(field);
+		}
+		else if constexpr (Type == pgsqlSchema::SqlType::Text) {
+			appendCsvText(out, field);
+		}
+		else if constexpr (Type == pgsqlSchema::SqlType::Money) {
+			appendCsvMoney(out, field);
+		}
+		else {
+			static_assert(Type == pgsqlSchema::SqlType::Date && std::is_same_v<Field, std::int32_t>);
+			appendCsvDate(out, field);
+		}
+	}
+
+	template<typename Table, std::size_t... I>
+	void appendCsvColumns(const typename Table::Row& row, std::string& out, std::index_sequence<I...>) {
+		using Columns = std::remove_const_t<decltype(Table::columns)>;
+		((out += I == 0 ? "" : ",",
+		  appendCsvField<std::tuple_element_t<I, Columns>::type>(row.*std::tuple_element_t<I, Columns>::member, out)),
+		 ...);
+	}
+
+	// CSV line for a row in descriptor order, NULLs as empty fields
+	template<typename Table>
+	void appendCsv(const typename Table::Row& row, std::string& out) {
+		appendCsvColumns<Table>(row, out, std::make_index_sequence<pgsqlSchema::columnCount<Table>()>{});
+		out += '\n';
+	}
+
+} // namespace pgsqlDatagen
+
+#endif // PGSQL_DATAGEN_H
@@ -0,0 +1,575 @@
+#include "pgsql_dump.h"
+#include "pgsql_copy.h"
+#include "pgsql_handles.h"
+#include "pgsql_indexes.h"
+#include "pgsql_partitions.h"
+#include "pgsql_purge.h"
+#include "pgsql_schema.h"
+#include "pgsql_snapshot.h"
+#include "pgsql_workers.h"
+
+#include <algorithm>
+#include <cctype>
+#include <charconv>
+#include <chrono>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+
+namespace pgsqlDump {
+	using Clock = std::chrono::steady_clock;
+
+	constexpr char kManifestMagic[] = "PETDUMP1";
+	constexpr char kManifestName[] = "manifest";
+
+	static double secondsSince(Clock::time_point start) {
+		return std::chrono::duration<double>(Clock::now() - start).count();
+	}
+
+	static std::string manifestPath(const std::string& directory) {
+		return (std::filesystem::path(directory) / kManifestName).string();
+	}
+
+	constexpr char kDatesTag[] = "dates";
+
+	bool writeManifest(const std::string& directory,
+	                   const std::vector<ArchiveChunk>& chunks,
+	                   const std::vector<DateRange>& dates,
+	                   std::string& error) {
+		std::string path = manifestPath(directory);
+		std::string temporary = path + ".tmp";
+		{
+			std::ofstream file(temporary, std::ios::binary | std::ios::trunc);
+			file << kManifestMagic << '\n';
+			for (const ArchiveChunk& chunk : chunks) {
+				file << chunk.table << '\t' << chunk.file << '\t' << chunk.rows << '\n';
+			}
+			for (const DateRange& range : dates) {
+				file << kDatesTag << '\t' << range.table << '\t' << range.firstDay << '\t' << range.lastDay << '\n';
+			}
+			if (!file.flush()) {
+				error = "cannot write " + temporary;
+				return false;
+			}
+		}
+		std::error_code renamed;
+		std::filesystem::rename(temporary, path, renamed);
+		if (renamed) {
+			error = "cannot write " + path + ": " + renamed.message();
+			return false;
+		}
+		return true;
+	}
+
+	// "dates" line: table, first day, last day
+	static bool parseDateRange(const std::string& line, DateRange& range) {
+		std::size_t first = line.find('\t');
+		std::size_t second = first == std::string::npos ? first : line.find('\t', first + 1);
+		std::size_t third = second == std::string::npos ? second : line.find('\t', second + 1);
+		if (third == std::string::npos) {
+			return false;
+		}
+		range.table = line.substr(first + 1, second - first - 1);
+		const char* end = line.data() + line.size();
+		auto [firstEnd, firstError] = std::from_chars(line.data() + second + 1, line.data() + third, range.firstDay);
+		auto [lastEnd, lastError] = std::from_chars(line.data() + third + 1, end, range.lastDay);
+		return firstError == std::errc() && firstEnd == line.data() + third && lastError == std::errc()
+		       && lastEnd == end && !range.table.empty() && range.firstDay <= range.lastDay;
+	}
+
+	bool readManifest(const std::string& directory,
+	                  std::vector<ArchiveChunk>& chunks,
+	                  std::vector<DateRange>& dates,
+	                  std::string& error) {
+		std::string path = manifestPath(directory);
+		std::ifstream file(path, std::ios::binary);
+		std::string line;
+		if (!std::getline(file, line) || line != kManifestMagic) {
+			error = path + " is missing or not a store archive manifest";
+			return false;
+		}
+
+		chunks.clear();
+		dates.clear();
+		std::size_t lineNumber = 1;
+		while (std::getline(file, line)) {
+			++lineNumber;
+			if (line.rfind(std::string(kDatesTag) + '\t', 0) == 0) {
+				DateRange range;
+				if (!parseDateRange(line, range)) {
+					error = path + " line " + std::to_string(lineNumber) + " is malformed";
+					return false;
+				}
+				dates.push_back(std::move(range));
+				continue;
+			}
+			std::size_t first = line.find('\t');
+			std::size_t second = first == std::string::npos ? first : line.find('\t', first + 1);
+			ArchiveChunk chunk;
+			const char* end = line.data() + line.size();
+			bool ok = second != std::string::npos;
+			if (ok) {
+				chunk.table = line.substr(0, first);
+				chunk.file = line.substr(first + 1, second - first - 1);
+				auto [parsedEnd, parseError] = std::from_chars(line.data() + second + 1, end, chunk.rows);
+				ok = parseError == std::errc() && parsedEnd == end && !chunk.table.empty() && !chunk.file.empty()
+				     && chunk.file.find('/') == std::string::npos;
+			}
+			if (!ok) {
+				error = path + " line " + std::to_string(lineNumber) + " is malformed";
+				return false;
+			}
+			chunks.push_back(std::move(chunk));
+		}
+		return true;
+	}
+
+	std::vector<KeyRange> splitKeyRange(std::int64_t minKey, std::int64_t maxKey, std::int64_t chunkKeys) {
+		std::vector<KeyRange> ranges;
+		if (minKey > maxKey) {
+			return ranges;
+		}
+		chunkKeys = std::max<std::int64_t>(chunkKeys, 1);
+		for (std::int64_t first = minKey;; first += chunkKeys) {
+			std::int64_t last = maxKey - first < chunkKeys ? maxKey : first + chunkKeys - 1;
+			ranges.push_back({first, last});
+			if (last == maxKey) {
+				break;
+			}
+		}
+		return ranges;
+	}
+
+	void ArchiveReport::print(std::ostream& out) const {
+		std::uint64_t total = 0;
+		for (const TableStats& table : tables) {
+			total += table.rows;
+		}
+		out << "\n" << (ok ? "Archived " : "Failed after ") << total << " rows in " << std::fixed
+		    << std::setprecision(2) << seconds << " s (" << (seconds > 0 ? static_cast<double>(total) / seconds : 0.0)
+		    << " rows/s)" << std::endl;
+		for (const TableStats& table : tables) {
+			out << "  " << std::left << std::setw(20) << table.table << std::right << std::setw(14) << table.rows
+			    << " rows " << std::setw(6) << table.chunks << " chunks " << std::setw(14) << table.bytes << " bytes"
+			    << std::endl;
+		}
+		if (indexSeconds > 0) {
+			out << "  Index pack and ANALYZE: " << indexSeconds << " s" << std::endl;
+		}
+		if (!ok) {
+			out << "Error: " << error << std::endl;
+		}
+	}
+
+	// A store table as the archive sees it
+	struct StoreTable {
+		std::string name;
+		std::string key; // SERIAL id the dump splits on
+		std::vector<pgsqlSnapshot::SnapshotColumn> columns;
+		std::vector<std::string> references = {}; // Tables its foreign keys point at
+		std::string archiveOf = {}; // Set on an Archive_* table: the store table whose purged rows it holds
+	};
+
+	// The seven store tables, parents before children. A store with the soft-delete step (see
+	// pgsqlPurge) adds deleted_at to each of them, and their seven archives after them.
+	static std::vector<StoreTable> storeTables(bool softDelete) {
+		std::vector<StoreTable> tables;
+		pgsqlSchema::forEachTable<pgsqlSchema::PetstoreTables>([&](auto table) {
+			using Table = decltype(table);
+			StoreTable storeTable{
+			    Table::name, pgsqlSchema::serialColumn<Table>(), pgsqlSnapshot::snapshotColumns<Table>()};
+			for (const pgsqlSchema::ForeignKey& key : Table::foreignKeys) {
+				storeTable.references.emplace_back(key.table);
+			}
+			if (softDelete) {
+				storeTable.columns.push_back({"deleted_at", pgsqlSchema::SqlType::Timestamp});
+			}
+			tables.push_back(std::move(storeTable));
+		});
+		if (!softDelete) {
+			return tables;
+		}
+
+		// An archive is a LIKE copy of its table: the same columns, without the keys, plus archived_at
+		for (std::size_t i = 0, count = tables.size(); i < count; ++i) {
+			StoreTable archive{pgsqlPurge::archiveTableName(tables[i].name), tables[i].key, tables[i].columns};
+			archive.archiveOf = tables[i].name;
+			archive.columns.push_back({"archived_at", pgsqlSchema::SqlType::Timestamp});
+			tables.push_back(std::move(archive));
+		}
+		return tables;
+	}
+
+	// Moves a store table's id sequence past its largest id, archived rows included, so purged ids
+	// are not handed out again
+	static bool advanceSequence(PGconn* conn,
+	                            const std::vector<StoreTable>& tables,
+	                            const StoreTable& table,
+	                            std::string& error) {
+		std::string archive = pgsqlPurge::archiveTableName(table.name);
+		bool archived =
+		    std::any_of(tables.begin(), tables.end(), [&](const StoreTable& t) { return t.name == archive; });
+		if (!archived) {
+			return pgsqlCopy::advanceSequence(conn, table.name, table.key.c_str(), error);
+		}
+		const std::string& key = table.key;
+		std::string sql = "SELECT setval(pg_get_serial_sequence('" + table.name + "', '" + key + "'), max(" + key
+		                  + ")) FROM (SELECT " + key + " FROM " + table.name + " UNION ALL SELECT " + key + " FROM "
+		                  + archive + ") AS ids HAVING max(" + key + ") IS NOT NULL;";
+		pgsqlHandles::PgResult res = pgsqlHandles::PgResult::exec(conn, sql.c_str());
+		if (!res.ok()) {
+			error = res.errorMessage();
+			return false;
+		}
+		return true;
+	}
+
+	static bool exec(PGconn* conn, const std::string& sql, std::string& error) {
+		pgsqlHandles::PgResult res = pgsqlHandles::PgResult::exec(conn, sql.c_str());
+		if (!res.ok()) {
+			error = res.errorMessage();
+			return false;
+		}
+		return true;
+	}
+
+	// count connections, each with setup run on it
+	static bool connectWorkers(const std::string& conninfo,
+	                           std::size_t count,
+	                           const std::string& setup,
+	                           std::vector<pgsqlHandles::PgConn>& conns,
+	                           std::string& error) {
+		for (std::size_t i = 0; i < std::max<std::size_t>(count, 1); ++i) {
+			pgsqlHandles::PgConn conn = pgsqlHandles::PgConn::connect(conninfo);
+			if (!conn.ok()) {
+				error = conn.errorMessage();
+				return false;
+			}
+			if (!exec(conn.get(), setup, error)) {
+				return false;
+			}
+			conns.push_back(std::move(conn));
+		}
+		return true;
+	}
+
+	static std::string chunkFileName(const std::string& table, std::size_t index) {
+		std::string name = table;
+		std::transform(name.begin(), name.end(), name.begin(), [](unsigned char c) {
+			return static_cast<char>(std::tolower(c));
+		});
+		std::string number = std::to_string(index);
+		return name + "." + std::string(number.size() < 4 ? 4 - number.size() : 0, '0') + number + ".snap";
+	}
+
+	// Rows of every table, summed over its chunks, in store table order
+	static std::vector<TableStats> tableTotals(const std::vector<StoreTable>& tables,
+	                                           const std::vector<ArchiveChunk>& chunks,
+	                                           const std::vector<std::uint64_t>& bytes) {
+		std::vector<TableStats> totals;
+		for (const StoreTable& table : tables) {
+			TableStats stats{table.name};
+			for (std::size_t i = 0; i < chunks.size(); ++i) {
+				if (chunks[i].table == table.name) {
+					stats.rows += chunks[i].rows;
+					stats.bytes += bytes[i];
+					++stats.chunks;
+				}
+			}
+			totals.push_back(stats);
+		}
+		return totals;
+	}
+
+	ArchiveReport dumpDatabase(const std::string& conninfo, const std::string& directory, const DumpOptions& options) {
+		ArchiveReport report;
+		auto start = Clock::now();
+		std::error_code created;
+		std::filesystem::create_directories(directory, created);
+		if (created) {
+			report.error = "cannot create " + directory + ": " + created.message();
+			return report;
+		}
+		if (std::filesystem::exists(manifestPath(directory))) {
+			report.error = directory + " already holds an archive";
+			return report;
+		}
+
+		// The coordinator's transaction pins the snapshot until every worker has imported it
+		pgsqlHandles::PgConn coordinator = pgsqlHandles::PgConn::connect(conninfo);
+		if (!coordinator.ok()) {
+			report.error = coordinator.errorMessage();
+			return report;
+		}
+		if (!exec(coordinator.get(), "BEGIN ISOLATION LEVEL REPEATABLE READ, READ ONLY;", report.error)) {
+			return report;
+		}
+		pgsqlHandles::PgResult exported =
+		    pgsqlHandles::PgResult::exec(coordinator.get(), "SELECT pg_export_snapshot();");
+		if (!exported.ok() || exported.rows() != 1) {
+			report.error = exported.errorMessage();
+			return report;
+		}
+		std::string snapshot = PQgetvalue(exported.get(), 0, 0);
+		if (snapshot.empty() || !std::all_of(snapshot.begin(), snapshot.end(), [](unsigned char c) {
+			    return std::isxdigit(c) || c == '-';
+		    }))
+		{
+			report.error = "unexpected snapshot name '" + snapshot + "'";
+			return report;
+		}
+
+		// The soft-delete step adds deleted_at and the archives in one migration, so one of its tables
+		// tells whether the store has it
+		std::string sql = "SELECT to_regclass('" + pgsqlPurge::archiveTableName(pgsqlSchema::Orders::name)
+		                  + "') IS NOT NULL;";
+		pgsqlHandles::PgResult softDelete = pgsqlHandles::PgResult::exec(coordinator.get(), sql.c_str());
+		if (!softDelete.ok() || softDelete.rows() != 1) {
+			report.error = softDelete.errorMessage();
+			return report;
+		}
+
+		// Id ranges as of the snapshot; an empty table still gets one (empty) chunk
+		std::vector<StoreTable> tables = storeTables(PQgetvalue(softDelete.get(), 0, 0)[0] == 't');
+		std::vector<ArchiveChunk> chunks;
+		std::vector<std::string> filters;
+		std::vector<std::size_t> chunkTables;
+		for (std::size_t t = 0; t < tables.size(); ++t) {
+			const std::string& key = tables[t].key;
+			sql = "SELECT min(" + key + "), max(" + key + ") FROM " + tables[t].name + ";";
+			pgsqlHandles::PgResult bounds = pgsqlHandles::PgResult::exec(coordinator.get(), sql.c_str());
+			if (!bounds.ok() || bounds.rows() != 1) {
+				report.error = tables[t].name + ": " + bounds.errorMessage();
+				return report;
+			}
+			std::vector<KeyRange> ranges;
+			if (!PQgetisnull(bounds.get(), 0, 0)) {
+				ranges = splitKeyRange(std::strtoll(PQgetvalue(bounds.get(), 0, 0), nullptr, 10),
+				                       std::strtoll(PQgetvalue(bounds.get(), 0, 1), nullptr, 10),
+				                       options.chunkKeys);
+			}
+			for (std::size_t i = 0; i < std::max<std::size_t>(ranges.size(), 1); ++i) {
+				filters.push_back(ranges.empty() ? std::string()
+				                                 : key + " BETWEEN " + std::to_string(ranges[i].first) + " AND "
+				                                       + std::to_string(ranges[i].last));
+				chunkTables.push_back(t);
+				chunks.push_back({tables[t].name, chunkFileName(tables[t].name, i)});
+			}
+		}
+
+		// Partition key range of each partitioned table, whatever the source layout: the restore target
+		// decides whether it needs partitions for them
+		std::vector<DateRange> dates;
+		for (const StoreTable& table : tables) {
+			const pgsqlPartitions::PartitionedTable* partitioned = pgsqlPartitions::partitionedTable(table.name);
+			if (!partitioned) {
+				continue;
+			}
+			std::string column = partitioned->column;
+			sql = "SELECT min(" + column + ") - DATE '2000-01-01', max(" + column + ") - DATE '2000-01-01' FROM "
+			      + table.name + ";";
+			pgsqlHandles::PgResult bounds = pgsqlHandles::PgResult::exec(coordinator.get(), sql.c_str());
+			if (!bounds.ok() || bounds.rows() != 1) {
+				report.error = table.name + ": " + bounds.errorMessage();
+				return report;
+			}
+			if (!bounds[0].isNull(0)) {
+				dates.push_back({table.name, bounds[0].get<std::int32_t>(0), bounds[0].get<std::int32_t>(1)});
+			}
+		}
+
+		std::vector<pgsqlHandles::PgConn> conns;
+		std::string importSnapshot =
+		    "BEGIN ISOLATION LEVEL REPEATABLE READ, READ ONLY; SET TRANSACTION SNAPSHOT '" + snapshot + "';";
+		if (!connectWorkers(conninfo, options.threads, importSnapshot, conns, report.error)
+		    || !exec(coordinator.get(), "COMMIT;", report.error))
+		{
+			return report;
+		}
+
+		std::vector<std::uint64_t> bytes(chunks.size());
+		bool ok = pgsqlWorkers::runIndexed(
+		    chunks.size(),
+		    conns.size(),
+		    [&](std::size_t i, std::size_t worker, std::string& error) {
+			    const StoreTable& table = tables[chunkTables[i]];
+			    std::string path = (std::filesystem::path(directory) / chunks[i].file).string();
+			    pgsqlSnapshot::ExportStats stats = pgsqlSnapshot::exportSnapshot(
+			        conns[worker].get(), table.name, table.columns, path, options.blockRows, filters[i]);
+			    chunks[i].rows = stats.rows;
+			    bytes[i] = stats.bytesOut;
+			    error = table.name + ": " + stats.error;
+			    return stats.ok;
+		    },
+		    report.error);
+		for (pgsqlHandles::PgConn& conn : conns) {
+			ok = exec(conn.get(), "COMMIT;", report.error) && ok;
+		}
+
+		report.tables = tableTotals(tables, chunks, bytes);
+		report.ok = ok && writeManifest(directory, chunks, dates, report.error);
+		report.seconds = secondsSince(start);
+		return report;
+	}
+
+	ArchiveReport restoreDatabase(const std::string& conninfo,
+	                              const std::string& directory,
+	                              const RestoreOptions& options) {
+		ArchiveReport report;
+		auto start = Clock::now();
+		std::vector<ArchiveChunk> chunks;
+		std::vector<DateRange> dates;
+		if (!readManifest(directory, chunks, dates, report.error)) {
+			return report;
+		}
+		// Tables without a chunk are the archives of a store dumped before the soft-delete step; every
+		// dumped table has at least one
+		std::vector<StoreTable> tables = storeTables(true);
+		auto undumped = [&](const StoreTable& table) {
+			return std::none_of(
+			    chunks.begin(), chunks.end(), [&](const ArchiveChunk& chunk) { return chunk.table == table.name; });
+		};
+		tables.erase(std::remove_if(tables.begin(), tables.end(), undumped), tables.end());
+		std::vector<std::size_t> chunkTables;
+		for (const ArchiveChunk& chunk : chunks) {
+			auto table = std::find_if(
+			    tables.begin(), tables.end(), [&](const StoreTable& t) { return t.name == chunk.table; });
+			if (table == tables.end()) {
+				report.error = "archive holds unknown table " + chunk.table;
+				return report;
+			}
+			chunkTables.push_back(static_cast<std::size_t>(table - tables.begin()));
+		}
+		if (options.maintenanceWorkMem.find('\'') != std::string::npos) {
+			report.error = "invalid maintenance_work_mem";
+			return report;
+		}
+
+		pgsqlHandles::PgConn coordinator = pgsqlHandles::PgConn::connect(conninfo);
+		if (!coordinator.ok()) {
+			report.error = coordinator.errorMessage();
+			return report;
+		}
+
+		// Chunks keep the source store's ids and the sequences only move past the largest of them, so
+		// restoring on top of existing rows would fail on the primary keys halfway through the load
+		for (const StoreTable& table : tables) {
+			std::string sql = "SELECT 1 FROM " + table.name + " LIMIT 1;";
+			pgsqlHandles::PgResult res = pgsqlHandles::PgResult::exec(coordinator.get(), sql.c_str());
+			if (!res.ok() || res.rows() > 0) {
+				report.error = res.ok() ? table.name + " is not empty" : res.errorMessage();
+				return report;
+			}
+		}
+
+		// A fresh store only has the partitions of the maintenance window; an archived history needs
+		// every month it covers, created before the loaders so they do not queue on the parent's lock
+		for (const DateRange& range : dates) {
+			const pgsqlPartitions::PartitionedTable* partitioned = pgsqlPartitions::partitionedTable(range.table);
+			if (!partitioned) {
+				report.error = "archive holds dates for unpartitioned table " + range.table;
+				return report;
+			}
+			if (!pgsqlPartitions::ensureMonths(
+			        coordinator.get(), *partitioned, range.firstDay, range.lastDay, report.error))
+			{
+				return report;
+			}
+		}
+
+		// A COPY commit need not wait for its WAL flush: a restore cut short by a server crash leaves a
+		// partial store that has to be recreated anyway (see restoreDatabase)
+		std::vector<pgsqlHandles::PgConn> conns;
+		std::string setup =
+		    "SET synchronous_commit = off; SET maintenance_work_mem = '" + options.maintenanceWorkMem + "';";
+		if (!connectWorkers(conninfo, options.threads, setup, conns, report.error)) {
+			return report;
+		}
+
+		// Maintaining the secondary indexes row by row costs more than building them once from sorted
+		// input. schema_migrations still lists the pack as applied, so from here on every path out of
+		// the restore builds it again, a failed one included.
+		const std::vector<pgsqlIndexes::IndexDefinition>& pack = pgsqlIndexes::petstoreIndexPack();
+		auto rebuildPack = [&](std::vector<pgsqlWorkers::Task>& tasks) {
+			for (const pgsqlIndexes::IndexDefinition& index : pack) {
+				tasks.push_back({[&conns, &index](std::size_t worker, std::string& error) {
+					return exec(conns[worker].get(), pgsqlIndexes::createIndexSQL(index, false), error);
+				}});
+			}
+		};
+		auto restorePack = [&]() {
+			std::vector<pgsqlWorkers::Task> tasks;
+			rebuildPack(tasks);
+			std::string error;
+			if (!pgsqlWorkers::runTasks(tasks, conns.size(), error)) {
+				report.error += "; rebuilding the index pack failed too: " + error;
+			}
+		};
+		if (options.rebuildIndexes) {
+			for (const pgsqlIndexes::IndexDefinition& index : pack) {
+				if (!exec(coordinator.get(), pgsqlIndexes::dropIndexSQL(index, false), report.error)) {
+					restorePack();
+					return report;
+				}
+			}
+		}
+
+		// A chunk waits for every chunk of the tables its table references
+		std::vector<std::uint64_t> bytes(chunks.size());
+		std::vector<pgsqlWorkers::Task> tasks;
+		for (std::size_t i = 0; i < chunks.size(); ++i) {
+			pgsqlWorkers::Task task{[&, i](std::size_t worker, std::string& error) {
+				std::string path = (std::filesystem::path(directory) / chunks[i].file).string();
+				pgsqlCopy::ImportStats stats =
+				    pgsqlSnapshot::importSnapshot(conns[worker].get(), chunks[i].table, path);
+				bytes[i] = stats.bytes;
+				if (stats.ok && stats.rows != chunks[i].rows) {
+					stats.error = chunks[i].file + " holds " + std::to_string(stats.rows) + " rows, the manifest "
+					              + std::to_string(chunks[i].rows);
+					stats.ok = false;
+				}
+				error = chunks[i].table + ": " + stats.error;
+				return stats.ok;
+			}};
+			const std::vector<std::string>& references = tables[chunkTables[i]].references;
+			for (std::size_t j = 0; j < chunks.size(); ++j) {
+				if (std::find(references.begin(), references.end(), chunks[j].table) != references.end()) {
+					task.after.push_back(j);
+				}
+			}
+			tasks.push_back(std::move(task));
+		}
+		bool ok = pgsqlWorkers::runTasks(tasks, conns.size(), report.error);
+		report.tables = tableTotals(tables, chunks, bytes);
+		for (const StoreTable& table : tables) {
+			ok = ok && (!table.archiveOf.empty() || advanceSequence(coordinator.get(), tables, table, report.error));
+		}
+
+		// Index builds, then statistics for the planner, spread over the workers
+		auto indexStart = Clock::now();
+		if (!ok) {
+			if (options.rebuildIndexes) {
+				restorePack();
+			}
+			report.seconds = secondsSince(start);
+			return report;
+		}
+		tasks.clear();
+		if (options.rebuildIndexes) {
+			rebuildPack(tasks);
+		}
+		for (const StoreTable& table : tables) {
+			tasks.push_back({[&conns, &table](std::size_t worker, std::string& error) {
+				return exec(conns[worker].get(), "ANALYZE " + table.name + ";", error);
+			}});
+		}
+		ok = pgsqlWorkers::runTasks(tasks, conns.size(), report.error);
+		report.indexSeconds = secondsSince(indexStart);
+
+		report.ok = ok;
+		report.seconds = secondsSince(start);
+		return report;
+	}
+} // namespace pgsqlDump
@@ -0,0 +1,98 @@
+#ifndef PGSQL_DUMP_H
+#define PGSQL_DUMP_H
+
+#include <cstddef>
+#include <cstdint>
+#include <iosfwd>
+#include <string>
+#include <vector>
+
+namespace pgsqlDump {
+
+	// Archive directory: one columnar snapshot file (see pgsqlSnapshot) per table chunk, and a manifest
+	// written last, so a directory without one is an interrupted dump:
+	//   manifest  "PETDUMP1", then one line per chunk: table, file name, rows (tab-separated), then
+	//             one line per non-empty partitioned table: "dates", table, first day, last day
+	struct ArchiveChunk {
+		std::string table;
+		std::string file; // Relative to the archive directory
+		std::uint64_t rows = 0;
+	};
+
+	// Days (since 2000-01-01) of the partition key a table's rows span, so a restore can create the
+	// monthly partitions they need before loading them
+	struct DateRange {
+		std::string table;
+		std::int32_t firstDay = 0;
+		std::int32_t lastDay = 0;
+	};
+
+	bool writeManifest(const std::string& directory,
+	                   const std::vector<ArchiveChunk>& chunks,
+	                   const std::vector<DateRange>& dates,
+	                   std::string& error);
+	bool readManifest(const std::string& directory,
+	                  std::vector<ArchiveChunk>& chunks,
+	                  std::vector<DateRange>& dates,
+	                  std::string& error);
+
+	// Inclusive id range of one chunk
+	struct KeyRange {
+		std::int64_t first;
+		std::int64_t last;
+	};
+
+	// Splits [minKey, maxKey] into ranges of at most chunkKeys ids
+	std::vector<KeyRange> splitKeyRange(std::int64_t minKey, std::int64_t maxKey, std::int64_t chunkKeys);
+
+	struct DumpOptions {
+		std::size_t threads = 4; // Worker connections, each importing the same snapshot
+		std::int64_t chunkKeys = 1000000; // Ids per archive file; large tables are spread over the workers
+		std::size_t blockRows = 65536;
+	};
+
+	struct RestoreOptions {
+		std::size_t threads = 4;
+		bool rebuildIndexes = true; // Drop the secondary index pack before loading and build it afterwards
+		std::string maintenanceWorkMem = "256MB"; // For the index builds
+	};
+
+	struct TableStats {
+		std::string table;
+		std::uint64_t rows = 0;
+		std::uint64_t bytes = 0; // Archive bytes written, or binary COPY bytes sent
+		std::size_t chunks = 0;
+	};
+
+	struct ArchiveReport {
+		bool ok = false;
+		std::vector<TableStats> tables; // Store tables in foreign-key order, then their archives
+		double seconds = 0;
+		double indexSeconds = 0; // Restore: building the index pack and analyzing
+		std::string error;
+
+		void print(std::ostream& out) const;
+	};
+
+	// Dumps all seven store tables into directory as of one instant: a coordinator exports its
+	// snapshot with pg_export_snapshot() and every worker runs SET TRANSACTION SNAPSHOT before its
+	// first COPY, so the chunks form one consistent image while the store keeps taking writes.
+	// A store with the soft-delete step also keeps deleted_at, so restored rows keep their retention,
+	// and its Archive_* tables. The directory is created; an existing archive in it is not overwritten.
+	ArchiveReport dumpDatabase(const std::string& conninfo,
+	                           const std::string& directory,
+	                           const DumpOptions& options = {});
+
+	// Loads an archive into a store whose tables exist and are empty; an archive with deleted_at needs
+	// a store with the soft-delete step. On the monthly layout the partitions for the archived dates
+	// are created first, however old the rows are. A table's chunks load in parallel once every table it
+	// references is complete, so foreign keys stay checked. The id sequences are advanced past the
+	// archived ids too, and the index pack built after the data. A failed restore leaves partial data
+	// behind, with the index pack rebuilt over it; recreate the store before retrying.
+	ArchiveReport restoreDatabase(const std::string& conninfo,
+	                              const std::string& directory,
+	                              const RestoreOptions& options = {});
+
+} // namespace pgsqlDump
+
+#endif // PGSQL_DUMP_H
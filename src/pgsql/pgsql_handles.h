@@ -0,0 +1,272 @@
+#ifndef PGSQL_HANDLES_H
+#define PGSQL_HANDLES_H
+
+#include "libpq-fe.h"
+#include <charconv>
+#include <cstddef>
+#include <iterator>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <utility>
+
+namespace pgsqlHandles {
+
+	// Move-only owner of a PGconn, closed with PQfinish
+	class PgConn {
+	 public:
+		PgConn() = default;
+		explicit PgConn(PGconn* conn)
+		: conn_(conn) {}
+		~PgConn() {
+			reset();
+		}
+
+		PgConn(const PgConn&) = delete;
+		PgConn& operator=(const PgConn&) = delete;
+		PgConn(PgConn&& other) noexcept
+		: conn_(std::exchange(other.conn_, nullptr)) {}
+		PgConn& operator=(PgConn&& other) noexcept {
+			if (this != &other) {
+				reset(std::exchange(other.conn_, nullptr));
+			}
+			return *this;
+		}
+
+		// Blocking connect; check ok() and errorMessage() on the returned handle
+		static PgConn connect(const std::string& conninfo) {
+			return PgConn(PQconnectdb(conninfo.c_str()));
+		}
+
+		[[nodiscard]] PGconn* get() const {
+			return conn_;
+		}
+
+		[[nodiscard]] bool ok() const {
+			return conn_ && PQstatus(conn_) == CONNECTION_OK;
+		}
+
+		[[nodiscard]] const char* errorMessage() const {
+			return conn_ ? PQerrorMessage(conn_) : "no connection";
+		}
+
+		void reset(PGconn* conn = nullptr) {
+			if (conn_) {
+				PQfinish(conn_);
+			}
+			conn_ = conn;
+		}
+
+		PGconn* release() {
+			return std::exchange(conn_, nullptr);
+		}
+
+	 private:
+		PGconn* conn_ = nullptr;
+	};
+
+	// Non-owning view of one row; columns are returned as string_views into the PGresult
+	class RowView {
+	 public:
+		RowView(const PGresult* res, int row)
+		: res_(res)
+		, row_(row) {}
+
+		[[nodiscard]] int index() const {
+			return row_;
+		}
+
+		[[nodiscard]] int columns() const {
+			return PQnfields(res_);
+		}
+
+		[[nodiscard]] bool isNull(int column) const {
+			return PQgetisnull(res_, row_, column) != 0;
+		}
+
+		// Raw value bytes, valid as long as the owning PgResult
+		[[nodiscard]] std::string_view operator[](int column) const {
+			return {PQgetvalue(res_, row_, column), static_cast<std::size_t>(PQgetlength(res_, row_, column))};
+		}
+
+		// Typed access to a text-format column: integral, floating point, bool, string_view or string.
+		// Unparsable and NULL values yield a value-initialized T; use getOptional to tell them apart.
+		template<typename T>
+		[[nodiscard]] T get(int column) const {
+			return getOptional<T>(column).value_or(T{});
+		}
+
+		template<typename T>
+		[[nodiscard]] std::optional<T> getOptional(int column) const {
+			if (isNull(column)) {
+				return std::nullopt;
+			}
+			return parse<T>((*this)[column]);
+		}
+
+		template<typename T>
+		static std::optional<T> parse(std::string_view text) {
+			if constexpr (std::is_same_v<T, std::string_view>) {
+				return text;
+			}
+			else if constexpr (std::is_same_v<T, std::string>) {
+				return std::string(text);
+			}
+			else if constexpr (std::is_same_v<T, bool>) {
+				// PostgreSQL prints booleans as 't' / 'f'
+				if (text == "t" || text == "true") {
+					return true;
+				}
+				if (text == "f" || text == "false") {
+					return false;
+				}
+				return std::nullopt;
+			}
+			else {
+				static_assert(std::is_arithmetic_v<T>, "RowView::get supports arithmetic, bool and string types");
+				T value{};
+				auto [end, ec] = std::from_chars(text.data(), text.data() + text.size(), value);
+				if (ec != std::errc() || end != text.data() + text.size()) {
+					return std::nullopt;
+				}
+				return value;
+			}
+		}
+
+	 private:
+		const PGresult* res_;
+		int row_;
+	};
+
+	// Move-only owner of a PGresult, cleared with PQclear. Iterating yields RowViews without allocating.
+	class PgResult {
+	 public:
+		class Iterator {
+		 public:
+			using iterator_category = std::input_iterator_tag;
+			using value_type = RowView;
+			using difference_type = std::ptrdiff_t;
+			using pointer = void;
+			using reference = RowView;
+
+			Iterator(const PGresult* res, int row)
+			: res_(res)
+			, row_(row) {}
+
+			RowView operator*() const {
+				return {res_, row_};
+			}
+
+			Iterator& operator++() {
+				++row_;
+				return *this;
+			}
+
+			Iterator operator++(int) {
+				Iterator previous = *this;
+				++row_;
+				return previous;
+			}
+
+			bool operator==(const Iterator& other) const {
+				return row_ == other.row_;
+			}
+
+			bool operator!=(const Iterator& other) const {
+				return row_ != other.row_;
+			}
+
+		 private:
+			const PGresult* res_;
+			int row_;
+		};
+
+		PgResult() = default;
+		explicit PgResult(PGresult* res)
+		: res_(res) {}
+		~PgResult() {
+			reset();
+		}
+
+		PgResult(const PgResult&) = delete;
+		PgResult& operator=(const PgResult&) = delete;
+		PgResult(PgResult&& other) noexcept
+		: res_(std::exchange(other.res_, nullptr)) {}
+		PgResult& operator=(PgResult&& other) noexcept {
+			if (this != &other) {
+				reset(std::exchange(other.res_, nullptr));
+			}
+			return *this;
+		}
+
+		// Convenience for the common blocking call sites
+		static PgResult exec(PGconn* conn, const char* sql) {
+			return PgResult(PQexec(conn, sql));
+		}
+
+		[[nodiscard]] PGresult* get() const {
+			return res_;
+		}
+
+		explicit operator bool() const {
+			return res_ != nullptr;
+		}
+
+		[[nodiscard]] ExecStatusType status() const {
+			return PQresultStatus(res_);
+		}
+
+		// True for PGRES_COMMAND_OK and PGRES_TUPLES_OK
+		[[nodiscard]] bool ok() const {
+			ExecStatusType s = status();
+			return s == PGRES_COMMAND_OK || s == PGRES_TUPLES_OK;
+		}
+
+		[[nodiscard]] const char* errorMessage() const {
+			return res_ ? PQresultErrorMessage(res_) : "no result";
+		}
+
+		[[nodiscard]] int rows() const {
+			return PQntuples(res_);
+		}
+
+		[[nodiscard]] int columns() const {
+			return PQnfields(res_);
+		}
+
+		// Column number for a name, or -1; resolve once outside row loops
+		[[nodiscard]] int columnIndex(const char* name) const {
+			return PQfnumber(res_, name);
+		}
+
+		[[nodiscard]] RowView operator[](int row) const {
+			return {res_, row};
+		}
+
+		[[nodiscard]] Iterator begin() const {
+			return {res_, 0};
+		}
+
+		[[nodiscard]] Iterator end() const {
+			return {res_, rows()};
+		}
+
+		void reset(PGresult* res = nullptr) {
+			if (res_) {
+				PQclear(res_);
+			}
+			res_ = res;
+		}
+
+		PGresult* release() {
+			return std::exchange(res_, nullptr);
+		}
+
+	 private:
+		PGresult* res_ = nullptr;
+	};
+
+} // namespace pgsqlHandles
+
+#endif // PGSQL_HANDLES_H
@@ -0,0 +1,53 @@
+#include "pgsql_indexes.h"
+
+#include <algorithm>
+
+namespace pgsqlIndexes {
+	const std::vector<IndexDefinition>& petstoreIndexPack() {
+		static const std::vector<IndexDefinition> pack = {
+		    {"order_items_order_id_idx", "Order_Items", "order_id", false},
+		    {"orders_customer_date_active_idx", "Orders", "customer_id, order_date", true},
+		    {"inventory_actions_product_date_active_idx", "Inventory_Actions", "product_id, action_date", true},
+		    {"suppliers_product_active_idx", "Suppliers", "product_id", true},
+		};
+		return pack;
+	}
+
+	std::string createIndexSQL(const IndexDefinition& index, bool concurrently) {
+		std::string sql = concurrently ? "CREATE INDEX CONCURRENTLY IF NOT EXISTS " : "CREATE INDEX IF NOT EXISTS ";
+		sql += index.name;
+		sql += " ON ";
+		sql += index.table;
+		sql += " (";
+		sql += index.columns;
+		sql += ")";
+		if (index.activeRowsOnly) {
+			sql += " WHERE NOT is_deleted";
+		}
+		return sql + ";";
+	}
+
+	std::string dropIndexSQL(const IndexDefinition& index, bool concurrently) {
+		return std::string(concurrently ? "DROP INDEX CONCURRENTLY IF EXISTS " : "DROP INDEX IF EXISTS ") + index.name
+		       + ";";
+	}
+
+	std::vector<pgsqlMigrations::Migration> indexMigrations(int firstVersion,
+	                                                        const std::vector<IndexDefinition>& pack,
+	                                                        const std::vector<std::string>& partitionedTables) {
+		std::vector<pgsqlMigrations::Migration> migrations;
+		int version = firstVersion;
+		for (const IndexDefinition& index : pack) {
+			std::string name = std::string("create_index_") + index.name;
+			bool partitioned = std::find(partitionedTables.begin(), partitionedTables.end(), index.table)
+			                   != partitionedTables.end();
+			if (partitioned) {
+				migrations.push_back({version++, name, createIndexSQL(index, false)});
+			}
+			else {
+				migrations.push_back({version++, name, createIndexSQL(index), false, dropIndexSQL(index), index.name});
+			}
+		}
+		return migrations;
+	}
+} // namespace pgsqlIndexes
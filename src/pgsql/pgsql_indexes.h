@@ -0,0 +1,37 @@
+#ifndef PGSQL_INDEXES_H
+#define PGSQL_INDEXES_H
+
+#include "pgsql_migrations.h"
+#include <string>
+#include <vector>
+
+namespace pgsqlIndexes {
+
+	// A secondary index managed by the initializer
+	struct IndexDefinition {
+		const char* name;
+		const char* table;
+		const char* columns; // Key list as written between the parentheses
+		bool activeRowsOnly; // Partial index over rows with NOT is_deleted
+	};
+
+	// Secondary indexes of a store database. Order_Items(order_id) stays a full index because the
+	// foreign-key check behind deleting an order has to see soft-deleted items as well.
+	const std::vector<IndexDefinition>& petstoreIndexPack();
+
+	// CREATE INDEX [CONCURRENTLY] IF NOT EXISTS ...; concurrent builds do not block writes on live tables
+	std::string createIndexSQL(const IndexDefinition& index, bool concurrently = true);
+	std::string dropIndexSQL(const IndexDefinition& index, bool concurrently = true);
+
+	// One non-transactional migration per index, numbered from firstVersion. A failed concurrent
+	// build leaves an INVALID index behind, so each step drops it again on failure, and drops and
+	// rebuilds one it finds left over from a build that could not clean up after itself. Partitioned
+	// parents cannot be indexed concurrently; indexes on partitionedTables are plain transactional
+	// steps, which the parent cascades to every partition.
+	std::vector<pgsqlMigrations::Migration> indexMigrations(int firstVersion,
+	                                                        const std::vector<IndexDefinition>& pack,
+	                                                        const std::vector<std::string>& partitionedTables = {});
+
+} // namespace pgsqlIndexes
+
+#endif // PGSQL_INDEXES_H
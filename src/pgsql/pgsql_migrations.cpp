@@ -0,0 +1,295 @@
+#include "pgsql_migrations.h"
+#include "pgsql_handles.h"
+
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <thread>
+
+namespace pgsqlMigrations {
+	const char* const kCreateMigrationsTableSQL =
+	    "CREATE TABLE IF NOT EXISTS schema_migrations ("
+	    "version INTEGER PRIMARY KEY, "
+	    "name TEXT NOT NULL, "
+	    "checksum TEXT NOT NULL, "
+	    "applied_at TIMESTAMPTZ NOT NULL DEFAULT now());";
+
+	// Session-level advisory lock key serializing the non-transactional steps of all migrators
+	constexpr std::int64_t kNonTransactionalLock = 0x7065746d696772; // "petmigr"
+
+	// NULL when schema_migrations does not exist yet
+	const char* const kFingerprintSQL =
+	    "SELECT obj_description(to_regclass('schema_migrations'), 'pg_class');";
+
+	static std::uint64_t fnv1a(std::uint64_t hash, const std::string& data) {
+		for (unsigned char c : data) {
+			hash ^= c;
+			hash *= 0x100000001b3ULL;
+		}
+		return hash;
+	}
+
+	static std::string toHex(std::uint64_t value) {
+		char buffer[17];
+		std::snprintf(buffer, sizeof(buffer), "%016llx", static_cast<unsigned long long>(value));
+		return buffer;
+	}
+
+	std::string checksum(const Migration& migration) {
+		return toHex(fnv1a(0xcbf29ce484222325ULL, migration.sql));
+	}
+
+	std::string fingerprint(const std::vector<Migration>& migrations) {
+		std::uint64_t hash = 0xcbf29ce484222325ULL;
+		for (const Migration& migration : migrations) {
+			hash = fnv1a(hash, std::to_string(migration.version) + ':' + checksum(migration) + ';');
+		}
+		return toHex(hash);
+	}
+
+	bool planMigrations(const std::vector<Migration>& migrations,
+	                    const std::vector<AppliedMigration>& applied,
+	                    std::vector<const Migration*>& pending,
+	                    std::string& error) {
+		for (std::size_t i = 1; i < migrations.size(); ++i) {
+			if (migrations[i].version <= migrations[i - 1].version) {
+				error = "migration versions are not increasing at " + std::to_string(migrations[i].version);
+				return false;
+			}
+		}
+
+		for (const AppliedMigration& row : applied) {
+			const Migration* known = nullptr;
+			for (const Migration& migration : migrations) {
+				if (migration.version == row.version) {
+					known = &migration;
+					break;
+				}
+			}
+			if (!known) {
+				error = "database has migration " + std::to_string(row.version) + " which this build does not know";
+				return false;
+			}
+			if (checksum(*known) != row.checksum) {
+				error = "checksum mismatch for migration " + std::to_string(row.version) + " (" + known->name + ")";
+				return false;
+			}
+		}
+
+		pending.clear();
+		for (const Migration& migration : migrations) {
+			bool done = false;
+			for (const AppliedMigration& row : applied) {
+				done = done || row.version == migration.version;
+			}
+			if (!done) {
+				pending.push_back(&migration);
+			}
+		}
+		return true;
+	}
+
+	static bool run(PGconn* conn, const char* sql, std::string& error) {
+		pgsqlHandles::PgResult res = pgsqlHandles::PgResult::exec(conn, sql);
+		if (!res.ok()) {
+			error = res.errorMessage();
+			return false;
+		}
+		return true;
+	}
+
+	static bool readApplied(PGconn* conn, std::vector<AppliedMigration>& applied, std::string& error) {
+		pgsqlHandles::PgResult res =
+		    pgsqlHandles::PgResult::exec(conn, "SELECT version, checksum FROM schema_migrations ORDER BY version;");
+		if (!res.ok()) {
+			error = res.errorMessage();
+			return false;
+		}
+		applied.clear();
+		for (pgsqlHandles::RowView row : res) {
+			applied.push_back({row.get<int>(0), row.get<std::string>(1)});
+		}
+		return true;
+	}
+
+	static bool isRecorded(PGconn* conn, const char* version, bool& recorded, std::string& error) {
+		const char* values[] = {version};
+		pgsqlHandles::PgResult res(PQexecParams(
+		    conn, "SELECT 1 FROM schema_migrations WHERE version = $1;", 1, nullptr, values, nullptr, nullptr, 0));
+		if (!res.ok()) {
+			error = res.errorMessage();
+			return false;
+		}
+		recorded = res.rows() > 0;
+		return true;
+	}
+
+	// invalid is true only for an existing index with pg_index.indisvalid unset
+	static bool isInvalidIndex(PGconn* conn, const std::string& index, bool& invalid, std::string& error) {
+		const char* values[] = {index.c_str()};
+		const char* sql = "SELECT NOT indisvalid FROM pg_index WHERE indexrelid = to_regclass($1);";
+		pgsqlHandles::PgResult res(PQexecParams(conn, sql, 1, nullptr, values, nullptr, nullptr, 0));
+		if (!res.ok()) {
+			error = res.errorMessage();
+			return false;
+		}
+		invalid = res.rows() == 1 && res[0].get<bool>(0);
+		return true;
+	}
+
+	// Polls rather than blocking in pg_advisory_lock: a waiter parked inside that statement holds a
+	// snapshot, and the holder's CREATE INDEX CONCURRENTLY would wait for it to finish
+	static bool lockNonTransactional(PGconn* conn, std::string& error) {
+		std::string sql = "SELECT pg_try_advisory_lock(" + std::to_string(kNonTransactionalLock) + ");";
+		for (;;) {
+			pgsqlHandles::PgResult res = pgsqlHandles::PgResult::exec(conn, sql.c_str());
+			if (!res.ok() || res.rows() != 1) {
+				error = res.errorMessage();
+				return false;
+			}
+			if (res[0].get<bool>(0)) {
+				return true;
+			}
+			std::this_thread::sleep_for(std::chrono::milliseconds(200));
+		}
+	}
+
+	// A non-transactional step under kNonTransactionalLock: no other migrator builds, records or cleans
+	// up concurrently, so the cleanup can only drop what this one left behind
+	static bool applyNonTransactional(PGconn* conn,
+	                                  const Migration& migration,
+	                                  const char* const* values,
+	                                  const char* insertSQL,
+	                                  bool& appliedHere,
+	                                  std::string& error) {
+		bool recorded = false;
+		if (!isRecorded(conn, values[0], recorded, error)) {
+			return false;
+		}
+		if (recorded) {
+			return true; // Applied by another migrator while this one waited for the lock
+		}
+
+		// IF NOT EXISTS would take an INVALID index, e.g. from a session that died mid-build, as built
+		bool invalid = false;
+		if (!migration.validIndex.empty()) {
+			if (!isInvalidIndex(conn, migration.validIndex, invalid, error)) {
+				return false;
+			}
+			if (invalid && (migration.cleanupSql.empty() || !run(conn, migration.cleanupSql.c_str(), error))) {
+				error = "index " + migration.validIndex + " is invalid and could not be dropped: " + error;
+				return false;
+			}
+		}
+
+		bool ok = run(conn, migration.sql.c_str(), error);
+		if (ok && !migration.validIndex.empty()) {
+			ok = isInvalidIndex(conn, migration.validIndex, invalid, error);
+			if (ok && invalid) {
+				error = "index " + migration.validIndex + " is invalid after its build";
+				ok = false;
+			}
+		}
+		if (!ok) {
+			// Nothing rolls back a failed CREATE INDEX CONCURRENTLY; leave a clean slate for the retry
+			std::string ignored;
+			if (!migration.cleanupSql.empty()) {
+				run(conn, migration.cleanupSql.c_str(), ignored);
+			}
+			return false;
+		}
+		pgsqlHandles::PgResult res(PQexecParams(conn, insertSQL, 3, nullptr, values, nullptr, nullptr, 0));
+		if (!res.ok()) {
+			error = res.errorMessage();
+			return false;
+		}
+		appliedHere = true;
+		return true;
+	}
+
+	// Runs one step and records it. Transactional steps re-check schema_migrations under the table lock,
+	// so a step another migrator committed in the meantime is skipped instead of applied twice.
+	static bool applyStep(PGconn* conn, const Migration& migration, bool& appliedHere, std::string& error) {
+		std::string version = std::to_string(migration.version);
+		std::string sum = checksum(migration);
+		const char* values[] = {version.c_str(), migration.name.c_str(), sum.c_str()};
+		const char* insertSQL = "INSERT INTO schema_migrations (version, name, checksum) VALUES ($1, $2, $3) "
+		                        "ON CONFLICT (version) DO NOTHING;";
+		appliedHere = false;
+
+		if (!migration.transactional) {
+			if (!lockNonTransactional(conn, error)) {
+				return false;
+			}
+			bool ok = applyNonTransactional(conn, migration, values, insertSQL, appliedHere, error);
+			std::string unlock = "SELECT pg_advisory_unlock(" + std::to_string(kNonTransactionalLock) + ");";
+			std::string ignored;
+			run(conn, unlock.c_str(), ignored);
+			return ok;
+		}
+
+		if (!run(conn, "BEGIN;", error)) {
+			return false;
+		}
+		bool recorded = false;
+		bool ok = run(conn, "LOCK TABLE schema_migrations IN SHARE ROW EXCLUSIVE MODE;", error)
+		          && isRecorded(conn, values[0], recorded, error);
+		if (ok && recorded) {
+			return run(conn, "COMMIT;", error);
+		}
+		ok = ok && run(conn, migration.sql.c_str(), error);
+		if (ok) {
+			pgsqlHandles::PgResult res(PQexecParams(conn, insertSQL, 3, nullptr, values, nullptr, nullptr, 0));
+			ok = res.ok();
+			if (!ok) {
+				error = res.errorMessage();
+			}
+		}
+		if (!ok) {
+			std::string ignored;
+			run(conn, "ROLLBACK;", ignored);
+			return false;
+		}
+		appliedHere = true;
+		return run(conn, "COMMIT;", error);
+	}
+
+	MigrationResult migrate(PGconn* conn, const std::vector<Migration>& migrations) {
+		MigrationResult result;
+		const std::string expected = fingerprint(migrations);
+
+		pgsqlHandles::PgResult stored = pgsqlHandles::PgResult::exec(conn, kFingerprintSQL);
+		if (!stored.ok()) {
+			result.error = stored.errorMessage();
+			return result;
+		}
+		if (stored.rows() == 1 && !stored[0].isNull(0) && stored[0][0] == expected) {
+			result.ok = true;
+			result.fastPath = true;
+			return result;
+		}
+
+		std::vector<AppliedMigration> applied;
+		std::vector<const Migration*> pending;
+		if (!run(conn, kCreateMigrationsTableSQL, result.error) || !readApplied(conn, applied, result.error)
+		    || !planMigrations(migrations, applied, pending, result.error))
+		{
+			return result;
+		}
+
+		for (const Migration* migration : pending) {
+			bool appliedHere = false;
+			if (!applyStep(conn, *migration, appliedHere, result.error)) {
+				result.error = "migration " + std::to_string(migration->version) + " (" + migration->name
+				               + ") failed: " + result.error;
+				return result;
+			}
+			result.applied += appliedHere ? 1 : 0;
+		}
+
+		// The fingerprint is a plain literal of hex digits, so it needs no quoting beyond the quotes
+		std::string comment = "COMMENT ON TABLE schema_migrations IS '" + expected + "';";
+		result.ok = run(conn, comment.c_str(), result.error);
+		return result;
+	}
+} // namespace pgsqlMigrations
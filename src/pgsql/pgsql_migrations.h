@@ -0,0 +1,55 @@
+#ifndef PGSQL_MIGRATIONS_H
+#define PGSQL_MIGRATIONS_H
+
+#include "libpq-fe.h"
+#include <cstddef>
+#include <string>
+#include <vector>
+
+namespace pgsqlMigrations {
+
+	// One schema step. Versions must be strictly increasing; the checksum of an applied step may never change.
+	struct Migration {
+		int version;
+		std::string name;
+		std::string sql; // May hold several statements
+		bool transactional = true; // False for statements such as CREATE INDEX CONCURRENTLY
+		std::string cleanupSql = {}; // Run after a failed non-transactional step, e.g. to drop an invalid index
+		std::string validIndex = {}; // Index the step builds; an INVALID one is dropped with cleanupSql and rebuilt
+	};
+
+	// A row of schema_migrations
+	struct AppliedMigration {
+		int version;
+		std::string checksum;
+	};
+
+	// 64-bit FNV-1a of the migration's SQL, as 16 hex digits
+	std::string checksum(const Migration& migration);
+
+	// Hash over every (version, checksum) pair; stored as the comment on schema_migrations once all of
+	// them are applied, so an up-to-date database is recognized with a single catalog lookup
+	std::string fingerprint(const std::vector<Migration>& migrations);
+
+	// Steps of `migrations` missing from `applied`, in version order. Fails when versions are not
+	// increasing, when an applied checksum differs, or when the database knows a version this build does not.
+	bool planMigrations(const std::vector<Migration>& migrations,
+	                    const std::vector<AppliedMigration>& applied,
+	                    std::vector<const Migration*>& pending,
+	                    std::string& error);
+
+	struct MigrationResult {
+		bool ok = false;
+		bool fastPath = false; // Fingerprint matched; nothing else was queried
+		std::size_t applied = 0; // Steps run by this call
+		std::string error;
+	};
+
+	// Bring the database behind conn up to date. Each transactional step runs in its own transaction
+	// together with its schema_migrations row, under a lock so concurrent migrators apply it once.
+	// Non-transactional steps, their cleanup included, are serialized by a session advisory lock.
+	MigrationResult migrate(PGconn* conn, const std::vector<Migration>& migrations);
+
+} // namespace pgsqlMigrations
+
+#endif // PGSQL_MIGRATIONS_H
@@ -0,0 +1,253 @@
+#include "pgsql_partitions.h"
+#include "pgsql_binary.h"
+#include "pgsql_handles.h"
+
+#include <algorithm>
+#include <cctype>
+#include <charconv>
+#include <chrono>
+#include <cstdio>
+
+namespace pgsqlPartitions {
+	const std::vector<PartitionedTable>& petstorePartitionedTables() {
+		static const std::vector<PartitionedTable> tables = {
+		    {"Orders", "order_date"},
+		    {"Inventory_Actions", "action_date"},
+		};
+		return tables;
+	}
+
+	const PartitionedTable* partitionedTable(std::string_view name) {
+		for (const PartitionedTable& table : petstorePartitionedTables()) {
+			if (name == table.table) {
+				return &table;
+			}
+		}
+		return nullptr;
+	}
+
+	Month currentMonth() {
+		auto days = std::chrono::duration_cast<std::chrono::hours>(
+		                std::chrono::system_clock::now().time_since_epoch())
+		                .count()
+		            / 24;
+		pgsqlBinary::Date today = pgsqlBinary::civilFromDays(static_cast<std::int32_t>(days));
+		return {today.year, today.month};
+	}
+
+	Month addMonths(Month month, int delta) {
+		int index = month.year * 12 + static_cast<int>(month.month) - 1 + delta;
+		int year = index >= 0 ? index / 12 : (index - 11) / 12;
+		return {year, static_cast<unsigned>(index - year * 12 + 1)};
+	}
+
+	std::vector<Month> monthsCovering(std::int32_t firstDay, std::int32_t lastDay) {
+		std::vector<Month> months;
+		if (firstDay > lastDay) {
+			return months;
+		}
+		pgsqlBinary::Date first = pgsqlBinary::civilFromDays(firstDay + pgsqlBinary::kPostgresEpochDays);
+		pgsqlBinary::Date last = pgsqlBinary::civilFromDays(lastDay + pgsqlBinary::kPostgresEpochDays);
+		for (Month month{first.year, first.month};; month = addMonths(month, 1)) {
+			months.push_back(month);
+			if (month == Month{last.year, last.month}) {
+				break;
+			}
+		}
+		return months;
+	}
+
+	static std::string lowerCase(const char* text) {
+		std::string result = text;
+		std::transform(result.begin(), result.end(), result.begin(), [](unsigned char c) {
+			return static_cast<char>(std::tolower(c));
+		});
+		return result;
+	}
+
+	static int monthIndex(Month month) {
+		return month.year * 12 + static_cast<int>(month.month) - 1;
+	}
+
+	std::string partitionName(const PartitionedTable& table, Month month) {
+		char suffix[16];
+		std::snprintf(suffix, sizeof(suffix), "_p%04d_%02u", month.year, month.month);
+		return lowerCase(table.table) + suffix;
+	}
+
+	std::optional<Month> parsePartitionName(const PartitionedTable& table, const std::string& name) {
+		std::string prefix = lowerCase(table.table) + "_p";
+		// prefix + YYYY_MM
+		if (name.size() != prefix.size() + 7 || name.compare(0, prefix.size(), prefix) != 0
+		    || name[prefix.size() + 4] != '_')
+		{
+			return std::nullopt;
+		}
+		const char* digits = name.data() + prefix.size();
+		Month month{};
+		auto [yearEnd, yearError] = std::from_chars(digits, digits + 4, month.year);
+		auto [monthEnd, monthError] = std::from_chars(digits + 5, digits + 7, month.month);
+		if (yearError != std::errc() || monthError != std::errc() || yearEnd != digits + 4 || monthEnd != digits + 7
+		    || month.month < 1 || month.month > 12)
+		{
+			return std::nullopt;
+		}
+		return month;
+	}
+
+	std::vector<std::string> partitionNames(const std::vector<std::string>& tables) {
+		std::vector<std::string> partitions;
+		for (const std::string& name : tables) {
+			for (const PartitionedTable& table : petstorePartitionedTables()) {
+				if (parsePartitionName(table, name)) {
+					partitions.push_back(name);
+					break;
+				}
+			}
+		}
+		return partitions;
+	}
+
+	static std::string firstDay(Month month) {
+		char date[16];
+		std::snprintf(date, sizeof(date), "%04d-%02u-01", month.year, month.month);
+		return date;
+	}
+
+	std::string createPartitionSQL(const PartitionedTable& table, Month month) {
+		return "CREATE TABLE IF NOT EXISTS " + partitionName(table, month) + " PARTITION OF " + table.table
+		       + " FOR VALUES FROM ('" + firstDay(month) + "') TO ('" + firstDay(addMonths(month, 1)) + "');";
+	}
+
+	MaintenancePlan planMaintenance(const PartitionedTable& table,
+	                                const std::vector<std::string>& existing,
+	                                Month today,
+	                                const MaintenancePolicy& policy) {
+		MaintenancePlan plan;
+		std::vector<int> present;
+		for (const std::string& name : existing) {
+			std::optional<Month> month = parsePartitionName(table, name);
+			if (!month) {
+				continue;
+			}
+			present.push_back(monthIndex(*month));
+			if (monthIndex(*month) < monthIndex(today) - policy.retainMonths) {
+				plan.detach.push_back(name);
+			}
+		}
+
+		for (int delta = -policy.monthsBehind; delta <= policy.monthsAhead; ++delta) {
+			Month month = addMonths(today, delta);
+			if (std::find(present.begin(), present.end(), monthIndex(month)) == present.end()) {
+				plan.create.push_back(month);
+			}
+		}
+		return plan;
+	}
+
+	// Names of table's partitions; partitioned is false when the table is missing or not partitioned
+	static bool listPartitions(PGconn* conn,
+	                           const PartitionedTable& table,
+	                           bool& partitioned,
+	                           std::vector<std::string>& existing,
+	                           std::string& error) {
+		// One row per partition (a single NULL when there are none yet), or no rows at all when the
+		// table is missing or not partitioned
+		std::string parent = lowerCase(table.table);
+		const char* values[] = {parent.c_str()};
+		pgsqlHandles::PgResult children(PQexecParams(conn,
+		                                             "SELECT c.relname FROM pg_class p "
+		                                             "LEFT JOIN pg_inherits i ON i.inhparent = p.oid "
+		                                             "LEFT JOIN pg_class c ON c.oid = i.inhrelid "
+		                                             "WHERE p.oid = to_regclass($1) AND p.relkind = 'p';",
+		                                             1,
+		                                             nullptr,
+		                                             values,
+		                                             nullptr,
+		                                             nullptr,
+		                                             0));
+		if (!children.ok()) {
+			error = children.errorMessage();
+			return false;
+		}
+		partitioned = children.rows() > 0;
+		existing.clear();
+		for (pgsqlHandles::RowView row : children) {
+			if (!row.isNull(0)) {
+				existing.emplace_back(row[0]);
+			}
+		}
+		return true;
+	}
+
+	static bool createPartition(PGconn* conn, const PartitionedTable& table, Month month, std::string& error) {
+		pgsqlHandles::PgResult res = pgsqlHandles::PgResult::exec(conn, createPartitionSQL(table, month).c_str());
+		if (!res.ok()) {
+			error = "creating " + partitionName(table, month) + ": " + res.errorMessage();
+			return false;
+		}
+		return true;
+	}
+
+	MaintenanceResult runMaintenance(PGconn* conn, const MaintenancePolicy& policy, std::optional<Month> today) {
+		MaintenanceResult result;
+		Month now = today.value_or(currentMonth());
+
+		for (const PartitionedTable& table : petstorePartitionedTables()) {
+			bool partitioned = false;
+			std::vector<std::string> existing;
+			if (!listPartitions(conn, table, partitioned, existing, result.error)) {
+				return result;
+			}
+			if (!partitioned) {
+				continue; // Plain layout
+			}
+
+			MaintenancePlan plan = planMaintenance(table, existing, now, policy);
+			for (Month month : plan.create) {
+				if (!createPartition(conn, table, month, result.error)) {
+					return result;
+				}
+				++result.created;
+			}
+
+			// CONCURRENTLY only holds SHARE UPDATE EXCLUSIVE on the parent, so inserts into recent
+			// months continue while an old month is detached
+			for (const std::string& name : plan.detach) {
+				std::string sql =
+				    std::string("ALTER TABLE ") + table.table + " DETACH PARTITION " + name + " CONCURRENTLY;";
+				pgsqlHandles::PgResult res = pgsqlHandles::PgResult::exec(conn, sql.c_str());
+				if (!res.ok()) {
+					result.error = "detaching " + name + ": " + res.errorMessage();
+					return result;
+				}
+				++result.detached;
+			}
+		}
+
+		result.ok = true;
+		return result;
+	}
+
+	bool ensureMonths(PGconn* conn,
+	                  const PartitionedTable& table,
+	                  std::int32_t firstDay,
+	                  std::int32_t lastDay,
+	                  std::string& error) {
+		bool partitioned = false;
+		std::vector<std::string> existing;
+		if (!listPartitions(conn, table, partitioned, existing, error)) {
+			return false;
+		}
+		if (!partitioned) {
+			return true; // Plain layout
+		}
+		for (Month month : monthsCovering(firstDay, lastDay)) {
+			bool present = std::find(existing.begin(), existing.end(), partitionName(table, month)) != existing.end();
+			if (!present && !createPartition(conn, table, month, error)) {
+				return false;
+			}
+		}
+		return true;
+	}
+} // namespace pgsqlPartitions
@@ -0,0 +1,95 @@
+#ifndef PGSQL_PARTITIONS_H
+#define PGSQL_PARTITIONS_H
+
+#include "libpq-fe.h"
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace pgsqlPartitions {
+
+	// A table declared PARTITION BY RANGE (column) with one partition per calendar month
+	struct PartitionedTable {
+		const char* table;
+		const char* column;
+	};
+
+	// Orders by order_date and Inventory_Actions by action_date
+	const std::vector<PartitionedTable>& petstorePartitionedTables();
+
+	// The entry of petstorePartitionedTables() for a store table, nullptr for one that is never partitioned
+	const PartitionedTable* partitionedTable(std::string_view name);
+
+	struct Month {
+		int year;
+		unsigned month; // 1-12
+
+		bool operator==(const Month& other) const = default;
+	};
+
+	Month currentMonth();
+	Month addMonths(Month month, int delta);
+
+	// Every month from the one holding firstDay to the one holding lastDay (days since 2000-01-01)
+	std::vector<Month> monthsCovering(std::int32_t firstDay, std::int32_t lastDay);
+
+	// "orders_p2024_05"; the lower-cased table name keeps partitions next to their parent in listings
+	std::string partitionName(const PartitionedTable& table, Month month);
+
+	// Inverse of partitionName; nullopt for partitions not created by this module
+	std::optional<Month> parsePartitionName(const PartitionedTable& table, const std::string& name);
+
+	// The names among tables that follow partitionName for one of petstorePartitionedTables(), e.g. to
+	// find the partitions maintenance detached, which live on as ordinary tables
+	std::vector<std::string> partitionNames(const std::vector<std::string>& tables);
+
+	// CREATE TABLE IF NOT EXISTS ... PARTITION OF ... FOR VALUES FROM (first day) TO (first day of next month)
+	std::string createPartitionSQL(const PartitionedTable& table, Month month);
+
+	struct MaintenancePolicy {
+		int monthsAhead = 3; // Future partitions kept ready, so inserts never find their month missing
+		int monthsBehind = 1; // Past months created as well, for late entries
+		int retainMonths = 24; // Partitions older than this many months before the current one are detached
+	};
+
+	struct MaintenancePlan {
+		std::vector<Month> create;
+		std::vector<std::string> detach;
+	};
+
+	// What to create and detach given the partitions that already exist
+	MaintenancePlan planMaintenance(const PartitionedTable& table,
+	                                const std::vector<std::string>& existing,
+	                                Month today,
+	                                const MaintenancePolicy& policy);
+
+	struct MaintenanceResult {
+		bool ok = false;
+		std::size_t created = 0;
+		std::size_t detached = 0;
+		std::string error;
+	};
+
+	// Apply the plan for every partitioned table. Detached partitions stay behind as ordinary tables
+	// for archival; they no longer appear in plans or in the parent's vacuum cycle. Tables that are not
+	// partitioned in this database are skipped, so the routine is safe on the plain layout.
+	MaintenanceResult runMaintenance(PGconn* conn,
+	                                 const MaintenancePolicy& policy = {},
+	                                 std::optional<Month> today = std::nullopt);
+
+	// Creates the missing partitions of table for every month holding one of the days firstDay to
+	// lastDay, so rows outside the maintenance window (an imported history) find theirs. Creating a
+	// partition locks the parent, so loaders call this before their workers start. A table that is
+	// not partitioned is left alone.
+	bool ensureMonths(PGconn* conn,
+	                  const PartitionedTable& table,
+	                  std::int32_t firstDay,
+	                  std::int32_t lastDay,
+	                  std::string& error);
+
+} // namespace pgsqlPartitions
+
+#endif // PGSQL_PARTITIONS_H
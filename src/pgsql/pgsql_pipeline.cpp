@@ -0,0 +1,177 @@
+#include "pgsql_pipeline.h"
+
+#include <poll.h>
+
+namespace pgsqlPipeline {
+	PipelineExecutor::PipelineExecutor(PGconn* conn, bool stopAfterFailedSegment)
+	: conn_(conn)
+	, stopAfterFailedSegment_(stopAfterFailedSegment) {}
+
+	std::size_t PipelineExecutor::add(const std::string& sql) {
+		steps_.push_back({sql, false});
+		return statementCount_++;
+	}
+
+	void PipelineExecutor::sync() {
+		if (!steps_.empty() && !steps_.back().isSync) {
+			steps_.push_back({"", true});
+		}
+	}
+
+	void classifyResult(const PGresult* res, std::size_t index, std::vector<StatementError>& errors) {
+		ExecStatusType status = PQresultStatus(res);
+		if (status == PGRES_PIPELINE_ABORTED) {
+			errors.push_back({index, "Skipped: an earlier statement in the same batch failed.", true});
+		}
+		else if (status != PGRES_COMMAND_OK && status != PGRES_TUPLES_OK) {
+			const char* message = PQresultErrorMessage(res);
+			errors.push_back({index, *message ? message : PQresStatus(status), false});
+		}
+	}
+
+	void reportSkipped(std::size_t firstIndex, std::size_t count, std::vector<StatementError>& errors) {
+		for (std::size_t i = 0; i < count; ++i) {
+			errors.push_back({firstIndex + i, "Skipped: an earlier segment of the batch failed.", true});
+		}
+	}
+
+	const StatementError* firstError(const std::vector<StatementError>& errors) {
+		for (const StatementError& error : errors) {
+			if (!error.aborted) {
+				return &error;
+			}
+		}
+		return errors.empty() ? nullptr : &errors.front();
+	}
+
+	const StatementError* PipelineExecutor::firstError() const {
+		return pgsqlPipeline::firstError(errors_);
+	}
+
+	bool PipelineExecutor::execute() {
+		errors_.clear();
+		if (steps_.empty()) {
+			return true;
+		}
+		sync(); // Every pipeline ends with a sync point
+
+		if (PQpipelineStatus(conn_) != PQ_PIPELINE_OFF || !PQenterPipelineMode(conn_)) {
+			errors_.push_back({0, "Failed to enter pipeline mode: " + std::string(PQerrorMessage(conn_)), false});
+			steps_.clear();
+			statementCount_ = 0;
+			return false;
+		}
+
+		// Non-blocking sends let us drain server output while a large batch is still being written
+		PQsetnonblocking(conn_, 1);
+		bool ok = true;
+		std::size_t index = 0; // Statement index of the first step of the round trip
+		for (std::size_t first = 0; ok && first < steps_.size();) {
+			std::size_t last = steps_.size();
+			if (stopAfterFailedSegment_) {
+				last = first;
+				while (!steps_[last].isSync) {
+					++last;
+				}
+				++last; // The segment's sync point
+			}
+			std::size_t failures = errors_.size();
+			ok = send(first, last, index) && read(first, last, index);
+			for (std::size_t step = first; step < last; ++step) {
+				index += steps_[step].isSync ? 0 : 1;
+			}
+			first = last;
+			if (ok && errors_.size() > failures) {
+				std::size_t unsent = 0;
+				for (std::size_t step = first; step < steps_.size(); ++step) {
+					unsent += steps_[step].isSync ? 0 : 1;
+				}
+				reportSkipped(index, unsent, errors_);
+				break;
+			}
+		}
+		PQsetnonblocking(conn_, 0);
+		PQexitPipelineMode(conn_);
+
+		steps_.clear();
+		statementCount_ = 0;
+		return ok && errors_.empty();
+	}
+
+	bool PipelineExecutor::send(std::size_t first, std::size_t last, std::size_t firstIndex) {
+		std::size_t index = firstIndex;
+		for (std::size_t i = first; i < last; ++i) {
+			const Step& step = steps_[i];
+			int sent = step.isSync
+			               ? PQpipelineSync(conn_)
+			               : PQsendQueryParams(conn_, step.sql.c_str(), 0, nullptr, nullptr, nullptr, nullptr, 0);
+			if (!sent) {
+				errors_.push_back({index, "Failed to queue statement: " + std::string(PQerrorMessage(conn_)), false});
+				return false;
+			}
+			if (!step.isSync) {
+				++index;
+			}
+		}
+		return flushAll();
+	}
+
+	// Push the whole batch to the server, consuming input meanwhile so neither side stalls on a full buffer
+	bool PipelineExecutor::flushAll() {
+		while (true) {
+			int pending = PQflush(conn_);
+			if (pending == 0) {
+				return true;
+			}
+			if (pending < 0) {
+				errors_.push_back({0, "Failed to send pipeline: " + std::string(PQerrorMessage(conn_)), false});
+				return false;
+			}
+
+			pollfd pfd{PQsocket(conn_), POLLIN | POLLOUT, 0};
+			if (poll(&pfd, 1, -1) < 0) {
+				errors_.push_back({0, "Failed to wait for the server socket.", false});
+				return false;
+			}
+			if ((pfd.revents & POLLIN) && !PQconsumeInput(conn_)) {
+				errors_.push_back({0, "Failed to read from server: " + std::string(PQerrorMessage(conn_)), false});
+				return false;
+			}
+		}
+	}
+
+	bool PipelineExecutor::read(std::size_t first, std::size_t last, std::size_t firstIndex) {
+		std::size_t index = firstIndex;
+		for (std::size_t i = first; i < last; ++i) {
+			const Step& step = steps_[i];
+			PGresult* res = PQgetResult(conn_);
+			if (!res) {
+				errors_.push_back({index, "Connection lost: " + std::string(PQerrorMessage(conn_)), false});
+				return false;
+			}
+
+			ExecStatusType status = PQresultStatus(res);
+			if (step.isSync) {
+				PQclear(res);
+				if (status != PGRES_PIPELINE_SYNC) {
+					errors_.push_back({index, "Unexpected result while waiting for pipeline sync.", false});
+					return false;
+				}
+				continue;
+			}
+
+			classifyResult(res, index, errors_);
+			PQclear(res);
+
+			// Each statement's results are terminated by a null result
+			res = PQgetResult(conn_);
+			if (res) {
+				PQclear(res);
+				errors_.push_back({index, "Unexpected extra result in pipeline.", false});
+				return false;
+			}
+			++index;
+		}
+		return true;
+	}
+} // namespace pgsqlPipeline
@@ -0,0 +1,75 @@
+#ifndef PGSQL_PIPELINE_H
+#define PGSQL_PIPELINE_H
+
+#include "libpq-fe.h"
+#include <cstddef>
+#include <string>
+#include <vector>
+
+namespace pgsqlPipeline {
+
+	// Failure of one queued statement, identified by the index returned from add()
+	struct StatementError {
+		std::size_t index;
+		std::string message;
+		bool aborted; // Skipped because an earlier statement in the same segment failed
+	};
+
+	// Appends the outcome of statement index to errors unless it succeeded: a failure with the
+	// server's message, or an aborted follower for PGRES_PIPELINE_ABORTED
+	void classifyResult(const PGresult* res, std::size_t index, std::vector<StatementError>& errors);
+
+	// Appends count statements from firstIndex on as aborted: never sent because a segment before
+	// them failed (see PipelineExecutor's stopAfterFailedSegment)
+	void reportSkipped(std::size_t firstIndex, std::size_t count, std::vector<StatementError>& errors);
+
+	// First real failure (not an aborted follower), else the first entry, or nullptr
+	const StatementError* firstError(const std::vector<StatementError>& errors);
+
+	// Sends a batch of statements in libpq pipeline mode and reads every result in one round trip.
+	// Statements between two sync() calls form one implicit transaction: the first failure aborts
+	// the rest of that segment, later segments still run. With stopAfterFailedSegment, segments
+	// that depend on each other are sent one round trip at a time instead, and the first failed
+	// segment ends the batch: the statements after it are reported as aborted and never sent.
+	class PipelineExecutor {
+	 public:
+		explicit PipelineExecutor(PGconn* conn, bool stopAfterFailedSegment = false);
+
+		// Queue a statement (one SQL command, no parameters) and return its index
+		std::size_t add(const std::string& sql);
+
+		// Close the current segment; statements that refuse to run inside a transaction
+		// block (CREATE DATABASE) must be the first statement of their segment
+		void sync();
+
+		// Send the queue, read all results and clear it; false if any statement failed
+		bool execute();
+
+		[[nodiscard]] const std::vector<StatementError>& errors() const {
+			return errors_;
+		}
+
+		// First real failure (not an aborted follower), or nullptr
+		[[nodiscard]] const StatementError* firstError() const;
+
+	 private:
+		struct Step {
+			std::string sql;
+			bool isSync;
+		};
+
+		// Steps [first, last), whose first statement has index firstIndex
+		bool send(std::size_t first, std::size_t last, std::size_t firstIndex);
+		bool flushAll();
+		bool read(std::size_t first, std::size_t last, std::size_t firstIndex);
+
+		PGconn* conn_;
+		bool stopAfterFailedSegment_;
+		std::vector<Step> steps_;
+		std::vector<StatementError> errors_;
+		std::size_t statementCount_ = 0;
+	};
+
+} // namespace pgsqlPipeline
+
+#endif // PGSQL_PIPELINE_H
@@ -0,0 +1,92 @@
+#include "pgsql_prepared.h"
+
+#include <cstring>
+#include <iostream>
+
+namespace pgsqlPrepared {
+	// SQLSTATE reported when executing a statement the session does not know about
+	static const char* kInvalidStatementName = "26000";
+
+	PreparedStatementRegistry& PreparedStatementRegistry::instance() {
+		static PreparedStatementRegistry registry;
+		return registry;
+	}
+
+	pgsqlHandles::PgResult PreparedStatementRegistry::execute(PGconn* conn,
+	                                             const PreparedStatement& statement,
+	                                             const std::vector<std::string>& params) {
+		if (isPrepared(conn, statement.name)) {
+			++hits_;
+		}
+		else {
+			++misses_;
+			if (!prepare(conn, statement)) {
+				return {};
+			}
+		}
+
+		std::vector<const char*> values;
+		values.reserve(params.size());
+		for (const std::string& param : params) {
+			values.push_back(param.c_str());
+		}
+
+		pgsqlHandles::PgResult res(PQexecPrepared(
+		    conn, statement.name, static_cast<int>(values.size()), values.data(), nullptr, nullptr, 0));
+
+		// The cache can be stale if the session ran DISCARD ALL or the PGconn address was reused;
+		// prepare again and retry once
+		const char* sqlState = PQresultErrorField(res.get(), PG_DIAG_SQLSTATE);
+		if (sqlState && std::strcmp(sqlState, kInvalidStatementName) == 0) {
+			markPrepared(conn, statement.name, false);
+			if (!prepare(conn, statement)) {
+				return {};
+			}
+			res.reset(PQexecPrepared(
+			    conn, statement.name, static_cast<int>(values.size()), values.data(), nullptr, nullptr, 0));
+		}
+		return res;
+	}
+
+	void PreparedStatementRegistry::forget(PGconn* conn) {
+		std::lock_guard<std::mutex> lock(mutex_);
+		prepared_.erase(conn);
+	}
+
+	PreparedStats PreparedStatementRegistry::stats() const {
+		PreparedStats result;
+		result.hits = hits_;
+		result.misses = misses_;
+		return result;
+	}
+
+	bool PreparedStatementRegistry::prepare(PGconn* conn, const PreparedStatement& statement) {
+		pgsqlHandles::PgResult res(PQprepare(conn,
+		                                     statement.name,
+		                                     statement.sql,
+		                                     static_cast<int>(statement.paramTypes.size()),
+		                                     statement.paramTypes.data()));
+		if (res.status() != PGRES_COMMAND_OK) {
+			std::cerr << "Failed to prepare statement " << statement.name << ": " << PQerrorMessage(conn) << std::endl;
+			return false;
+		}
+		markPrepared(conn, statement.name, true);
+		return true;
+	}
+
+	bool PreparedStatementRegistry::isPrepared(PGconn* conn, const char* name) {
+		std::lock_guard<std::mutex> lock(mutex_);
+		auto it = prepared_.find(conn);
+		return it != prepared_.end() && it->second.count(name) > 0;
+	}
+
+	void PreparedStatementRegistry::markPrepared(PGconn* conn, const char* name, bool prepared) {
+		std::lock_guard<std::mutex> lock(mutex_);
+		if (prepared) {
+			prepared_[conn].insert(name);
+		}
+		else {
+			prepared_[conn].erase(name);
+		}
+	}
+} // namespace pgsqlPrepared
@@ -0,0 +1,98 @@
+#ifndef PGSQL_PREPARED_H
+#define PGSQL_PREPARED_H
+
+#include "libpq-fe.h"
+#include "pgsql_handles.h"
+#include <atomic>
+#include <cstddef>
+#include <mutex>
+#include <string>
+#include <type_traits>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+namespace pgsqlPrepared {
+
+	// Type OIDs from pg_type used to declare statement parameters
+	constexpr Oid kBoolOid = 16;
+	constexpr Oid kInt8Oid = 20;
+	constexpr Oid kInt4Oid = 23;
+	constexpr Oid kTextOid = 25;
+	constexpr Oid kNumericOid = 1700;
+	constexpr Oid kDateOid = 1082;
+
+	// A named statement, prepared at most once per connection
+	struct PreparedStatement {
+		const char* name;
+		const char* sql;
+		std::vector<Oid> paramTypes;
+	};
+
+	struct PreparedStats {
+		std::size_t hits = 0; // Executions that reused a statement already prepared on the connection
+		std::size_t misses = 0; // Executions that had to PQprepare first
+
+		[[nodiscard]] double reuseRate() const {
+			std::size_t total = hits + misses;
+			return total == 0 ? 0.0 : static_cast<double>(hits) / static_cast<double>(total);
+		}
+	};
+
+	// Tracks which statements have been prepared on which connection, so each plan is parsed
+	// once per session and executed with PQexecPrepared afterwards
+	class PreparedStatementRegistry {
+	 public:
+		static PreparedStatementRegistry& instance();
+
+		// Execute with text-format parameters; an empty result means the statement could not be prepared
+		pgsqlHandles::PgResult execute(PGconn* conn,
+		                               const PreparedStatement& statement,
+		                               const std::vector<std::string>& params);
+
+		// Typed convenience overload: integers, bools and strings are bound in their text form
+		template<typename... Args>
+		pgsqlHandles::PgResult execute(PGconn* conn, const PreparedStatement& statement, const Args&... args) {
+			return execute(conn, statement, std::vector<std::string>{toParam(args)...});
+		}
+
+		// Drop everything known about a connection that is being closed
+		void forget(PGconn* conn);
+
+		// Whether execute() will reuse the statement name on conn instead of preparing it
+		bool isPrepared(PGconn* conn, const char* name);
+
+		// Record that conn's session has (or no longer has) the statement name
+		void markPrepared(PGconn* conn, const char* name, bool prepared);
+
+		[[nodiscard]] PreparedStats stats() const;
+
+	 private:
+		bool prepare(PGconn* conn, const PreparedStatement& statement);
+
+		static std::string toParam(const std::string& value) {
+			return value;
+		}
+
+		static std::string toParam(const char* value) {
+			return value;
+		}
+
+		static std::string toParam(bool value) {
+			return value ? "true" : "false";
+		}
+
+		template<typename T, typename = std::enable_if_t<std::is_integral_v<T>>>
+		static std::string toParam(T value) {
+			return std::to_string(value);
+		}
+
+		mutable std::mutex mutex_;
+		std::unordered_map<PGconn*, std::unordered_set<std::string>> prepared_;
+		std::atomic<std::size_t> hits_{0};
+		std::atomic<std::size_t> misses_{0};
+	};
+
+} // namespace pgsqlPrepared
+
+#endif // PGSQL_PREPARED_H
@@ -0,0 +1,160 @@
+#include "pgsql_profiles.h"
+
+#include <cstdlib>
+#include <iostream>
+
+namespace pgsqlProfiles {
+	ConnectionProfile ConnectionProfile::tcp(const std::string& host, const std::string& port) {
+		ConnectionProfile profile;
+		profile.host = host;
+		profile.port = port;
+		return profile;
+	}
+
+	ConnectionProfile ConnectionProfile::unixSocket(const std::string& directory, const std::string& port) {
+		ConnectionProfile profile;
+		profile.host = directory;
+		profile.port = port;
+		profile.keepalives = false; // TCP keepalives do not apply to Unix-domain sockets
+		return profile;
+	}
+
+	ProfileRegistry::ProfileRegistry() {
+		define("tcp", ConnectionProfile::tcp());
+		define("socket", ConnectionProfile::unixSocket());
+		defaultProfile_ = "tcp";
+
+		const char* envConninfo = std::getenv("PETSTORE_PG_CONNINFO");
+		if (envConninfo && defineFromConninfo("env", envConninfo)) {
+			defaultProfile_ = "env";
+		}
+
+		const char* envProfile = std::getenv("PETSTORE_PG_PROFILE");
+		if (envProfile) {
+			setDefaultProfile(envProfile);
+		}
+	}
+
+	ProfileRegistry& ProfileRegistry::instance() {
+		static ProfileRegistry registry;
+		return registry;
+	}
+
+	bool ProfileRegistry::define(const std::string& name, const ConnectionProfile& profile) {
+		return defineFromConninfo(name, serialize(toOptions(profile)));
+	}
+
+	bool ProfileRegistry::defineFromConninfo(const std::string& name, const std::string& conninfo) {
+		std::string error;
+		auto options = parse(conninfo, error);
+		if (!options) {
+			std::cerr << "Invalid connection profile '" << name << "': " << error << std::endl;
+			return false;
+		}
+
+		std::lock_guard<std::mutex> lock(mutex_);
+		profiles_[name] = std::move(*options);
+		cache_.clear(); // Cached strings may have been built from the old definition
+		return true;
+	}
+
+	void ProfileRegistry::setDefaultProfile(const std::string& name) {
+		std::lock_guard<std::mutex> lock(mutex_);
+		if (profiles_.count(name) == 0) {
+			std::cerr << "Unknown connection profile '" << name << "', keeping '" << defaultProfile_ << "'."
+			          << std::endl;
+			return;
+		}
+		defaultProfile_ = name;
+	}
+
+	std::string ProfileRegistry::defaultProfile() const {
+		std::lock_guard<std::mutex> lock(mutex_);
+		return defaultProfile_;
+	}
+
+	std::string ProfileRegistry::conninfo(const std::string& dbName,
+	                                      const std::string& userName,
+	                                      const std::string& password) {
+		return conninfoFor(defaultProfile(), dbName, userName, password);
+	}
+
+	std::string ProfileRegistry::conninfoFor(const std::string& profileName,
+	                                         const std::string& dbName,
+	                                         const std::string& userName,
+	                                         const std::string& password) {
+		std::lock_guard<std::mutex> lock(mutex_);
+		std::string name = profiles_.count(profileName) ? profileName : defaultProfile_;
+
+		// '\0' cannot appear in any of the parts, so the key is unambiguous
+		std::string key = name + '\0' + dbName + '\0' + userName + '\0' + password;
+		auto cached = cache_.find(key);
+		if (cached != cache_.end()) {
+			return cached->second;
+		}
+
+		std::map<std::string, std::string> options = profiles_.at(name);
+		options["dbname"] = dbName;
+		options["user"] = userName;
+		if (!password.empty()) {
+			options["password"] = password;
+		}
+		return cache_.emplace(std::move(key), serialize(options)).first->second;
+	}
+
+	std::optional<std::map<std::string, std::string>> ProfileRegistry::parse(const std::string& conninfo,
+	                                                                          std::string& error) {
+		char* errorMessage = nullptr;
+		PQconninfoOption* parsed = PQconninfoParse(conninfo.c_str(), &errorMessage);
+		if (!parsed) {
+			error = errorMessage ? errorMessage : "out of memory";
+			PQfreemem(errorMessage);
+			return std::nullopt;
+		}
+
+		std::map<std::string, std::string> options;
+		for (PQconninfoOption* option = parsed; option->keyword; ++option) {
+			if (option->val) {
+				options[option->keyword] = option->val;
+			}
+		}
+		PQconninfoFree(parsed);
+		return options;
+	}
+
+	std::map<std::string, std::string> ProfileRegistry::toOptions(const ConnectionProfile& profile) {
+		std::map<std::string, std::string> options;
+		options["host"] = profile.host;
+		options["port"] = profile.port;
+		options["application_name"] = profile.applicationName;
+		options["connect_timeout"] = std::to_string(profile.connectTimeoutSeconds);
+		options["target_session_attrs"] = profile.targetSessionAttrs;
+		options["keepalives"] = profile.keepalives ? "1" : "0";
+		if (profile.keepalives) {
+			options["keepalives_idle"] = std::to_string(profile.keepalivesIdleSeconds);
+			options["keepalives_interval"] = std::to_string(profile.keepalivesIntervalSeconds);
+			options["keepalives_count"] = std::to_string(profile.keepalivesCount);
+		}
+		return options;
+	}
+
+	// keyword='value' pairs with quotes and backslashes escaped, as PQconnectdb expects
+	std::string ProfileRegistry::serialize(const std::map<std::string, std::string>& options) {
+		std::string conninfo;
+		for (const auto& [keyword, value] : options) {
+			if (!conninfo.empty()) {
+				conninfo += ' ';
+			}
+			conninfo += keyword;
+			conninfo += "='";
+			for (char c : value) {
+				if (c == '\'' || c == '\\') {
+					conninfo += '\\';
+				}
+				conninfo += c;
+			}
+			conninfo += '\'';
+		}
+		return conninfo;
+	}
+} // namespace pgsqlProfiles
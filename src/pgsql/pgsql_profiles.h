@@ -0,0 +1,76 @@
+#ifndef PGSQL_PROFILES_H
+#define PGSQL_PROFILES_H
+
+#include "libpq-fe.h"
+#include <map>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <unordered_map>
+
+namespace pgsqlProfiles {
+
+	// Settings shared by every connection made through one profile
+	struct ConnectionProfile {
+		std::string host = "localhost"; // An absolute path selects the Unix-domain socket directory
+		std::string port = "5432";
+		std::string applicationName = "petstore";
+		int connectTimeoutSeconds = 5;
+		bool keepalives = true;
+		int keepalivesIdleSeconds = 30;
+		int keepalivesIntervalSeconds = 10;
+		int keepalivesCount = 3;
+		std::string targetSessionAttrs = "any"; // any, read-write, primary, ...
+
+		// Loopback TCP, what the managers used before profiles existed
+		static ConnectionProfile tcp(const std::string& host = "localhost", const std::string& port = "5432");
+
+		// Unix-domain socket in `directory`; skips the TCP stack on co-located deployments
+		static ConnectionProfile unixSocket(const std::string& directory = "/var/run/postgresql",
+		                                   const std::string& port = "5432");
+	};
+
+	// Named connection profiles, each validated with PQconninfoParse once. Full conninfo strings
+	// for (database, user, password) combinations are built on first use and cached.
+	class ProfileRegistry {
+	 public:
+		// Registry preloaded with "tcp" and "socket", plus "env" when PETSTORE_PG_CONNINFO is set.
+		// The default profile is PETSTORE_PG_PROFILE, or "env" / "tcp" when unset.
+		static ProfileRegistry& instance();
+
+		bool define(const std::string& name, const ConnectionProfile& profile);
+
+		// Define a profile from a conninfo string ("host=/tmp port=5433 application_name=x")
+		bool defineFromConninfo(const std::string& name, const std::string& conninfo);
+
+		void setDefaultProfile(const std::string& name);
+		[[nodiscard]] std::string defaultProfile() const;
+
+		// Conninfo for the default profile
+		std::string conninfo(const std::string& dbName, const std::string& userName, const std::string& password = "");
+
+		// Conninfo for a named profile; falls back to the default profile if the name is unknown
+		std::string conninfoFor(const std::string& profileName,
+		                        const std::string& dbName,
+		                        const std::string& userName,
+		                        const std::string& password = "");
+
+		// Parsed keyword/value pairs of a conninfo string, or nullopt (with the libpq message in error)
+		static std::optional<std::map<std::string, std::string>> parse(const std::string& conninfo,
+		                                                                std::string& error);
+
+	 private:
+		ProfileRegistry();
+
+		static std::map<std::string, std::string> toOptions(const ConnectionProfile& profile);
+		static std::string serialize(const std::map<std::string, std::string>& options);
+
+		mutable std::mutex mutex_;
+		std::string defaultProfile_;
+		std::unordered_map<std::string, std::map<std::string, std::string>> profiles_;
+		std::unordered_map<std::string, std::string> cache_;
+	};
+
+} // namespace pgsqlProfiles
+
+#endif // PGSQL_PROFILES_H
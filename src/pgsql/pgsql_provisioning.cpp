@@ -0,0 +1,176 @@
+#include "pgsql_provisioning.h"
+#include "pgsql_connection_pool.h"
+#include "pgsql_workers.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <mutex>
+#include <thread>
+
+namespace pgsqlProvisioning {
+	using Clock = std::chrono::steady_clock;
+
+	static double secondsSince(Clock::time_point start) {
+		return std::chrono::duration<double>(Clock::now() - start).count();
+	}
+
+	bool parseManifest(std::istream& in, std::vector<TenantSpec>& tenants, std::string& error) {
+		std::string line;
+		std::size_t lineNumber = 0;
+		while (std::getline(in, line)) {
+			++lineNumber;
+			if (!line.empty() && line.back() == '\r') {
+				line.pop_back();
+			}
+			if (line.empty() || line.front() == '#') {
+				continue;
+			}
+
+			std::size_t first = line.find(',');
+			std::size_t second = first == std::string::npos ? first : line.find(',', first + 1);
+			if (second == std::string::npos || first == 0 || second == first + 1) {
+				error = "line " + std::to_string(lineNumber) + ": expected dbName,userName,password";
+				return false;
+			}
+			tenants.push_back(
+			    {line.substr(0, first), line.substr(first + 1, second - first - 1), line.substr(second + 1)});
+		}
+		return true;
+	}
+
+	bool loadManifest(const std::string& path, std::vector<TenantSpec>& tenants) {
+		std::ifstream file(path);
+		if (!file) {
+			std::cerr << "Cannot open manifest: " << path << std::endl;
+			return false;
+		}
+		std::string error;
+		if (!parseManifest(file, tenants, error)) {
+			std::cerr << "Invalid manifest " << path << ", " << error << std::endl;
+			return false;
+		}
+		return true;
+	}
+
+	double ProvisionReport::throughput() const {
+		return wallSeconds > 0 ? static_cast<double>(outcomes.size()) / wallSeconds : 0.0;
+	}
+
+	double ProvisionReport::latencyPercentile(double percentile) const {
+		std::vector<double> latencies;
+		for (const TenantOutcome& outcome : outcomes) {
+			if (outcome.ok) {
+				latencies.push_back(outcome.seconds);
+			}
+		}
+		if (latencies.empty()) {
+			return 0.0;
+		}
+		std::sort(latencies.begin(), latencies.end());
+		auto rank = static_cast<std::size_t>(std::ceil(percentile / 100.0 * static_cast<double>(latencies.size())));
+		return latencies[std::clamp<std::size_t>(rank, 1, latencies.size()) - 1];
+	}
+
+	void ProvisionReport::print(std::ostream& out, const char* action) const {
+		out << "\n" << action << " " << succeeded << " of " << outcomes.size() << " stores in " << std::fixed
+		    << std::setprecision(2) << wallSeconds << " s (" << throughput() << " stores/s)" << std::endl;
+		out << "Per-store latency: p50 " << latencyPercentile(50) * 1e3 << " ms, p99 " << latencyPercentile(99) * 1e3
+		    << " ms" << std::endl;
+		for (const TenantOutcome& outcome : outcomes) {
+			if (!outcome.ok) {
+				out << "- FAILED " << outcome.tenant.dbName << " after " << outcome.attempts << " attempts"
+				    << std::endl;
+			}
+		}
+	}
+
+	bool likeMatches(std::string_view name, std::string_view pattern) {
+		if (pattern.empty()) {
+			return name.empty();
+		}
+		if (pattern.front() == '%') {
+			while (pattern.size() > 1 && pattern[1] == '%') {
+				pattern.remove_prefix(1); // Runs of % match the same names as one
+			}
+			for (std::size_t skip = 0; skip <= name.size(); ++skip) {
+				if (likeMatches(name.substr(skip), pattern.substr(1))) {
+					return true;
+				}
+			}
+			return false;
+		}
+		if (name.empty()) {
+			return false;
+		}
+		if (pattern.front() == '_') {
+			return likeMatches(name.substr(1), pattern.substr(1));
+		}
+		if (pattern.front() == '\\' && pattern.size() > 1) {
+			pattern.remove_prefix(1); // The escaped character matches itself
+		}
+		return name.front() == pattern.front() && likeMatches(name.substr(1), pattern.substr(1));
+	}
+
+	ProvisionReport provisionTenants(const std::vector<TenantSpec>& tenants,
+	                                 const ProvisionFunction& provision,
+	                                 const ProvisionOptions& options) {
+		ProvisionReport report;
+		report.outcomes.resize(tenants.size());
+
+		std::atomic<std::size_t> finished{0};
+		std::mutex outputMutex;
+		auto start = Clock::now();
+		if (!options.pooledConnInfo.empty()) {
+			pgsqlPool::PgConnectionPool::instance().reserve(options.pooledConnInfo, options.concurrency);
+		}
+
+		// Each entry is written by exactly one worker. A tenant that keeps failing is recorded in its
+		// outcome and does not stop the others, so the task itself always succeeds.
+		std::string ignored;
+		pgsqlWorkers::runIndexed(
+		    tenants.size(),
+		    options.concurrency,
+		    [&](std::size_t index, std::size_t, std::string&) {
+			    TenantOutcome& outcome = report.outcomes[index];
+			    outcome.tenant = tenants[index];
+			    auto tenantStart = Clock::now();
+			    auto backoff = options.retryBackoff;
+			    while (outcome.attempts < std::max(options.maxAttempts, 1)) {
+				    if (outcome.attempts++ > 0) {
+					    std::this_thread::sleep_for(backoff);
+					    backoff *= 2;
+				    }
+				    std::size_t timeouts = pgsqlPool::PgConnectionPool::timeoutsOnThisThread();
+				    if (provision(outcome.tenant)) {
+					    outcome.ok = true;
+					    break;
+				    }
+				    if (pgsqlPool::PgConnectionPool::timeoutsOnThisThread() != timeouts) {
+					    --outcome.attempts; // Waited on the pool; the tenant itself did not fail
+				    }
+			    }
+			    outcome.seconds = secondsSince(tenantStart);
+
+			    std::size_t done = ++finished;
+			    if (options.printProgress) {
+				    std::lock_guard<std::mutex> lock(outputMutex);
+				    std::cout << "[" << done << "/" << tenants.size() << "] " << outcome.tenant.dbName
+				              << (outcome.ok ? " ok in " : " failed after ") << std::fixed << std::setprecision(1)
+				              << outcome.seconds * 1e3 << " ms (" << outcome.attempts << " attempt"
+				              << (outcome.attempts == 1 ? "" : "s") << ")" << std::endl;
+			    }
+			    return true;
+		    },
+		    ignored);
+
+		report.wallSeconds = secondsSince(start);
+		for (const TenantOutcome& outcome : report.outcomes) {
+			(outcome.ok ? report.succeeded : report.failed)++;
+		}
+		return report;
+	}
+} // namespace pgsqlProvisioning
@@ -0,0 +1,74 @@
+#ifndef PGSQL_PROVISIONING_H
+#define PGSQL_PROVISIONING_H
+
+#include <chrono>
+#include <cstddef>
+#include <functional>
+#include <iosfwd>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace pgsqlProvisioning {
+
+	// One store of a provisioning manifest
+	struct TenantSpec {
+		std::string dbName;
+		std::string userName;
+		std::string password;
+	};
+
+	// Manifest lines are "dbName,userName,password"; the password is everything after the second comma.
+	// Blank lines and lines starting with '#' are skipped. On a malformed line error names the line.
+	bool parseManifest(std::istream& in, std::vector<TenantSpec>& tenants, std::string& error);
+	bool loadManifest(const std::string& path, std::vector<TenantSpec>& tenants);
+
+	struct ProvisionOptions {
+		std::size_t concurrency = 4; // Worker threads; each holds at most one superuser connection at a time
+		// Conninfo the workers borrow from pgsqlPool::PgConnectionPool::instance(); its sub-pool is
+		// sized to concurrency so no worker queues behind the pool's default limit
+		std::string pooledConnInfo = {};
+		int maxAttempts = 3; // Per tenant, including the first
+		std::chrono::milliseconds retryBackoff{250}; // Doubled after every failed attempt
+		bool printProgress = true; // One line per finished tenant on std::cout
+	};
+
+	struct TenantOutcome {
+		TenantSpec tenant;
+		bool ok = false;
+		int attempts = 0;
+		double seconds = 0; // All attempts and backoff included
+	};
+
+	struct ProvisionReport {
+		std::vector<TenantOutcome> outcomes; // Manifest order
+		std::size_t succeeded = 0;
+		std::size_t failed = 0;
+		double wallSeconds = 0;
+
+		// Tenants finished per second of wall time
+		[[nodiscard]] double throughput() const;
+
+		// Nearest-rank percentile (0-100) of successful tenant latencies, in seconds
+		[[nodiscard]] double latencyPercentile(double percentile) const;
+
+		// action is the past-tense verb of the summary line ("Provisioned", "Migrated", "Dropped")
+		void print(std::ostream& out, const char* action = "Provisioned") const;
+	};
+
+	// SQL LIKE on the client, selecting stores by name: % matches any run of characters, _ exactly one,
+	// and a backslash makes the next character literal. Case-sensitive, as database names are.
+	bool likeMatches(std::string_view name, std::string_view pattern);
+
+	// Provisions one tenant; must be safe to call again for a tenant whose previous attempt failed
+	using ProvisionFunction = std::function<bool(const TenantSpec&)>;
+
+	// Runs provision for every tenant on a pool of options.concurrency workers, retrying failures. An
+	// attempt that failed because the shared connection pool timed out is retried without counting.
+	ProvisionReport provisionTenants(const std::vector<TenantSpec>& tenants,
+	                                 const ProvisionFunction& provision,
+	                                 const ProvisionOptions& options = {});
+
+} // namespace pgsqlProvisioning
+
+#endif // PGSQL_PROVISIONING_H
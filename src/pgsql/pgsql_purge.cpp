@@ -0,0 +1,384 @@
+#include "pgsql_purge.h"
+#include "pgsql_handles.h"
+#include "pgsql_indexes.h"
+#include "pgsql_schema.h"
+
+#include <algorithm>
+#include <cctype>
+#include <cstdlib>
+#include <cstring>
+#include <iomanip>
+#include <iostream>
+#include <limits>
+
+namespace pgsqlPurge {
+	using Clock = std::chrono::steady_clock;
+
+	// Order_Items belong to their order; every other foreign key only points at a shared row
+	constexpr const char* kOwnedChildren[][2] = {{pgsqlSchema::OrderItems::name, pgsqlSchema::Orders::name}};
+
+	static double secondsSince(Clock::time_point start) {
+		return std::chrono::duration<double>(Clock::now() - start).count();
+	}
+
+	static std::string lower(std::string name) {
+		std::transform(name.begin(), name.end(), name.begin(), [](unsigned char c) {
+			return static_cast<char>(std::tolower(c));
+		});
+		return name;
+	}
+
+	std::vector<PurgeTable> purgeTables() {
+		struct Described {
+			PurgeTable table;
+			std::vector<pgsqlSchema::ForeignKey> foreignKeys;
+		};
+		std::vector<Described> described;
+		pgsqlSchema::forEachTable<pgsqlSchema::PetstoreTables>([&](auto table) {
+			using Table = decltype(table);
+			Described entry{{Table::name, pgsqlSchema::serialColumn<Table>(), {}},
+			                {Table::foreignKeys.begin(), Table::foreignKeys.end()}};
+			std::apply([&](const auto&... column) { (entry.table.columns.emplace_back(column.name), ...); },
+			           Table::columns);
+			entry.table.columns.emplace_back("deleted_at");
+			described.push_back(std::move(entry));
+		});
+
+		for (Described& parent : described) {
+			for (const Described& child : described) {
+				for (const pgsqlSchema::ForeignKey& key : child.foreignKeys) {
+					if (parent.table.name != key.table) {
+						continue;
+					}
+					bool owned = false;
+					for (const auto& pair : kOwnedChildren) {
+						owned = owned || (child.table.name == pair[0] && parent.table.name == pair[1]);
+					}
+					parent.table.children.push_back(
+					    {child.table.name, key.column, key.referencedColumn, owned, child.table.columns});
+				}
+			}
+		}
+
+		// The store order creates parents first, so its reverse purges children first
+		std::vector<PurgeTable> tables;
+		for (auto entry = described.rbegin(); entry != described.rend(); ++entry) {
+			tables.push_back(std::move(entry->table));
+		}
+		return tables;
+	}
+
+	std::string archiveTableName(const std::string& table) {
+		return "Archive_" + table;
+	}
+
+	std::string softDeleteArchiveSQL() {
+		std::string sql = "CREATE OR REPLACE FUNCTION petstore_stamp_deleted_at() RETURNS trigger\n"
+		                  "LANGUAGE plpgsql AS $$\n"
+		                  "BEGIN\n"
+		                  "    IF TG_OP = 'INSERT' THEN\n"
+		                  "        NEW.deleted_at := COALESCE(NEW.deleted_at, now());\n"
+		                  "    ELSE\n"
+		                  "        NEW.deleted_at := CASE WHEN NEW.is_deleted THEN now() END;\n"
+		                  "    END IF;\n"
+		                  "    RETURN NEW;\n"
+		                  "END $$;\n";
+		for (const PurgeTable& table : purgeTables()) {
+			std::string trigger = lower(table.name) + "_deleted_at";
+			std::string archive = archiveTableName(table.name);
+			sql += "ALTER TABLE " + table.name + " ADD COLUMN deleted_at TIMESTAMPTZ;\n";
+			sql += "UPDATE " + table.name + " SET deleted_at = now() WHERE is_deleted;\n";
+			sql += "CREATE TRIGGER " + trigger + "_insert BEFORE INSERT ON " + table.name
+			       + " FOR EACH ROW WHEN (NEW.is_deleted) EXECUTE FUNCTION petstore_stamp_deleted_at();\n";
+			sql += "CREATE TRIGGER " + trigger + "_update BEFORE UPDATE OF is_deleted ON " + table.name
+			       + " FOR EACH ROW WHEN (OLD.is_deleted IS DISTINCT FROM NEW.is_deleted) "
+			         "EXECUTE FUNCTION petstore_stamp_deleted_at();\n";
+			sql += "CREATE TABLE " + archive + " (LIKE " + table.name
+			       + ", archived_at TIMESTAMPTZ NOT NULL DEFAULT now());\n";
+			sql += "CREATE INDEX " + lower(archive) + "_" + table.key + "_idx ON " + archive + " (" + table.key
+			       + ");\n";
+
+			// Every eligibility check probes the referencing rows of each child, soft-deleted ones
+			// included, which the partial indexes of the pack leave out
+			for (const ChildReference& child : table.children) {
+				const std::vector<pgsqlIndexes::IndexDefinition>& pack = pgsqlIndexes::petstoreIndexPack();
+				bool indexed = std::any_of(pack.begin(), pack.end(), [&](const pgsqlIndexes::IndexDefinition& index) {
+					return !index.activeRowsOnly && child.table == index.table && child.column == index.columns;
+				});
+				if (!indexed) {
+					sql += "CREATE INDEX IF NOT EXISTS " + lower(child.table) + "_" + child.column + "_idx ON "
+					       + child.table + " (" + child.column + ");\n";
+				}
+			}
+		}
+		return sql;
+	}
+
+	// Soft-deleted before the cutoff ($2) and no longer referenced, except by owned rows that are
+	// themselves soft-deleted
+	static std::string eligibleSQL(const PurgeTable& table) {
+		std::string sql = "t.is_deleted AND t.deleted_at < $2";
+		for (const ChildReference& child : table.children) {
+			sql += " AND NOT EXISTS (SELECT 1 FROM " + child.table + " AS c WHERE c." + child.column + " = t."
+			       + child.referencedColumn + (child.owned ? " AND c.is_deleted IS NOT TRUE)" : ")");
+		}
+		return sql;
+	}
+
+	static std::string joinColumns(const std::vector<std::string>& columns, const std::string& prefix) {
+		std::string joined;
+		for (const std::string& column : columns) {
+			joined += (joined.empty() ? "" : ", ") + prefix + column;
+		}
+		return joined;
+	}
+
+	std::string candidatesSQL(const PurgeTable& table) {
+		return "SELECT t." + table.key + " FROM " + table.name + " AS t WHERE t." + table.key + " > $1 AND "
+		       + eligibleSQL(table) + " ORDER BY t." + table.key + " LIMIT $3;";
+	}
+
+	std::string moveSQL(const PurgeTable& table) {
+		std::string columns = joinColumns(table.columns, "");
+		std::string sql = "WITH moved AS (DELETE FROM " + table.name + " AS t WHERE t." + table.key
+		                  + " = ANY($1::int[]) AND " + eligibleSQL(table) + " RETURNING "
+		                  + joinColumns(table.columns, "t.") + "), archived AS (INSERT INTO "
+		                  + archiveTableName(table.name) + " (" + columns + ") SELECT " + columns
+		                  + " FROM moved RETURNING 1)";
+		std::string childCount;
+		std::size_t owned = 0;
+		for (const ChildReference& child : table.children) {
+			if (!child.owned) {
+				continue;
+			}
+			std::string rows = "children" + std::to_string(owned);
+			std::string archived = "archived_children" + std::to_string(owned++);
+			std::string childColumns = joinColumns(child.columns, "");
+			sql += ", " + rows + " AS (DELETE FROM " + child.table + " AS c WHERE c." + child.column + " IN (SELECT "
+			       + child.referencedColumn + " FROM moved) RETURNING " + joinColumns(child.columns, "c.") + "), "
+			       + archived + " AS (INSERT INTO " + archiveTableName(child.table) + " (" + childColumns
+			       + ") SELECT " + childColumns + " FROM " + rows + " RETURNING 1)";
+			childCount += (childCount.empty() ? "" : " + ") + std::string("(SELECT count(*) FROM ") + archived + ")";
+		}
+		return sql + " SELECT (SELECT count(*) FROM archived), " + (childCount.empty() ? "0" : childCount) + ";";
+	}
+
+	void PurgeReport::print(std::ostream& out) const {
+		std::uint64_t total = 0;
+		for (const PurgeStats& table : tables) {
+			total += table.moved + table.children;
+		}
+		out << "\n"
+		    << (!ok ? "Purge failed after archiving " : stopped ? "Purge stopped after archiving " : "Archived ")
+		    << total << " rows in " << std::fixed << std::setprecision(2) << seconds << " s ("
+		    << (seconds > 0 ? static_cast<double>(total) / seconds : 0.0) << " rows/s)" << std::endl;
+		for (const PurgeStats& table : tables) {
+			out << "  " << std::left << std::setw(20) << table.table << std::right << std::setw(12) << table.moved
+			    << " rows";
+			if (table.children > 0) {
+				out << " + " << table.children << " owned";
+			}
+			out << ", " << table.batches << " batches, " << table.retries << " retries, " << table.seconds << " s"
+			    << std::endl;
+		}
+		if (!ok) {
+			out << "Error: " << error << std::endl;
+		}
+	}
+
+	static pgsqlHandles::PgResult execParams(PGconn* conn,
+	                                         const std::string& sql,
+	                                         const std::vector<std::string>& params) {
+		std::vector<const char*> values;
+		for (const std::string& param : params) {
+			values.push_back(param.c_str());
+		}
+		return pgsqlHandles::PgResult(PQexecParams(
+		    conn, sql.c_str(), static_cast<int>(values.size()), nullptr, values.data(), nullptr, nullptr, 0));
+	}
+
+	// Lock and statement timeouts leave the batch to be retried smaller; anything else ends the purge
+	static bool retryable(const pgsqlHandles::PgResult& res) {
+		const char* state = res.get() ? PQresultErrorField(res.get(), PG_DIAG_SQLSTATE) : nullptr;
+		return state && (std::strcmp(state, "55P03") == 0 || std::strcmp(state, "57014") == 0);
+	}
+
+	// Sleeps until due unless stop is set first
+	static void pauseUntil(Clock::time_point due, const std::atomic<bool>& stop) {
+		while (!stop && Clock::now() < due) {
+			std::this_thread::sleep_for(std::min<Clock::duration>(std::chrono::milliseconds(50), due - Clock::now()));
+		}
+	}
+
+	PurgeReport purgeSoftDeleted(PGconn* conn,
+	                             const PurgeOptions& options,
+	                             const std::atomic<bool>& stop,
+	                             const std::function<void(const PurgeProgress&)>& onBatch) {
+		PurgeReport report;
+		auto start = Clock::now();
+		if (options.retentionDays < 0 || options.minBatchRows == 0 || options.minBatchRows > options.maxBatchRows) {
+			report.error = "invalid purge options";
+			return report;
+		}
+
+		// One cutoff for the whole run, taken from the server clock that stamped deleted_at
+		pgsqlHandles::PgResult cutoffResult = execParams(
+		    conn, "SELECT now() - make_interval(days => $1::int);", {std::to_string(options.retentionDays)});
+		if (!cutoffResult.ok() || cutoffResult.rows() != 1) {
+			report.error = cutoffResult.errorMessage();
+			return report;
+		}
+		std::string cutoff = PQgetvalue(cutoffResult.get(), 0, 0);
+		std::string begin = "BEGIN; SET LOCAL lock_timeout = " + std::to_string(options.lockTimeout.count())
+		                    + "; SET LOCAL statement_timeout = " + std::to_string(options.statementTimeout.count())
+		                    + ";";
+
+		PurgeProgress progress;
+		progress.running = true;
+		progress.batchRows = std::clamp(options.batchRows, options.minBatchRows, options.maxBatchRows);
+		bool ok = true;
+		for (const PurgeTable& table : purgeTables()) {
+			if (!ok || stop) {
+				break;
+			}
+			PurgeStats stats;
+			stats.table = table.name;
+			progress.table = table.name;
+			auto tableStart = Clock::now();
+			std::string candidates = candidatesSQL(table);
+			std::string move = moveSQL(table);
+			std::string last = std::to_string(std::numeric_limits<std::int32_t>::min());
+			std::size_t failures = 0;
+
+			while (ok && !stop) {
+				pgsqlHandles::PgResult ids =
+				    execParams(conn, candidates, {last, cutoff, std::to_string(progress.batchRows)});
+				if (!ids.ok()) {
+					report.error = table.name + ": " + ids.errorMessage();
+					ok = false;
+					break;
+				}
+				if (ids.rows() == 0) {
+					break;
+				}
+				std::string array = "{";
+				for (int row = 0; row < ids.rows(); ++row) {
+					array += (row ? "," : "") + std::string(PQgetvalue(ids.get(), row, 0));
+				}
+				array += "}";
+
+				// Row locks are held only for this short transaction, on rows nobody uses any more
+				auto batchStart = Clock::now();
+				pgsqlHandles::PgResult begun = pgsqlHandles::PgResult::exec(conn, begin.c_str());
+				pgsqlHandles::PgResult moved = begun.ok() ? execParams(conn, move, {array, cutoff}) : std::move(begun);
+				bool committed = moved.ok() && pgsqlHandles::PgResult::exec(conn, "COMMIT;").ok();
+				if (!committed) {
+					std::string error = moved.ok() ? std::string(PQerrorMessage(conn)) : moved.errorMessage();
+					pgsqlHandles::PgResult::exec(conn, "ROLLBACK;");
+					if (retryable(moved) && ++failures <= options.maxRetries) {
+						++stats.retries;
+						progress.batchRows = std::max(options.minBatchRows, progress.batchRows / 2);
+						pauseUntil(Clock::now() + options.lockTimeout, stop);
+						continue;
+					}
+					report.error = table.name + ": " + error;
+					ok = false;
+					break;
+				}
+				failures = 0;
+
+				// Halve batches that held their locks too long, double quick ones
+				auto elapsed = Clock::now() - batchStart;
+				if (elapsed > options.maxBatchTime) {
+					progress.batchRows = std::max(options.minBatchRows, progress.batchRows / 2);
+				}
+				else if (elapsed * 4 < options.maxBatchTime) {
+					progress.batchRows = std::min(options.maxBatchRows, progress.batchRows * 2);
+				}
+
+				std::uint64_t rows = std::strtoull(PQgetvalue(moved.get(), 0, 0), nullptr, 10);
+				std::uint64_t children = std::strtoull(PQgetvalue(moved.get(), 0, 1), nullptr, 10);
+				last = PQgetvalue(ids.get(), ids.rows() - 1, 0);
+				stats.moved += rows;
+				stats.children += children;
+				++stats.batches;
+				progress.moved += rows + children;
+				++progress.batches;
+				progress.seconds = secondsSince(start);
+				if (onBatch) {
+					onBatch(progress);
+				}
+
+				// Average rate over the whole run, so short bursts are paid back with a pause
+				if (options.maxRowsPerSecond > 0) {
+					auto due = start + std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>(
+					                       static_cast<double>(progress.moved) / options.maxRowsPerSecond));
+					pauseUntil(due, stop);
+				}
+			}
+			stats.seconds = secondsSince(tableStart);
+			report.tables.push_back(stats);
+		}
+
+		report.stopped = stop;
+		report.ok = ok;
+		report.seconds = secondsSince(start);
+		progress.running = false;
+		progress.seconds = report.seconds;
+		if (onBatch) {
+			onBatch(progress);
+		}
+		return report;
+	}
+
+	PurgeJob::PurgeJob(std::string conninfo, PurgeOptions options)
+	: conninfo_(std::move(conninfo))
+	, options_(options) {}
+
+	PurgeJob::~PurgeJob() {
+		stop();
+	}
+
+	void PurgeJob::start() {
+		if (thread_.joinable()) {
+			return;
+		}
+		stop_ = false;
+		progress_ = PurgeProgress{};
+		progress_.running = true;
+		thread_ = std::thread([this] {
+			PurgeReport report;
+			pgsqlHandles::PgConn conn = pgsqlHandles::PgConn::connect(conninfo_);
+			if (!conn.ok()) {
+				report.error = conn.errorMessage();
+			}
+			else {
+				report = purgeSoftDeleted(conn.get(), options_, stop_, [this](const PurgeProgress& progress) {
+					std::lock_guard<std::mutex> lock(mutex_);
+					progress_ = progress;
+				});
+			}
+			std::lock_guard<std::mutex> lock(mutex_);
+			progress_.running = false;
+			report_ = std::move(report);
+		});
+	}
+
+	PurgeReport PurgeJob::stop() {
+		stop_ = true;
+		return wait();
+	}
+
+	PurgeReport PurgeJob::wait() {
+		if (thread_.joinable()) {
+			thread_.join();
+		}
+		std::lock_guard<std::mutex> lock(mutex_);
+		return report_;
+	}
+
+	PurgeProgress PurgeJob::progress() const {
+		std::lock_guard<std::mutex> lock(mutex_);
+		return progress_;
+	}
+} // namespace pgsqlPurge
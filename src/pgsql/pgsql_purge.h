@@ -0,0 +1,140 @@
+#ifndef PGSQL_PURGE_H
+#define PGSQL_PURGE_H
+
+#include "libpq-fe.h"
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <iosfwd>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace pgsqlPurge {
+
+	// A table whose rows reference a purged table. Owned children are archived together with their
+	// parent (an order's items); any other remaining reference keeps the parent row in place.
+	struct ChildReference {
+		std::string table;
+		std::string column;
+		std::string referencedColumn;
+		bool owned = false;
+		std::vector<std::string> columns = {}; // The child's columns, archived with an owned child
+	};
+
+	// A store table as the purge sees it
+	struct PurgeTable {
+		std::string name;
+		std::string key;
+		std::vector<std::string> columns; // Descriptor columns, then deleted_at
+		std::vector<ChildReference> children = {};
+	};
+
+	// The store tables in purge order, children before their parents. Owned children are also purged
+	// on their own, e.g. items removed from an order that is still live.
+	std::vector<PurgeTable> purgeTables();
+
+	std::string archiveTableName(const std::string& table); // "Archive_Orders"
+
+	// Schema step adding deleted_at to every store table, the triggers that stamp it when is_deleted
+	// turns true (and clear it when a row is restored), one append-only archive table per store table
+	// and a full index on each referencing column the purge probes, unless the index pack has one.
+	// Rows deleted before the step start their retention when it runs. BEFORE ROW triggers on the
+	// partitioned parents of the monthly layout need PostgreSQL 13.
+	std::string softDeleteArchiveSQL();
+
+	// Next batch of eligible ids after $1 ($1 key, $2 cutoff timestamptz, $3 limit); takes no locks
+	std::string candidatesSQL(const PurgeTable& table);
+
+	// Moves the eligible rows among ids $1 (an int[]) into the archive in one statement, re-checking
+	// eligibility, and returns the rows moved and the owned child rows moved with them
+	std::string moveSQL(const PurgeTable& table);
+
+	struct PurgeOptions {
+		int retentionDays = 90; // Rows soft-deleted at least this long ago are archived
+		std::size_t batchRows = 1000; // First batch; then halved or doubled to stay near maxBatchTime
+		std::size_t minBatchRows = 50;
+		std::size_t maxBatchRows = 20000;
+		std::chrono::milliseconds maxBatchTime{200}; // Target duration of one move transaction
+		std::chrono::milliseconds lockTimeout{100}; // A batch never queues behind application locks for longer
+		std::chrono::milliseconds statementTimeout{5000}; // Hard cap on one move
+		double maxRowsPerSecond = 5000; // Archived rows per second over the run; 0 disables the limit
+		std::size_t maxRetries = 5; // Consecutive lock / statement timeouts of one batch before giving up
+	};
+
+	// Live metrics of a running purge
+	struct PurgeProgress {
+		std::string table; // Table being purged
+		std::uint64_t moved = 0; // Rows archived so far, owned children included
+		std::uint64_t batches = 0;
+		std::size_t batchRows = 0; // Current batch size
+		double seconds = 0;
+		bool running = false;
+
+		[[nodiscard]] double rowsPerSecond() const {
+			return seconds > 0 ? static_cast<double>(moved) / seconds : 0.0;
+		}
+	};
+
+	struct PurgeStats {
+		std::string table;
+		std::uint64_t moved = 0;
+		std::uint64_t children = 0; // Owned child rows archived with them
+		std::uint64_t batches = 0;
+		std::uint64_t retries = 0; // Batches retried after a lock or statement timeout
+		double seconds = 0;
+	};
+
+	struct PurgeReport {
+		bool ok = false; // Every table was purged, or the run was stopped cleanly
+		bool stopped = false;
+		std::vector<PurgeStats> tables;
+		double seconds = 0;
+		std::string error;
+
+		void print(std::ostream& out) const;
+	};
+
+	// Archives every eligible row over conn, table by table in keyset-paginated batches, each batch
+	// its own short transaction. onBatch sees the progress after every batch; setting stop ends the
+	// run after the current batch.
+	PurgeReport purgeSoftDeleted(PGconn* conn,
+	                             const PurgeOptions& options,
+	                             const std::atomic<bool>& stop,
+	                             const std::function<void(const PurgeProgress&)>& onBatch = {});
+
+	// purgeSoftDeleted on a thread of its own, with its own connection
+	class PurgeJob {
+	 public:
+		PurgeJob(std::string conninfo, PurgeOptions options);
+		~PurgeJob();
+
+		PurgeJob(const PurgeJob&) = delete;
+		PurgeJob& operator=(const PurgeJob&) = delete;
+
+		void start();
+
+		// Asks the job to finish its current batch and waits for it
+		PurgeReport stop();
+
+		// Waits for the job to run to completion
+		PurgeReport wait();
+
+		[[nodiscard]] PurgeProgress progress() const;
+
+	 private:
+		std::string conninfo_;
+		PurgeOptions options_;
+		std::thread thread_;
+		std::atomic<bool> stop_{false};
+		mutable std::mutex mutex_;
+		PurgeProgress progress_;
+		PurgeReport report_;
+	};
+
+} // namespace pgsqlPurge
+
+#endif // PGSQL_PURGE_H
@@ -0,0 +1,565 @@
+#ifndef PGSQL_SCHEMA_H
+#define PGSQL_SCHEMA_H
+
+#include "pgsql_binary.h"
+#include "pgsql_handles.h"
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace pgsqlSchema {
+
+	// Column types of the store schema. Each one fixes the C++ field type it decodes into:
+	// Serial/Integer -> int32_t, Text -> std::string, Money (NUMERIC(10, 2)) -> int64_t cents,
+	// Date -> int32_t days since 2000-01-01, Boolean -> bool. Nullable columns use std::optional.
+	// Timestamp (TIMESTAMPTZ, int64_t microseconds since 2000-01-01) is not used by the descriptors; it
+	// covers the columns the soft-delete step adds (see pgsqlPurge).
+	enum class SqlType { Serial, Integer, Text, Money, Date, Boolean, Timestamp };
+
+	// Precision and scale of Money
+	constexpr int kMoneyPrecision = 10;
+	constexpr int kMoneyScale = 2;
+
+	constexpr const char* sqlTypeName(SqlType type) {
+		switch (type) {
+		case SqlType::Serial: return "SERIAL";
+		case SqlType::Integer: return "INTEGER";
+		case SqlType::Text: return "TEXT";
+		case SqlType::Money: return "NUMERIC(10, 2)";
+		case SqlType::Date: return "DATE";
+		case SqlType::Boolean: return "BOOLEAN";
+		case SqlType::Timestamp: return "TIMESTAMPTZ";
+		}
+		return "";
+	}
+
+	// One column: SQL name and constraints, plus the Row field it maps to. Type and field are template
+	// arguments, so decoding a column is resolved at compile time from its position in the table.
+	template<SqlType Type, auto Member>
+	struct Column {
+		static constexpr SqlType type = Type;
+		static constexpr auto member = Member;
+		const char* name;
+		const char* constraints; // "PRIMARY KEY", "NOT NULL", "DEFAULT FALSE" or ""
+	};
+
+	template<SqlType Type, auto Member>
+	constexpr Column<Type, Member> column(const char* name, const char* constraints = "") {
+		return {name, constraints};
+	}
+
+	struct ForeignKey {
+		const char* column;
+		const char* table;
+		const char* referencedColumn;
+	};
+
+	struct Customers {
+		struct Row {
+			std::int32_t customerId;
+			std::string name;
+			std::string phoneNumber;
+			std::string email;
+			std::string address;
+			bool isDeleted; // Soft delete flag
+		};
+
+		static constexpr const char* name = "Customers";
+		static constexpr const char* displayName = "Customers";
+		static constexpr auto columns = std::make_tuple(
+		    column<SqlType::Serial, &Row::customerId>("customer_id", "PRIMARY KEY"),
+		    column<SqlType::Text, &Row::name>("name", "NOT NULL"),
+		    column<SqlType::Text, &Row::phoneNumber>("phone_number", "NOT NULL"),
+		    column<SqlType::Text, &Row::email>("email", "NOT NULL"),
+		    column<SqlType::Text, &Row::address>("address", "NOT NULL"),
+		    column<SqlType::Boolean, &Row::isDeleted>("is_deleted", "DEFAULT FALSE"));
+		static constexpr std::array<ForeignKey, 0> foreignKeys{};
+	};
+
+	struct Products {
+		struct Row {
+			std::int32_t productId;
+			std::string name;
+			std::int64_t priceCents;
+			std::int32_t stock;
+			std::optional<std::string> category;
+			bool isDeleted;
+		};
+
+		static constexpr const char* name = "Products";
+		static constexpr const char* displayName = "Products";
+		static constexpr auto columns =
+		    std::make_tuple(column<SqlType::Serial, &Row::productId>("product_id", "PRIMARY KEY"),
+		                    column<SqlType::Text, &Row::name>("name", "NOT NULL"),
+		                    column<SqlType::Money, &Row::priceCents>("price", "NOT NULL"),
+		                    column<SqlType::Integer, &Row::stock>("stock", "NOT NULL"),
+		                    column<SqlType::Text, &Row::category>("category"),
+		                    column<SqlType::Boolean, &Row::isDeleted>("is_deleted", "DEFAULT FALSE"));
+		static constexpr std::array<ForeignKey, 0> foreignKeys{};
+	};
+
+	struct Employees {
+		struct Row {
+			std::int32_t employeeId;
+			std::string name;
+			std::string position;
+			std::int32_t hireDate; // Days since 2000-01-01
+			std::optional<std::string> contactInfo;
+			bool isDeleted;
+		};
+
+		static constexpr const char* name = "Employees";
+		static constexpr const char* displayName = "Employees";
+		static constexpr auto columns =
+		    std::make_tuple(column<SqlType::Serial, &Row::employeeId>("employee_id", "PRIMARY KEY"),
+		                    column<SqlType::Text, &Row::name>("name", "NOT NULL"),
+		                    column<SqlType::Text, &Row::position>("position", "NOT NULL"),
+		                    column<SqlType::Date, &Row::hireDate>("hire_date", "NOT NULL"),
+		                    column<SqlType::Text, &Row::contactInfo>("contact_info"),
+		                    column<SqlType::Boolean, &Row::isDeleted>("is_deleted", "DEFAULT FALSE"));
+		static constexpr std::array<ForeignKey, 0> foreignKeys{};
+	};
+
+	struct Orders {
+		struct Row {
+			std::int32_t orderId;
+			std::int32_t orderDate; // Days since 2000-01-01
+			std::optional<std::int32_t> employeeId;
+			std::optional<std::int32_t> customerId;
+			std::int64_t totalCents;
+			std::string status; // e.g. pending, completed
+			bool isDeleted;
+		};
+
+		static constexpr const char* name = "Orders";
+		static constexpr const char* displayName = "Orders";
+		static constexpr auto columns =
+		    std::make_tuple(column<SqlType::Serial, &Row::orderId>("order_id", "PRIMARY KEY"),
+		                    column<SqlType::Date, &Row::orderDate>("order_date", "NOT NULL"),
+		                    column<SqlType::Integer, &Row::employeeId>("employee_id"),
+		                    column<SqlType::Integer, &Row::customerId>("customer_id"),
+		                    column<SqlType::Money, &Row::totalCents>("total", "NOT NULL"),
+		                    column<SqlType::Text, &Row::status>("status", "NOT NULL"),
+		                    column<SqlType::Boolean, &Row::isDeleted>("is_deleted", "DEFAULT FALSE"));
+		static constexpr std::array<ForeignKey, 2> foreignKeys{
+		    {{"employee_id", "Employees", "employee_id"}, {"customer_id", "Customers", "customer_id"}}};
+	};
+
+	struct OrderItems {
+		struct Row {
+			std::int32_t orderItemId;
+			std::int32_t orderId;
+			std::int32_t productId;
+			std::int32_t quantity;
+			std::int64_t priceCents; // Price at the time of the order
+			bool isDeleted;
+		};
+
+		static constexpr const char* name = "Order_Items";
+		static constexpr const char* displayName = "Order Items";
+		static constexpr auto columns =
+		    std::make_tuple(column<SqlType::Serial, &Row::orderItemId>("order_item_id", "PRIMARY KEY"),
+		                    column<SqlType::Integer, &Row::orderId>("order_id", "NOT NULL"),
+		                    column<SqlType::Integer, &Row::productId>("product_id", "NOT NULL"),
+		                    column<SqlType::Integer, &Row::quantity>("quantity", "NOT NULL"),
+		                    column<SqlType::Money, &Row::priceCents>("price", "NOT NULL"),
+		                    column<SqlType::Boolean, &Row::isDeleted>("is_deleted", "DEFAULT FALSE"));
+		static constexpr std::array<ForeignKey, 2> foreignKeys{
+		    {{"order_id", "Orders", "order_id"}, {"product_id", "Products", "product_id"}}};
+	};
+
+	struct Suppliers {
+		struct Row {
+			std::int32_t supplierId;
+			std::string name;
+			std::optional<std::string> contactInfo;
+			std::optional<std::int32_t> productId;
+			bool isDeleted;
+		};
+
+		static constexpr const char* name = "Suppliers";
+		static constexpr const char* displayName = "Suppliers";
+		static constexpr auto columns =
+		    std::make_tuple(column<SqlType::Serial, &Row::supplierId>("supplier_id", "PRIMARY KEY"),
+		                    column<SqlType::Text, &Row::name>("name", "NOT NULL"),
+		                    column<SqlType::Text, &Row::contactInfo>("contact_info"),
+		                    column<SqlType::Integer, &Row::productId>("product_id"),
+		                    column<SqlType::Boolean, &Row::isDeleted>("is_deleted", "DEFAULT FALSE"));
+		static constexpr std::array<ForeignKey, 1> foreignKeys{{{"product_id", "Products", "product_id"}}};
+	};
+
+	struct InventoryActions {
+		struct Row {
+			std::int32_t actionId;
+			std::int32_t productId;
+			std::string actionType; // e.g. inbound, outbound
+			std::int32_t quantity;
+			std::int32_t actionDate; // Days since 2000-01-01
+			bool isDeleted;
+		};
+
+		static constexpr const char* name = "Inventory_Actions";
+		static constexpr const char* displayName = "Inventory Actions";
+		static constexpr auto columns =
+		    std::make_tuple(column<SqlType::Serial, &Row::actionId>("action_id", "PRIMARY KEY"),
+		                    column<SqlType::Integer, &Row::productId>("product_id", "NOT NULL"),
+		                    column<SqlType::Text, &Row::actionType>("action_type", "NOT NULL"),
+		                    column<SqlType::Integer, &Row::quantity>("quantity", "NOT NULL"),
+		                    column<SqlType::Date, &Row::actionDate>("action_date", "NOT NULL"),
+		                    column<SqlType::Boolean, &Row::isDeleted>("is_deleted", "DEFAULT FALSE"));
+		static constexpr std::array<ForeignKey, 1> foreignKeys{{{"product_id", "Products", "product_id"}}};
+	};
+
+	// Every store table, in an order that satisfies the foreign keys when creating
+	using PetstoreTables = std::tuple<Customers, Products, Employees, Orders, OrderItems, Suppliers, InventoryActions>;
+
+	// Calls f(Table{}) for each table of the tuple, in order
+	template<typename Tables, typename F>
+	void forEachTable(F&& f) {
+		std::apply([&](auto... table) { (f(table), ...); }, Tables{});
+	}
+
+	// "Customers, Products, ..." for statements that take several tables at once
+	template<typename Tables>
+	std::string tableList() {
+		std::string names;
+		forEachTable<Tables>([&](auto table) {
+			names += names.empty() ? "" : ", ";
+			names += decltype(table)::name;
+		});
+		return names;
+	}
+
+	template<typename Table>
+	constexpr std::size_t columnCount() {
+		return std::tuple_size_v<decltype(Table::columns)>;
+	}
+
+	// Options for the partitioned layout
+	struct DdlOptions {
+		const char* partitionColumn = nullptr; // PARTITION BY RANGE; the primary key becomes (key, column)
+		std::vector<std::string> omitReferencesTo; // Tables whose foreign keys are left out
+	};
+
+	template<typename Table>
+	std::string createTableSQL(const DdlOptions& options = {}) {
+		std::string sql = std::string("CREATE TABLE IF NOT EXISTS ") + Table::name + " (";
+		std::string primaryKey;
+		bool first = true;
+		std::apply(
+		    [&](const auto&... columns) {
+			    auto append = [&](const auto& column) {
+				    sql += first ? "" : ", ";
+				    first = false;
+				    sql += column.name;
+				    sql += ' ';
+				    sql += sqlTypeName(column.type);
+				    std::string constraints = column.constraints;
+				    if (options.partitionColumn && constraints == "PRIMARY KEY") {
+					    primaryKey = column.name; // Moved to a table constraint with the partition column
+				    }
+				    else if (!constraints.empty()) {
+					    sql += ' ' + constraints;
+				    }
+			    };
+			    (append(columns), ...);
+		    },
+		    Table::columns);
+
+		if (!primaryKey.empty()) {
+			sql += ", PRIMARY KEY (" + primaryKey + ", " + options.partitionColumn + ")";
+		}
+		for (const ForeignKey& key : Table::foreignKeys) {
+			bool omitted = false;
+			for (const std::string& table : options.omitReferencesTo) {
+				omitted = omitted || table == key.table;
+			}
+			if (!omitted) {
+				sql += std::string(", FOREIGN KEY (") + key.column + ") REFERENCES " + key.table + "("
+				       + key.referencedColumn + ")";
+			}
+		}
+		sql += ")";
+		if (options.partitionColumn) {
+			sql += std::string(" PARTITION BY RANGE (") + options.partitionColumn + ")";
+		}
+		return sql + ";";
+	}
+
+	// ALTER TABLE ... SET LOGGED / SET UNLOGGED for every table. A logged table may not reference an
+	// unlogged one, so referenced tables go first when logging and last when unlogging. Sent as one
+	// query string, the statements run in a single implicit transaction.
+	template<typename Tables>
+	std::string setLoggedSQL(bool logged) {
+		std::vector<std::string> statements;
+		forEachTable<Tables>([&](auto table) {
+			statements.push_back(std::string("ALTER TABLE ") + decltype(table)::name
+			                     + (logged ? " SET LOGGED;" : " SET UNLOGGED;"));
+		});
+		if (!logged) {
+			std::reverse(statements.begin(), statements.end());
+		}
+
+		std::string sql;
+		for (const std::string& statement : statements) {
+			sql += statement + "\n";
+		}
+		return sql;
+	}
+
+	// One row: whether any of the tables is still logged, and whether any of them holds a row. Only an
+	// empty store may be made UNLOGGED; a crash truncates unlogged tables.
+	template<typename Tables>
+	std::string persistenceCheckSQL() {
+		std::string relations, rows;
+		forEachTable<Tables>([&](auto table) {
+			std::string name = decltype(table)::name;
+			relations += (relations.empty() ? "'" : ", '") + name + "'::regclass";
+			rows += (rows.empty() ? "" : " OR ") + std::string("EXISTS (SELECT 1 FROM ") + name + ")";
+		});
+		return "SELECT EXISTS (SELECT 1 FROM pg_class WHERE oid IN (" + relations
+		       + ") AND relpersistence = 'p'), " + rows + ";";
+	}
+
+	template<typename Table>
+	const std::string& dropTableSQL() {
+		static const std::string sql = std::string("DROP TABLE IF EXISTS ") + Table::name + " CASCADE;";
+		return sql;
+	}
+
+	// "customer_id, name, ..." in descriptor order
+	template<typename Table>
+	const std::string& columnList() {
+		static const std::string list = [] {
+			std::string text;
+			bool first = true;
+			std::apply(
+			    [&](const auto&... columns) {
+				    ((text += (first ? "" : ", "), text += columns.name, first = false), ...);
+			    },
+			    Table::columns);
+			return text;
+		}();
+		return list;
+	}
+
+	// Every column in descriptor order, which is the order decodeBinary and parseText expect
+	template<typename Table>
+	const std::string& selectSQL() {
+		static const std::string sql = "SELECT " + columnList<Table>() + " FROM " + Table::name;
+		return sql;
+	}
+
+	// Name of the table's SERIAL column, or nullptr
+	template<typename Table>
+	const char* serialColumn() {
+		const char* name = nullptr;
+		std::apply(
+		    [&](const auto&... columns) {
+			    ((name = !name && columns.type == SqlType::Serial ? columns.name : name), ...);
+		    },
+		    Table::columns);
+		return name;
+	}
+
+	// Every column except SERIAL keys, as $1..$n in descriptor order
+	template<typename Table>
+	const std::string& insertSQL() {
+		static const std::string sql = [] {
+			std::string names;
+			std::string values;
+			int parameter = 0;
+			std::apply(
+			    [&](const auto&... columns) {
+				    auto append = [&](const auto& column) {
+					    if (column.type == SqlType::Serial) {
+						    return;
+					    }
+					    names += parameter ? ", " : "";
+					    values += parameter ? ", " : "";
+					    names += column.name;
+					    values += '$' + std::to_string(++parameter);
+				    };
+				    (append(columns), ...);
+			    },
+			    Table::columns);
+			return std::string("INSERT INTO ") + Table::name + " (" + names + ") VALUES (" + values + ")";
+		}();
+		return sql;
+	}
+
+	template<typename T>
+	struct IsOptional : std::false_type {};
+	template<typename T>
+	struct IsOptional<std::optional<T>> : std::true_type {};
+
+	// Decode one column of a resultFormat=1 row into its field
+	template<SqlType Type, typename Field>
+	bool decodeBinaryField(const pgsqlHandles::RowView& row, int column, Field& field) {
+		if constexpr (IsOptional<Field>::value) {
+			if (row.isNull(column)) {
+				field.reset();
+				return true;
+			}
+			typename Field::value_type value{};
+			if (!decodeBinaryField<Type>(row, column, value)) {
+				return false;
+			}
+			field = std::move(value);
+			return true;
+		}
+		else if constexpr (Type == SqlType::Boolean) {
+			static_assert(std::is_same_v<Field, bool>);
+			field = false; // NULL counts as false, matching DEFAULT FALSE
+			return row.isNull(column) || pgsqlBinary::decodeBool(row[column], field);
+		}
+		else if constexpr (Type == SqlType::Serial || Type == SqlType::Integer) {
+			static_assert(std::is_same_v<Field, std::int32_t>);
+			return pgsqlBinary::decodeInt4(row[column], field);
+		}
+		else if constexpr (Type == SqlType::Text) {
+			static_assert(std::is_same_v<Field, std::string>);
+			field.assign(row[column]);
+			return !row.isNull(column);
+		}
+		else if constexpr (Type == SqlType::Money) {
+			static_assert(std::is_same_v<Field, std::int64_t>);
+			return pgsqlBinary::decodeNumeric(row[column], 2, field);
+		}
+		else {
+			static_assert(Type == SqlType::Date && std::is_same_v<Field, std::int32_t>);
+			return pgsqlBinary::decodeDate(row[column], field);
+		}
+	}
+
+	// Decode one column of a text-format row into its field
+	template<SqlType Type, typename Field>
+	bool parseTextField(const pgsqlHandles::RowView& row, int column, Field& field) {
+		if constexpr (IsOptional<Field>::value) {
+			if (row.isNull(column)) {
+				field.reset();
+				return true;
+			}
+			typename Field::value_type value{};
+			if (!parseTextField<Type>(row, column, value)) {
+				return false;
+			}
+			field = std::move(value);
+			return true;
+		}
+		else if constexpr (Type == SqlType::Boolean) {
+			static_assert(std::is_same_v<Field, bool>);
+			field = row.getOptional<bool>(column).value_or(false);
+			return true;
+		}
+		else if constexpr (Type == SqlType::Serial || Type == SqlType::Integer) {
+			static_assert(std::is_same_v<Field, std::int32_t>);
+			std::optional<std::int32_t> value = row.getOptional<std::int32_t>(column);
+			field = value.value_or(0);
+			return value.has_value();
+		}
+		else if constexpr (Type == SqlType::Text) {
+			static_assert(std::is_same_v<Field, std::string>);
+			field.assign(row[column]);
+			return !row.isNull(column);
+		}
+		else if constexpr (Type == SqlType::Money) {
+			static_assert(std::is_same_v<Field, std::int64_t>);
+			return pgsqlBinary::parseNumericText(row[column], 2, field);
+		}
+		else {
+			static_assert(Type == SqlType::Date && std::is_same_v<Field, std::int32_t>);
+			return pgsqlBinary::parseDateText(row[column], field);
+		}
+	}
+
+	// Append one column as a binary COPY field: int32 byte length (-1 for NULL), then the value
+	template<SqlType Type, typename Field>
+	void encodeBinaryField(const Field& field, std::string& out) {
+		if constexpr (IsOptional<Field>::value) {
+			if (!field) {
+				pgsqlBinary::encodeInt4(out, -1);
+				return;
+			}
+			encodeBinaryField<Type>(*field, out);
+		}
+		else {
+			std::size_t lengthAt = out.size();
+			out.append(4, '\0'); // Patched once the value is written
+			if constexpr (Type == SqlType::Boolean) {
+				pgsqlBinary::encodeBool(out, field);
+			}
+			else if constexpr (Type == SqlType::Serial || Type == SqlType::Integer) {
+				pgsqlBinary::encodeInt4(out, field);
+			}
+			else if constexpr (Type == SqlType::Text) {
+				out += field;
+			}
+			else if constexpr (Type == SqlType::Money) {
+				pgsqlBinary::encodeNumeric(out, field, 2);
+			}
+			else {
+				static_assert(Type == SqlType::Date && std::is_same_v<Field, std::int32_t>);
+				pgsqlBinary::encodeDate(out, field);
+			}
+			auto length = static_cast<std::uint32_t>(out.size() - lengthAt - 4);
+			for (int i = 0; i < 4; ++i) {
+				out[lengthAt + i] = static_cast<char>((length >> (24 - 8 * i)) & 0xFF);
+			}
+		}
+	}
+
+	template<typename Table, std::size_t... I>
+	void encodeBinaryColumns(const typename Table::Row& row, std::string& out, std::index_sequence<I...>) {
+		using Columns = std::remove_const_t<decltype(Table::columns)>;
+		(encodeBinaryField<std::tuple_element_t<I, Columns>::type>(row.*std::tuple_element_t<I, Columns>::member, out),
+		 ...);
+	}
+
+	// Append a row as one tuple of a binary COPY over columnList<Table>(): field count, then the fields
+	template<typename Table>
+	void encodeCopyBinary(const typename Table::Row& row, std::string& out) {
+		pgsqlBinary::encodeInt2(out, static_cast<std::int16_t>(columnCount<Table>()));
+		encodeBinaryColumns<Table>(row, out, std::make_index_sequence<columnCount<Table>()>{});
+	}
+
+	template<typename Table, std::size_t... I>
+	bool decodeBinaryColumns(const pgsqlHandles::RowView& row, typename Table::Row& out, std::index_sequence<I...>) {
+		using Columns = std::remove_const_t<decltype(Table::columns)>;
+		return (decodeBinaryField<std::tuple_element_t<I, Columns>::type>(
+		            row, static_cast<int>(I), out.*std::tuple_element_t<I, Columns>::member)
+		        && ...);
+	}
+
+	template<typename Table, std::size_t... I>
+	bool parseTextColumns(const pgsqlHandles::RowView& row, typename Table::Row& out, std::index_sequence<I...>) {
+		using Columns = std::remove_const_t<decltype(Table::columns)>;
+		return (parseTextField<std::tuple_element_t<I, Columns>::type>(
+		            row, static_cast<int>(I), out.*std::tuple_element_t<I, Columns>::member)
+		        && ...);
+	}
+
+	// Decode a row of a binary result produced by selectSQL<Table>(); false on a type or NULL mismatch
+	template<typename Table>
+	bool decodeBinary(const pgsqlHandles::RowView& row, typename Table::Row& out) {
+		return row.columns() == static_cast<int>(columnCount<Table>())
+		       && decodeBinaryColumns<Table>(row, out, std::make_index_sequence<columnCount<Table>()>{});
+	}
+
+	// Text-format counterpart of decodeBinary
+	template<typename Table>
+	bool parseText(const pgsqlHandles::RowView& row, typename Table::Row& out) {
+		return row.columns() == static_cast<int>(columnCount<Table>())
+		       && parseTextColumns<Table>(row, out, std::make_index_sequence<columnCount<Table>()>{});
+	}
+
+} // namespace pgsqlSchema
+
+#endif // PGSQL_SCHEMA_H
@@ -0,0 +1,819 @@
+#include "pgsql_snapshot.h"
+#include "pgsql_binary.h"
+#include "pgsql_handles.h"
+
+#include <algorithm>
+#include <cctype>
+#include <chrono>
+#include <cstring>
+#include <iomanip>
+#include <iostream>
+#include <limits>
+#include <unordered_map>
+#include <unordered_set>
+
+namespace pgsqlSnapshot {
+	constexpr char kHeaderMagic[] = "PETSNAP1";
+	constexpr char kFooterMagic[] = "PETSNAPE";
+	constexpr std::size_t kMagicSize = 8;
+	constexpr std::size_t kFooterSize = 8 + 8 + kMagicSize; // Block count, row count, magic
+
+	// A dictionary pays off when values repeat; per block it is used when there are at most half as
+	// many distinct values as rows, and no more than this many
+	constexpr std::size_t kMaxDictionaryEntries = 65536;
+
+	static void putU16(std::string& out, std::uint16_t value) {
+		out += static_cast<char>(value & 0xFF);
+		out += static_cast<char>(value >> 8);
+	}
+
+	static void putU32(std::string& out, std::uint32_t value) {
+		for (int shift = 0; shift < 32; shift += 8) {
+			out += static_cast<char>((value >> shift) & 0xFF);
+		}
+	}
+
+	static void putU64(std::string& out, std::uint64_t value) {
+		for (int shift = 0; shift < 64; shift += 8) {
+			out += static_cast<char>((value >> shift) & 0xFF);
+		}
+	}
+
+	static void putVarint(std::string& out, std::uint64_t value) {
+		while (value >= 0x80) {
+			out += static_cast<char>((value & 0x7F) | 0x80);
+			value >>= 7;
+		}
+		out += static_cast<char>(value);
+	}
+
+	// Small magnitudes of either sign become small unsigned numbers: 0, -1, 1, -2 -> 0, 1, 2, 3
+	static std::uint64_t zigzag(std::int64_t value) {
+		return (static_cast<std::uint64_t>(value) << 1) ^ static_cast<std::uint64_t>(value >> 63);
+	}
+
+	static std::int64_t unzigzag(std::uint64_t value) {
+		return static_cast<std::int64_t>(value >> 1) ^ -static_cast<std::int64_t>(value & 1);
+	}
+
+	// Bounds-checked cursor over a mapped region
+	class Cursor {
+	 public:
+		Cursor(std::string_view data, std::size_t pos = 0)
+		: data_(data)
+		, pos_(pos) {}
+
+		bool u8(std::uint8_t& out) {
+			if (pos_ + 1 > data_.size()) {
+				return false;
+			}
+			out = static_cast<std::uint8_t>(data_[pos_++]);
+			return true;
+		}
+
+		template<typename T>
+		bool fixed(T& out) {
+			if (pos_ + sizeof(T) > data_.size()) {
+				return false;
+			}
+			std::uint64_t value = 0;
+			for (std::size_t i = 0; i < sizeof(T); ++i) {
+				value |= static_cast<std::uint64_t>(static_cast<unsigned char>(data_[pos_ + i])) << (8 * i);
+			}
+			out = static_cast<T>(value);
+			pos_ += sizeof(T);
+			return true;
+		}
+
+		bool varint(std::uint64_t& out) {
+			out = 0;
+			for (int shift = 0; shift < 64 && pos_ < data_.size(); shift += 7) {
+				auto byte = static_cast<unsigned char>(data_[pos_++]);
+				out |= static_cast<std::uint64_t>(byte & 0x7F) << shift;
+				if (!(byte & 0x80)) {
+					return true;
+				}
+			}
+			return false;
+		}
+
+		bool bytes(std::size_t length, std::string_view& out) {
+			if (length > data_.size() - pos_) {
+				return false;
+			}
+			out = data_.substr(pos_, length);
+			pos_ += length;
+			return true;
+		}
+
+		[[nodiscard]] std::size_t pos() const {
+			return pos_;
+		}
+
+	 private:
+		std::string_view data_;
+		std::size_t pos_;
+	};
+
+	static Encoding encodingFor(pgsqlSchema::SqlType type) {
+		switch (type) {
+		case pgsqlSchema::SqlType::Serial:
+		case pgsqlSchema::SqlType::Integer:
+		case pgsqlSchema::SqlType::Date: return Encoding::DeltaVarint;
+		case pgsqlSchema::SqlType::Money:
+		case pgsqlSchema::SqlType::Timestamp: return Encoding::Varint;
+		case pgsqlSchema::SqlType::Boolean: return Encoding::Bitmap;
+		case pgsqlSchema::SqlType::Text: return Encoding::PlainText;
+		}
+		return Encoding::Varint;
+	}
+
+	static void appendBitmap(std::string& out, const std::vector<bool>& bits) {
+		std::size_t start = out.size();
+		out.append((bits.size() + 7) / 8, '\0');
+		for (std::size_t i = 0; i < bits.size(); ++i) {
+			if (bits[i]) {
+				out[start + i / 8] = static_cast<char>(out[start + i / 8] | (1 << (i % 8)));
+			}
+		}
+	}
+
+	bool SnapshotWriter::open(const std::string& path,
+	                          const std::vector<SnapshotColumn>& columns,
+	                          std::string& error,
+	                          std::size_t blockRows) {
+		file_.close();
+		file_.clear();
+		file_.open(path, std::ios::binary | std::ios::trunc);
+		if (!file_) {
+			error = "cannot create " + path;
+			return false;
+		}
+
+		blockRows_ = std::max<std::size_t>(blockRows, 1);
+		columns_.clear();
+		blockOffsets_.clear();
+		pending_ = 0;
+		rows_ = 0;
+		offset_ = 0;
+		std::string header(kHeaderMagic, kMagicSize);
+		putU32(header, static_cast<std::uint32_t>(columns.size()));
+		for (const SnapshotColumn& column : columns) {
+			header += static_cast<char>(column.type);
+			putU16(header, static_cast<std::uint16_t>(column.name.size()));
+			header += column.name;
+
+			ColumnBuffer buffer;
+			buffer.type = column.type;
+			buffer.nulls.reserve(blockRows_);
+			if (column.type == pgsqlSchema::SqlType::Text) {
+				buffer.texts.reserve(blockRows_);
+			}
+			else {
+				buffer.ints.reserve(blockRows_);
+			}
+			columns_.push_back(std::move(buffer));
+		}
+		return write(header, error);
+	}
+
+	void SnapshotWriter::appendNull(std::size_t column) {
+		columns_[column].nulls.push_back(true);
+	}
+
+	void SnapshotWriter::appendInt(std::size_t column, std::int64_t value) {
+		columns_[column].nulls.push_back(false);
+		columns_[column].ints.push_back(value);
+	}
+
+	void SnapshotWriter::appendText(std::size_t column, std::string_view value) {
+		ColumnBuffer& buffer = columns_[column];
+		buffer.nulls.push_back(false);
+		if (buffer.textCount == buffer.texts.size()) {
+			buffer.texts.emplace_back();
+		}
+		buffer.texts[buffer.textCount++].assign(value); // Keeps the string's capacity from earlier blocks
+	}
+
+	bool SnapshotWriter::endRow(std::string& error) {
+		++rows_;
+		return ++pending_ < blockRows_ || flushBlock(error);
+	}
+
+	bool SnapshotWriter::write(const std::string& bytes, std::string& error) {
+		file_.write(bytes.data(), static_cast<std::streamsize>(bytes.size()));
+		if (!file_) {
+			error = "write failed";
+			return false;
+		}
+		offset_ += bytes.size();
+		return true;
+	}
+
+	void SnapshotWriter::encodeColumn(const ColumnBuffer& column, std::string& out) {
+		Encoding encoding = encodingFor(column.type);
+		std::unordered_map<std::string_view, std::uint32_t> dictionary;
+		std::vector<std::string_view> entries;
+		if (encoding == Encoding::PlainText) {
+			for (std::size_t i = 0; i < column.textCount && dictionary.size() <= kMaxDictionaryEntries; ++i) {
+				if (dictionary.emplace(column.texts[i], static_cast<std::uint32_t>(entries.size())).second) {
+					entries.push_back(column.texts[i]);
+				}
+			}
+			if (dictionary.size() <= kMaxDictionaryEntries && dictionary.size() * 2 <= column.textCount) {
+				encoding = Encoding::DictionaryText;
+			}
+		}
+
+		out += static_cast<char>(encoding);
+		appendBitmap(out, column.nulls);
+		switch (encoding) {
+		case Encoding::Varint:
+			for (std::int64_t value : column.ints) {
+				putVarint(out, zigzag(value));
+			}
+			break;
+		case Encoding::DeltaVarint: {
+			std::int64_t previous = 0;
+			for (std::int64_t value : column.ints) {
+				putVarint(out, zigzag(value - previous));
+				previous = value;
+			}
+			break;
+		}
+		case Encoding::Bitmap: {
+			std::vector<bool> bits;
+			bits.reserve(column.ints.size());
+			for (std::int64_t value : column.ints) {
+				bits.push_back(value != 0);
+			}
+			appendBitmap(out, bits);
+			break;
+		}
+		case Encoding::PlainText:
+			for (std::size_t i = 0; i < column.textCount; ++i) {
+				putVarint(out, column.texts[i].size());
+				out += column.texts[i];
+			}
+			break;
+		case Encoding::DictionaryText:
+			putVarint(out, entries.size());
+			for (std::string_view entry : entries) {
+				putVarint(out, entry.size());
+				out += entry;
+			}
+			for (std::size_t i = 0; i < column.textCount; ++i) {
+				putVarint(out, dictionary.at(column.texts[i]));
+			}
+			break;
+		}
+	}
+
+	bool SnapshotWriter::flushBlock(std::string& error) {
+		if (pending_ == 0) {
+			return true;
+		}
+
+		blockOffsets_.push_back(offset_);
+		scratch_.clear();
+		putU32(scratch_, static_cast<std::uint32_t>(pending_));
+		for (ColumnBuffer& column : columns_) {
+			std::size_t lengthAt = scratch_.size();
+			putU32(scratch_, 0); // Patched below
+			encodeColumn(column, scratch_);
+			auto length = static_cast<std::uint32_t>(scratch_.size() - lengthAt - 4);
+			for (int i = 0; i < 4; ++i) {
+				scratch_[lengthAt + i] = static_cast<char>((length >> (8 * i)) & 0xFF);
+			}
+
+			column.nulls.clear();
+			column.ints.clear();
+			column.textCount = 0;
+		}
+		pending_ = 0;
+		return write(scratch_, error);
+	}
+
+	bool SnapshotWriter::finish(std::string& error) {
+		if (!flushBlock(error)) {
+			return false;
+		}
+
+		std::string footer;
+		for (std::uint64_t blockOffset : blockOffsets_) {
+			putU64(footer, blockOffset);
+		}
+		putU64(footer, blockOffsets_.size());
+		putU64(footer, rows_);
+		footer.append(kFooterMagic, kMagicSize);
+		if (!write(footer, error)) {
+			return false;
+		}
+		file_.close();
+		if (!file_) {
+			error = "close failed";
+			return false;
+		}
+		return true;
+	}
+
+	bool SnapshotReader::open(const std::string& path, std::string& error) {
+		columns_.clear();
+		blockOffsets_.clear();
+		if (!file_.open(path, error)) {
+			return false;
+		}
+
+		std::string_view data = file_.data();
+		if (data.size() < kMagicSize + 4 + kFooterSize || data.substr(0, kMagicSize) != kHeaderMagic
+		    || data.substr(data.size() - kMagicSize) != kFooterMagic)
+		{
+			error = path + ": not a snapshot file";
+			return false;
+		}
+
+		Cursor header(data, kMagicSize);
+		std::uint32_t columnCount = 0;
+		header.fixed(columnCount);
+		for (std::uint32_t i = 0; i < columnCount; ++i) {
+			std::uint8_t type = 0;
+			std::uint16_t nameLength = 0;
+			std::string_view name;
+			if (!header.u8(type) || !header.fixed(nameLength) || !header.bytes(nameLength, name)
+			    || type > static_cast<std::uint8_t>(pgsqlSchema::SqlType::Timestamp))
+			{
+				error = path + ": corrupt header";
+				return false;
+			}
+			columns_.push_back({std::string(name), static_cast<pgsqlSchema::SqlType>(type)});
+		}
+
+		Cursor footer(data, data.size() - kFooterSize);
+		std::uint64_t blockCount = 0;
+		footer.fixed(blockCount);
+		footer.fixed(rows_);
+		if (blockCount > (data.size() - kFooterSize - header.pos()) / 8) {
+			error = path + ": corrupt footer";
+			return false;
+		}
+		dataEnd_ = data.size() - kFooterSize - blockCount * 8;
+		Cursor index(data, dataEnd_);
+		for (std::uint64_t i = 0; i < blockCount; ++i) {
+			std::uint64_t blockOffset = 0;
+			index.fixed(blockOffset);
+			if (blockOffset < header.pos() || blockOffset >= dataEnd_) {
+				error = path + ": corrupt block index";
+				return false;
+			}
+			blockOffsets_.push_back(blockOffset);
+		}
+		return true;
+	}
+
+	int SnapshotReader::columnIndex(const std::string& name) const {
+		for (std::size_t i = 0; i < columns_.size(); ++i) {
+			if (columns_[i].name == name) {
+				return static_cast<int>(i);
+			}
+		}
+		return -1;
+	}
+
+	static bool readBitmap(Cursor& cursor, std::size_t count, std::vector<bool>& bits) {
+		std::string_view bytes;
+		if (!cursor.bytes((count + 7) / 8, bytes)) {
+			return false;
+		}
+		bits.resize(count);
+		for (std::size_t i = 0; i < count; ++i) {
+			bits[i] = (static_cast<unsigned char>(bytes[i / 8]) >> (i % 8)) & 1;
+		}
+		return true;
+	}
+
+	static bool readText(Cursor& cursor, std::string_view& out) {
+		std::uint64_t length = 0;
+		return cursor.varint(length) && cursor.bytes(length, out);
+	}
+
+	// Values of the non-NULL rows, spread over all rows of the block
+	static bool decodeValues(Cursor& cursor, Encoding encoding, ColumnBlock& out) {
+		std::size_t count = out.nulls.size();
+		std::int64_t previous = 0;
+		std::vector<bool> bits;
+		std::vector<std::string_view> entries;
+
+		std::size_t present = static_cast<std::size_t>(std::count(out.nulls.begin(), out.nulls.end(), false));
+		if (encoding == Encoding::Bitmap && !readBitmap(cursor, present, bits)) {
+			return false;
+		}
+		if (encoding == Encoding::DictionaryText) {
+			std::uint64_t entryCount = 0;
+			if (!cursor.varint(entryCount) || entryCount > kMaxDictionaryEntries) {
+				return false;
+			}
+			entries.resize(entryCount);
+			for (std::string_view& entry : entries) {
+				if (!readText(cursor, entry)) {
+					return false;
+				}
+			}
+		}
+
+		if (encoding == Encoding::PlainText || encoding == Encoding::DictionaryText) {
+			out.texts.assign(count, std::string_view());
+		}
+		else {
+			out.ints.assign(count, 0);
+		}
+
+		std::size_t next = 0; // Index among the non-NULL values
+		for (std::size_t row = 0; row < count; ++row) {
+			if (out.nulls[row]) {
+				continue;
+			}
+			std::uint64_t raw = 0;
+			switch (encoding) {
+			case Encoding::Varint:
+				if (!cursor.varint(raw)) {
+					return false;
+				}
+				out.ints[row] = unzigzag(raw);
+				break;
+			case Encoding::DeltaVarint:
+				if (!cursor.varint(raw)) {
+					return false;
+				}
+				previous += unzigzag(raw);
+				out.ints[row] = previous;
+				break;
+			case Encoding::Bitmap: out.ints[row] = bits[next] ? 1 : 0; break;
+			case Encoding::PlainText:
+				if (!readText(cursor, out.texts[row])) {
+					return false;
+				}
+				break;
+			case Encoding::DictionaryText:
+				if (!cursor.varint(raw) || raw >= entries.size()) {
+					return false;
+				}
+				out.texts[row] = entries[raw];
+				break;
+			}
+			++next;
+		}
+		return true;
+	}
+
+	bool SnapshotReader::readColumn(std::size_t block,
+	                                std::size_t column,
+	                                ColumnBlock& out,
+	                                std::string& error) const {
+		if (block >= blockOffsets_.size() || column >= columns_.size()) {
+			error = "block or column out of range";
+			return false;
+		}
+
+		Cursor cursor(file_.data().substr(0, dataEnd_), blockOffsets_[block]);
+		std::uint32_t rowCount = 0;
+		if (!cursor.fixed(rowCount)) {
+			error = "truncated block";
+			return false;
+		}
+
+		// Skip the payloads of the columns before this one
+		std::uint32_t length = 0;
+		for (std::size_t i = 0; i <= column; ++i) {
+			std::string_view skipped;
+			if (!cursor.fixed(length) || (i < column && !cursor.bytes(length, skipped))) {
+				error = "truncated block";
+				return false;
+			}
+		}
+
+		std::string_view payload;
+		std::uint8_t encoding = 0;
+		if (!cursor.bytes(length, payload)) {
+			error = "truncated column";
+			return false;
+		}
+		Cursor values(payload);
+		out.ints.clear();
+		out.texts.clear();
+		if (!values.u8(encoding) || encoding > static_cast<std::uint8_t>(Encoding::DictionaryText)
+		    || !readBitmap(values, rowCount, out.nulls)
+		    || !decodeValues(values, static_cast<Encoding>(encoding), out))
+		{
+			error = "corrupt column " + columns_[column].name + " in block " + std::to_string(block);
+			return false;
+		}
+		out.encoding = static_cast<Encoding>(encoding);
+		return true;
+	}
+
+	void SnapshotReader::summarize(std::ostream& out) const {
+		out << rows_ << " rows in " << blockOffsets_.size() << " blocks, " << file_.data().size() << " bytes"
+		    << std::endl;
+
+		ColumnBlock block;
+		std::string error;
+		for (std::size_t column = 0; column < columns_.size(); ++column) {
+			std::uint64_t nulls = 0;
+			std::int64_t min = std::numeric_limits<std::int64_t>::max();
+			std::int64_t max = std::numeric_limits<std::int64_t>::min();
+			std::unordered_set<std::string_view> distinct;
+			bool dictionary = true;
+			bool text = columns_[column].type == pgsqlSchema::SqlType::Text;
+
+			for (std::size_t b = 0; b < blockOffsets_.size(); ++b) {
+				if (!readColumn(b, column, block, error)) {
+					out << "  " << columns_[column].name << ": " << error << std::endl;
+					return;
+				}
+				dictionary = dictionary && block.encoding == Encoding::DictionaryText;
+				for (std::size_t row = 0; row < block.nulls.size(); ++row) {
+					if (block.nulls[row]) {
+						++nulls;
+					}
+					else if (text) {
+						if (dictionary) {
+							distinct.insert(block.texts[row]);
+						}
+					}
+					else {
+						min = std::min(min, block.ints[row]);
+						max = std::max(max, block.ints[row]);
+					}
+				}
+			}
+
+			out << "  " << std::left << std::setw(16) << columns_[column].name << std::right << " nulls " << nulls;
+			if (!text && min <= max) {
+				out << ", min " << min << ", max " << max;
+			}
+			else if (text && dictionary && !blockOffsets_.empty()) {
+				out << ", " << distinct.size() << " distinct (dictionary)";
+			}
+			out << std::endl;
+		}
+	}
+
+	void ExportStats::print(std::ostream& out) const {
+		if (!ok) {
+			out << table << ": export failed: " << error << std::endl;
+			return;
+		}
+		double ratio = bytesOut > 0 ? static_cast<double>(bytesIn) / static_cast<double>(bytesOut) : 0.0;
+		out << table << ": " << rows << " rows in " << blocks << " blocks, " << std::fixed << std::setprecision(3)
+		    << seconds << " s; " << bytesIn << " COPY bytes -> " << bytesOut << " file bytes ("
+		    << std::setprecision(1) << ratio << "x)" << std::endl;
+	}
+
+	static std::uint32_t readBigEndian32(const char* data) {
+		auto bytes = reinterpret_cast<const unsigned char*>(data);
+		return (static_cast<std::uint32_t>(bytes[0]) << 24) | (static_cast<std::uint32_t>(bytes[1]) << 16)
+		       | (static_cast<std::uint32_t>(bytes[2]) << 8) | static_cast<std::uint32_t>(bytes[3]);
+	}
+
+	// Appends one binary COPY tuple to the writer; false on anything that does not match the columns
+	static bool appendTuple(std::string_view tuple,
+	                        const std::vector<SnapshotColumn>& columns,
+	                        SnapshotWriter& writer,
+	                        std::string& error) {
+		auto fieldCount = [&]() {
+			return static_cast<std::size_t>((static_cast<unsigned char>(tuple[0]) << 8)
+			                                | static_cast<unsigned char>(tuple[1]));
+		};
+		if (tuple.size() < 2 || fieldCount() != columns.size()) {
+			error = "unexpected field count in COPY data";
+			return false;
+		}
+
+		std::size_t pos = 2;
+		for (std::size_t column = 0; column < columns.size(); ++column) {
+			if (pos + 4 > tuple.size()) {
+				error = "truncated COPY tuple";
+				return false;
+			}
+			auto length = static_cast<std::int32_t>(readBigEndian32(tuple.data() + pos));
+			pos += 4;
+			if (length < 0) {
+				writer.appendNull(column);
+				continue;
+			}
+			if (pos + static_cast<std::size_t>(length) > tuple.size()) {
+				error = "truncated COPY tuple";
+				return false;
+			}
+			std::string_view bytes = tuple.substr(pos, static_cast<std::size_t>(length));
+			pos += static_cast<std::size_t>(length);
+
+			bool decoded = true;
+			switch (columns[column].type) {
+			case pgsqlSchema::SqlType::Serial:
+			case pgsqlSchema::SqlType::Integer:
+			case pgsqlSchema::SqlType::Date: {
+				std::int32_t value = 0;
+				decoded = pgsqlBinary::decodeInt4(bytes, value);
+				writer.appendInt(column, value);
+				break;
+			}
+			case pgsqlSchema::SqlType::Money: {
+				std::int64_t cents = 0;
+				decoded = pgsqlBinary::decodeNumeric(bytes, 2, cents);
+				writer.appendInt(column, cents);
+				break;
+			}
+			case pgsqlSchema::SqlType::Boolean: {
+				bool value = false;
+				decoded = pgsqlBinary::decodeBool(bytes, value);
+				writer.appendInt(column, value ? 1 : 0);
+				break;
+			}
+			case pgsqlSchema::SqlType::Timestamp: {
+				std::int64_t micros = 0;
+				decoded = pgsqlBinary::decodeTimestamp(bytes, micros);
+				writer.appendInt(column, micros);
+				break;
+			}
+			case pgsqlSchema::SqlType::Text: writer.appendText(column, bytes); break;
+			}
+			if (!decoded) {
+				error = "cannot decode column " + columns[column].name;
+				return false;
+			}
+		}
+		return true;
+	}
+
+	ExportStats exportSnapshot(PGconn* conn,
+	                           const std::string& table,
+	                           const std::vector<SnapshotColumn>& columns,
+	                           const std::string& path,
+	                           std::size_t blockRows,
+	                           const std::string& where) {
+		ExportStats stats;
+		stats.table = table;
+		auto start = std::chrono::steady_clock::now();
+
+		SnapshotWriter writer;
+		if (!writer.open(path, columns, stats.error, blockRows)) {
+			return stats;
+		}
+
+		std::string sql = "COPY (SELECT ";
+		for (std::size_t i = 0; i < columns.size(); ++i) {
+			sql += (i ? ", " : "") + columns[i].name;
+		}
+		sql += " FROM " + table + (where.empty() ? "" : " WHERE " + where) + ") TO STDOUT (FORMAT binary)";
+		pgsqlHandles::PgResult copy = pgsqlHandles::PgResult::exec(conn, sql.c_str());
+		if (copy.status() != PGRES_COPY_OUT) {
+			stats.error = copy.errorMessage();
+			return stats;
+		}
+
+		// The first message starts with the PGCOPY signature, flags and header extension; the last one
+		// is the -1 trailer. Every other message is exactly one tuple.
+		bool ok = true;
+		bool headerSeen = false;
+		char* message = nullptr;
+		int length = 0;
+		while ((length = PQgetCopyData(conn, &message, 0)) > 0) {
+			std::string_view data(message, static_cast<std::size_t>(length));
+			stats.bytesIn += data.size();
+			if (ok && !headerSeen) {
+				constexpr std::size_t kSignatureSize = 11;
+				if (data.size() < kSignatureSize + 8) {
+					stats.error = "truncated COPY header";
+					ok = false;
+				}
+				else {
+					std::size_t extension = readBigEndian32(data.data() + kSignatureSize + 4);
+					data.remove_prefix(std::min(data.size(), kSignatureSize + 8 + extension));
+					headerSeen = true;
+				}
+			}
+			bool trailer = data.size() == 2 && data[0] == '\xff' && data[1] == '\xff';
+			if (ok && !data.empty() && !trailer) {
+				// Keep draining after a failure so the connection ends the COPY cleanly
+				ok = appendTuple(data, columns, writer, stats.error) && writer.endRow(stats.error);
+			}
+			PQfreemem(message);
+		}
+
+		if (length == -2) {
+			stats.error = PQerrorMessage(conn);
+			ok = false;
+		}
+		for (PGresult* raw = PQgetResult(conn); raw; raw = PQgetResult(conn)) {
+			pgsqlHandles::PgResult res(raw);
+			if (res.status() != PGRES_COMMAND_OK && ok) {
+				stats.error = res.errorMessage();
+				ok = false;
+			}
+		}
+
+		ok = ok && writer.finish(stats.error);
+		stats.ok = ok;
+		stats.rows = writer.rows();
+		stats.blocks = writer.blocks();
+		stats.bytesOut = writer.bytesWritten();
+		stats.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+		return stats;
+	}
+
+	ExportStats exportStoreTable(PGconn* conn, const std::string& tableName, const std::string& path) {
+		ExportStats stats;
+		stats.table = tableName;
+		stats.error = "unknown table";
+		bool found = false;
+		pgsqlSchema::forEachTable<pgsqlSchema::PetstoreTables>([&](auto table) {
+			using Table = decltype(table);
+			std::string_view name = Table::name;
+			auto sameLetter = [](unsigned char a, unsigned char b) { return std::tolower(a) == std::tolower(b); };
+			bool same =
+			    name.size() == tableName.size() && std::equal(name.begin(), name.end(), tableName.begin(), sameLetter);
+			if (same && !found) {
+				found = true;
+				stats = exportTable<Table>(conn, path);
+			}
+		});
+		return stats;
+	}
+
+	void appendCopyTuple(const std::vector<SnapshotColumn>& columns,
+	                     const std::vector<ColumnBlock>& blocks,
+	                     std::size_t row,
+	                     std::string& out) {
+		pgsqlBinary::encodeInt2(out, static_cast<std::int16_t>(columns.size()));
+		for (std::size_t column = 0; column < columns.size(); ++column) {
+			const ColumnBlock& block = blocks[column];
+			if (block.nulls[row]) {
+				pgsqlBinary::encodeInt4(out, -1);
+				continue;
+			}
+			std::size_t lengthAt = out.size();
+			out.append(4, '\0'); // Patched once the value is written
+			switch (columns[column].type) {
+			case pgsqlSchema::SqlType::Serial:
+			case pgsqlSchema::SqlType::Integer:
+				pgsqlBinary::encodeInt4(out, static_cast<std::int32_t>(block.ints[row]));
+				break;
+			case pgsqlSchema::SqlType::Date:
+				pgsqlBinary::encodeDate(out, static_cast<std::int32_t>(block.ints[row]));
+				break;
+			case pgsqlSchema::SqlType::Money: pgsqlBinary::encodeNumeric(out, block.ints[row], 2); break;
+			case pgsqlSchema::SqlType::Boolean: pgsqlBinary::encodeBool(out, block.ints[row] != 0); break;
+			case pgsqlSchema::SqlType::Timestamp: pgsqlBinary::encodeTimestamp(out, block.ints[row]); break;
+			case pgsqlSchema::SqlType::Text: out += block.texts[row]; break;
+			}
+			auto length = static_cast<std::uint32_t>(out.size() - lengthAt - 4);
+			for (int i = 0; i < 4; ++i) {
+				out[lengthAt + i] = static_cast<char>((length >> (24 - 8 * i)) & 0xFF);
+			}
+		}
+	}
+
+	pgsqlCopy::ImportStats importSnapshot(PGconn* conn,
+	                                      const std::string& table,
+	                                      const std::string& path,
+	                                      std::size_t bufferSize) {
+		pgsqlCopy::ImportStats stats;
+		stats.table = table;
+		auto start = std::chrono::steady_clock::now();
+
+		SnapshotReader reader;
+		if (!reader.open(path, stats.error)) {
+			return stats;
+		}
+		const std::vector<SnapshotColumn>& columns = reader.columns();
+		std::string columnList;
+		for (const SnapshotColumn& column : columns) {
+			columnList += (columnList.empty() ? "" : ", ") + column.name;
+		}
+
+		pgsqlCopy::BinaryCopyWriter writer(conn, bufferSize);
+		bool ok = writer.begin(table, columnList, stats.error);
+		std::vector<ColumnBlock> blocks(columns.size());
+		for (std::size_t block = 0; ok && block < reader.blocks(); ++block) {
+			for (std::size_t column = 0; ok && column < columns.size(); ++column) {
+				ok = reader.readColumn(block, column, blocks[column], stats.error);
+			}
+			std::size_t rows = ok && !blocks.empty() ? blocks[0].nulls.size() : 0;
+			for (std::size_t row = 0; ok && row < rows; ++row) {
+				appendCopyTuple(columns, blocks, row, writer.buffer());
+				ok = writer.rowWritten(stats.error);
+			}
+		}
+		ok = ok && writer.finish(stats.rows, stats.error);
+		if (ok && stats.rows != reader.rows()) {
+			stats.error = "stored " + std::to_string(stats.rows) + " of " + std::to_string(reader.rows()) + " rows";
+			ok = false;
+		}
+
+		stats.ok = ok;
+		stats.bytes = writer.bytesSent();
+		stats.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+		return stats;
+	}
+} // namespace pgsqlSnapshot
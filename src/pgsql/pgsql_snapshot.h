@@ -0,0 +1,188 @@
+#ifndef PGSQL_SNAPSHOT_H
+#define PGSQL_SNAPSHOT_H
+
+#include "libpq-fe.h"
+#include "pgsql_copy.h"
+#include "pgsql_schema.h"
+#include <cstddef>
+#include <cstdint>
+#include <fstream>
+#include <iosfwd>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace pgsqlSnapshot {
+
+	// Columnar snapshot file, all integers little-endian:
+	//   header  "PETSNAP1", u32 column count, per column: u8 SqlType, u16 name length, name
+	//   blocks  u32 row count, then per column: u32 payload length, payload
+	//   footer  u64 offset of every block, u64 block count, u64 row count, "PETSNAPE"
+	// A column payload is a u8 Encoding, a null bitmap (bit set = NULL) and the non-NULL values.
+	enum class Encoding : std::uint8_t {
+		Varint = 0, // Zigzag varints (Money, Timestamp)
+		DeltaVarint = 1, // Zigzag varints of the difference to the previous value (ids, dates)
+		Bitmap = 2, // One bit per value (Boolean)
+		PlainText = 3, // Varint length + bytes per value
+		DictionaryText = 4, // Varint entry count, the entries as PlainText, then a varint index per value
+	};
+
+	struct SnapshotColumn {
+		std::string name;
+		pgsqlSchema::SqlType type;
+	};
+
+	// Every column of a table descriptor
+	template<typename Table>
+	std::vector<SnapshotColumn> snapshotColumns() {
+		std::vector<SnapshotColumn> columns;
+		std::apply([&](const auto&... column) { (columns.push_back({column.name, column.type}), ...); },
+		           Table::columns);
+		return columns;
+	}
+
+	// Writes rows column by column. Only the current block is held in memory, so the writer's footprint
+	// is bounded by blockRows no matter how many rows pass through it.
+	class SnapshotWriter {
+	 public:
+		bool open(const std::string& path,
+		          const std::vector<SnapshotColumn>& columns,
+		          std::string& error,
+		          std::size_t blockRows = 65536);
+
+		// One call per column of the row, in column order, then endRow(). Integers cover Serial,
+		// Integer, Date (days since 2000-01-01), Money (cents), Boolean (0 / 1) and Timestamp
+		// (microseconds since 2000-01-01).
+		void appendNull(std::size_t column);
+		void appendInt(std::size_t column, std::int64_t value);
+		void appendText(std::size_t column, std::string_view value);
+		bool endRow(std::string& error);
+
+		// Writes the last block and the footer
+		bool finish(std::string& error);
+
+		[[nodiscard]] std::uint64_t rows() const {
+			return rows_;
+		}
+
+		[[nodiscard]] std::size_t blocks() const {
+			return blockOffsets_.size();
+		}
+
+		[[nodiscard]] std::uint64_t bytesWritten() const {
+			return offset_;
+		}
+
+	 private:
+		struct ColumnBuffer {
+			pgsqlSchema::SqlType type;
+			std::vector<bool> nulls;
+			std::vector<std::int64_t> ints;
+			std::vector<std::string> texts;
+			std::size_t textCount = 0; // texts is reused across blocks; only the first textCount are live
+		};
+
+		bool write(const std::string& bytes, std::string& error);
+		bool flushBlock(std::string& error);
+		static void encodeColumn(const ColumnBuffer& column, std::string& out);
+
+		std::ofstream file_;
+		std::vector<ColumnBuffer> columns_;
+		std::size_t blockRows_ = 0;
+		std::size_t pending_ = 0; // Rows in the current block
+		std::uint64_t rows_ = 0;
+		std::uint64_t offset_ = 0;
+		std::vector<std::uint64_t> blockOffsets_;
+		std::string scratch_;
+	};
+
+	// One decoded column of one block. Text views point into the mapped file and stay valid while
+	// the reader is open; NULL rows hold 0 / an empty view.
+	struct ColumnBlock {
+		std::vector<bool> nulls;
+		std::vector<std::int64_t> ints;
+		std::vector<std::string_view> texts;
+		Encoding encoding = Encoding::Varint;
+	};
+
+	// Memory-maps a snapshot and decodes single columns of single blocks on demand
+	class SnapshotReader {
+	 public:
+		bool open(const std::string& path, std::string& error);
+
+		[[nodiscard]] const std::vector<SnapshotColumn>& columns() const {
+			return columns_;
+		}
+
+		[[nodiscard]] std::uint64_t rows() const {
+			return rows_;
+		}
+
+		[[nodiscard]] std::size_t blocks() const {
+			return blockOffsets_.size();
+		}
+
+		// Index of a column by name, or -1
+		[[nodiscard]] int columnIndex(const std::string& name) const;
+
+		bool readColumn(std::size_t block, std::size_t column, ColumnBlock& out, std::string& error) const;
+
+		// Per column: NULL count, min / max of numbers, distinct values of dictionary text
+		void summarize(std::ostream& out) const;
+
+	 private:
+		pgsqlCopy::MappedFile file_;
+		std::vector<SnapshotColumn> columns_;
+		std::vector<std::uint64_t> blockOffsets_;
+		std::uint64_t rows_ = 0;
+		std::uint64_t dataEnd_ = 0; // Where the footer starts
+	};
+
+	struct ExportStats {
+		std::string table;
+		bool ok = false;
+		std::uint64_t rows = 0;
+		std::size_t blocks = 0;
+		std::uint64_t bytesIn = 0; // COPY data received
+		std::uint64_t bytesOut = 0; // Snapshot file size
+		double seconds = 0;
+		std::string error;
+
+		void print(std::ostream& out) const;
+	};
+
+	// Streams table with COPY (SELECT ...) TO STDOUT (FORMAT binary) into a snapshot file, one COPY row
+	// at a time. The SELECT form also works for partitioned parents, which plain COPY TO refuses.
+	// A non-empty where (without the keyword) exports only the matching rows.
+	ExportStats exportSnapshot(PGconn* conn,
+	                           const std::string& table,
+	                           const std::vector<SnapshotColumn>& columns,
+	                           const std::string& path,
+	                           std::size_t blockRows = 65536,
+	                           const std::string& where = "");
+
+	template<typename Table>
+	ExportStats exportTable(PGconn* conn, const std::string& path, std::size_t blockRows = 65536) {
+		return exportSnapshot(conn, Table::name, snapshotColumns<Table>(), path, blockRows);
+	}
+
+	// Any of the seven store tables by name (case-insensitive)
+	ExportStats exportStoreTable(PGconn* conn, const std::string& tableName, const std::string& path);
+
+	// Appends row of a decoded block (one ColumnBlock per column) as a binary COPY tuple; the inverse
+	// of what exportSnapshot reads, so the bytes match what the server sent
+	void appendCopyTuple(const std::vector<SnapshotColumn>& columns,
+	                     const std::vector<ColumnBlock>& blocks,
+	                     std::size_t row,
+	                     std::string& out);
+
+	// Loads a snapshot file back into table with COPY ... FROM STDIN (FORMAT binary), block by block.
+	// Every column of the snapshot is written, ids included; the id sequence is left alone.
+	pgsqlCopy::ImportStats importSnapshot(PGconn* conn,
+	                                      const std::string& table,
+	                                      const std::string& path,
+	                                      std::size_t bufferSize = 256 * 1024);
+
+} // namespace pgsqlSnapshot
+
+#endif // PGSQL_SNAPSHOT_H
@@ -0,0 +1,107 @@
+#include "pgsql_stream.h"
+
+#include <chrono>
+
+namespace pgsqlStream {
+	using Clock = std::chrono::steady_clock;
+
+	static double secondsSince(Clock::time_point start) {
+		return std::chrono::duration<double>(Clock::now() - start).count();
+	}
+
+	static bool enableRowMode(PGconn* conn, int chunkRows) {
+#ifdef LIBPQ_HAS_CHUNK_MODE
+		if (chunkRows > 1) {
+			return PQsetChunkedRowsMode(conn, chunkRows) == 1;
+		}
+#else
+		(void)chunkRows;
+#endif
+		return PQsetSingleRowMode(conn) == 1;
+	}
+
+	static bool isRowBatch(ExecStatusType status) {
+#ifdef LIBPQ_HAS_CHUNK_MODE
+		if (status == PGRES_TUPLES_CHUNK) {
+			return true;
+		}
+#endif
+		return status == PGRES_SINGLE_TUPLE;
+	}
+
+	void consumeResult(const pgsqlHandles::PgResult& batch,
+	                   const RowCallback& onRow,
+	                   double elapsedSeconds,
+	                   StreamResult& result,
+	                   bool& finished) {
+		ExecStatusType status = batch.status();
+		if (!isRowBatch(status) && status != PGRES_TUPLES_OK) {
+			if (status == PGRES_COMMAND_OK) {
+				finished = true;
+			}
+			else if (result.error.empty()) {
+				const char* message = batch.errorMessage();
+				result.error = *message ? message : PQresStatus(status);
+			}
+			return;
+		}
+
+		// The terminating TUPLES_OK of a streamed query has no rows
+		if (status == PGRES_TUPLES_OK) {
+			finished = true;
+		}
+		if (result.stopped || !result.error.empty()) {
+			return;
+		}
+		for (pgsqlHandles::RowView row : batch) {
+			if (result.rows++ == 0) {
+				result.firstRowSeconds = elapsedSeconds;
+			}
+			if (!onRow(row)) {
+				result.stopped = true;
+				break;
+			}
+		}
+	}
+
+	StreamResult streamQuery(PGconn* conn,
+	                         const char* sql,
+	                         const std::vector<std::string>& params,
+	                         const RowCallback& onRow,
+	                         const StreamOptions& options) {
+		StreamResult result;
+		std::vector<const char*> values;
+		values.reserve(params.size());
+		for (const std::string& param : params) {
+			values.push_back(param.c_str());
+		}
+
+		auto start = Clock::now();
+		if (!PQsendQueryParams(conn,
+		                       sql,
+		                       static_cast<int>(values.size()),
+		                       nullptr,
+		                       values.data(),
+		                       nullptr,
+		                       nullptr,
+		                       options.resultFormat))
+		{
+			result.error = PQerrorMessage(conn);
+			return result;
+		}
+
+		// Without row mode the whole result arrives as one TUPLES_OK, which consumeResult delivers too
+		result.buffered = !enableRowMode(conn, options.chunkRows);
+
+		// Read until PQgetResult returns null, even after an error or early stop. Rows after a stop
+		// are discarded rather than cancelled: a cancel request can land on the next query instead.
+		bool finished = false;
+		while (PGresult* raw = PQgetResult(conn)) {
+			consumeResult(pgsqlHandles::PgResult(raw), onRow, secondsSince(start), result, finished);
+		}
+
+		result.totalSeconds = secondsSince(start);
+		result.ok = finished && result.error.empty();
+		return result;
+	}
+} // namespace pgsqlStream
@@ -0,0 +1,59 @@
+#ifndef PGSQL_STREAM_H
+#define PGSQL_STREAM_H
+
+#include "libpq-fe.h"
+#include "pgsql_handles.h"
+#include <cstddef>
+#include <functional>
+#include <string>
+#include <vector>
+
+namespace pgsqlStream {
+
+	// Called once per row; the view is only valid during the call. Return false to stop early.
+	using RowCallback = std::function<bool(const pgsqlHandles::RowView&)>;
+
+	struct StreamOptions {
+		// Rows per PGresult. 1 uses PQsetSingleRowMode; larger values use PQsetChunkedRowsMode when the
+		// libpq headers provide it (17+) and fall back to single-row mode otherwise.
+		int chunkRows = 1;
+		int resultFormat = 0; // 0 text, 1 binary
+	};
+
+	struct StreamResult {
+		bool ok = false;
+		bool stopped = false; // The callback returned false; remaining rows were discarded
+		bool buffered = false; // Row mode could not be enabled; the rows arrived as one complete result
+		std::size_t rows = 0; // Rows handed to the callback
+		double firstRowSeconds = 0; // From sending the query to the first row arriving
+		double totalSeconds = 0;
+		std::string error;
+	};
+
+	// Applies one PGresult of a streamed statement to result. Row batches go to onRow, and so do the
+	// rows of a TUPLES_OK, which only carries any when row mode was not enabled; TUPLES_OK and
+	// COMMAND_OK end the statement and set finished; any other status records its error. Rows are
+	// skipped once the callback stopped or an error was recorded.
+	void consumeResult(const pgsqlHandles::PgResult& batch,
+	                   const RowCallback& onRow,
+	                   double elapsedSeconds,
+	                   StreamResult& result,
+	                   bool& finished);
+
+	// Runs one statement and feeds its rows to onRow as they arrive, so memory stays bounded by
+	// chunkRows instead of the result size. If row mode cannot be enabled the rows are still
+	// delivered, from one buffered result (see StreamResult::buffered). The connection is idle again
+	// when this returns.
+	StreamResult streamQuery(PGconn* conn,
+	                         const char* sql,
+	                         const std::vector<std::string>& params,
+	                         const RowCallback& onRow,
+	                         const StreamOptions& options = {});
+
+	inline StreamResult streamQuery(PGconn* conn, const char* sql, const RowCallback& onRow) {
+		return streamQuery(conn, sql, {}, onRow);
+	}
+
+} // namespace pgsqlStream
+
+#endif // PGSQL_STREAM_H
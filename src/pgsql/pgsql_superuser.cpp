@@ -1,4 +1,8 @@
 #include "pgsql_superuser.h"
+#include "pgsql_handles.h"
+#include "pgsql_prepared.h"
+#include "pgsql_profiles.h"
+#include "pgsql_stream.h"
 
 #include "libpq-fe.h"
 #include <iostream>
@@ -6,70 +10,57 @@
 #include <string>
 
 namespace pgsqlSuperUser {
+	const pgsqlPrepared::PreparedStatement isSuperUserStatement{
+	    "superuser_is_superuser",
+	    "SELECT rolname FROM pg_roles WHERE rolname = $1 AND rolsuper = true;",
+	    {pgsqlPrepared::kTextOid}};
+
 	// Constructor: Initializes the connection string
 	PgSQLSuperUserManager::PgSQLSuperUserManager(const std::string& superUserName, const std::string& superUserPassword)
-	: connInfo_("dbname=postgres user=" + superUserName + " host=localhost port=5432"
-	            + (superUserPassword.empty() ? "" : " password=" + superUserPassword)) {}
-
-	// Destructor: Closes the connection if it's open
-	PgSQLSuperUserManager::~PgSQLSuperUserManager() {
-		if (conn_) {
-			PQfinish(conn_);
-		}
-	}
+	: connInfo_(pgsqlProfiles::ProfileRegistry::instance().conninfo("postgres", superUserName, superUserPassword)) {}
 
-	// Connects to the PostgreSQL database using the stored connection info
+	// Borrows a connection for the stored connection info from the shared pool
 	bool PgSQLSuperUserManager::connect() {
-		conn_ = PQconnectdb(connInfo_.c_str());
-		if (PQstatus(conn_) != CONNECTION_OK) {
-			std::cerr << "Connection to database failed: " << PQerrorMessage(conn_) << std::endl;
-			PQfinish(conn_);
-			conn_ = nullptr; // Reset connection pointer after failed connection
-			return false;
-		}
-		return true;
+		conn_ = pgsqlPool::PgConnectionPool::instance().acquire(connInfo_);
+		return static_cast<bool>(conn_);
 	}
 
 	// Lists all superusers in the PostgreSQL instance
 	void PgSQLSuperUserManager::listSuperUsers() const {
 		const char* query = "SELECT rolname FROM pg_roles WHERE rolsuper = true;";
-		PGresult* res = PQexec(conn_, query);
-
-		if (PQresultStatus(res) != PGRES_TUPLES_OK) {
-			std::cerr << "Failed to retrieve superusers: " << PQerrorMessage(conn_) << std::endl;
-
-			PQclear(res);
+		bool printedHeader = false;
+		pgsqlStream::StreamResult result =
+		    pgsqlStream::streamQuery(conn_.get(), query, [&printedHeader](const pgsqlHandles::RowView& row) {
+			    if (!printedHeader) {
+				    std::cout << "Superusers list:" << std::endl;
+				    printedHeader = true;
+			    }
+			    std::cout << "- " << row[0] << '\n';
+			    return true;
+		    });
+		std::cout.flush();
+
+		if (!result.ok) {
+			std::cerr << "Failed to retrieve superusers: " << result.error << std::endl;
 			return;
 		}
 
-		int rows = PQntuples(res);
-		if (rows == 0) {
+		if (result.rows == 0) {
 			std::cout << "No superusers found." << std::endl;
 		}
-		else {
-			std::cout << "Superusers list:" << std::endl;
-			for (int i = 0; i < rows; ++i) {
-				std::cout << "- " << PQgetvalue(res, i, 0) << std::endl;
-			}
-		}
-
-		PQclear(res);
 	}
 
 	// Checks if a specific user is a superuser
 	bool PgSQLSuperUserManager::isUserSuperUser(const std::string& superUserName) const {
-		std::string query = "SELECT rolname FROM pg_roles WHERE rolname = '" + superUserName + "' AND rolsuper = true;";
-		PGresult* res = PQexec(conn_, query.c_str());
+		pgsqlHandles::PgResult res =
+		    pgsqlPrepared::PreparedStatementRegistry::instance().execute(conn_.get(), isSuperUserStatement, superUserName);
 
-		if (PQresultStatus(res) != PGRES_TUPLES_OK) {
-			std::cerr << "Failed to check if user is superuser: " << PQerrorMessage(conn_) << std::endl;
-			PQclear(res);
+		if (res.status() != PGRES_TUPLES_OK) {
+			std::cerr << "Failed to check if user is superuser: " << PQerrorMessage(conn_.get()) << std::endl;
 			return false;
 		}
 
-		bool isSuperUser = PQntuples(res) > 0;
-		PQclear(res);
-		return isSuperUser;
+		return res.rows() > 0;
 	}
 
 	// Creates a new superuser
@@ -82,14 +73,12 @@ namespace pgsqlSuperUser {
 			createUserSQL += ";";
 		}
 
-		PGresult* res = PQexec(conn_, createUserSQL.c_str());
-		if (PQresultStatus(res) != PGRES_COMMAND_OK) {
-			std::cerr << "Failed to create superuser: " << PQerrorMessage(conn_) << std::endl;
-			PQclear(res);
+		pgsqlHandles::PgResult res = pgsqlHandles::PgResult::exec(conn_.get(), createUserSQL.c_str());
+		if (res.status() != PGRES_COMMAND_OK) {
+			std::cerr << "Failed to create superuser: " << PQerrorMessage(conn_.get()) << std::endl;
 			return false;
 		}
 
-		PQclear(res);
 		std::cout << "Superuser created successfully." << std::endl;
 		return true;
 	}
@@ -100,21 +89,19 @@ namespace pgsqlSuperUser {
 			return false;
 		}
 
-		if (superUserName == PQuser(conn_)) {
+		if (superUserName == PQuser(conn_.get())) {
 			std::cerr << "Error: You cannot drop yourself." << std::endl;
 			return false;
 		}
 
 		std::string dropUserSQL = "DROP ROLE IF EXISTS " + superUserName + ";";
-		PGresult* res = PQexec(conn_, dropUserSQL.c_str());
+		pgsqlHandles::PgResult res = pgsqlHandles::PgResult::exec(conn_.get(), dropUserSQL.c_str());
 
-		if (PQresultStatus(res) != PGRES_COMMAND_OK) {
-			std::cerr << "Failed to drop superuser: " << PQerrorMessage(conn_) << std::endl;
-			PQclear(res);
+		if (res.status() != PGRES_COMMAND_OK) {
+			std::cerr << "Failed to drop superuser: " << PQerrorMessage(conn_.get()) << std::endl;
 			return false;
 		}
 
-		PQclear(res);
 		std::cout << "Superuser '" << superUserName << "' dropped successfully." << std::endl;
 		return true;
 	}
@@ -140,13 +127,7 @@ namespace pgsqlSuperUser {
 		std::cout << "Enter superuser password (leave blank for no password): ";
 		std::getline(std::cin, superUserPassword);
 
-		std::string conninfo = "dbname=postgres user=" + superUserName;
-		if (!superUserPassword.empty()) {
-			conninfo += " password=" + superUserPassword;
-		}
-		conninfo += " host=localhost port=5432";
-
-		return conninfo;
+		return pgsqlProfiles::ProfileRegistry::instance().conninfo("postgres", superUserName, superUserPassword);
 	}
 
 	void sqlSuperUsersManagementMenu() {
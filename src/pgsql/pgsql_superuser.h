@@ -2,6 +2,7 @@
 #define PGSQL_SUPERUSER_H
 
 #include "libpq-fe.h"
+#include "pgsql_connection_pool.h"
 #include <iostream>
 #include <string>
 
@@ -13,10 +14,7 @@ namespace pgsqlSuperUser {
 		// Constructor: initializes the PostgreSQL connection info
 		PgSQLSuperUserManager(const std::string& superUserName, const std::string& superUserPassword);
 
-		// Destructor: destroys the connection
-		~PgSQLSuperUserManager();
-
-		// Connects to the PostgreSQL database
+		// Borrows a connection from the shared pool
 		bool connect();
 
 		// Lists all the superusers
@@ -32,7 +30,7 @@ namespace pgsqlSuperUser {
 		bool dropSuperUser(const std::string& superUserName) const;
 
 	 private:
-		PGconn* conn_ = nullptr; // PostgreSQL connection object
+		pgsqlPool::PooledConnection conn_; // Connection borrowed from the shared pool, returned on destruction
 		std::string connInfo_; // Connection string
 	};
 
@@ -0,0 +1,291 @@
+#include "pgsql_sync.h"
+#include "pgsql_handles.h"
+
+#include <algorithm>
+#include <cctype>
+#include <chrono>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <string_view>
+
+namespace pgsqlSync {
+	using Clock = std::chrono::steady_clock;
+
+	static double secondsSince(Clock::time_point start) {
+		return std::chrono::duration<double>(Clock::now() - start).count();
+	}
+
+	// New products start out of stock until the store receives goods; feeds describe the catalog only
+	static const char* const kStoreOwnedColumns[][3] = {{pgsqlSchema::Products::name, "stock", "0"}};
+
+	void markStoreOwned(SyncTable& table) {
+		for (const auto& owned : kStoreOwnedColumns) {
+			if (table.name != owned[0]) {
+				continue;
+			}
+			table.storeOwned.push_back({owned[1], owned[2]});
+			for (pgsqlCopy::CopyColumn& column : table.columns) {
+				column.notNull = column.notNull && column.name != table.storeOwned.back().name;
+			}
+		}
+	}
+
+	SyncTable feedTable(const SyncTable& table, const std::vector<std::string>& header) {
+		SyncTable feed{table.name, table.key, {}, table.storeOwned};
+		for (const pgsqlCopy::CopyColumn& column : table.columns) {
+			bool named = column.name == table.key || std::string_view(column.name) == "is_deleted";
+			for (const std::string& name : header) {
+				named = named || name == column.name;
+			}
+			if (named) {
+				feed.columns.push_back(column);
+			}
+		}
+		return feed;
+	}
+
+	// "prefix" + column, joined with ", ", optionally without the key
+	static std::string joinColumns(const SyncTable& table, const std::string& prefix, bool withKey) {
+		std::string joined;
+		for (const pgsqlCopy::CopyColumn& column : table.columns) {
+			if (withKey || column.name != table.key) {
+				joined += (joined.empty() ? "" : ", ") + prefix + column.name;
+			}
+		}
+		return joined;
+	}
+
+	std::string stagingTableName(const SyncTable& table) {
+		std::string name = "sync_" + table.name;
+		std::transform(name.begin(), name.end(), name.begin(), [](unsigned char c) {
+			return static_cast<char>(std::tolower(c));
+		});
+		return name;
+	}
+
+	static const StoreOwnedColumn* findStoreOwned(const SyncTable& table, std::string_view column) {
+		for (const StoreOwnedColumn& owned : table.storeOwned) {
+			if (owned.name == column) {
+				return &owned;
+			}
+		}
+		return nullptr;
+	}
+
+	// Staged value of a column; an empty store-owned cell falls back to fallback instead of writing NULL
+	static std::string stagedValue(const SyncTable& table,
+	                               const pgsqlCopy::CopyColumn& column,
+	                               const std::string& prefix,
+	                               const std::string& fallback) {
+		std::string value = prefix + column.name;
+		const StoreOwnedColumn* owned = findStoreOwned(table, column.name);
+		return owned ? "COALESCE(" + value + ", " + (fallback.empty() ? owned->initialValue : fallback) + ")" : value;
+	}
+
+	// Same columns and defaults as the target, minus the key's sequence default: a feed row missing its
+	// id must fail the COPY, not draw a fresh id from the live table's sequence. LIKE copies NOT NULL,
+	// which store-owned columns lose so a feed may leave them out or empty.
+	std::string createStagingSQL(const SyncTable& table) {
+		std::string staging = stagingTableName(table);
+		std::string sql = "CREATE TEMP TABLE " + staging + " (LIKE " + table.name + " INCLUDING DEFAULTS)";
+		sql += " ON COMMIT DROP; ";
+		sql += "ALTER TABLE " + staging + " ALTER COLUMN " + table.key + " DROP DEFAULT";
+		for (const StoreOwnedColumn& owned : table.storeOwned) {
+			sql += ", ALTER COLUMN " + owned.name + " DROP NOT NULL";
+		}
+		return sql + ";";
+	}
+
+	std::string duplicateKeySQL(const SyncTable& table) {
+		return "SELECT " + table.key + " FROM " + stagingTableName(table) + " GROUP BY " + table.key
+		       + " HAVING count(*) > 1 LIMIT 1;";
+	}
+
+	std::string updateChangedSQL(const SyncTable& table) {
+		std::string assignments;
+		std::string staged;
+		for (const pgsqlCopy::CopyColumn& column : table.columns) {
+			if (column.name != table.key) {
+				std::string value = stagedValue(table, column, "s.", std::string("t.") + column.name);
+				assignments += (assignments.empty() ? "" : ", ") + std::string(column.name) + " = " + value;
+				staged += (staged.empty() ? "" : ", ") + value;
+			}
+		}
+		return "UPDATE " + table.name + " AS t SET " + assignments + " FROM " + stagingTableName(table)
+		       + " AS s WHERE t." + table.key + " = s." + table.key + " AND (" + joinColumns(table, "t.", false)
+		       + ") IS DISTINCT FROM (" + staged + ");";
+	}
+
+	std::string insertNewSQL(const SyncTable& table) {
+		std::string columns = joinColumns(table, "", true);
+		std::string values;
+		for (const pgsqlCopy::CopyColumn& column : table.columns) {
+			values += (values.empty() ? "" : ", ") + stagedValue(table, column, "", "");
+		}
+		for (const StoreOwnedColumn& owned : table.storeOwned) {
+			bool carried = std::any_of(table.columns.begin(), table.columns.end(), [&](const pgsqlCopy::CopyColumn& c) {
+				return owned.name == c.name;
+			});
+			if (!carried) {
+				columns += ", " + owned.name;
+				values += ", " + owned.initialValue;
+			}
+		}
+		return "INSERT INTO " + table.name + " (" + columns + ") SELECT " + values + " FROM "
+		       + stagingTableName(table) + " ON CONFLICT (" + table.key + ") DO NOTHING;";
+	}
+
+	std::string softDeleteMissingSQL(const SyncTable& table) {
+		return "UPDATE " + table.name + " AS t SET is_deleted = TRUE WHERE t.is_deleted IS NOT TRUE AND NOT EXISTS "
+		       + "(SELECT 1 FROM " + stagingTableName(table) + " AS s WHERE s." + table.key + " = t." + table.key
+		       + ");";
+	}
+
+	void SyncStats::print(std::ostream& out) const {
+		if (!ok) {
+			out << table << ": sync failed: " << error << std::endl;
+		}
+		else {
+			out << table << ": " << staged << " feed rows, " << inserted << " inserted, " << updated << " updated, "
+			    << softDeleted << " soft-deleted, " << unchanged << " unchanged (stage " << std::fixed
+			    << std::setprecision(3) << stageSeconds << " s, apply " << applySeconds << " s)" << std::endl;
+		}
+		for (const pgsqlCopy::RowError& rowError : errors) {
+			out << "  line " << rowError.line << ": " << rowError.message << std::endl;
+		}
+	}
+
+	// Runs one statement; affected gets the row count of an INSERT / UPDATE or the first value of a SELECT
+	static bool run(PGconn* conn, const std::string& sql, std::size_t* affected, std::string& error) {
+		pgsqlHandles::PgResult res = pgsqlHandles::PgResult::exec(conn, sql.c_str());
+		if (!res.ok()) {
+			error = res.errorMessage();
+			return false;
+		}
+		if (affected) {
+			const char* count = res.status() == PGRES_TUPLES_OK
+			                        ? (res.rows() > 0 ? PQgetvalue(res.get(), 0, 0) : "0")
+			                        : PQcmdTuples(res.get());
+			*affected = std::strtoull(count, nullptr, 10);
+		}
+		return true;
+	}
+
+	// One feed inside the caller's transaction
+	static bool applyFeed(PGconn* conn,
+	                      const SyncTable& table,
+	                      const std::string& path,
+	                      const SyncOptions& options,
+	                      SyncStats& stats) {
+		auto start = Clock::now();
+		std::string staging = stagingTableName(table);
+		if (!run(conn, createStagingSQL(table), nullptr, stats.error)) {
+			return false;
+		}
+
+		pgsqlCopy::ImportStats feed = pgsqlCopy::importCsvFile(conn, staging, table.columns, path, options.import);
+		stats.staged = feed.rows;
+		stats.errors = std::move(feed.errors);
+		if (!feed.ok) {
+			stats.error = "feed " + path + ": " + feed.error;
+			return false;
+		}
+		SyncTable carried = feedTable(table, feed.columns);
+
+		// Temporary tables are never auto-analyzed; without statistics the joins below plan as nested loops
+		std::size_t duplicate = 0;
+		if (!run(conn, "ANALYZE " + staging + ";", nullptr, stats.error)
+		    || !run(conn, duplicateKeySQL(table), &duplicate, stats.error))
+		{
+			return false;
+		}
+		if (duplicate != 0) {
+			stats.error = "feed lists " + table.key + " " + std::to_string(duplicate) + " more than once";
+			return false;
+		}
+		stats.stageSeconds = secondsSince(start);
+
+		start = Clock::now();
+		std::size_t live = 0;
+		std::string liveSQL = "SELECT count(*) FROM " + table.name + " WHERE is_deleted IS NOT TRUE;";
+		if ((options.softDeleteMissing && !run(conn, liveSQL, &live, stats.error))
+		    || !run(conn, updateChangedSQL(carried), &stats.updated, stats.error)
+		    || !run(conn, insertNewSQL(carried), &stats.inserted, stats.error))
+		{
+			return false;
+		}
+		if (options.softDeleteMissing) {
+			if (!run(conn, softDeleteMissingSQL(table), &stats.softDeleted, stats.error)) {
+				return false;
+			}
+			if (options.maxSoftDeleteRatio < 1
+			    && static_cast<double>(stats.softDeleted) > options.maxSoftDeleteRatio * static_cast<double>(live))
+			{
+				stats.error = "feed would soft-delete " + std::to_string(stats.softDeleted) + " of "
+				              + std::to_string(live) + " live rows; rejected as truncated";
+				return false;
+			}
+		}
+		if (!pgsqlCopy::advanceSequence(conn, table.name, table.key.c_str(), stats.error)) {
+			return false;
+		}
+
+		stats.unchanged = stats.staged - stats.inserted - stats.updated;
+		stats.applySeconds = secondsSince(start);
+		return true;
+	}
+
+	// COMMIT when every feed applied, ROLLBACK otherwise; a rolled-back sync reports no changes
+	static void endTransaction(PGconn* conn, bool ok, std::vector<SyncStats>& stats) {
+		std::string error;
+		if (!run(conn, ok ? "COMMIT;" : "ROLLBACK;", nullptr, error) && ok) {
+			stats.back().error = error;
+			ok = false;
+		}
+		for (SyncStats& table : stats) {
+			table.ok = ok;
+			if (!ok) {
+				table.inserted = table.updated = table.softDeleted = table.unchanged = 0;
+				if (table.error.empty()) {
+					table.error = "rolled back";
+				}
+			}
+		}
+	}
+
+	SyncStats syncFeed(PGconn* conn, const SyncTable& table, const std::string& path, const SyncOptions& options) {
+		std::vector<SyncStats> stats(1);
+		stats[0].table = table.name;
+		bool ok = run(conn, "BEGIN;", nullptr, stats[0].error) && applyFeed(conn, table, path, options, stats[0]);
+		endTransaction(conn, ok, stats);
+		return stats[0];
+	}
+
+	std::vector<SyncStats> syncCatalog(PGconn* conn,
+	                                   const std::string& productsPath,
+	                                   const std::string& suppliersPath,
+	                                   const SyncOptions& options) {
+		std::vector<std::pair<SyncTable, std::string>> feeds;
+		if (!productsPath.empty()) {
+			feeds.emplace_back(syncTable<pgsqlSchema::Products>(), productsPath);
+		}
+		if (!suppliersPath.empty()) {
+			feeds.emplace_back(syncTable<pgsqlSchema::Suppliers>(), suppliersPath);
+		}
+		std::vector<SyncStats> stats(feeds.size());
+		for (std::size_t i = 0; i < feeds.size(); ++i) {
+			stats[i].table = feeds[i].first.name;
+		}
+		if (feeds.empty()) {
+			return stats;
+		}
+
+		bool ok = run(conn, "BEGIN;", nullptr, stats[0].error);
+		for (std::size_t i = 0; ok && i < feeds.size(); ++i) {
+			ok = applyFeed(conn, feeds[i].first, feeds[i].second, options, stats[i]);
+		}
+		endTransaction(conn, ok, stats);
+		return stats;
+	}
+} // namespace pgsqlSync
@@ -0,0 +1,94 @@
+#ifndef PGSQL_SYNC_H
+#define PGSQL_SYNC_H
+
+#include "libpq-fe.h"
+#include "pgsql_copy.h"
+#include "pgsql_schema.h"
+#include <cstddef>
+#include <iosfwd>
+#include <string>
+#include <vector>
+
+namespace pgsqlSync {
+
+	// A column the store maintains itself, such as Products.stock. A feed may leave it out or leave a cell
+	// empty; matched rows then keep their value and new rows start at initialValue (an SQL literal).
+	struct StoreOwnedColumn {
+		std::string name;
+		std::string initialValue;
+	};
+
+	// A table a full feed can be synchronized into: its key and every column, the key made required
+	struct SyncTable {
+		std::string name;
+		std::string key;
+		std::vector<pgsqlCopy::CopyColumn> columns;
+		std::vector<StoreOwnedColumn> storeOwned = {};
+	};
+
+	// Store-owned columns of the table, made optional in its feed
+	void markStoreOwned(SyncTable& table);
+
+	template<typename Table>
+	SyncTable syncTable() {
+		SyncTable table{Table::name, pgsqlSchema::serialColumn<Table>(), pgsqlCopy::copyColumns<Table>()};
+		for (pgsqlCopy::CopyColumn& column : table.columns) {
+			if (column.name == table.key) {
+				column.type = pgsqlSchema::SqlType::Integer; // A feed row without its id cannot be matched
+			}
+		}
+		markStoreOwned(table);
+		return table;
+	}
+
+	// The columns one feed carries: the key and whatever its header names, plus is_deleted, which the
+	// sync owns (a listed row is live). Columns the header leaves out are neither updated nor inserted,
+	// so a feed without category or stock does not clear them.
+	SyncTable feedTable(const SyncTable& table, const std::vector<std::string>& header);
+
+	// Set-based statements of one sync; the staging table lives until the transaction ends
+	std::string stagingTableName(const SyncTable& table);
+	std::string createStagingSQL(const SyncTable& table);
+	std::string duplicateKeySQL(const SyncTable& table);
+	std::string updateChangedSQL(const SyncTable& table); // UPDATE ... FROM, only rows whose values differ
+	std::string insertNewSQL(const SyncTable& table); // INSERT ... ON CONFLICT (key) DO NOTHING; see storeOwned
+	std::string softDeleteMissingSQL(const SyncTable& table); // Live rows the feed no longer lists
+
+	struct SyncOptions {
+		// A row that fails validation would otherwise be soft-deleted as missing, so any rejects the feed
+		pgsqlCopy::ImportOptions import{.maxRejectedRows = 0};
+		bool softDeleteMissing = true; // Full feed: live rows absent from it get is_deleted = TRUE
+		double maxSoftDeleteRatio = 0.5; // A feed retiring more of the live rows is taken as truncated; 1 disables
+	};
+
+	struct SyncStats {
+		std::string table;
+		bool ok = false; // Committed; every count is 0 after a rollback
+		std::size_t staged = 0; // Feed rows
+		std::size_t inserted = 0;
+		std::size_t updated = 0; // Includes soft-deleted rows the feed brought back
+		std::size_t softDeleted = 0;
+		std::size_t unchanged = 0;
+		double stageSeconds = 0; // COPY into the staging table
+		double applySeconds = 0; // Diff statements
+		std::vector<pgsqlCopy::RowError> errors; // Rejected feed rows
+		std::string error;
+
+		void print(std::ostream& out) const;
+	};
+
+	// Applies the full CSV feed at path to table in one transaction: COPY into a temporary staging table,
+	// then update changed rows, insert new ones and soft-delete missing ones. The header must name the key
+	// and every required column; only the columns it names are written (see feedTable).
+	SyncStats syncFeed(PGconn* conn, const SyncTable& table, const std::string& path, const SyncOptions& options = {});
+
+	// Products and then Suppliers in a single transaction, so suppliers may reference products the same
+	// feed adds. An empty path skips that table.
+	std::vector<SyncStats> syncCatalog(PGconn* conn,
+	                                   const std::string& productsPath,
+	                                   const std::string& suppliersPath,
+	                                   const SyncOptions& options = {});
+
+} // namespace pgsqlSync
+
+#endif // PGSQL_SYNC_H
@@ -0,0 +1,91 @@
+#include "pgsql_workers.h"
+
+#include <algorithm>
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <thread>
+
+namespace pgsqlWorkers {
+	bool runTasks(const std::vector<Task>& tasks, std::size_t threads, std::string& error) {
+		std::vector<std::size_t> waiting(tasks.size());
+		std::vector<std::vector<std::size_t>> dependents(tasks.size());
+		std::deque<std::size_t> ready;
+		for (std::size_t task = 0; task < tasks.size(); ++task) {
+			waiting[task] = tasks[task].after.size();
+			for (std::size_t predecessor : tasks[task].after) {
+				dependents[predecessor].push_back(task);
+			}
+			if (waiting[task] == 0) {
+				ready.push_back(task);
+			}
+		}
+
+		std::mutex mutex;
+		std::condition_variable changed;
+		std::size_t running = 0;
+		std::size_t finished = 0;
+		bool failed = false;
+
+		// With nothing ready and nothing running, nothing can become ready any more
+		auto worker = [&](std::size_t workerIndex) {
+			std::unique_lock<std::mutex> lock(mutex);
+			while (true) {
+				changed.wait(lock, [&] { return failed || !ready.empty() || running == 0; });
+				if (failed || ready.empty()) {
+					break;
+				}
+				std::size_t task = ready.front();
+				ready.pop_front();
+				++running;
+
+				lock.unlock();
+				std::string message;
+				bool ok = tasks[task].run(workerIndex, message);
+				lock.lock();
+
+				--running;
+				++finished;
+				if (!ok && !failed) {
+					failed = true;
+					error = message;
+				}
+				for (std::size_t dependent : dependents[task]) {
+					if (ok && --waiting[dependent] == 0) {
+						ready.push_back(dependent);
+					}
+				}
+				changed.notify_all();
+			}
+		};
+
+		std::size_t workerCount = std::clamp<std::size_t>(threads, 1, std::max<std::size_t>(tasks.size(), 1));
+		std::vector<std::thread> workers;
+		workers.reserve(workerCount);
+		for (std::size_t i = 0; i < workerCount; ++i) {
+			workers.emplace_back(worker, i);
+		}
+		for (std::thread& thread : workers) {
+			thread.join();
+		}
+		if (!failed && finished != tasks.size()) {
+			error = "circular task dependencies";
+			failed = true;
+		}
+		return !failed;
+	}
+
+	bool runIndexed(std::size_t count,
+	                std::size_t threads,
+	                const std::function<bool(std::size_t index, std::size_t worker, std::string& error)>& work,
+	                std::string& error) {
+		std::vector<Task> tasks;
+		tasks.reserve(count);
+		for (std::size_t index = 0; index < count; ++index) {
+			tasks.push_back({[&work, index](std::size_t worker, std::string& message) {
+				return work(index, worker, message);
+			}});
+		}
+		return runTasks(tasks, threads, error);
+	}
+} // namespace pgsqlWorkers
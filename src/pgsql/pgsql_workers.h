@@ -0,0 +1,31 @@
+#ifndef PGSQL_WORKERS_H
+#define PGSQL_WORKERS_H
+
+#include <cstddef>
+#include <functional>
+#include <string>
+#include <vector>
+
+namespace pgsqlWorkers {
+
+	// One unit of work. worker is the index (0..threads-1) of the thread running it, e.g. to pick that
+	// thread's connection; false with a message in error fails the run.
+	struct Task {
+		std::function<bool(std::size_t worker, std::string& error)> run;
+		std::vector<std::size_t> after = {}; // Tasks that must have succeeded before this one starts
+	};
+
+	// Runs tasks on up to `threads` threads, in list order as far as their predecessors allow. A started
+	// task always runs to its end, but nothing new starts after the first failure, whose message ends
+	// up in error. Dependencies that can never be met fail the run as well.
+	bool runTasks(const std::vector<Task>& tasks, std::size_t threads, std::string& error);
+
+	// runTasks over count independent tasks, work(index, worker, error)
+	bool runIndexed(std::size_t count,
+	                std::size_t threads,
+	                const std::function<bool(std::size_t index, std::size_t worker, std::string& error)>& work,
+	                std::string& error);
+
+} // namespace pgsqlWorkers
+
+#endif // PGSQL_WORKERS_H
@@ -1,11 +1,1384 @@
 #include "../lib/catch_amalgamated.hpp"
+#include "../src/pgsql/pgsql_async.h"
+#include "../src/pgsql/pgsql_binary.h"
+#include "../src/pgsql/pgsql_cdc.h"
+#include "../src/pgsql/pgsql_connection_pool.h"
+#include "../src/pgsql/pgsql_copy.h"
+#include "../src/pgsql/pgsql_datagen.h"
+#include "../src/pgsql/pgsql_dump.h"
+#include "../src/pgsql/pgsql_handles.h"
+#include "../src/pgsql/pgsql_indexes.h"
+#include "../src/pgsql/pgsql_migrations.h"
+#include "../src/pgsql/pgsql_partitions.h"
+#include "../src/pgsql/pgsql_pipeline.h"
+#include "../src/pgsql/pgsql_prepared.h"
+#include "../src/pgsql/pgsql_profiles.h"
+#include "../src/pgsql/pgsql_provisioning.h"
+#include "../src/pgsql/pgsql_purge.h"
+#include "../src/pgsql/pgsql_schema.h"
+#include "../src/pgsql/pgsql_snapshot.h"
+#include "../src/pgsql/pgsql_stream.h"
+#include "../src/pgsql/pgsql_sync.h"
+#include "../src/pgsql/pgsql_workers.h"
 #include "../src/test.h"
 
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <future>
 #include <iostream>
+#include <limits>
+#include <map>
+#include <mutex>
+#include <sstream>
+#include <thread>
 
 TEST_CASE("test for test") {
     int a = 10;
     int b = 20;
     int c = plus(a,b);
     CHECK(c == 30);
-}
\ No newline at end of file
+}
+
+// Builds a text-format result without a server: columns id, price, active, name
+static pgsqlHandles::PgResult makeProductsResult() {
+    PGresult* res = PQmakeEmptyPGresult(nullptr, PGRES_TUPLES_OK);
+    PGresAttDesc attrs[4] = {};
+    const char* names[] = {"id", "price", "active", "name"};
+    for (int i = 0; i < 4; ++i) {
+        attrs[i].name = const_cast<char*>(names[i]);
+        attrs[i].typlen = -1;
+    }
+    PQsetResultAttrs(res, 4, attrs);
+
+    const char* rows[][4] = {{"1", "19.99", "t", "Dog food"}, {"2", "5.50", "f", "Cat toy"}};
+    for (int row = 0; row < 2; ++row) {
+        for (int column = 0; column < 4; ++column) {
+            const char* value = rows[row][column];
+            PQsetvalue(res, row, column, const_cast<char*>(value), static_cast<int>(std::strlen(value)));
+        }
+    }
+    PQsetvalue(res, 2, 0, const_cast<char*>("3"), 1);
+    PQsetvalue(res, 2, 1, nullptr, -1);
+    PQsetvalue(res, 2, 2, const_cast<char*>("t"), 1);
+    PQsetvalue(res, 2, 3, const_cast<char*>("Bird cage"), 9);
+    return pgsqlHandles::PgResult(res);
+}
+
+TEST_CASE("PgResult rows are iterated as typed RowViews") {
+    pgsqlHandles::PgResult res = makeProductsResult();
+    REQUIRE(res.ok());
+    REQUIRE(res.rows() == 3);
+    CHECK(res.columnIndex("active") == 2);
+
+    int ids = 0;
+    for (pgsqlHandles::RowView row : res) {
+        ids += row.get<int>(0);
+    }
+    CHECK(ids == 6);
+
+    CHECK(res[0].get<double>(1) == 19.99);
+    CHECK(res[0].get<bool>(2));
+    CHECK_FALSE(res[1].get<bool>(2));
+    CHECK(res[1][3] == "Cat toy");
+    CHECK(res[2].isNull(1));
+    CHECK_FALSE(res[2].getOptional<double>(1).has_value());
+    CHECK_FALSE(res[1].getOptional<int>(3).has_value());
+}
+
+TEST_CASE("PgResult is move-only and releases ownership on move") {
+    pgsqlHandles::PgResult first = makeProductsResult();
+    pgsqlHandles::PgResult second = std::move(first);
+    CHECK_FALSE(first);
+    CHECK(second.rows() == 3);
+}
+
+TEST_CASE("connection pool evicts expired idle connections and fails acquire cleanly") {
+    using Clock = std::chrono::steady_clock;
+    auto now = Clock::now();
+
+    // Unconnected handles are enough here: eviction only moves them out of the sub-pool
+    pgsqlPool::ConnectionSubPool sub;
+    std::vector<PGconn*> conns;
+    for (int i = 0; i < 4; ++i) {
+        conns.push_back(PQconnectStart("host=127.0.0.1 port=1"));
+        REQUIRE(conns.back() != nullptr);
+    }
+    sub.idle.push_back({conns[0], now - std::chrono::seconds(300)});
+    sub.idle.push_back({conns[1], now - std::chrono::seconds(120)});
+    sub.idle.push_back({conns[2], now - std::chrono::seconds(10)});
+    sub.open = 4; // One more is checked out
+
+    std::vector<PGconn*> expired = pgsqlPool::takeExpired(sub, 3, now - std::chrono::seconds(60));
+    CHECK(expired == std::vector<PGconn*>{conns[0]}); // minSize keeps the second one
+    CHECK(sub.open == 3);
+    expired = pgsqlPool::takeExpired(sub, 0, now - std::chrono::seconds(60));
+    CHECK(expired == std::vector<PGconn*>{conns[1]});
+    CHECK(sub.idle.size() == 1);
+    CHECK(sub.idle.front().conn == conns[2]); // Still within the timeout
+    CHECK(sub.open == 2);
+    for (PGconn* conn : conns) {
+        PQfinish(conn);
+    }
+
+    pgsqlPool::PoolOptions options;
+    options.minSize = 5;
+    options.maxSize = 0;
+    options.idleTimeout = std::chrono::seconds(0); // Every acquire sweeps
+    pgsqlPool::PgConnectionPool pool(options);
+    CHECK(pool.options().maxSize == 1);
+    CHECK(pool.options().minSize == 1);
+
+    // A refused connection returns an empty handle and gives its slot back
+    std::string conninfo = "host=127.0.0.1 port=1 connect_timeout=1";
+    for (int attempt = 0; attempt < 2; ++attempt) {
+        pgsqlPool::PooledConnection conn = pool.acquire(conninfo);
+        CHECK_FALSE(conn);
+    }
+    pgsqlPool::PoolStats stats = pool.stats(conninfo);
+    CHECK(stats.created == 0);
+    CHECK(stats.open == 0);
+    CHECK(stats.idle == 0);
+    CHECK(stats.maxSize == 1);
+    CHECK(pgsqlPool::PgConnectionPool::timeoutsOnThisThread() == 0); // Refused, not timed out
+
+    // Provisioning workers size the sub-pool they share; a smaller reservation never shrinks it
+    pool.reserve(conninfo, 16);
+    CHECK(pool.stats(conninfo).maxSize == 16);
+    pool.reserve(conninfo, 4);
+    CHECK(pool.stats(conninfo).maxSize == 16);
+    CHECK_FALSE(pool.acquire(conninfo));
+    pool.evictIdle();
+    pool.clear();
+    CHECK(pool.stats(conninfo).open == 0);
+}
+
+
+TEST_CASE("async engine fails queries on unreachable targets from the event loop") {
+    using namespace std::chrono_literals;
+    std::string conninfo = "host=127.0.0.1 port=1 connect_timeout=1";
+    pgsqlAsync::EngineOptions options;
+    options.maxConnectionsPerTarget = 1;
+    pgsqlAsync::AsyncEngine engine(options);
+
+    std::future<pgsqlAsync::QueryResult> early = engine.submit(conninfo, "SELECT 1;");
+    REQUIRE(early.wait_for(0s) == std::future_status::ready);
+    CHECK(early.get().error == "Async engine is not running.");
+
+    REQUIRE(engine.start());
+    // Both queries wait on the one connection; its refusal fails the whole queue
+    std::future<pgsqlAsync::QueryResult> first = engine.submit(conninfo, "SELECT 1;");
+    std::future<pgsqlAsync::QueryResult> second = engine.submit(conninfo, "SELECT $1::int;", {"2"});
+    std::promise<std::string> callbackError;
+    engine.submit("host=127.0.0.1 port=1 connect_timeout=1 dbname=other", "SELECT 1;", {},
+                  [&callbackError](pgsqlAsync::QueryResult result) { callbackError.set_value(result.error); });
+
+    REQUIRE(first.wait_for(10s) == std::future_status::ready);
+    REQUIRE(second.wait_for(10s) == std::future_status::ready);
+    pgsqlAsync::QueryResult failed = first.get();
+    CHECK_FALSE(failed.ok());
+    CHECK_FALSE(failed.result);
+    CHECK(failed.error.rfind("Connection to database failed", 0) == 0);
+    CHECK(second.get().error.rfind("Connection to database failed", 0) == 0);
+    std::future<std::string> callbackDone = callbackError.get_future();
+    REQUIRE(callbackDone.wait_for(10s) == std::future_status::ready);
+    CHECK(callbackDone.get().rfind("Connection to database failed", 0) == 0);
+
+    // The loop keeps serving the target after its connection was closed
+    std::future<pgsqlAsync::QueryResult> retry = engine.submit(conninfo, "SELECT 1;");
+    REQUIRE(retry.wait_for(10s) == std::future_status::ready);
+    CHECK_FALSE(retry.get().ok());
+
+    engine.stop();
+    CHECK(engine.submit(conninfo, "SELECT 1;").get().error == "Async engine is not running.");
+
+    // Submits racing stop() are either failed by it or rejected; none is lost
+    pgsqlAsync::AsyncEngine raced(options);
+    REQUIRE(raced.start());
+    std::vector<std::future<pgsqlAsync::QueryResult>> racing;
+    std::thread submitter([&] {
+        for (int i = 0; i < 200; ++i) {
+            racing.push_back(raced.submit(conninfo, "SELECT 1;"));
+        }
+    });
+    std::this_thread::sleep_for(1ms);
+    raced.stop();
+    submitter.join();
+    for (std::future<pgsqlAsync::QueryResult>& result : racing) {
+        REQUIRE(result.wait_for(10s) == std::future_status::ready);
+        CHECK_FALSE(result.get().ok());
+    }
+}
+
+// Client-side PGresult with one text column holding values, as a streamed query would receive it
+static pgsqlHandles::PgResult makeRowsResult(ExecStatusType status, const std::vector<std::string>& values) {
+    pgsqlHandles::PgResult res(PQmakeEmptyPGresult(nullptr, status));
+    PGresAttDesc column{const_cast<char*>("name"), 0, 0, 0, 25, -1, -1};
+    REQUIRE(PQsetResultAttrs(res.get(), 1, &column));
+    for (std::size_t i = 0; i < values.size(); ++i) {
+        REQUIRE(PQsetvalue(res.get(),
+                           static_cast<int>(i),
+                           0,
+                           const_cast<char*>(values[i].c_str()),
+                           static_cast<int>(values[i].size())));
+    }
+    return res;
+}
+
+TEST_CASE("streamed results feed the row callback, buffered ones included") {
+    std::vector<std::string> seen;
+    auto collect = [&seen](const pgsqlHandles::RowView& row) {
+        seen.emplace_back(row.get<std::string>(0));
+        return seen.size() < 3;
+    };
+
+    // Row mode: single-row batches, then a terminating TUPLES_OK without rows
+    pgsqlStream::StreamResult streamed;
+    bool finished = false;
+    pgsqlStream::consumeResult(makeRowsResult(PGRES_SINGLE_TUPLE, {"a"}), collect, 0.5, streamed, finished);
+    pgsqlStream::consumeResult(makeRowsResult(PGRES_SINGLE_TUPLE, {"b"}), collect, 0.7, streamed, finished);
+    CHECK_FALSE(finished);
+    pgsqlStream::consumeResult(makeRowsResult(PGRES_TUPLES_OK, {}), collect, 0.9, streamed, finished);
+    CHECK(finished);
+    CHECK(streamed.rows == 2);
+    CHECK(streamed.firstRowSeconds == 0.5);
+    CHECK(seen == std::vector<std::string>{"a", "b"});
+
+    // Row mode refused: every row arrives in the one TUPLES_OK and still reaches the callback, which
+    // stops after the third
+    seen.clear();
+    pgsqlStream::StreamResult buffered;
+    finished = false;
+    pgsqlStream::consumeResult(makeRowsResult(PGRES_TUPLES_OK, {"x", "y", "z", "w"}), collect, 0.1, buffered, finished);
+    CHECK(finished);
+    CHECK(buffered.stopped);
+    CHECK(buffered.rows == 3);
+    CHECK(seen == std::vector<std::string>{"x", "y", "z"});
+
+    // An error keeps the first message and drops later rows
+    seen.clear();
+    pgsqlStream::StreamResult failed;
+    finished = false;
+    pgsqlStream::consumeResult(pgsqlHandles::PgResult(PQmakeEmptyPGresult(nullptr, PGRES_FATAL_ERROR)),
+                               collect,
+                               0,
+                               failed,
+                               finished);
+    pgsqlStream::consumeResult(makeRowsResult(PGRES_SINGLE_TUPLE, {"late"}), collect, 0, failed, finished);
+    CHECK_FALSE(failed.error.empty());
+    CHECK(failed.rows == 0);
+    CHECK(seen.empty());
+}
+
+TEST_CASE("pipeline results name the failing statement and the aborted ones after it") {
+    // Segment 1: statements 0-2, the middle one fails and the server aborts the third
+    std::vector<pgsqlPipeline::StatementError> errors;
+    std::vector<ExecStatusType> statuses = {PGRES_COMMAND_OK, PGRES_FATAL_ERROR, PGRES_PIPELINE_ABORTED};
+    for (std::size_t index = 0; index < statuses.size(); ++index) {
+        pgsqlHandles::PgResult res(PQmakeEmptyPGresult(nullptr, statuses[index]));
+        pgsqlPipeline::classifyResult(res.get(), index, errors);
+    }
+    REQUIRE(errors.size() == 2);
+    CHECK(errors[0].index == 1);
+    CHECK_FALSE(errors[0].aborted);
+    CHECK_FALSE(errors[0].message.empty());
+    CHECK(errors[1].index == 2);
+    CHECK(errors[1].aborted);
+
+    // With stopAfterFailedSegment the next segment, statements 3-4, is never sent
+    pgsqlPipeline::reportSkipped(3, 2, errors);
+    REQUIRE(errors.size() == 4);
+    CHECK(errors[2].index == 3);
+    CHECK(errors[3].index == 4);
+    CHECK(errors[3].aborted);
+    REQUIRE(pgsqlPipeline::firstError(errors) != nullptr);
+    CHECK(pgsqlPipeline::firstError(errors)->index == 1);
+
+    // Only aborted entries: the first of them stands in for the failure
+    std::vector<pgsqlPipeline::StatementError> aborted;
+    pgsqlPipeline::reportSkipped(5, 1, aborted);
+    CHECK(pgsqlPipeline::firstError(aborted) == &aborted.front());
+    CHECK(pgsqlPipeline::firstError({}) == nullptr);
+
+    pgsqlHandles::PgResult rows(PQmakeEmptyPGresult(nullptr, PGRES_TUPLES_OK));
+    pgsqlPipeline::classifyResult(rows.get(), 0, aborted);
+    CHECK(aborted.size() == 1);
+}
+
+TEST_CASE("prepared statement registry prepares once per connection and forgets closed ones") {
+    pgsqlPrepared::PreparedStatementRegistry registry;
+    PGconn* first = PQconnectStart("host=127.0.0.1 port=1");
+    PGconn* second = PQconnectStart("host=127.0.0.1 port=1");
+    REQUIRE(first != nullptr);
+    REQUIRE(second != nullptr);
+
+    registry.markPrepared(first, "list_databases", true);
+    registry.markPrepared(first, "tenant_state", true);
+    CHECK(registry.isPrepared(first, "list_databases"));
+    CHECK_FALSE(registry.isPrepared(second, "list_databases")); // Sessions never share statements
+    registry.markPrepared(first, "tenant_state", false); // E.g. after DISCARD ALL
+    CHECK_FALSE(registry.isPrepared(first, "tenant_state"));
+
+    // A connection that cannot prepare is not recorded as having the statement
+    pgsqlPrepared::PreparedStatement statement{"select_one", "SELECT $1::int;", {pgsqlPrepared::kInt4Oid}};
+    CHECK_FALSE(registry.execute(second, statement, 1));
+    CHECK_FALSE(registry.isPrepared(second, "select_one"));
+    CHECK(registry.stats().misses == 1);
+    CHECK(registry.stats().hits == 0);
+
+    // The pool forgets a connection before closing it, so a new PGconn at the same address starts clean
+    registry.forget(first);
+    CHECK_FALSE(registry.isPrepared(first, "list_databases"));
+    registry.forget(second);
+    PQfinish(first);
+    PQfinish(second);
+}
+
+TEST_CASE("binary NUMERIC values decode into scaled integers") {
+    std::int64_t cents = 0;
+
+    // 1234.56: ndigits=2 weight=0 sign=+ dscale=2, digits 1234 and 5600
+    const unsigned char price[] = {0, 2, 0, 0, 0, 0, 0, 2, 0x04, 0xD2, 0x15, 0xE0};
+    REQUIRE(pgsqlBinary::decodeNumeric({reinterpret_cast<const char*>(price), sizeof(price)}, 2, cents));
+    CHECK(cents == 123456);
+
+    // -100000: one digit 10 with weight 1
+    const unsigned char negative[] = {0, 1, 0, 1, 0x40, 0, 0, 0, 0, 10};
+    REQUIRE(pgsqlBinary::decodeNumeric({reinterpret_cast<const char*>(negative), sizeof(negative)}, 2, cents));
+    CHECK(cents == -10000000);
+
+    // NaN is rejected
+    const unsigned char nan[] = {0, 0, 0, 0, 0xC0, 0, 0, 0};
+    CHECK_FALSE(pgsqlBinary::decodeNumeric({reinterpret_cast<const char*>(nan), sizeof(nan)}, 2, cents));
+
+    REQUIRE(pgsqlBinary::parseNumericText("1234.5", 2, cents));
+    CHECK(cents == 123450);
+    REQUIRE(pgsqlBinary::parseNumericText("-0.07", 2, cents));
+    CHECK(cents == -7);
+    REQUIRE(pgsqlBinary::parseNumericText(".5", 2, cents));
+    CHECK(cents == 50);
+    REQUIRE(pgsqlBinary::parseNumericText("2.345", 2, cents)); // Rounded as the server rounds
+    CHECK(cents == 235);
+
+    // NUMERIC(10, 2) holds at most 8 integer digits, also after rounding
+    REQUIRE(pgsqlBinary::parseNumericText("0099999999.99", 2, cents, 10));
+    CHECK(cents == 9999999999);
+    CHECK_FALSE(pgsqlBinary::parseNumericText("100000000", 2, cents, 10));
+    CHECK_FALSE(pgsqlBinary::parseNumericText("99999999.995", 2, cents, 10));
+    CHECK(pgsqlBinary::parseNumericText("100000000", 2, cents));
+
+    for (const char* text : {"", ".", "-", "+.", "--5", "1.2.3", "1.2x", "1e3", " 1", "12345678901234567890"}) {
+        CHECK_FALSE(pgsqlBinary::parseNumericText(text, 2, cents));
+    }
+}
+
+TEST_CASE("binary INTEGER, BOOLEAN and DATE values decode") {
+    std::int32_t value = 0;
+    const unsigned char int4[] = {0xFF, 0xFF, 0xFF, 0xFE};
+    REQUIRE(pgsqlBinary::decodeInt4({reinterpret_cast<const char*>(int4), sizeof(int4)}, value));
+    CHECK(value == -2);
+    CHECK_FALSE(pgsqlBinary::decodeInt4("abc", value));
+
+    bool flag = false;
+    REQUIRE(pgsqlBinary::decodeBool(std::string_view("\x01", 1), flag));
+    CHECK(flag);
+
+    // 2024-03-10 is 8835 days after 2000-01-01
+    const unsigned char date[] = {0, 0, 0x22, 0x83};
+    std::int32_t days = 0;
+    REQUIRE(pgsqlBinary::decodeDate({reinterpret_cast<const char*>(date), sizeof(date)}, days));
+    CHECK(days == 8835);
+
+    std::int32_t parsed = 0;
+    REQUIRE(pgsqlBinary::parseDateText("2024-03-10", parsed));
+    CHECK(parsed == days);
+    CHECK(pgsqlBinary::parseDateText("2024-02-29", parsed)); // Leap year
+    CHECK(pgsqlBinary::parseDateText("2000-02-29", parsed));
+    for (const char* text : {"2023-02-29", "1900-02-29", "2024-13-01", "2024-00-10", "2024-04-31", "2024-01-00",
+                             "0000-01-01", "2024-1a-10", "-024-01-01", "2024/01/01", "2024-01-1"}) {
+        CHECK_FALSE(pgsqlBinary::parseDateText(text, parsed));
+    }
+
+    pgsqlBinary::Date civil = pgsqlBinary::civilFromDays(days + pgsqlBinary::kPostgresEpochDays);
+    CHECK(civil.year == 2024);
+    CHECK(civil.month == 3);
+    CHECK(civil.day == 10);
+}
+
+
+TEST_CASE("connection profiles build validated conninfo strings") {
+    auto& registry = pgsqlProfiles::ProfileRegistry::instance();
+    REQUIRE(registry.define("test-socket", pgsqlProfiles::ConnectionProfile::unixSocket("/tmp", "5433")));
+
+    std::string conninfo = registry.conninfoFor("test-socket", "store_db", "alice", "it's secret");
+    CHECK(conninfo == registry.conninfoFor("test-socket", "store_db", "alice", "it's secret"));
+
+    std::string error;
+    auto options = pgsqlProfiles::ProfileRegistry::parse(conninfo, error);
+    REQUIRE(options.has_value());
+    CHECK(options->at("host") == "/tmp");
+    CHECK(options->at("port") == "5433");
+    CHECK(options->at("dbname") == "store_db");
+    CHECK(options->at("password") == "it's secret");
+    CHECK(options->at("keepalives") == "0");
+
+    CHECK_FALSE(registry.defineFromConninfo("test-bad", "hostt=localhost"));
+}
+
+TEST_CASE("provisioning manifest parsing and retrying worker pool") {
+    std::istringstream manifest("# stores\nstore_1,owner_1,pw,with,commas\n\nstore_2,owner_2,\r\n");
+    std::vector<pgsqlProvisioning::TenantSpec> tenants;
+    std::string error;
+    REQUIRE(pgsqlProvisioning::parseManifest(manifest, tenants, error));
+    REQUIRE(tenants.size() == 2);
+    CHECK(tenants[0].password == "pw,with,commas");
+    CHECK(tenants[1].userName == "owner_2");
+    CHECK(tenants[1].password.empty());
+
+    std::istringstream broken("store_3,owner_3,pw\nstore_4\n");
+    CHECK_FALSE(pgsqlProvisioning::parseManifest(broken, tenants, error));
+    CHECK(error.find("line 2") != std::string::npos);
+
+    // Every tenant fails once before succeeding; store_bad never succeeds
+    std::vector<pgsqlProvisioning::TenantSpec> fleet;
+    for (int i = 0; i < 20; ++i) {
+        fleet.push_back({"store_" + std::to_string(i), "owner", "pw"});
+    }
+    fleet.push_back({"store_bad", "owner", "pw"});
+
+    std::mutex mutex;
+    std::map<std::string, int> calls;
+    pgsqlProvisioning::ProvisionOptions options;
+    options.concurrency = 4;
+    options.maxAttempts = 3;
+    options.retryBackoff = std::chrono::milliseconds(1);
+    options.printProgress = false;
+    auto report = pgsqlProvisioning::provisionTenants(
+        fleet,
+        [&](const pgsqlProvisioning::TenantSpec& tenant) {
+            std::lock_guard<std::mutex> lock(mutex);
+            return ++calls[tenant.dbName] > 1 && tenant.dbName != "store_bad";
+        },
+        options);
+
+    CHECK(report.succeeded == 20);
+    CHECK(report.failed == 1);
+    CHECK(report.outcomes[0].attempts == 2);
+    CHECK(report.outcomes.back().attempts == 3);
+    CHECK_FALSE(report.outcomes.back().ok);
+    CHECK(report.latencyPercentile(50) <= report.latencyPercentile(99));
+    CHECK(report.throughput() > 0);
+}
+
+TEST_CASE("worker pool honours task dependencies and stops after a failure") {
+    // A diamond: 0 before 1 and 2, both before 3
+    std::mutex mutex;
+    std::vector<std::size_t> order;
+    std::vector<pgsqlWorkers::Task> tasks(4);
+    for (std::size_t i = 0; i < tasks.size(); ++i) {
+        tasks[i].run = [&, i](std::size_t worker, std::string&) {
+            std::lock_guard<std::mutex> lock(mutex);
+            CHECK(worker < 3);
+            order.push_back(i);
+            return true;
+        };
+    }
+    tasks[1].after = {0};
+    tasks[2].after = {0};
+    tasks[3].after = {1, 2};
+    std::string error;
+    REQUIRE(pgsqlWorkers::runTasks(tasks, 3, error));
+    REQUIRE(order.size() == 4);
+    CHECK(order.front() == 0);
+    CHECK(order.back() == 3);
+
+    // Nothing starts after the first failure; the single worker claims tasks in index order
+    std::vector<std::size_t> started;
+    CHECK_FALSE(pgsqlWorkers::runIndexed(
+        10,
+        1,
+        [&](std::size_t index, std::size_t, std::string& message) {
+            started.push_back(index);
+            message = "task " + std::to_string(index) + " failed";
+            return index != 3;
+        },
+        error));
+    CHECK(started == std::vector<std::size_t>{0, 1, 2, 3});
+    CHECK(error == "task 3 failed");
+
+    tasks[0].after = {3};
+    CHECK_FALSE(pgsqlWorkers::runTasks(tasks, 2, error));
+    CHECK(error == "circular task dependencies");
+}
+
+TEST_CASE("fleet teardown selects stores by LIKE pattern and reports failures") {
+    using pgsqlProvisioning::likeMatches;
+    CHECK(likeMatches("store_1", "store_%"));
+    CHECK(likeMatches("store_", "store_%"));
+    CHECK(likeMatches("storeX1", "store_%")); // _ is a wildcard unless escaped
+    CHECK_FALSE(likeMatches("storeX1", "store\\_%"));
+    CHECK(likeMatches("store_1", "store\\_%"));
+    CHECK_FALSE(likeMatches("Store_1", "store_%")); // Database names are case-sensitive
+    CHECK(likeMatches("Store-A b", "%-A%"));
+    CHECK(likeMatches("load_42_test", "load__%%%test"));
+    CHECK_FALSE(likeMatches("load_42_tes", "load_%test"));
+    CHECK(likeMatches("", "%"));
+    CHECK_FALSE(likeMatches("a", ""));
+    CHECK(likeMatches("50%", "50\\%"));
+    CHECK_FALSE(likeMatches("500", "50\\%"));
+
+    std::vector<pgsqlProvisioning::TenantSpec> targets = {{"store_a", "", ""}, {"Store-B", "", ""}};
+    pgsqlProvisioning::ProvisionOptions options;
+    options.maxAttempts = 2;
+    options.retryBackoff = std::chrono::milliseconds(1);
+    options.printProgress = false;
+    auto report = pgsqlProvisioning::provisionTenants(
+        targets, [](const pgsqlProvisioning::TenantSpec& target) { return target.dbName == "store_a"; }, options);
+    std::ostringstream out;
+    report.print(out, "Dropped");
+    CHECK(out.str().find("Dropped 1 of 2 stores") != std::string::npos);
+    CHECK(out.str().find("- FAILED Store-B after 2 attempts") != std::string::npos);
+}
+
+TEST_CASE("migration planning checks order and checksums") {
+    std::vector<pgsqlMigrations::Migration> migrations = {
+        {1, "create_tables", "CREATE TABLE a (id INT);"},
+        {2, "add_column", "ALTER TABLE a ADD COLUMN name TEXT;"},
+        {3, "add_index", "CREATE INDEX CONCURRENTLY a_name ON a (name);", false},
+    };
+    std::string sum1 = pgsqlMigrations::checksum(migrations[0]);
+    CHECK(sum1.size() == 16);
+    CHECK(sum1 != pgsqlMigrations::checksum(migrations[1]));
+
+    std::vector<const pgsqlMigrations::Migration*> pending;
+    std::string error;
+    REQUIRE(pgsqlMigrations::planMigrations(migrations, {{1, sum1}}, pending, error));
+    REQUIRE(pending.size() == 2);
+    CHECK(pending[0]->version == 2);
+    CHECK(pending[1]->version == 3);
+
+    CHECK_FALSE(pgsqlMigrations::planMigrations(migrations, {{1, "0000000000000000"}}, pending, error));
+    CHECK(error.find("checksum mismatch") != std::string::npos);
+    CHECK_FALSE(pgsqlMigrations::planMigrations(migrations, {{4, sum1}}, pending, error));
+
+    std::string before = pgsqlMigrations::fingerprint(migrations);
+    migrations[1].sql += " -- edited";
+    CHECK(before != pgsqlMigrations::fingerprint(migrations));
+
+    std::swap(migrations[0], migrations[1]);
+    CHECK_FALSE(pgsqlMigrations::planMigrations(migrations, {}, pending, error));
+}
+
+TEST_CASE("index pack builds concurrent, partial index migrations") {
+    pgsqlIndexes::IndexDefinition index{"orders_active_idx", "Orders", "customer_id, order_date", true};
+    CHECK(pgsqlIndexes::createIndexSQL(index)
+          == "CREATE INDEX CONCURRENTLY IF NOT EXISTS orders_active_idx ON Orders (customer_id, order_date) "
+             "WHERE NOT is_deleted;");
+    CHECK(pgsqlIndexes::createIndexSQL({"items_idx", "Order_Items", "order_id", false}, false)
+          == "CREATE INDEX IF NOT EXISTS items_idx ON Order_Items (order_id);");
+
+    auto migrations = pgsqlIndexes::indexMigrations(2, pgsqlIndexes::petstoreIndexPack());
+    REQUIRE(migrations.size() == pgsqlIndexes::petstoreIndexPack().size());
+    CHECK(migrations.front().version == 2);
+    CHECK_FALSE(migrations.front().transactional);
+    CHECK(migrations.front().cleanupSql.find("DROP INDEX CONCURRENTLY IF EXISTS") == 0);
+    // A leftover INVALID index is found by name and rebuilt rather than skipped by IF NOT EXISTS
+    CHECK(migrations.front().validIndex == pgsqlIndexes::petstoreIndexPack().front().name);
+    auto layered = pgsqlIndexes::indexMigrations(2, pgsqlIndexes::petstoreIndexPack(), {"Orders"});
+    CHECK(layered[1].transactional);
+    CHECK(layered[1].validIndex.empty());
+}
+
+TEST_CASE("monthly partition naming and maintenance planning") {
+    using pgsqlPartitions::Month;
+    pgsqlPartitions::PartitionedTable orders{"Orders", "order_date"};
+
+    CHECK(pgsqlPartitions::addMonths({2024, 11}, 3) == Month{2025, 2});
+    CHECK(pgsqlPartitions::addMonths({2024, 1}, -1) == Month{2023, 12});
+    CHECK(pgsqlPartitions::partitionName(orders, {2024, 5}) == "orders_p2024_05");
+    CHECK(pgsqlPartitions::parsePartitionName(orders, "orders_p2024_05") == Month{2024, 5});
+    CHECK_FALSE(pgsqlPartitions::parsePartitionName(orders, "orders_p2024_13").has_value());
+    CHECK_FALSE(pgsqlPartitions::parsePartitionName(orders, "inventory_actions_p2024_05").has_value());
+    CHECK(pgsqlPartitions::createPartitionSQL(orders, {2024, 12})
+          == "CREATE TABLE IF NOT EXISTS orders_p2024_12 PARTITION OF Orders "
+             "FOR VALUES FROM ('2024-12-01') TO ('2025-01-01');");
+
+    pgsqlPartitions::MaintenancePolicy policy;
+    policy.monthsAhead = 2;
+    policy.monthsBehind = 1;
+    policy.retainMonths = 12;
+    auto plan = pgsqlPartitions::planMaintenance(
+        orders, {"orders_p2023_05", "orders_p2023_06", "orders_p2024_06", "orders_p2024_07"}, {2024, 6}, policy);
+    REQUIRE(plan.create.size() == 2);
+    CHECK(plan.create[0] == Month{2024, 5});
+    CHECK(plan.create[1] == Month{2024, 8});
+    REQUIRE(plan.detach.size() == 1);
+    CHECK(plan.detach[0] == "orders_p2023_05");
+
+    // A generated history: 2022-01-01 (day 8036) plus 730 days ends on 2023-12-31
+    std::vector<Month> months = pgsqlPartitions::monthsCovering(8036, 8036 + 729);
+    REQUIRE(months.size() == 24);
+    CHECK(months.front() == Month{2022, 1});
+    CHECK(months.back() == Month{2023, 12});
+    CHECK(pgsqlPartitions::monthsCovering(8036 + 30, 8036 + 31) == std::vector<Month>{{2022, 1}, {2022, 2}});
+    CHECK(pgsqlPartitions::monthsCovering(8037, 8036).empty());
+    REQUIRE(pgsqlPartitions::partitionedTable("Orders") != nullptr);
+    CHECK(pgsqlPartitions::partitionedTable("Orders")->column == std::string("order_date"));
+    CHECK(pgsqlPartitions::partitionedTable("Order_Items") == nullptr);
+
+    // Detached partitions are told apart from the store's other plain tables by name
+    CHECK(pgsqlPartitions::partitionNames({"orders", "orders_p2022_03", "inventory_actions_p2021_12", "orders_p2022",
+                                           "archive_orders", "customers_p2022_03"})
+          == std::vector<std::string>{"orders_p2022_03", "inventory_actions_p2021_12"});
+}
+
+// Builds a one-row result from raw column bytes, NULL where the value is nullptr
+static pgsqlHandles::PgResult makeRowResult(const std::vector<std::string>& names,
+                                            const std::vector<const std::string*>& values) {
+    PGresult* res = PQmakeEmptyPGresult(nullptr, PGRES_TUPLES_OK);
+    std::vector<PGresAttDesc> attrs(names.size());
+    for (std::size_t i = 0; i < names.size(); ++i) {
+        attrs[i].name = const_cast<char*>(names[i].c_str());
+        attrs[i].typlen = -1;
+    }
+    PQsetResultAttrs(res, static_cast<int>(attrs.size()), attrs.data());
+    for (std::size_t i = 0; i < values.size(); ++i) {
+        if (values[i]) {
+            PQsetvalue(res, 0, static_cast<int>(i), const_cast<char*>(values[i]->data()),
+                       static_cast<int>(values[i]->size()));
+        }
+        else {
+            PQsetvalue(res, 0, static_cast<int>(i), nullptr, -1);
+        }
+    }
+    return pgsqlHandles::PgResult(res);
+}
+
+TEST_CASE("table descriptors generate SQL and typed decoders") {
+    using pgsqlSchema::Orders;
+    using pgsqlSchema::Products;
+    STATIC_REQUIRE(pgsqlSchema::columnCount<Products>() == 6);
+
+    CHECK(pgsqlSchema::selectSQL<Products>()
+          == "SELECT product_id, name, price, stock, category, is_deleted FROM Products");
+    CHECK(pgsqlSchema::insertSQL<Products>()
+          == "INSERT INTO Products (name, price, stock, category, is_deleted) VALUES ($1, $2, $3, $4, $5)");
+    CHECK(pgsqlSchema::dropTableSQL<pgsqlSchema::OrderItems>() == "DROP TABLE IF EXISTS Order_Items CASCADE;");
+    CHECK(pgsqlSchema::tableList<pgsqlSchema::PetstoreTables>()
+          == "Customers, Products, Employees, Orders, Order_Items, Suppliers, Inventory_Actions");
+
+    // Referenced tables are logged first and unlogged last
+    std::string logged = pgsqlSchema::setLoggedSQL<pgsqlSchema::PetstoreTables>(true);
+    std::string unlogged = pgsqlSchema::setLoggedSQL<pgsqlSchema::PetstoreTables>(false);
+    CHECK(logged.rfind("ALTER TABLE Customers SET LOGGED;\n", 0) == 0);
+    CHECK(logged.find("ALTER TABLE Orders SET LOGGED;") < logged.find("ALTER TABLE Order_Items SET LOGGED;"));
+    CHECK(unlogged.rfind("ALTER TABLE Inventory_Actions SET UNLOGGED;\n", 0) == 0);
+    CHECK(unlogged.find("ALTER TABLE Order_Items SET UNLOGGED;") < unlogged.find("ALTER TABLE Orders SET UNLOGGED;"));
+    CHECK(pgsqlSchema::persistenceCheckSQL<std::tuple<pgsqlSchema::Customers, pgsqlSchema::Orders>>()
+          == "SELECT EXISTS (SELECT 1 FROM pg_class WHERE oid IN ('Customers'::regclass, 'Orders'::regclass) AND "
+             "relpersistence = 'p'), EXISTS (SELECT 1 FROM Customers) OR EXISTS (SELECT 1 FROM Orders);");
+    CHECK(pgsqlSchema::createTableSQL<pgsqlSchema::Suppliers>()
+          == "CREATE TABLE IF NOT EXISTS Suppliers (supplier_id SERIAL PRIMARY KEY, name TEXT NOT NULL, "
+             "contact_info TEXT, product_id INTEGER, is_deleted BOOLEAN DEFAULT FALSE, "
+             "FOREIGN KEY (product_id) REFERENCES Products(product_id));");
+
+    pgsqlSchema::DdlOptions partitioned;
+    partitioned.partitionColumn = "order_date";
+    partitioned.omitReferencesTo = {"Customers"};
+    std::string orders = pgsqlSchema::createTableSQL<Orders>(partitioned);
+    CHECK(orders.find("order_id SERIAL, ") != std::string::npos);
+    CHECK(orders.find("PRIMARY KEY (order_id, order_date)") != std::string::npos);
+    CHECK(orders.find("REFERENCES Customers") == std::string::npos);
+    CHECK(orders.find("REFERENCES Employees(employee_id)) PARTITION BY RANGE (order_date);") != std::string::npos);
+
+    // Text format: NULL category stays empty, NULL flag reads as false
+    std::vector<std::string> names = {"product_id", "name", "price", "stock", "category", "is_deleted"};
+    std::string id = "7", name = "Dog food", price = "19.99", stock = "12";
+    pgsqlHandles::PgResult text = makeRowResult(names, {&id, &name, &price, &stock, nullptr, nullptr});
+    Products::Row product{};
+    REQUIRE(pgsqlSchema::parseText<Products>(text[0], product));
+    CHECK(product.productId == 7);
+    CHECK(product.name == "Dog food");
+    CHECK(product.priceCents == 1999);
+    CHECK(product.stock == 12);
+    CHECK_FALSE(product.category.has_value());
+    CHECK_FALSE(product.isDeleted);
+
+    // Binary format, with a NULL employee_id
+    std::string orderId("\0\0\0\x2a", 4);
+    std::string orderDate("\0\0\x21\x34", 4); // 8500 days after 2000-01-01
+    std::string customerId("\0\0\0\x03", 4);
+    std::string total("\0\x02\0\0\0\0\0\x02\0\x0c\x0d\xac", 12); // 12.35
+    std::string status = "completed";
+    std::string deleted("\x01", 1);
+    pgsqlHandles::PgResult binary = makeRowResult(
+        {"order_id", "order_date", "employee_id", "customer_id", "total", "status", "is_deleted"},
+        {&orderId, &orderDate, nullptr, &customerId, &total, &status, &deleted});
+    Orders::Row order{};
+    REQUIRE(pgsqlSchema::decodeBinary<Orders>(binary[0], order));
+    CHECK(order.orderId == 42);
+    CHECK(order.orderDate == 8500);
+    CHECK_FALSE(order.employeeId.has_value());
+    CHECK(order.customerId == 3);
+    CHECK(order.totalCents == 1235);
+    CHECK(order.status == "completed");
+    CHECK(order.isDeleted);
+
+    CHECK_FALSE(pgsqlSchema::decodeBinary<Products>(binary[0], product));
+}
+
+TEST_CASE("CSV records are validated and encoded for COPY") {
+    using pgsqlCopy::CsvField;
+    std::vector<CsvField> fields;
+
+    pgsqlCopy::CsvReader reader("name,price\r\n\"Dog \"\"Rex\"\" bowl\",4.50\n\n\"two\nlines\",,x\n\"open");
+    REQUIRE(reader.next(fields));
+    CHECK(reader.line() == 1);
+    REQUIRE(fields.size() == 2);
+    CHECK(fields[1].value == "price");
+
+    REQUIRE(reader.next(fields));
+    CHECK(fields[0].value == "Dog \"Rex\" bowl");
+    CHECK(fields[0].quoted);
+    CHECK(fields[1].value == "4.50");
+
+    REQUIRE(reader.next(fields)); // The blank line is skipped
+    CHECK(reader.line() == 4);
+    REQUIRE(fields.size() == 3);
+    CHECK(fields[0].value == "two\nlines");
+    CHECK(fields[1].value.empty());
+    CHECK_FALSE(fields[1].quoted);
+
+    REQUIRE(reader.next(fields));
+    CHECK(reader.line() == 6);
+    CHECK(reader.malformed());
+    CHECK_FALSE(reader.next(fields));
+
+    // Products without its SERIAL id: name, price, stock, category, is_deleted
+    std::vector<pgsqlCopy::CopyColumn> columns = pgsqlCopy::copyColumns<pgsqlSchema::Products>();
+    REQUIRE(columns.size() == 6);
+    CHECK(columns[0].notNull);
+    CHECK_FALSE(columns[4].notNull);
+    columns.erase(columns.begin());
+
+    std::string out, error;
+    auto row = [](std::vector<std::pair<std::string, bool>> values) {
+        std::vector<CsvField> record;
+        for (auto& [value, quoted] : values) {
+            record.push_back({value, quoted});
+        }
+        return record;
+    };
+    CHECK(pgsqlCopy::encodeCopyRow(
+        row({{"Tab\there\\", false}, {"4.5", false}, {"3", false}, {"", false}, {"Yes", false}}), columns, out, error));
+    CHECK(out == "Tab\\there\\\\\t4.5\t3\t\\N\tt\n");
+
+    std::string before = out;
+    CHECK_FALSE(pgsqlCopy::encodeCopyRow(
+        row({{"Leash", false}, {"cheap", false}, {"1", false}, {"", false}, {"f", false}}), columns, out, error));
+    CHECK(error.find("price") != std::string::npos);
+    CHECK_FALSE(pgsqlCopy::encodeCopyRow(
+        row({{"", false}, {"1.00", false}, {"1", false}, {"", false}, {"f", false}}), columns, out, error));
+    CHECK(error == "name: value is required");
+    CHECK_FALSE(pgsqlCopy::encodeCopyRow(
+        row({{"Leash", false}, {"123456789", false}, {"1", false}, {"", false}, {"f", false}}), columns, out, error));
+    CHECK(error == "price: not a NUMERIC(10, 2) amount '123456789'");
+    CHECK_FALSE(pgsqlCopy::encodeCopyRow(
+        row({{"Leash", false}, {".", false}, {"1", false}, {"", false}, {"f", false}}), columns, out, error));
+    CHECK_FALSE(pgsqlCopy::encodeCopyRow(row({{"Leash", false}}), columns, out, error));
+    CHECK(out == before);
+
+    // A quoted empty field is an empty string, not NULL
+    CHECK(pgsqlCopy::encodeCopyRow(
+        row({{"", true}, {"1", false}, {"0", false}, {"", true}, {"false", false}}), columns, out, error));
+    CHECK(out == before + "\t1\t0\t\tf\n");
+
+    // A header that supplies the SERIAL ids keeps the column's type, so importCsv advances its sequence
+    std::vector<pgsqlCopy::CopyColumn> targets;
+    REQUIRE(pgsqlCopy::mapHeader(row({{"PRICE", false}, {"product_id", false}, {"name", false}, {"stock", false}}),
+                                 pgsqlCopy::copyColumns<pgsqlSchema::Products>(),
+                                 targets,
+                                 error));
+    REQUIRE(targets.size() == 4);
+    CHECK(targets[1].type == pgsqlSchema::SqlType::Serial);
+    CHECK(pgsqlCopy::advanceSequenceSQL("Products", targets[1].name)
+          == "SELECT setval(pg_get_serial_sequence('Products', 'product_id'), max(product_id)) FROM Products "
+             "HAVING max(product_id) IS NOT NULL;");
+    targets.clear();
+    CHECK_FALSE(pgsqlCopy::mapHeader(
+        row({{"name", false}, {"price", false}}), pgsqlCopy::copyColumns<pgsqlSchema::Products>(), targets, error));
+    CHECK(error == "required column 'stock' missing from header");
+}
+
+TEST_CASE("binary encoders round-trip through the decoders") {
+    for (int scale : {0, 2, 4, 5, 18}) {
+        for (std::int64_t value : {std::int64_t{0}, std::int64_t{5}, std::int64_t{450}, std::int64_t{-123456},
+                                   std::int64_t{100000000}, std::numeric_limits<std::int64_t>::max(),
+                                   std::numeric_limits<std::int64_t>::min() + 1}) {
+            std::string bytes;
+            pgsqlBinary::encodeNumeric(bytes, value, scale);
+            std::int64_t decoded = 0;
+            CHECK(pgsqlBinary::decodeNumeric(bytes, scale, decoded));
+            CHECK(decoded == value);
+        }
+    }
+
+    // 4.50 as the server sends it: one digit group before the point, 5000 after it
+    std::string fourFifty;
+    pgsqlBinary::encodeNumeric(fourFifty, 450, 2);
+    CHECK(fourFifty == std::string("\0\2\0\0\0\0\0\2\0\4\x13\x88", 12));
+
+    std::string zero;
+    pgsqlBinary::encodeNumeric(zero, 0, 2);
+    CHECK(zero == std::string("\0\0\0\0\0\0\0\2", 8));
+
+    pgsqlSchema::OrderItems::Row item{7, 3, 11, 2, 450, false};
+    std::string tuple;
+    pgsqlSchema::encodeCopyBinary<pgsqlSchema::OrderItems>(item, tuple);
+    std::int32_t orderItemId = 0;
+    CHECK(tuple.substr(0, 2) == std::string("\0\6", 2));
+    CHECK(tuple.substr(2, 4) == std::string("\0\0\0\4", 4));
+    CHECK(pgsqlBinary::decodeInt4(std::string_view(tuple).substr(6, 4), orderItemId));
+    CHECK(orderItemId == 7);
+    CHECK(tuple.size() == 2 + 4 * (4 + 4) + (4 + 12) + (4 + 1));
+
+    pgsqlSchema::Orders::Row order{1, 8500, std::nullopt, 4, 1999, "completed", false};
+    tuple.clear();
+    pgsqlSchema::encodeCopyBinary<pgsqlSchema::Orders>(order, tuple);
+    CHECK(tuple.substr(2 + 8 + 8, 4) == std::string("\xff\xff\xff\xff", 4)); // NULL employee_id
+
+    CHECK(pgsqlSchema::serialColumn<pgsqlSchema::Orders>() == std::string("order_id"));
+    CHECK(pgsqlSchema::columnList<pgsqlSchema::OrderItems>()
+          == "order_item_id, order_id, product_id, quantity, price, is_deleted");
+}
+
+TEST_CASE("columnar snapshot round-trips through the mapped reader") {
+    using pgsqlSnapshot::Encoding;
+    std::string path = "/tmp/petstore_snapshot_test.snap";
+    std::vector<pgsqlSnapshot::SnapshotColumn> columns = pgsqlSnapshot::snapshotColumns<pgsqlSchema::Orders>();
+    REQUIRE(columns.size() == 7);
+
+    // Three rows per block, so the seven rows span three blocks
+    std::string error;
+    pgsqlSnapshot::SnapshotWriter writer;
+    REQUIRE(writer.open(path, columns, error, 3));
+    for (std::int64_t i = 0; i < 7; ++i) {
+        writer.appendInt(0, 1000 + i);
+        writer.appendInt(1, 8500 - i);
+        if (i % 3 == 0) {
+            writer.appendNull(2);
+        }
+        else {
+            writer.appendInt(2, i);
+        }
+        writer.appendInt(3, 42);
+        writer.appendInt(4, i * -250);
+        writer.appendText(5, i % 2 ? "pending" : "completed");
+        writer.appendInt(6, i == 5);
+        REQUIRE(writer.endRow(error));
+    }
+    REQUIRE(writer.finish(error));
+    CHECK(writer.rows() == 7);
+    CHECK(writer.blocks() == 3);
+
+    pgsqlSnapshot::SnapshotReader reader;
+    REQUIRE(reader.open(path, error));
+    CHECK(reader.rows() == 7);
+    REQUIRE(reader.blocks() == 3);
+    CHECK(reader.columns()[5].name == "status");
+    CHECK(reader.columnIndex("total") == 4);
+    CHECK(reader.columnIndex("missing") == -1);
+
+    pgsqlSnapshot::ColumnBlock block;
+    REQUIRE(reader.readColumn(1, 1, block, error));
+    CHECK(block.encoding == Encoding::DeltaVarint);
+    CHECK(block.ints == std::vector<std::int64_t>{8497, 8496, 8495});
+
+    REQUIRE(reader.readColumn(1, 2, block, error));
+    CHECK(block.nulls == std::vector<bool>{true, false, false});
+    CHECK(block.ints[2] == 5);
+
+    REQUIRE(reader.readColumn(2, 4, block, error));
+    CHECK(block.ints == std::vector<std::int64_t>{-1500});
+
+    REQUIRE(reader.readColumn(1, 5, block, error));
+    CHECK(block.encoding == Encoding::PlainText); // Three rows, two distinct values: no dictionary
+    CHECK(block.texts[0] == "pending");
+    CHECK(block.texts[1] == "completed");
+
+    REQUIRE(reader.readColumn(1, 6, block, error));
+    CHECK(block.ints == std::vector<std::int64_t>{0, 0, 1});
+    CHECK_FALSE(reader.readColumn(3, 0, block, error));
+
+    // Larger blocks let repeated text switch to a dictionary
+    REQUIRE(writer.open(path, {{"status", pgsqlSchema::SqlType::Text}}, error));
+    for (int i = 0; i < 100; ++i) {
+        writer.appendText(0, i % 3 ? "completed" : "pending");
+        REQUIRE(writer.endRow(error));
+    }
+    REQUIRE(writer.finish(error));
+    REQUIRE(reader.open(path, error));
+    REQUIRE(reader.readColumn(0, 0, block, error));
+    CHECK(block.encoding == Encoding::DictionaryText);
+    CHECK(block.texts[99] == "pending");
+    CHECK(block.texts[98] == "completed");
+    std::remove(path.c_str());
+}
+
+TEST_CASE("generated stores are reproducible and keep their foreign keys") {
+    pgsqlDatagen::DatagenConfig config;
+    config.customers = 40;
+    config.products = 25;
+    config.employees = 5;
+    config.suppliers = 10;
+    config.orders = 300;
+    config.chunkRows = 64;
+    std::string error;
+    REQUIRE(pgsqlDatagen::validate(config, error));
+
+    // Rows depend on the seed and id only
+    CHECK(pgsqlDatagen::makeCustomer(config, 7).email == pgsqlDatagen::makeCustomer(config, 7).email);
+    CHECK(pgsqlDatagen::makeProduct(config, 3).priceCents % 100 == 99);
+    pgsqlDatagen::DatagenConfig reseeded = config;
+    reseeded.seed = 43;
+    CHECK(pgsqlDatagen::makeCustomer(reseeded, 7).email != pgsqlDatagen::makeCustomer(config, 7).email);
+    for (std::int32_t id = 1; id <= 10; ++id) {
+        std::optional<std::int32_t> product = pgsqlDatagen::makeSupplier(config, id).productId;
+        REQUIRE(product);
+        CHECK((*product >= 1 && *product <= 25));
+    }
+
+    // Chunks generated out of order still get dense, consecutive item ids
+    pgsqlDatagen::OrderGenerator orders(config);
+    REQUIRE(orders.chunks() == 5);
+    std::vector<pgsqlDatagen::OrderChunk> chunks(orders.chunks());
+    for (std::size_t chunk = orders.chunks(); chunk-- > 0;) {
+        orders.generate(chunk, chunks[chunk]);
+    }
+    std::int32_t nextOrder = 1;
+    std::int32_t nextItem = 1;
+    std::map<std::int32_t, std::int64_t> totals;
+    for (const pgsqlDatagen::OrderChunk& chunk : chunks) {
+        for (const pgsqlSchema::Orders::Row& order : chunk.orders) {
+            CHECK(order.orderId == nextOrder++);
+            CHECK((!order.employeeId || (*order.employeeId >= 1 && *order.employeeId <= 5)));
+            CHECK((!order.customerId || (*order.customerId >= 1 && *order.customerId <= 40)));
+            totals[order.orderId] = order.totalCents;
+        }
+        for (const pgsqlSchema::OrderItems::Row& item : chunk.items) {
+            CHECK(item.orderItemId == nextItem++);
+            CHECK((item.productId >= 1 && item.productId <= 25));
+            CHECK(item.priceCents == pgsqlDatagen::makeProduct(config, item.productId).priceCents);
+            totals[item.orderId] -= item.priceCents * item.quantity;
+        }
+    }
+    CHECK(nextOrder == 301);
+    CHECK(static_cast<std::uint64_t>(nextItem - 1) == orders.totalItems());
+    for (const auto& [order, remainder] : totals) {
+        CHECK(remainder == 0);
+    }
+
+    // A strong Zipf exponent piles most sales onto one product
+    pgsqlDatagen::ZipfSampler skewed(1000, 2.0, 42);
+    pgsqlDatagen::Random random(1);
+    std::map<std::int32_t, int> sales;
+    for (int i = 0; i < 2000; ++i) {
+        ++sales[skewed.sample(random)];
+    }
+    int best = 0;
+    for (const auto& [product, count] : sales) {
+        best = std::max(best, count);
+    }
+    CHECK(best > 1000);
+
+    // CSV output passes the COPY importer's validation
+    std::string csv;
+    pgsqlDatagen::appendCsvHeader<pgsqlSchema::Customers>(csv);
+    pgsqlSchema::Customers::Row customer = pgsqlDatagen::makeCustomer(config, 1);
+    customer.name = "O'Brien, \"Pat\"";
+    pgsqlDatagen::appendCsv<pgsqlSchema::Customers>(customer, csv);
+    pgsqlDatagen::appendCsv<pgsqlSchema::Orders>(chunks[0].orders[0], csv);
+    pgsqlCopy::CsvReader reader(csv);
+    std::vector<pgsqlCopy::CsvField> fields;
+    REQUIRE(reader.next(fields));
+    CHECK(fields[1].value == "name");
+    REQUIRE(reader.next(fields));
+    CHECK(fields[1].value == customer.name);
+    std::string encoded;
+    CHECK(pgsqlCopy::encodeCopyRow(fields, pgsqlCopy::copyColumns<pgsqlSchema::Customers>(), encoded, error));
+    REQUIRE(reader.next(fields));
+    CHECK(pgsqlCopy::encodeCopyRow(fields, pgsqlCopy::copyColumns<pgsqlSchema::Orders>(), encoded, error));
+
+    std::string money;
+    pgsqlDatagen::appendCsvMoney(money, -1205);
+    pgsqlDatagen::appendCsvDate(money, 0);
+    CHECK(money == "-12.052000-01-01");
+
+    config.products = 0;
+    CHECK_FALSE(pgsqlDatagen::validate(config, error));
+}
+
+TEST_CASE("catalog sync builds set-based diff statements from descriptors") {
+    pgsqlSync::SyncTable products = pgsqlSync::syncTable<pgsqlSchema::Products>();
+    CHECK(products.key == "product_id");
+    CHECK(products.columns[0].type == pgsqlSchema::SqlType::Integer); // The id is required in a feed
+    CHECK(pgsqlSync::stagingTableName(products) == "sync_products");
+
+    CHECK(pgsqlSync::createStagingSQL(products)
+          == "CREATE TEMP TABLE sync_products (LIKE Products INCLUDING DEFAULTS) ON COMMIT DROP; "
+             "ALTER TABLE sync_products ALTER COLUMN product_id DROP DEFAULT, ALTER COLUMN stock DROP NOT NULL;");
+    // LIKE copies NOT NULL; a store-owned column that kept it would abort the COPY of a feed without it
+    std::string staging = pgsqlSync::createStagingSQL(products);
+    for (const pgsqlSync::StoreOwnedColumn& owned : products.storeOwned) {
+        CHECK(staging.find("ALTER COLUMN " + owned.name + " DROP NOT NULL") != std::string::npos);
+    }
+    CHECK(pgsqlSync::updateChangedSQL(products)
+          == "UPDATE Products AS t SET name = s.name, price = s.price, stock = COALESCE(s.stock, t.stock), "
+             "category = s.category, is_deleted = s.is_deleted FROM sync_products AS s WHERE t.product_id = "
+             "s.product_id AND (t.name, t.price, t.stock, t.category, t.is_deleted) IS DISTINCT FROM "
+             "(s.name, s.price, COALESCE(s.stock, t.stock), s.category, s.is_deleted);");
+    CHECK(pgsqlSync::insertNewSQL(products)
+          == "INSERT INTO Products (product_id, name, price, stock, category, is_deleted) "
+             "SELECT product_id, name, price, COALESCE(stock, 0), category, is_deleted FROM sync_products "
+             "ON CONFLICT (product_id) DO NOTHING;");
+    CHECK(pgsqlSync::softDeleteMissingSQL(products)
+          == "UPDATE Products AS t SET is_deleted = TRUE WHERE t.is_deleted IS NOT TRUE AND NOT EXISTS "
+             "(SELECT 1 FROM sync_products AS s WHERE s.product_id = t.product_id);");
+
+    // A feed without category and stock leaves both alone on matched rows; new products start at stock 0
+    pgsqlSync::SyncTable feed = pgsqlSync::feedTable(products, {"product_id", "name", "price"});
+    CHECK(pgsqlSync::updateChangedSQL(feed)
+          == "UPDATE Products AS t SET name = s.name, price = s.price, is_deleted = s.is_deleted FROM sync_products "
+             "AS s WHERE t.product_id = s.product_id AND (t.name, t.price, t.is_deleted) IS DISTINCT FROM "
+             "(s.name, s.price, s.is_deleted);");
+    CHECK(pgsqlSync::insertNewSQL(feed)
+          == "INSERT INTO Products (product_id, name, price, is_deleted, stock) "
+             "SELECT product_id, name, price, is_deleted, 0 FROM sync_products ON CONFLICT (product_id) DO NOTHING;");
+    for (const pgsqlCopy::CopyColumn& column : products.columns) {
+        CHECK(column.notNull == (column.name == std::string("product_id") || column.name == std::string("name")
+                                 || column.name == std::string("price")));
+    }
+
+    pgsqlSync::SyncTable suppliers = pgsqlSync::syncTable<pgsqlSchema::Suppliers>();
+    CHECK(suppliers.storeOwned.empty());
+    CHECK(pgsqlSync::feedTable(suppliers, {"supplier_id", "name"}).columns.size() == 3);
+    CHECK(pgsqlSync::duplicateKeySQL(suppliers)
+          == "SELECT supplier_id FROM sync_suppliers GROUP BY supplier_id HAVING count(*) > 1 LIMIT 1;");
+
+    pgsqlSync::SyncOptions options;
+    CHECK(options.import.maxRejectedRows == 0);
+    CHECK(options.import.bufferSize == pgsqlCopy::ImportOptions{}.bufferSize);
+}
+
+// Big-endian builder for synthetic pgoutput messages
+struct PgOutputMessage {
+    std::string data;
+
+    explicit PgOutputMessage(char tag) : data(1, tag) {}
+
+    template <typename T>
+    PgOutputMessage& integer(T value) {
+        for (std::size_t i = sizeof(T); i-- > 0;) {
+            data += static_cast<char>((static_cast<std::uint64_t>(value) >> (8 * i)) & 0xFF);
+        }
+        return *this;
+    }
+
+    PgOutputMessage& string(const std::string& value) {
+        data += value;
+        data += '\0';
+        return *this;
+    }
+
+    // TupleData; std::nullopt is sent as NULL
+    PgOutputMessage& tuple(char part, const std::vector<std::optional<std::string>>& values) {
+        integer<char>(part).integer<std::uint16_t>(static_cast<std::uint16_t>(values.size()));
+        for (const std::optional<std::string>& value : values) {
+            if (!value) {
+                integer<char>('n');
+                continue;
+            }
+            integer<char>('t').integer<std::uint32_t>(static_cast<std::uint32_t>(value->size()));
+            data += *value;
+        }
+        return *this;
+    }
+};
+
+TEST_CASE("pgoutput messages decode into typed change events") {
+    pgsqlCdc::Lsn lsn = 0;
+    REQUIRE(pgsqlCdc::parseLsn("16/B374D848", lsn));
+    CHECK(lsn == 0x16B374D848ULL);
+    CHECK(pgsqlCdc::formatLsn(lsn) == "16/B374D848");
+    CHECK_FALSE(pgsqlCdc::parseLsn("16B374D848", lsn));
+    CHECK_FALSE(pgsqlCdc::parseLsn("16/", lsn));
+    CHECK_FALSE(pgsqlCdc::parseLsn("16/XYZ", lsn));
+
+    pgsqlCdc::PgOutputDecoder decoder;
+    std::vector<pgsqlCdc::ChangeEvent> events;
+    std::string error;
+    auto decode = [&](const PgOutputMessage& message, pgsqlCdc::Lsn walStart) {
+        return decoder.decode(message.data, walStart, events, error);
+    };
+
+    // Server column order differs from the descriptor and carries an extra column
+    PgOutputMessage relation('R');
+    relation.integer<std::uint32_t>(16400).string("public").string("orders").integer<std::uint8_t>('d');
+    relation.integer<std::uint16_t>(8);
+    for (const char* column :
+         {"order_id", "status", "order_date", "employee_id", "customer_id", "total", "is_deleted", "note"}) {
+        relation.integer<std::uint8_t>(0).string(column).integer<std::uint32_t>(25).integer<std::int32_t>(-1);
+    }
+    REQUIRE(decode(relation, 0x100));
+
+    PgOutputMessage products('R');
+    products.integer<std::uint32_t>(16500).string("public").string("products").integer<std::uint8_t>('d');
+    products.integer<std::uint16_t>(1).integer<std::uint8_t>(1).string("product_id").integer<std::uint32_t>(23);
+    products.integer<std::int32_t>(-1);
+    REQUIRE(decode(products, 0x100));
+
+    PgOutputMessage begin('B');
+    begin.integer<std::uint64_t>(0x2000).integer<std::int64_t>(777).integer<std::uint32_t>(42);
+    REQUIRE(decode(begin, 0x1000));
+    CHECK(decoder.inTransaction());
+
+    PgOutputMessage insert('I');
+    insert.integer<std::uint32_t>(16400).tuple(
+        'N', {"7", "pending", "2024-03-01", std::nullopt, "12", "19.99", "f", "gift"});
+    REQUIRE(decode(insert, 0x1100));
+
+    PgOutputMessage untracked('I');
+    untracked.integer<std::uint32_t>(16500).tuple('N', {"3"});
+    REQUIRE(decode(untracked, 0x1180));
+
+    PgOutputMessage update('U');
+    update.integer<std::uint32_t>(16400)
+        .tuple('K', {"7", std::nullopt, std::nullopt, std::nullopt, std::nullopt, std::nullopt, std::nullopt})
+        .tuple('N', {"8", "shipped", "2024-03-01", "3", "12", "19.99", "f", std::nullopt});
+    REQUIRE(decode(update, 0x1200));
+
+    PgOutputMessage remove('D');
+    remove.integer<std::uint32_t>(16400).tuple('K', {"8", std::nullopt, std::nullopt, std::nullopt});
+    REQUIRE(decode(remove, 0x1300));
+
+    CHECK_FALSE(decoder.takeCommit());
+    PgOutputMessage commit('C');
+    commit.integer<std::uint8_t>(0).integer<std::uint64_t>(0x2000).integer<std::uint64_t>(0x2040);
+    commit.integer<std::int64_t>(777);
+    REQUIRE(decode(commit, 0x2000));
+    CHECK_FALSE(decoder.inTransaction());
+    CHECK(decoder.takeCommit() == pgsqlCdc::Lsn{0x2040});
+    CHECK_FALSE(decoder.takeCommit());
+
+    REQUIRE(events.size() == 3); // Products changes are not captured
+    for (const pgsqlCdc::ChangeEvent& event : events) {
+        CHECK(event.commitLsn == 0x2000);
+        CHECK(event.xid == 42);
+        CHECK(event.commitTime == 777);
+    }
+
+    const auto* inserted = std::get_if<pgsqlCdc::Change<pgsqlSchema::Orders>>(&events[0].change);
+    REQUIRE(inserted);
+    CHECK(events[0].lsn == 0x1100);
+    CHECK(inserted->kind == pgsqlCdc::ChangeKind::Insert);
+    CHECK(inserted->row.orderId == 7);
+    CHECK(inserted->row.status == "pending");
+    CHECK(inserted->row.orderDate == 8826);
+    CHECK_FALSE(inserted->row.employeeId);
+    CHECK(inserted->row.customerId == 12);
+    CHECK(inserted->row.totalCents == 1999);
+    CHECK_FALSE(inserted->row.isDeleted);
+
+    const auto& updated = std::get<pgsqlCdc::Change<pgsqlSchema::Orders>>(events[1].change);
+    CHECK(updated.kind == pgsqlCdc::ChangeKind::Update);
+    CHECK(updated.row.orderId == 8);
+    CHECK(updated.row.employeeId == 3);
+    REQUIRE(updated.old);
+    CHECK(updated.old->orderId == 7);
+
+    const auto& deleted = std::get<pgsqlCdc::Change<pgsqlSchema::Orders>>(events[2].change);
+    CHECK(deleted.kind == pgsqlCdc::ChangeKind::Delete);
+    CHECK(deleted.row.orderId == 8);
+    CHECK(deleted.row.status.empty());
+
+    // Malformed input is reported, not delivered
+    events.clear();
+    PgOutputMessage unknownRelation('I');
+    unknownRelation.integer<std::uint32_t>(99).tuple('N', {"1"});
+    CHECK_FALSE(decode(unknownRelation, 0x3000));
+    PgOutputMessage badValue('I');
+    badValue.integer<std::uint32_t>(16400).tuple('N', {"seven"});
+    CHECK_FALSE(decode(badValue, 0x3100));
+    CHECK(error.find("order_id") != std::string::npos);
+    PgOutputMessage truncated('B');
+    truncated.integer<std::uint32_t>(1);
+    CHECK_FALSE(decode(truncated, 0x3200));
+    CHECK(events.empty());
+}
+
+TEST_CASE("store archives split ids, keep a manifest and re-encode COPY tuples") {
+    auto ranges = pgsqlDump::splitKeyRange(1, 25, 10);
+    REQUIRE(ranges.size() == 3);
+    CHECK(ranges[0].first == 1);
+    CHECK(ranges[0].last == 10);
+    CHECK(ranges[2].first == 21);
+    CHECK(ranges[2].last == 25);
+    CHECK(pgsqlDump::splitKeyRange(5, 5, 10).size() == 1);
+    CHECK(pgsqlDump::splitKeyRange(1, 20, 10).size() == 2);
+    CHECK(pgsqlDump::splitKeyRange(6, 5, 10).empty());
+
+    std::string directory = "/tmp/petstore_dump_test";
+    std::filesystem::remove_all(directory);
+    std::filesystem::create_directories(directory);
+    std::string error;
+    std::vector<pgsqlDump::ArchiveChunk> chunks;
+    std::vector<pgsqlDump::DateRange> dates;
+    CHECK_FALSE(pgsqlDump::readManifest(directory, chunks, dates, error)); // No manifest: an interrupted dump
+    std::vector<pgsqlDump::ArchiveChunk> written = {{"Orders", "orders.0000.snap", 1000000},
+                                                    {"Order_Items", "order_items.0000.snap", 0}};
+    REQUIRE(pgsqlDump::writeManifest(
+        directory, written, {{"Orders", -366, 8826}, {"Inventory_Actions", 7000, 7000}}, error));
+    REQUIRE(pgsqlDump::readManifest(directory, chunks, dates, error));
+    REQUIRE(chunks.size() == 2);
+    CHECK(chunks[0].table == "Orders");
+    CHECK(chunks[0].file == "orders.0000.snap");
+    CHECK(chunks[0].rows == 1000000);
+    CHECK(chunks[1].rows == 0);
+    // The partition key ranges a restore creates partitions for survive the round trip
+    REQUIRE(dates.size() == 2);
+    CHECK(dates[0].table == "Orders");
+    CHECK(dates[0].firstDay == -366);
+    CHECK(dates[0].lastDay == 8826);
+    CHECK(dates[1].table == "Inventory_Actions");
+    CHECK(dates[1].firstDay == dates[1].lastDay);
+    CHECK(pgsqlPartitions::monthsCovering(dates[0].firstDay, dates[0].lastDay).size() == 304); // 1998-12 to 2024-03
+    std::ofstream(directory + "/manifest", std::ios::app) << "dates\tOrders\t9\t3\n";
+    CHECK_FALSE(pgsqlDump::readManifest(directory, chunks, dates, error)); // Last day before the first
+    REQUIRE(pgsqlDump::writeManifest(directory, {{"Orders", "orders.0000.snap", 1}}, {}, error));
+    std::ofstream(directory + "/manifest", std::ios::app) << "Orders\t../escape.snap\t1\n";
+    CHECK_FALSE(pgsqlDump::readManifest(directory, chunks, dates, error));
+
+    // A restored tuple is byte for byte what the typed encoder produces for the same row
+    std::vector<pgsqlSchema::Orders::Row> rows = {{7, 8826, std::nullopt, 12, 1999, "pending", false},
+                                                  {8, -30, 3, std::nullopt, -5, "", true}};
+    std::string path = directory + "/orders.0000.snap";
+    pgsqlSnapshot::SnapshotWriter writer;
+    REQUIRE(writer.open(path, pgsqlSnapshot::snapshotColumns<pgsqlSchema::Orders>(), error));
+    for (const pgsqlSchema::Orders::Row& row : rows) {
+        writer.appendInt(0, row.orderId);
+        writer.appendInt(1, row.orderDate);
+        row.employeeId ? writer.appendInt(2, *row.employeeId) : writer.appendNull(2);
+        row.customerId ? writer.appendInt(3, *row.customerId) : writer.appendNull(3);
+        writer.appendInt(4, row.totalCents);
+        writer.appendText(5, row.status);
+        writer.appendInt(6, row.isDeleted);
+        REQUIRE(writer.endRow(error));
+    }
+    REQUIRE(writer.finish(error));
+
+    pgsqlSnapshot::SnapshotReader reader;
+    REQUIRE(reader.open(path, error));
+    std::vector<pgsqlSnapshot::ColumnBlock> blocks(reader.columns().size());
+    for (std::size_t column = 0; column < blocks.size(); ++column) {
+        REQUIRE(reader.readColumn(0, column, blocks[column], error));
+    }
+    for (std::size_t row = 0; row < rows.size(); ++row) {
+        std::string restored;
+        std::string expected;
+        pgsqlSnapshot::appendCopyTuple(reader.columns(), blocks, row, restored);
+        pgsqlSchema::encodeCopyBinary<pgsqlSchema::Orders>(rows[row], expected);
+        CHECK(restored == expected);
+    }
+
+    // deleted_at of a soft-deleted row survives the archive as TIMESTAMPTZ microseconds
+    std::vector<pgsqlSnapshot::SnapshotColumn> columns = {{"order_id", pgsqlSchema::SqlType::Serial},
+                                                          {"deleted_at", pgsqlSchema::SqlType::Timestamp}};
+    std::int64_t deletedAt = 843177600123456; // 2026-09-20 00:00:00.123456 UTC
+    std::string archivePath = directory + "/archive_orders.0000.snap";
+    pgsqlSnapshot::SnapshotWriter archiveWriter;
+    REQUIRE(archiveWriter.open(archivePath, columns, error));
+    archiveWriter.appendInt(0, 7);
+    archiveWriter.appendInt(1, deletedAt);
+    REQUIRE(archiveWriter.endRow(error));
+    archiveWriter.appendInt(0, 8);
+    archiveWriter.appendNull(1);
+    REQUIRE(archiveWriter.endRow(error));
+    REQUIRE(archiveWriter.finish(error));
+    pgsqlSnapshot::SnapshotReader archiveReader;
+    REQUIRE(archiveReader.open(archivePath, error));
+    REQUIRE(archiveReader.columns()[1].type == pgsqlSchema::SqlType::Timestamp);
+    std::vector<pgsqlSnapshot::ColumnBlock> archiveBlocks(2);
+    for (std::size_t column = 0; column < archiveBlocks.size(); ++column) {
+        REQUIRE(archiveReader.readColumn(0, column, archiveBlocks[column], error));
+    }
+    std::string restored;
+    pgsqlSnapshot::appendCopyTuple(archiveReader.columns(), archiveBlocks, 0, restored);
+    std::int64_t decoded = 0;
+    REQUIRE(restored.size() == 2 + 8 + 4 + 8);
+    CHECK(restored.substr(10, 4) == std::string("\0\0\0\x08", 4));
+    CHECK(pgsqlBinary::decodeTimestamp(std::string_view(restored).substr(14), decoded));
+    CHECK(decoded == deletedAt);
+    restored.clear();
+    pgsqlSnapshot::appendCopyTuple(archiveReader.columns(), archiveBlocks, 1, restored);
+    CHECK(restored.substr(10) == std::string("\xff\xff\xff\xff", 4));
+    std::filesystem::remove_all(directory);
+}
+
+TEST_CASE("soft-delete purge archives children first and cascades owned items") {
+    std::vector<pgsqlPurge::PurgeTable> tables = pgsqlPurge::purgeTables();
+    std::vector<std::string> names;
+    for (const pgsqlPurge::PurgeTable& table : tables) {
+        names.push_back(table.name);
+    }
+    CHECK(names
+          == std::vector<std::string>{
+              "Inventory_Actions", "Suppliers", "Order_Items", "Orders", "Employees", "Products", "Customers"});
+
+    const pgsqlPurge::PurgeTable& orders = tables[3];
+    CHECK(orders.key == "order_id");
+    CHECK(orders.columns.back() == "deleted_at");
+    REQUIRE(orders.children.size() == 1);
+    CHECK(orders.children[0].table == "Order_Items");
+    CHECK(orders.children[0].owned);
+
+    const pgsqlPurge::PurgeTable& products = tables[5];
+    REQUIRE(products.children.size() == 3);
+    for (const pgsqlPurge::ChildReference& child : products.children) {
+        CHECK_FALSE(child.owned);
+    }
+
+    CHECK(pgsqlPurge::candidatesSQL(orders)
+          == "SELECT t.order_id FROM Orders AS t WHERE t.order_id > $1 AND t.is_deleted AND t.deleted_at < $2 AND "
+             "NOT EXISTS (SELECT 1 FROM Order_Items AS c WHERE c.order_id = t.order_id AND c.is_deleted IS NOT TRUE) "
+             "ORDER BY t.order_id LIMIT $3;");
+
+    std::string move = pgsqlPurge::moveSQL(orders);
+    CHECK(move.rfind("WITH moved AS (DELETE FROM Orders AS t WHERE t.order_id = ANY($1::int[]) AND ", 0) == 0);
+    CHECK(move.find("INSERT INTO Archive_Orders (order_id, order_date, employee_id, customer_id, total, status, "
+                    "is_deleted, deleted_at) SELECT")
+          != std::string::npos);
+    CHECK(move.find("DELETE FROM Order_Items AS c WHERE c.order_id IN (SELECT order_id FROM moved)")
+          != std::string::npos);
+    CHECK(move.find("INSERT INTO Archive_Order_Items") != std::string::npos);
+    CHECK(pgsqlPurge::moveSQL(products).find("Archive_Order_Items") == std::string::npos);
+    CHECK(pgsqlPurge::moveSQL(products).ends_with(" SELECT (SELECT count(*) FROM archived), 0;"));
+
+    std::string migration = pgsqlPurge::softDeleteArchiveSQL();
+    CHECK(migration.find("ALTER TABLE Customers ADD COLUMN deleted_at TIMESTAMPTZ;") != std::string::npos);
+    CHECK(migration.find("CREATE TRIGGER orders_deleted_at_update BEFORE UPDATE OF is_deleted ON Orders")
+          != std::string::npos);
+    CHECK(migration.find("CREATE TABLE Archive_Order_Items (LIKE Order_Items, archived_at TIMESTAMPTZ")
+          != std::string::npos);
+    // Purging a product probes Order_Items by product_id; order_id is covered by the index pack
+    CHECK(migration.find("CREATE INDEX IF NOT EXISTS order_items_product_id_idx ON Order_Items (product_id);")
+          != std::string::npos);
+    CHECK(migration.find("CREATE INDEX IF NOT EXISTS orders_customer_id_idx ON Orders (customer_id);")
+          != std::string::npos);
+    CHECK(migration.find("order_items_order_id_idx") == std::string::npos);
+
+    pgsqlPurge::PurgeProgress progress;
+    CHECK(progress.rowsPerSecond() == 0.0);
+    progress.moved = 500;
+    progress.seconds = 2;
+    CHECK(progress.rowsPerSecond() == 250.0);
+}